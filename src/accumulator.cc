@@ -52,6 +52,23 @@ void Accumulator::accumulate(double value) {
   }
 }
 
+void Accumulator::merge(const Accumulator &acc) {
+  nValues_ += acc.nValues_;
+  sum_ += acc.sum_;
+  sumSq_ += acc.sumSq_;
+  if (valMoment_.size() == acc.valMoment_.size()) {
+    for (int mo = 0; mo < static_cast<int>(valMoment_.size()); ++mo) {
+      valMoment_[mo] += acc.valMoment_[mo];
+    }
+  }
+  if (max_ < acc.max_) max_ = acc.max_;
+  if (min_ > acc.min_) min_ = acc.min_;
+  if (acc.blockAvs_ != NULL) {
+    if (blockAvs_ == NULL) blockAvs_ = make_shared<Accumulator>();
+    blockAvs_->merge(*acc.blockAvs_);
+  }
+}
+
 void Accumulator::reset() {
   sum_ = 0;
   nValues_ = 0;
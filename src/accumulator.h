@@ -80,6 +80,13 @@ class Accumulator : public Base {
   /// Zero all accumulated values.
   virtual void reset();
 
+  /**
+   * Add the values accumulated in acc, e.g., from another thread.
+   * Completed blocks of acc are added to the block averages, but values in
+   * its incomplete block are not.
+   */
+  void merge(const Accumulator &acc);
+
   /// Return number of values per block.
   long long nBlock() const { return nBlock_; }
 
@@ -21,8 +21,12 @@ AccumulatorVec::AccumulatorVec() {
 void AccumulatorVec::accumulate(
   const int index,
   const double value) {
-  // resize vector if index is out of range
-  if (static_cast<int>(accVec_.size()) <= index) accVec_.resize(index+1);
+  // resize vector if index is out of range, with the same block size
+  if (static_cast<int>(accVec_.size()) <= index) {
+    Accumulator acc;
+    acc.setBlock(nBlock_);
+    accVec_.resize(index+1, acc);
+  }
   accVec_[index].accumulate(value);
 }
 
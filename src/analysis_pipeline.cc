@@ -0,0 +1,197 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include "./analysis_pipeline.h"
+
+namespace feasst {
+
+AnalysisPipeline::AnalysisPipeline(const argtype &args) {
+  className_.assign("AnalysisPipeline");
+  args_ = args;
+  argparse_.initArgs(className_, args);
+  queueSize_ = argparse_.key("queueSize").dflt("10").integer();
+  ASSERT(queueSize_ > 0, "queueSize(" << queueSize_ << ") must be positive");
+  policy_ = argparse_.key("policy").dflt("block").str();
+  ASSERT( (policy_ == "block") || (policy_ == "drop") ||
+          (policy_ == "subsample"), "unrecognized policy(" << policy_ << ")");
+  nThreads_ = argparse_.key("nThreads").dflt("1").integer();
+  ASSERT(nThreads_ > 0, "nThreads(" << nThreads_ << ") must be positive");
+  argparse_.checkAllArgsUsed();
+  nDiscard_ = 0;
+  pair_ = NULL;
+  stop_flag_ = false;
+}
+
+void AnalysisPipeline::push(const vector<shared_ptr<Analyze> > &analyzers,
+  Pair *pair,
+  const long long nAttempts,
+  const int iMacro,
+  CriteriaWLTMMC *criteria) {
+  rethrow_();
+
+  // restart the workers if the analyzers have changed
+  if ( (analyzers != analyzers_) || (pair != pair_) ) {
+    stop_();
+    start_(analyzers, pair);
+  }
+
+  const int nWorkers = static_cast<int>(queue_.size());
+  for (int w = 0; w < nWorkers; ++w) {
+    vector<int> update, write;
+    for (int ia = w; ia < static_cast<int>(analyzers_.size()); ia += nWorkers) {
+      if (nAttempts % analyzers_[ia]->nFreq() == 0) update.push_back(ia);
+      if (nAttempts % analyzers_[ia]->nFreqPrint() == 0) write.push_back(ia);
+    }
+    if ( (update.size() == 0) && (write.size() == 0) ) continue;
+
+    // discard before the copy, if the queue is full
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::deque<shared_ptr<Snapshot> >& queue = queue_[w];
+    if ( (policy_ == "drop") && (write.size() == 0) &&
+         (static_cast<int>(queue.size()) >= queueSize_) ) {
+      nDiscard_ += update.size();
+      continue;
+    }
+    lock.unlock();
+
+    // the copy is made outside of the lock, while the worker continues
+    shared_ptr<Snapshot> snap = make_shared<Snapshot>();
+    snap->space = pair->space()->cloneShrPtr();
+    snap->pair = shared_ptr<Pair>(pair->clone(snap->space.get()));
+    if ( (criteria != NULL) && (write.size() != 0) ) {
+      snap->criteria = criteria->cloneShrPtr();
+    }
+    snap->iMacro = iMacro;
+    snap->update = update;
+    snap->write = write;
+
+    lock.lock();
+    if (static_cast<int>(queue.size()) >= queueSize_) {
+      // the front of the queue may be in progress, and is never replaced
+      if ( (policy_ == "subsample") && (write.size() == 0) &&
+           (queue.size() > 1) && (queue.back()->write.size() == 0) ) {
+        nDiscard_ += queue.back()->update.size();
+        queue.back() = snap;
+        continue;
+      } else if ( (policy_ == "drop") && (write.size() == 0) ) {
+        nDiscard_ += update.size();
+        continue;
+      }
+      condition_.wait(lock, [&] {
+        return static_cast<int>(queue.size()) < queueSize_; });
+    }
+    queue.push_back(snap);
+    lock.unlock();
+    condition_.notify_all();
+  }
+}
+
+void AnalysisPipeline::flush() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [&] {
+      for (unsigned int w = 0; w < queue_.size(); ++w) {
+        if (queue_[w].size() != 0) return false;
+      }
+      return true;
+    });
+  }
+  rethrow_();
+}
+
+void AnalysisPipeline::start_(const vector<shared_ptr<Analyze> > &analyzers,
+  Pair *pair) {
+  analyzers_ = analyzers;
+  pair_ = pair;
+  const int nWorkers = std::min(nThreads_, static_cast<int>(analyzers.size()));
+  queue_.assign(nWorkers, std::deque<shared_ptr<Snapshot> >());
+  for (int w = 0; w < nWorkers; ++w) {
+    workers_.push_back(std::thread(&AnalysisPipeline::work_, this, w));
+  }
+}
+
+void AnalysisPipeline::stop_() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_flag_ = true;
+  }
+  condition_.notify_all();
+  for (unsigned int w = 0; w < workers_.size(); ++w) {
+    workers_[w].join();
+  }
+  workers_.clear();
+  stop_flag_ = false;
+}
+
+void AnalysisPipeline::work_(const int w) {
+  std::deque<shared_ptr<Snapshot> >& queue = queue_[w];
+  while (true) {
+    shared_ptr<Snapshot> snap;
+    bool error;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [&] { return stop_flag_ || (queue.size() != 0); });
+      if (queue.size() == 0) return;
+      snap = queue.front();
+      error = static_cast<bool>(exception_);
+    }
+
+    // analyze the snapshot, then point the analyzers back to the chain
+    if (!error) {
+      try {
+        for (unsigned int i = 0; i < snap->update.size(); ++i) {
+          Analyze* an = analyzers_[snap->update[i]].get();
+          an->replacePair(snap->pair.get());
+          an->update(snap->iMacro);
+        }
+        for (unsigned int i = 0; i < snap->write.size(); ++i) {
+          Analyze* an = analyzers_[snap->write[i]].get();
+          an->replacePair(snap->pair.get());
+          if (snap->criteria) {
+            an->write(snap->criteria.get());
+          } else {
+            an->write();
+          }
+        }
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exception_ = std::current_exception();
+      }
+      for (unsigned int i = 0; i < snap->update.size(); ++i) {
+        analyzers_[snap->update[i]]->replacePair(pair_);
+      }
+      for (unsigned int i = 0; i < snap->write.size(); ++i) {
+        analyzers_[snap->write[i]]->replacePair(pair_);
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue.pop_front();
+    }
+    condition_.notify_all();
+  }
+}
+
+void AnalysisPipeline::rethrow_() {
+  std::exception_ptr exception;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exception = exception_;
+    exception_ = nullptr;
+  }
+  if (exception) std::rethrow_exception(exception);
+}
+
+shared_ptr<AnalysisPipeline> makeAnalysisPipeline(const argtype &args) {
+  return make_shared<AnalysisPipeline>(args);
+}
+
+}  // namespace feasst
@@ -0,0 +1,138 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef ANALYSIS_PIPELINE_H_
+#define ANALYSIS_PIPELINE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "./analyze.h"
+
+namespace feasst {
+
+/**
+ * Run analyzers on worker threads, decoupled from the Markov chain.
+ *
+ * Instead of calling Analyze::update and Analyze::write inline, MC hands
+ * the pipeline a snapshot of the configuration (a copy of the Space and
+ * Pair, the macrostate and, for writes, a copy of CriteriaWLTMMC). Each
+ * analyzer is assigned to one worker, which processes the snapshots in the
+ * order of the chain. Thus, each analyzer sees the same sequence of
+ * configurations as the inline mode, and the results are identical when no
+ * snapshots are discarded.
+ *
+ * Each worker has a bounded queue. When a queue is full, the policy decides:
+ *
+ *  - block: the chain waits for the worker (identical to inline).
+ *  - drop: the new snapshot is discarded.
+ *  - subsample: the newest queued snapshot is replaced by the new one, such
+ *    that the analyzers see the most recent configurations.
+ *
+ * Snapshots which print are never discarded, so output is always written.
+ * Call flush() to wait for all queued snapshots (e.g., before a restart).
+ */
+class AnalysisPipeline : public Base {
+ public:
+  /// Constructor
+  explicit AnalysisPipeline(
+    /**
+     * allowed string key pairs (e.g., dictionary):
+     *
+     *  queueSize : maximum number of snapshots queued for each worker.
+     *
+     *  - (default): 10
+     *
+     *  policy : "block", "drop" or "subsample" when a queue is full.
+     *
+     *  - (default): block
+     *
+     *  nThreads : number of worker threads.
+     *
+     *  - (default): 1
+     */
+    const argtype &args = argtype());
+
+  /**
+   * Queue the analysis of the current configuration of pair after trial
+   * nAttempts. The analyzers which update or print at nAttempts are given
+   * the macrostate iMacro. If criteria is not NULL, write(criteria) is used
+   * instead of write().
+   */
+  void push(const vector<shared_ptr<Analyze> > &analyzers,
+    Pair *pair,
+    const long long nAttempts,
+    const int iMacro = 0,
+    CriteriaWLTMMC *criteria = NULL);
+
+  /// Wait until all queued snapshots are analyzed.
+  void flush();
+
+  /// Return the number of analyzer updates which were discarded.
+  long long nDiscard() const { return nDiscard_; }
+
+  /// Return a new pipeline with the same settings but no workers.
+  shared_ptr<AnalysisPipeline> cloneShrPtr() const {
+    return make_shared<AnalysisPipeline>(args_); }
+
+  ~AnalysisPipeline() { stop_(); }
+
+ protected:
+  argtype args_;
+  int queueSize_;
+  string policy_;
+  int nThreads_;
+  long long nDiscard_;
+
+  /// Snapshot of the configuration for the analyzers of one worker.
+  struct Snapshot {
+    shared_ptr<Space> space;
+    shared_ptr<Pair> pair;
+    shared_ptr<CriteriaWLTMMC> criteria;
+    int iMacro;
+    vector<int> update;   //!< indices of analyzers to update
+    vector<int> write;    //!< indices of analyzers to print
+  };
+
+  vector<shared_ptr<Analyze> > analyzers_;
+  Pair* pair_;    //!< pair of the chain, restored to analyzers when idle
+  vector<std::deque<shared_ptr<Snapshot> > > queue_;
+  vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool stop_flag_;
+  std::exception_ptr exception_;
+
+  /// Start a worker for each thread, for the given analyzers.
+  void start_(const vector<shared_ptr<Analyze> > &analyzers, Pair *pair);
+
+  /// Wait for the queues, then stop and join the workers.
+  void stop_();
+
+  /// Process the queue of worker w until stopped.
+  void work_(const int w);
+
+  /// Rethrow an exception from a worker on the calling thread.
+  void rethrow_();
+
+  // workers hold pointers to this object and the queues, which must not move
+  AnalysisPipeline(const AnalysisPipeline&) = delete;
+  AnalysisPipeline& operator=(const AnalysisPipeline&) = delete;
+};
+
+/// Factory method
+shared_ptr<AnalysisPipeline> makeAnalysisPipeline(
+  const argtype &args = argtype());
+
+}  // namespace feasst
+
+#endif  // ANALYSIS_PIPELINE_H_
@@ -0,0 +1,147 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <numeric>
+#include "pair_lj.h"
+#include "mc_wltmmc.h"
+#include "trial_add.h"
+#include "trial_delete.h"
+#include "trial_transform.h"
+#include "analysis_pipeline.h"
+#include "analyze_widom.h"
+
+using namespace feasst;
+
+// record the configurations seen by the analyzer
+class AnalyzeRecord : public Analyze {
+ public:
+  AnalyzeRecord(Pair *pair, const int sleep = 0)
+    : Analyze(pair), nWrite(0), sleep_(sleep) {}
+  void update(const int iMacro) {
+    if (sleep_ > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(sleep_));
+    }
+    macro.push_back(iMacro);
+    nMol.push_back(space()->nMol());
+    pe.push_back(pair_->peTot());
+  }
+  void write() { ++nWrite; }
+  void write(CriteriaWLTMMC *c) { if (c != NULL) ++nWrite; }
+  vector<int> macro, nMol;
+  vector<double> pe;
+  int nWrite;
+ private:
+  int sleep_;
+};
+
+// run grand canonical TMMC, with the analysis pipeline if args is not empty
+vector<shared_ptr<AnalyzeRecord> > runRecord(const argtype &args,
+  const int nTrials, const int sleep = 0,
+  shared_ptr<AnalysisPipeline> *pipeline = NULL) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  CriteriaWLTMMC c(1., exp(-2.), "nmol", 0, 20);
+  c.collectInit();
+  c.tmmcInit();
+  WLTMMC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+  vector<shared_ptr<AnalyzeRecord> > ans;
+  for (int ia = 0; ia < 3; ++ia) {
+    ans.push_back(make_shared<AnalyzeRecord>(&p, sleep));
+    ans.back()->initFreq(ia + 1);
+    ans.back()->initFreqPrint(100);
+    mc.initAnalyze(ans.back());
+  }
+  if (args.size() != 0) mc.initAnalysisPipeline(args);
+  mc.runNumTrials(nTrials);
+  if (pipeline != NULL) *pipeline = mc.analysisPipeline();
+  return ans;
+}
+
+TEST(AnalysisPipeline, identicalToInline) {
+  vector<shared_ptr<AnalyzeRecord> > inl = runRecord(argtype(), 500);
+  vector<shared_ptr<AnalyzeRecord> > bkg = runRecord(
+    {{"nThreads", "2"}, {"queueSize", "3"}}, 500);
+  for (int ia = 0; ia < 3; ++ia) {
+    EXPECT_EQ(500/(ia + 1), static_cast<int>(inl[ia]->macro.size()));
+    EXPECT_EQ(inl[ia]->macro, bkg[ia]->macro);
+    EXPECT_EQ(inl[ia]->nMol, bkg[ia]->nMol);
+    EXPECT_EQ(inl[ia]->pe, bkg[ia]->pe);
+    EXPECT_EQ(5, bkg[ia]->nWrite);
+  }
+  EXPECT_LT(0, *std::max_element(inl[0]->nMol.begin(), inl[0]->nMol.end()));
+}
+
+// return the Widom averages of grand canonical TMMC, with the analysis
+// pipeline if args is not empty
+vector<double> runWidom(const argtype &args) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  CriteriaWLTMMC c(1., exp(-2.), "nmol", 0, 20);
+  c.collectInit();
+  c.tmmcInit();
+  WLTMMC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+  shared_ptr<AnalyzeWidom> widom = makeAnalyzeWidom(&p, {{"beta", "1."},
+    {"nInsert", "20"}, {"nThreads", "1"}});
+  widom->initFreq(10);
+  widom->initRNG(123);
+  mc.initAnalyze(widom);
+  if (args.size() != 0) mc.initAnalysisPipeline(args);
+  mc.runNumTrials(300);
+  vector<double> sum;
+  for (const Accumulator &acc : widom->boltzmann().vec()) {
+    sum.push_back(acc.sum());
+  }
+  return sum;
+}
+
+// the analyzers keep their random number sequence in the pipeline
+TEST(AnalysisPipeline, widomIdenticalToInline) {
+  const vector<double> inl = runWidom(argtype());
+  const vector<double> bkg = runWidom({{"nThreads", "2"}, {"queueSize", "3"}});
+  ASSERT_EQ(inl.size(), bkg.size());
+  for (unsigned int i = 0; i < inl.size(); ++i) {
+    EXPECT_NEAR(inl[i], bkg[i], 1e-10);
+  }
+  EXPECT_LT(0, std::accumulate(inl.begin(), inl.end(), 0.));
+}
+
+TEST(AnalysisPipeline, dropANDsubsample) {
+  for (const string policy : {"drop", "subsample"}) {
+    shared_ptr<AnalysisPipeline> pipeline;
+    vector<shared_ptr<AnalyzeRecord> > ans = runRecord(
+      {{"policy", policy}, {"queueSize", "2"}}, 200, 1, &pipeline);
+
+    // every update is either analyzed or discarded, and all writes are kept
+    int nUpdate = 0;
+    for (int ia = 0; ia < 3; ++ia) {
+      nUpdate += static_cast<int>(ans[ia]->macro.size());
+      EXPECT_EQ(2, ans[ia]->nWrite);
+    }
+    EXPECT_LT(0, pipeline->nDiscard());
+    EXPECT_EQ(200 + 100 + 66, nUpdate + pipeline->nDiscard());
+  }
+}
+
+TEST(AnalysisPipeline, args) {
+  try {
+    makeAnalysisPipeline({{"policy", "wait"}});
+    CATCH_PHRASE("unrecognized policy");
+  }
+}
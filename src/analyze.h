@@ -123,6 +123,10 @@ class Analyze : public BaseRandom {
   /// Reset object pointers.
   void reconstruct(Pair *pair);
 
+  /// Point to pair without reconstruction, which keeps the random number
+  /// generator and its sequence.
+  void replacePair(Pair *pair) { pair_ = pair; }
+
   /// Return pointer to space from pair.
   Space* space() { return pair_->space(); }
 
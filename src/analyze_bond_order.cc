@@ -0,0 +1,108 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include "./analyze_bond_order.h"
+
+namespace feasst {
+
+AnalyzeBondOrder::AnalyzeBondOrder(Pair *pair, const argtype &args)
+  : Analyze(pair, args) {
+  defaultConstruction_();
+  rCut_ = argparse_.key("rCut").dflt("1.5").dble();
+  argparse_.checkAllArgsUsed();
+}
+
+AnalyzeBondOrder::AnalyzeBondOrder(
+  Pair *pair,
+  const char* fileName)
+    : Analyze(pair, fileName) {
+  defaultConstruction_();
+  rCut_ = fstod("rCut", fileName);
+}
+
+void AnalyzeBondOrder::writeRestart(const char* fileName) {
+  writeRestartBase(fileName);
+  std::ofstream file(fileName, std::ios_base::app);
+  file << "# rCut " << rCut_ << endl;
+}
+
+void AnalyzeBondOrder::defaultConstruction_() {
+  className_.assign("AnalyzeBondOrder");
+  verbose_ = 0;
+}
+
+void AnalyzeBondOrder::update(const int iMacro) {
+  space()->bondOrder(rCut_);
+  q6Global_.accumulate(iMacro, space()->bondOrderQ6Global());
+  const int nMol = space()->nMol();
+  if (nMol > 0) {
+    const vector<double> &q4Mol = space()->bondOrderQ4(),
+                         &q6Mol = space()->bondOrderQ6(),
+                         &w6Mol = space()->bondOrderW6();
+    double q4 = 0., q6 = 0., w6 = 0.;
+    for (int iMol = 0; iMol < nMol; ++iMol) {
+      q4 += q4Mol[iMol];
+      q6 += q6Mol[iMol];
+      w6 += w6Mol[iMol];
+    }
+    q4_.accumulate(iMacro, q4/static_cast<double>(nMol));
+    q6_.accumulate(iMacro, q6/static_cast<double>(nMol));
+    w6_.accumulate(iMacro, w6/static_cast<double>(nMol));
+  }
+}
+
+void AnalyzeBondOrder::write(CriteriaWLTMMC *c) {
+  // initialize output
+  fileBackUp(fileName_.c_str());
+  std::ofstream file(fileName_.c_str());
+  stringstream ss;
+  ss << "# " << c->mType() << " Q6 Q6Stdev q4 q4Stdev q6 q6Stdev w6 w6Stdev"
+     << endl;
+  if (fileName_.empty()) {
+    cout << ss.str();
+  } else {
+    file << ss.str();
+  }
+
+  // print
+  for (int bin = 0; bin < c->nBin(); ++bin) {
+    ss.str("");
+    ss << c->bin2m(bin) << " ";
+    if (q6Global_.size() <= bin) {
+      ss << "-1 -1 -1 -1 -1 -1 -1 -1" << endl;
+    } else {
+      ss << q6Global_.vec(bin).average() << " "
+         << q6Global_.vec(bin).blockStdev() << " ";
+      if (q4_.size() <= bin) {
+        ss << "-1 -1 -1 -1 -1 -1";
+      } else {
+        ss << q4_.vec(bin).average() << " "
+           << q4_.vec(bin).blockStdev() << " "
+           << q6_.vec(bin).average() << " "
+           << q6_.vec(bin).blockStdev() << " "
+           << w6_.vec(bin).average() << " "
+           << w6_.vec(bin).blockStdev();
+      }
+      ss << endl;
+    }
+    if (fileName_.empty()) {
+      cout << ss.str();
+    } else {
+      file << ss.str();
+    }
+  }
+}
+
+shared_ptr<AnalyzeBondOrder> makeAnalyzeBondOrder(Pair *pair,
+  const argtype &args) {
+  return make_shared<AnalyzeBondOrder>(pair, args);
+}
+
+}  // namespace feasst
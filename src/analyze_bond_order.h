@@ -0,0 +1,94 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef ANALYZE_BOND_ORDER_H_
+#define ANALYZE_BOND_ORDER_H_
+
+#include "./analyze.h"
+
+namespace feasst {
+
+/**
+ * Compute Steinhardt bond orientational order parameters of the first atom
+ * in each molecule, as described in Space::bondOrder.
+ * For each macrostate, accumulate the global Q6 and the molecule averages
+ * of the local q4, q6 and w6.
+ */
+class AnalyzeBondOrder : public Analyze {
+ public:
+  /**
+   * Constructor
+   *
+   * args:
+   * - rCut: neighbor cut-off distance (default: 1.5).
+   */
+  AnalyzeBondOrder(Pair *pair, const argtype &args = argtype());
+
+  /// Return the neighbor cut-off distance.
+  double rCut() const { return rCut_; }
+
+  // update analysis every nFreq
+  void update() { update(0); }
+  void update(const int iMacro);
+
+  // print
+  void write(CriteriaWLTMMC *c);
+
+  /// Return the global Q6.
+  AccumulatorVec q6Global() const { return q6Global_; }
+
+  /// Return the average local q4.
+  AccumulatorVec q4() const { return q4_; }
+
+  /// Return the average local q6.
+  AccumulatorVec q6() const { return q6_; }
+
+  /// Return the average local w6.
+  AccumulatorVec w6() const { return w6_; }
+
+  /// Write restart file.
+  void writeRestart(const char* fileName);
+
+  /// Construct from restart file.
+  AnalyzeBondOrder(Pair *pair, const char* fileName);
+
+  ~AnalyzeBondOrder() {}
+  AnalyzeBondOrder* clone(Pair* pair) const {
+    AnalyzeBondOrder* a = new AnalyzeBondOrder(*this);
+    a->reconstruct(pair); return a;
+  }
+  shared_ptr<AnalyzeBondOrder> cloneShrPtr(Pair* pair) const {
+    return(std::static_pointer_cast<AnalyzeBondOrder, Analyze>(cloneImpl(
+      pair)));
+  }
+
+ protected:
+  double rCut_;               //!< neighbor cut-off distance
+  AccumulatorVec q6Global_;   //!< global Q6
+  AccumulatorVec q4_;         //!< average local q4
+  AccumulatorVec q6_;         //!< average local q6
+  AccumulatorVec w6_;         //!< average local w6
+
+  void defaultConstruction_();
+
+  // clone design pattern
+  virtual shared_ptr<Analyze> cloneImpl(Pair *pair) const {
+    shared_ptr<AnalyzeBondOrder> a = make_shared<AnalyzeBondOrder>(*this);
+    a->reconstruct(pair); return a;
+  }
+};
+
+/// Factory method
+shared_ptr<AnalyzeBondOrder> makeAnalyzeBondOrder(Pair *pair,
+  const argtype &args = argtype());
+
+}  // namespace feasst
+
+#endif  // ANALYZE_BOND_ORDER_H_
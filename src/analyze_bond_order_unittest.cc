@@ -0,0 +1,62 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include "mc_wltmmc.h"
+#include "pair_lj.h"
+#include "analyze_bond_order.h"
+#include "trial_transform.h"
+#include "ui_abbreviated.h"
+
+using namespace feasst;
+
+TEST(AnalyzeBondOrder, Q6macrostate) {
+  Space s(3, {{"boxLength", "6"}});
+  PairLJ p(&s, {{"rCut", "2.5"}, {"molTypeInForcefield", "data.lj"}});
+  {
+    CriteriaMetropolis cMet(1./1.5, exp(-3));
+    MC mc(&s, &p, &cMet);
+    transformTrial(&mc, "translate", 0.5);
+    mc.nMolSeek(50);
+  }
+  CriteriaWLTMMC c(1./1.5, {{"mType", "Q6"}, {"orderRCut", "1.5"},
+    {"mMin", "0"}, {"mMax", "1"}, {"nBin", "10"}});
+  EXPECT_EQ(1.5, c.orderRCut());
+  WLTMMC mc(&s, &p, &c);
+  transformTrial(&mc, "translate", 0.5);
+  shared_ptr<AnalyzeBondOrder> bo = makeAnalyzeBondOrder(&p,
+    {{"rCut", "1.5"}, {"nFreq", "10"}, {"fileName", "tmp/q6bond"}});
+  mc.initAnalyze(bo);
+  mc.runNumTrials(500);
+
+  // the macrostate follows the global Q6 of the configuration, which is
+  // cached from the last trial
+  EXPECT_GT(bo->q6Global().size(), 0);
+  c.store(&p);
+  EXPECT_NEAR(s.Q6(1.5), c.mOld(), 1e-12);
+  EXPECT_NEAR(s.Q6(1.5), c.bin2m(c.bin(s.Q6(1.5))), 0.5*c.mBin());
+
+  // a configuration change outside of a trial, with the same energy and
+  // number of molecules, is not hidden by the cache
+  const double q6Old = s.Q6(1.5);
+  s.transMol(0, {1.3, 0., 0.});
+  EXPECT_NE(q6Old, s.Q6(1.5));
+  c.store(&p);
+  EXPECT_NEAR(s.Q6(1.5), c.mOld(), 1e-12);
+
+  // restart
+  c.writeRestart("tmp/q6critrst");
+  CriteriaWLTMMC c2("tmp/q6critrst");
+  EXPECT_EQ(1.5, c2.orderRCut());
+  EXPECT_EQ("Q6", c2.mType());
+  bo->writeRestart("tmp/q6bondrst");
+  AnalyzeBondOrder bo2(&p, "tmp/q6bondrst");
+  EXPECT_EQ(1.5, bo2.rCut());
+}
@@ -147,7 +147,7 @@ void AnalyzeCluster::update(const int iMacro) {
   // cout << "updated " << iMacro << endl;
 
   // test for percolation
-  ASSERT( (percFlag_ >= 0) && (percFlag_ <= 2),
+  ASSERT( (percFlag_ >= 0) && (percFlag_ <= 3),
     "unrecognized percolation flag: " << percFlag_);
   if (percFlag_ == 1) {
     // replicate the system in each dimension
@@ -171,6 +171,8 @@ void AnalyzeCluster::update(const int iMacro) {
       << "assumes that the contact list is in the compact form, as only"
       << "implemented in PairTabular (current 4/28/2017)");
     percolation_.accumulate(iMacro, space()->percolation());
+  } else if (percFlag_ == 3) {
+    percolation_.accumulate(iMacro, space()->percolation());
   }
 }
 
@@ -222,17 +224,16 @@ void AnalyzeCluster::write(CriteriaWLTMMC *c) {
          << pcos_.vec(bin).blockStdev() << " ";
 
       // compute and print nematic order parameter
-      vector<vector<double> > mat, evectors;
-      mat.resize(3, vector<double>(3));
-      vector<double> evalues;
+      double mat[9] = {0.};
       for (int idim = 0; idim < space()->dimen(); ++idim) {
         for (int jdim = 0; jdim < space()->dimen(); ++jdim) {
-          mat[idim][jdim] = 3.*nematic_[idim][jdim].vec(bin).average()*0.5;
-          if (idim == jdim) mat[idim][jdim] -= 0.5;
+          mat[3*idim + jdim] = 3.*nematic_[idim][jdim].vec(bin).average()*0.5;
+          if (idim == jdim) mat[3*idim + jdim] -= 0.5;
         }
       }
-// HWH: ASSERT(jacobi(mat, evalues, evectors) != 1, "jacobi error");
-      const double maxEigen = *std::max_element(evalues.begin(), evalues.end());
+      double evalues[3];
+      symEigenvalues3(mat, evalues);
+      const double maxEigen = evalues[2];
       ss << maxEigen << " ";
       ss << endl;
     }
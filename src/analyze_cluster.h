@@ -47,7 +47,8 @@ class AnalyzeCluster : public Analyze {
     const int percFlag = 0
     /**< if "0", no computation.
          if "1", use expanding box (slow).
-         if "2", use contact map. */
+         if "2", use contact map.
+         if "3", use periodic images from the distance-based clusters. */
     ) { percFlag_ = percFlag; }
 
   /// Return the number of clusters
@@ -8,6 +8,9 @@
  * appropriate acknowledgments of NIST's creation of the data/software.
  */
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif  // _OPENMP
 #include "./analyze_scatter.h"
 
 namespace feasst {
@@ -30,9 +33,31 @@ AnalyzeScatter::AnalyzeScatter(
   if (!strtmp.empty()) {
     nMomentsCut_ = stoi(strtmp);
   }
+  double rMaxTmp = 0.;
+  strtmp = fstos("rMaxRadial", fileName);
+  if (!strtmp.empty()) {
+    rMaxTmp = stod(strtmp);
+  }
 
   // cout << "nm " << nMacrosTmp << endl;
-  initSANS(dgrTmp, nMacrosTmp);
+  initSANS(dgrTmp, nMacrosTmp, rMaxTmp);
+  strtmp = fstos("sfKmax", fileName);
+  if (!strtmp.empty()) {
+    initStructureFactor(stoi(strtmp));
+    const int nBins = static_cast<int>(sfSum_.size()/countConf_.size());
+    for (unsigned int iMacro = 0; iMacro < countConf_.size(); ++iMacro) {
+      stringstream ss;
+      ss << "sfSum" << iMacro;
+      stringstream sfSum(fstos(ss.str().c_str(), fileName));
+      ss.str("");
+      ss << "sfCount" << iMacro;
+      stringstream sfCount(fstos(ss.str().c_str(), fileName));
+      for (int bin = 0; bin < nBins; ++bin) {
+        sfSum >> sfSum_[iMacro*nBins + bin];
+        sfCount >> sfCount_[iMacro*nBins + bin];
+      }
+    }
+  }
 
   // cout << " open file and skip header lines" << endl;
   std::ifstream fs(fileName);
@@ -49,33 +74,31 @@ AnalyzeScatter::AnalyzeScatter(
     for (int bin = 0; bin < nbins_; ++bin) {
       double r;
       fs >> r;
-      for (unsigned int iType = 0; iType < histInter2_[iMacro].size();
-           ++iType) {
-        for (unsigned int jType = iType; jType < histInter2_[iMacro][0].size();
-             ++jType) {
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
           int hval;
           fs >> hval;
-          histInter2_[iMacro][iType][jType][bin] = hval;
-          histInter2_[iMacro][jType][iType][bin] =
-            histInter2_[iMacro][iType][jType][bin];
+          histInter_[histIndex_(iMacro, iType, jType, bin)] = hval;
+          histInter_[histIndex_(iMacro, jType, iType, bin)] = hval;
         }
       }
-      for (unsigned int iType = 0; iType < histIntra2_[iMacro].size();
-           ++iType) {
-        for (unsigned int jType = iType; jType < histIntra2_[iMacro][0].size();
-             ++jType) {
-          fs >> histIntra2_[iMacro][iType][jType][bin];
-          histIntra2_[iMacro][jType][iType][bin] =
-            histIntra2_[iMacro][iType][jType][bin];
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
+          long long hval;
+          fs >> hval;
+          histIntra_[histIndex_(iMacro, iType, jType, bin)] = hval;
+          histIntra_[histIndex_(iMacro, jType, iType, bin)] = hval;
         }
       }
-      for (unsigned int iType = 0; iType < histMoments_.size(); ++iType) {
-        for (unsigned int jType = iType; jType < histMoments_[0].size();
-             ++jType) {
-          for (int iMo = iType; iMo < nMomentsCut_; ++iMo) {
-            fs >> histMoments_[iMacro][iType][jType][iMo][bin];
-            histMoments_[iMacro][jType][iType][iMo][bin] =
-              histMoments_[iMacro][iType][jType][iMo][bin];
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
+          for (int iMo = 0; iMo < nMomentsCut_; ++iMo) {
+            double hval;
+            fs >> hval;
+            const int ij = histIndex_(iMacro, iType, jType, 0),
+                      ji = histIndex_(iMacro, jType, iType, 0);
+            histMoments_[nMomentsCut_*ij + iMo*nbins_ + bin] = hval;
+            histMoments_[nMomentsCut_*ji + iMo*nbins_ + bin] = hval;
           }
         }
       }
@@ -91,50 +114,69 @@ void AnalyzeScatter::writeRestart(const char* fileName, const int iMacro) {
   file << "# dgrRadialBinDist " << dgr_ << endl;
   file << "# nMacros " << countConf_.size() << endl;
   if (nMomentsCut_ != 0) file << "# nMomentsCut " << nMomentsCut_ << endl;
+  file << "# rMaxRadial " << MAX_PRECISION << rMax_ << endl;
+  if (sfKmax_ != 0) file << "# sfKmax " << sfKmax_ << endl;
   for (unsigned int im = 0; im < countConf_.size(); ++im) {
     if ( (iMacro == -1) || (static_cast<int>(im) == iMacro) ) {
       file << "# countConf" << im << " " << countConf_[im] << endl;
     }
   }
+  if (sfKmax_ != 0) {
+    const int nBins = static_cast<int>(sfSum_.size()/countConf_.size());
+    for (unsigned int im = 0; im < countConf_.size(); ++im) {
+      if ( (iMacro == -1) || (static_cast<int>(im) == iMacro) ) {
+        file << "# sfSum" << im;
+        for (int bin = 0; bin < nBins; ++bin) {
+          file << " " << sfSum_[im*nBins + bin];
+        }
+        file << endl << "# sfCount" << im;
+        for (int bin = 0; bin < nBins; ++bin) {
+          file << " " << sfCount_[im*nBins + bin];
+        }
+        file << endl;
+      }
+    }
+  }
   for (unsigned int im = 0; im < countConf_.size(); ++im) {
     if ( (iMacro == -1) || (static_cast<int>(im) == iMacro) ) {
       file << "#r ";
-      for (unsigned int iType = 0; iType < histInter2_[im].size(); ++iType) {
-        for (unsigned int jType = iType; jType < histInter2_[im][0].size(); ++jType) {
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
           file << "interi" << iType << "j" << jType << " ";
         }
       }
-      for (unsigned int iType = 0; iType < histIntra2_[im].size(); ++iType) {
-        for (unsigned int jType = iType; jType < histIntra2_[im][0].size(); ++jType) {
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
           file << "intrai" << iType << "j" << jType << " ";
         }
       }
-      for (unsigned int iType = 0; iType < histMoments_[im].size(); ++iType) {
-        for (unsigned int jType = iType; jType < histMoments_[im][0].size(); ++jType) {
+      for (int iType = 0; iType < nTypes_; ++iType) {
+        for (int jType = iType; jType < nTypes_; ++jType) {
           for (int iMo = 0; iMo < nMomentsCut_; ++iMo) {
             file << "hi" << iType << "j" << jType << "m" << iMo << " ";
           }
         }
       }
       file << endl;
-      vector<vector<vector<long long> > > &hist = histInter2_[im];
       for (int bin = 0; bin < nbins_; ++bin) {
         const double r = dgr_*(bin + 0.5);
         file << r << " ";
-        for (unsigned int iType = 0; iType < hist.size(); ++iType) {
-          for (unsigned int jType = iType; jType < hist[0].size(); ++jType) {
-            file << histInter2_[im][iType][jType][bin] << " ";
+        for (int iType = 0; iType < nTypes_; ++iType) {
+          for (int jType = iType; jType < nTypes_; ++jType) {
+            file << histInter_[histIndex_(im, iType, jType, bin)] << " ";
           }
         }
-        for (unsigned int iType = 0; iType < hist.size(); ++iType) {
-          for (unsigned int jType = iType; jType < hist[0].size(); ++jType) {
-            file << histIntra2_[im][iType][jType][bin] << " ";
+        for (int iType = 0; iType < nTypes_; ++iType) {
+          for (int jType = iType; jType < nTypes_; ++jType) {
+            file << histIntra_[histIndex_(im, iType, jType, bin)] << " ";
           }
         }
-        for (unsigned int iType = 0; iType < histMoments_[im].size(); ++iType) {
-          for (unsigned int jType = iType; jType < histMoments_[im][0].size(); ++jType) {
-            for (unsigned int iMo = 0; iMo < histMoments_[im][0][0].size(); ++iMo) {
-              file << histMoments_[im][iType][jType][iMo][bin] << " ";
+        for (int iType = 0; iType < nTypes_; ++iType) {
+          for (int jType = iType; jType < nTypes_; ++jType) {
+            const int ij = histIndex_(im, iType, jType, 0);
+            for (int iMo = 0; iMo < nMomentsCut_; ++iMo) {
+              file << histMoments_[nMomentsCut_*ij + iMo*nbins_ + bin]
+                   << " ";
             }
           }
         }
@@ -148,16 +190,25 @@ void AnalyzeScatter::defaultConstruction_() {
   className_.assign("AnalyzeScatter");
   nMomentsCut_ = 0;
   verbose_ = 0;
+  rMax_ = 0.;
+  nTypes_ = 0;
+  sfKmax_ = 0;
+  sfDq_ = 0.;
 }
 
 void AnalyzeScatter::initSANS(
   const double dgr,
-  const int nMacros
+  const int nMacros,
+  const double rMax
   ) {
   countConf_.resize(nMacros, 0.);
   dgr_ = dgr;
-  nbins_ = static_cast<int>((space()->minl()/2-10*DTOL)/dgr_) + 1;
-  qbins_ = static_cast<int>(nbins_)+1;
+  rMax_ = rMax;
+  if (rMax_ <= 0.) rMax_ = space()->minl()/2.;
+  ASSERT(rMax_ <= space()->minl()/2. + DTOL, "rMax(" << rMax_ << ") cannot "
+    << "exceed half of the minimum box length(" << space()->minl() << ")");
+  nbins_ = static_cast<int>((rMax_-10*DTOL)/dgr_) + 1;
+  qbins_ = static_cast<int>((space()->minl()/2-10*DTOL)/dgr_) + 2;
   // qbins_ = static_cast<int>(nbins_*10)+1;
   if (qbins_ > 500) qbins_ = 500;
   iqm_.resize(nMacros, vector<double>(qbins_, 0.));
@@ -181,16 +232,11 @@ void AnalyzeScatter::initSANS(
   }
 
   // initialize histograms
-  histInter2_.resize(nMacros, vector<vector<vector<long long> > >(
-    nPartTypes_(), vector<vector<long long> >(
-      nPartTypes_(), vector<long long>(nbins_))));
-  histIntra2_.resize(nMacros, vector<vector<vector<long long> > >(
-    nPartTypes_(), vector<vector<long long> >(
-      nPartTypes_(), vector<long long>(nbins_))));
-  histMoments_.resize(nMacros, vector<vector<vector<vector<double> > > >(
-    nPartTypes_(), vector<vector<vector<double> > >(
-      nPartTypes_(), vector<vector<double> >(
-        nMomentsCut_, vector<double>(nbins_)))));
+  nTypes_ = nPartTypes_();
+  const int nHist = nMacros*nTypes_*nTypes_*nbins_;
+  histInter_.assign(nHist, 0);
+  histIntra_.assign(nHist, 0);
+  histMoments_.assign(nHist*nMomentsCut_, 0.);
 }
 
 void AnalyzeScatter::update(const int iMacro) {
@@ -200,88 +246,287 @@ void AnalyzeScatter::update(const int iMacro) {
   const vector<int> mol = space()->mol();
   const vector<double> x = space()->x();
   const int natom = space()->natom();
-  const double minl = space()->minl();
   const int dimen = space()->dimen();
-
-  double lx = l[0], ly = 0, lz = 0, halflx = lx/2., halfly = 0, halflz = 0,
-    dx = 0, dy = 0, dz = 0, xi = 0, yi = 0, zi = 0, r2 = 0;
-  if (dimen >= 2) ly = l[1], halfly = ly/2.;
-  if (dimen >= 3) lz = l[2], halflz = lz/2.;
-  for (int ipart = 0; ipart < natom-1; ++ipart) {
-    const int iType = type[ipart];
-    const int iMol = mol[ipart];
-    xi = x[dimen*ipart];
-    if (dimen >= 2) yi = x[dimen*ipart+1];
-    if (dimen >= 3) zi = x[dimen*ipart+2];
-    for (int jpart = ipart + 1; jpart < natom; ++jpart) {
-      const int jMol = mol[jpart];
-      if (iMol != jMol) {
-        const int jType = type[jpart];
-        dx = xi - x[dimen*jpart];
-        if (dx >  halflx) dx -= lx;
-        if (dx < -halflx) dx += lx;
-        if (dimen >= 2) {
-          dy = yi - x[dimen*jpart+1];
-          if (dy >  halfly) dy -= ly;
-          if (dy < -halfly) dy += ly;
+  ASSERT(dimen <= 3, "AnalyzeScatter not implemented for dimen: " << dimen);
+
+  // bin the sites into cells at least as wide as rMax. If the domain is too
+  // small for three cells in each dimension, use only one cell.
+  int nCellVec[3] = {1, 1, 1};
+  bool useCells = true;
+  for (int dim = 0; dim < dimen; ++dim) {
+    nCellVec[dim] = static_cast<int>(l[dim]/rMax_);
+    if (nCellVec[dim] < 3) useCells = false;
+  }
+  if (!useCells) nCellVec[0] = nCellVec[1] = nCellVec[2] = 1;
+  const int nCell = nCellVec[0]*nCellVec[1]*nCellVec[2];
+  cellStart_.assign(nCell + 1, 0);
+  cellOfAtom_.resize(natom);
+  for (int i = 0; i < natom; ++i) {
+    int cell = 0;
+    for (int dim = dimen - 1; dim >= 0; --dim) {
+      double f = x[dimen*i + dim]/l[dim] + 0.5;
+      f -= floor(f);
+      const int c = std::min(static_cast<int>(f*nCellVec[dim]),
+                             nCellVec[dim] - 1);
+      cell = cell*nCellVec[dim] + c;
+    }
+    cellOfAtom_[i] = cell;
+    ++cellStart_[cell + 1];
+  }
+  for (int cell = 0; cell < nCell; ++cell) {
+    cellStart_[cell + 1] += cellStart_[cell];
+  }
+  cellAtoms_.resize(natom);
+  for (int i = 0; i < natom; ++i) {
+    cellAtoms_[cellStart_[cellOfAtom_[i]]++] = i;
+  }
+  for (int cell = nCell; cell > 0; --cell) {
+    cellStart_[cell] = cellStart_[cell - 1];
+  }
+  cellStart_[0] = 0;
+
+  // half stencil of neighboring cells, such that each pair is visited once
+  int stencil[13][3], nStencil = 0;
+  if (useCells) {
+    for (int dz = 0; dz <= ( (dimen == 3) ? 1 : 0); ++dz) {
+      for (int dy = ( (dimen >= 2) ? -1 : 0); dy <= ( (dimen >= 2) ? 1 : 0);
+           ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          if ( (dz > 0) || ( (dz == 0) && (dy > 0) ) ||
+               ( (dz == 0) && (dy == 0) && (dx > 0) ) ) {
+            stencil[nStencil][0] = dx;
+            stencil[nStencil][1] = dy;
+            stencil[nStencil][2] = dz;
+            ++nStencil;
+          }
         }
-        if (dimen >= 3) {
-          dz = zi - x[dimen*jpart+2];
-          if (dz >  halflz) dz -= lz;
-          if (dz < -halflz) dz += lz;
+      }
+    }
+  }
+
+  // histogram the pair distances, distributing cells among threads which
+  // each store the intermolecular and then the intramolecular histogram
+  int nThreads = 1;
+  #ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+  #endif  // _OPENMP
+  const int nPair = nTypes_*nTypes_*nbins_;
+  histThread_.resize(nThreads);
+  const double rMax2 = rMax_*rMax_;
+  #ifdef _OPENMP
+  #pragma omp parallel num_threads(nThreads)
+  #endif  // _OPENMP
+  {
+    int thread = 0;
+    #ifdef _OPENMP
+      thread = omp_get_thread_num();
+    #endif  // _OPENMP
+    histThread_[thread].assign(2*nPair, 0);
+    long long *inter = &histThread_[thread][0], *intra = inter + nPair;
+    #ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+    #endif  // _OPENMP
+    for (int iCell = 0; iCell < nCell; ++iCell) {
+      const int icx = iCell % nCellVec[0],
+                icy = (iCell/nCellVec[0]) % nCellVec[1],
+                icz = iCell/(nCellVec[0]*nCellVec[1]);
+      for (int s = -1; s < nStencil; ++s) {
+        int jCell = iCell;
+        if (s >= 0) {
+          const int jcx = (icx + stencil[s][0] + nCellVec[0]) % nCellVec[0],
+                    jcy = (icy + stencil[s][1] + nCellVec[1]) % nCellVec[1],
+                    jcz = (icz + stencil[s][2] + nCellVec[2]) % nCellVec[2];
+          jCell = (jcz*nCellVec[1] + jcy)*nCellVec[0] + jcx;
         }
-        r2 = dx*dx + dy*dy + dz*dz;
-        const double r = sqrt(r2);
-        if (r <= 0.5*minl) {
-          const int bin = feasstRound(r/dgr_ - 0.5);
-          histInter2_[iMacro][iType][jType][bin]++;
-          histInter2_[iMacro][jType][iType][bin]++;
-
-          // moments
-          double peMoment = 1.;
-          for (int iMo = 0; iMo < nMomentsCut_; ++iMo) {
-            histMoments_[iMacro][iType][jType][iMo][bin] += peMoment;
-            histMoments_[iMacro][jType][iType][iMo][bin] += peMoment;
-            peMoment *= pair_->peTot();
+        for (int ii = cellStart_[iCell]; ii < cellStart_[iCell + 1]; ++ii) {
+          const int ipart = cellAtoms_[ii];
+          const int iType = type[ipart];
+          int jjBegin = cellStart_[jCell];
+          if (s == -1) jjBegin = ii + 1;
+          for (int jj = jjBegin; jj < cellStart_[jCell + 1]; ++jj) {
+            const int jpart = cellAtoms_[jj];
+            double r2 = 0.;
+            for (int dim = 0; dim < dimen; ++dim) {
+              double dx = x[dimen*ipart + dim] - x[dimen*jpart + dim];
+              if (dx >  0.5*l[dim]) dx -= l[dim];
+              if (dx < -0.5*l[dim]) dx += l[dim];
+              r2 += dx*dx;
+            }
+            if (r2 <= rMax2) {
+              const int bin = static_cast<int>(sqrt(r2)/dgr_);
+              if (bin < nbins_) {
+                const int jType = type[jpart];
+                long long *hist = (mol[ipart] == mol[jpart]) ? intra : inter;
+                ++hist[(iType*nTypes_ + jType)*nbins_ + bin];
+                ++hist[(jType*nTypes_ + iType)*nbins_ + bin];
+              }
+            }
           }
         }
       }
     }
   }
 
-  // intramolecular term
-  const vector<int> mol2part = space()->mol2part();
-  for (int iMol = 0; iMol < space()->nMol(); ++iMol) {
-    for (int ipart = mol2part[iMol]; ipart < mol2part[iMol+1]-1; ++ipart) {
-      const int iType = type[ipart];
-      xi = x[dimen*ipart];
-      if (dimen >= 2) yi = x[dimen*ipart+1];
-      if (dimen >= 3) zi = x[dimen*ipart+2];
-      for (int jpart = ipart+1; jpart < mol2part[iMol+1]; ++jpart) {
-        const int jType = type[jpart];
-        dx = xi - x[dimen*jpart];
-        if (dx >  halflx) dx -= lx;
-        if (dx < -halflx) dx += lx;
-        if (dimen >= 2) {
-          dy = yi - x[dimen*jpart+1];
-          if (dy >  halfly) dy -= ly;
-          if (dy < -halfly) dy += ly;
-        }
-        if (dimen >= 3) {
-          dz = zi - x[dimen*jpart+2];
-          if (dz >  halflz) dz -= lz;
-          if (dz < -halflz) dz += lz;
+  // reduce the thread histograms. The moments of the intermolecular
+  // histogram are weighted by powers of the energy of this configuration.
+  vector<double> peMoment(nMomentsCut_, 1.);
+  if (nMomentsCut_ > 1) {
+    const double pe = pair_->peTot();
+    for (int iMo = 1; iMo < nMomentsCut_; ++iMo) {
+      peMoment[iMo] = peMoment[iMo - 1]*pe;
+    }
+  }
+  const int index0 = histIndex_(iMacro, 0, 0, 0);
+  for (int ij = 0; ij < nTypes_*nTypes_; ++ij) {
+    for (int bin = 0; bin < nbins_; ++bin) {
+      const int index = ij*nbins_ + bin;
+      long long nInter = 0, nIntra = 0;
+      for (int thread = 0; thread < nThreads; ++thread) {
+        nInter += histThread_[thread][index];
+        nIntra += histThread_[thread][nPair + index];
+      }
+      histInter_[index0 + index] += nInter;
+      histIntra_[index0 + index] += nIntra;
+      for (int iMo = 0; iMo < nMomentsCut_; ++iMo) {
+        histMoments_[nMomentsCut_*(index0 + ij*nbins_) + iMo*nbins_ + bin] +=
+          nInter*peMoment[iMo];
+      }
+    }
+  }
+
+  if (sfKmax_ > 0) updateStructureFactor_(iMacro);
+}
+
+void AnalyzeScatter::initStructureFactor(const int kMax) {
+  ASSERT(space()->dimen() == 3, "structure factor assumes 3D");
+  ASSERT(kMax > 0, "kMax(" << kMax << ") must be positive");
+  ASSERT(countConf_.size() > 0, "initSANS before initStructureFactor");
+  sfKmax_ = kMax;
+
+  // reciprocal lattice vectors in the half space, as k and -k are equivalent
+  sfMode_.clear();
+  for (int nx = 0; nx <= kMax; ++nx) {
+    for (int ny = -kMax; ny <= kMax; ++ny) {
+      for (int nz = -kMax; nz <= kMax; ++nz) {
+        if ( (nx*nx + ny*ny + nz*nz <= kMax*kMax) &&
+             ( (nx > 0) || ( (nx == 0) && (ny > 0) ) ||
+               ( (nx == 0) && (ny == 0) && (nz > 0) ) ) ) {
+          sfMode_.push_back(nx);
+          sfMode_.push_back(ny);
+          sfMode_.push_back(nz);
         }
-        r2 = dx*dx + dy*dy + dz*dz;
-        const double r = sqrt(r2);
-        if (r <= 0.5*minl) {
-          const int bin = feasstRound(r/dgr_ - 0.5);
-          histIntra2_[iMacro][iType][jType][bin]++;
-          histIntra2_[iMacro][jType][iType][bin]++;
+      }
+    }
+  }
+  const vector<double> l = space()->boxLength();
+  sfDq_ = 2.*PI/(*std::max_element(l.begin(), l.end()));
+  const int nBins = static_cast<int>(2.*PI*kMax/space()->minl()/sfDq_ + 0.5)
+                  + 1;
+  sfSum_.assign(countConf_.size()*nBins, 0.);
+  sfCount_.assign(countConf_.size()*nBins, 0);
+}
+
+void AnalyzeScatter::updateStructureFactor_(const int iMacro) {
+  const int natom = space()->natom();
+  if (natom == 0) return;
+  const vector<double> l = space()->boxLength();
+  const vector<double> x = space()->x();
+  const int nModes = static_cast<int>(sfMode_.size())/3;
+  sfModeSq_.resize(nModes);
+  // compute exp(i 2pi n x/L) of each site by recursion
+  const int nk = sfKmax_ + 1;
+  eikr_.resize(3*natom*nk);
+  eiki_.resize(3*natom*nk);
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif  // _OPENMP
+  for (int i = 0; i < natom; ++i) {
+    for (int dim = 0; dim < 3; ++dim) {
+      const int k0 = (3*i + dim)*nk;
+      const double a = 2.*PI*x[3*i + dim]/l[dim];
+      eikr_[k0] = 1.;
+      eiki_[k0] = 0.;
+      eikr_[k0 + 1] = cos(a);
+      eiki_[k0 + 1] = sin(a);
+      for (int k = 2; k < nk; ++k) {
+        eikr_[k0 + k] = eikr_[k0 + k - 1]*eikr_[k0 + 1]
+                      - eiki_[k0 + k - 1]*eiki_[k0 + 1];
+        eiki_[k0 + k] = eikr_[k0 + k - 1]*eiki_[k0 + 1]
+                      + eiki_[k0 + k - 1]*eikr_[k0 + 1];
+      }
+    }
+  }
+
+  // sum over the sites for each mode
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif  // _OPENMP
+  for (int mode = 0; mode < nModes; ++mode) {
+    const int *n = &sfMode_[3*mode];
+    double rhor = 0., rhoi = 0.;
+    for (int i = 0; i < natom; ++i) {
+      double er = 1., ei = 0.;
+      for (int dim = 0; dim < 3; ++dim) {
+        const int k = (3*i + dim)*nk + abs(n[dim]);
+        const double kr = eikr_[k], ki = (n[dim] < 0) ? -eiki_[k] : eiki_[k],
+                     tmp = er*kr - ei*ki;
+        ei = er*ki + ei*kr;
+        er = tmp;
+      }
+      rhor += er;
+      rhoi += ei;
+    }
+    sfModeSq_[mode] = rhor*rhor + rhoi*rhoi;
+  }
+
+  // average the modes in each bin
+  const int nBins = static_cast<int>(sfSum_.size()/countConf_.size());
+  for (int mode = 0; mode < nModes; ++mode) {
+    double q2 = 0.;
+    for (int dim = 0; dim < 3; ++dim) {
+      q2 += pow(2.*PI*sfMode_[3*mode + dim]/l[dim], 2);
+    }
+    const int bin = static_cast<int>(sqrt(q2)/sfDq_ + 0.5);
+    if (bin < nBins) {
+      sfSum_[iMacro*nBins + bin] += sfModeSq_[mode]/static_cast<double>(natom);
+      ++sfCount_[iMacro*nBins + bin];
+    }
+  }
+}
+
+vector<double> AnalyzeScatter::sqWave() const {
+  vector<double> q(sfSum_.size()/countConf_.size());
+  for (unsigned int bin = 0; bin < q.size(); ++bin) {
+    q[bin] = sfDq_*bin;
+  }
+  return q;
+}
+
+vector<double> AnalyzeScatter::sq(const int iMacro) const {
+  vector<double> sq(sfSum_.size()/countConf_.size(), 0.);
+  for (unsigned int bin = 0; bin < sq.size(); ++bin) {
+    const int index = iMacro*sq.size() + bin;
+    if (sfCount_[index] > 0) sq[bin] = sfSum_[index]/sfCount_[index];
+  }
+  return sq;
+}
+
+vector<vector<vector<vector<long long> > > > AnalyzeScatter::unflatten_(
+  const vector<long long> &hist) const {
+  vector<vector<vector<vector<long long> > > > nested(countConf_.size(),
+    vector<vector<vector<long long> > >(nTypes_,
+      vector<vector<long long> >(nTypes_, vector<long long>(nbins_))));
+  for (unsigned int iMacro = 0; iMacro < countConf_.size(); ++iMacro) {
+    for (int iType = 0; iType < nTypes_; ++iType) {
+      for (int jType = 0; jType < nTypes_; ++jType) {
+        for (int bin = 0; bin < nbins_; ++bin) {
+          nested[iMacro][iType][jType][bin] =
+            hist[histIndex_(iMacro, iType, jType, bin)];
         }
       }
     }
   }
+  return nested;
 }
 
 void AnalyzeScatter::computeSANS(const int iMacro,
@@ -315,11 +560,11 @@ void AnalyzeScatter::computeSANS(const int iMacro,
           double normFacIn;
           normFacIn = static_cast<double>(nMol);
           Iq1 += Pq_[k][iType]*Pq_[k][jType]*
-            histIntra2_[iMacro][iType][jType][bin]*sqrinvqr/normFacIn
-              /static_cast<double>(countConf_[iMacro]);
+            histIntra_[histIndex_(iMacro, iType, jType, bin)]*sqrinvqr
+              /normFacIn/static_cast<double>(countConf_[iMacro]);
           Iq2 += Pq_[k][iType]*Pq_[k][jType]
-            *histInter2_[iMacro][iType][jType][bin]*sqrinvqr/normFacIn
-              /static_cast<double>(countConf_[iMacro]);
+            *histInter_[histIndex_(iMacro, iType, jType, bin)]*sqrinvqr
+              /normFacIn/static_cast<double>(countConf_[iMacro]);
           Iq3 += Pq_[k][iType]*Pq_[k][jType]*nid*sqrinvqr;
         }
       }
@@ -369,6 +614,20 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
   // std::ofstream file2(ss.str().c_str());
   writeRestart(ss.str().c_str(), iMacro);
 
+  // print the structure factor
+  if (sfKmax_ > 0) {
+    ss.str("");
+    ss << fileName << "sq";
+    std::ofstream file6(ss.str().c_str());
+    const vector<double> q = sqWave(), sqm = sq(iMacro);
+    file6 << "#q Sq" << endl;
+    for (unsigned int bin = 0; bin < q.size(); ++bin) {
+      if (sfCount_[iMacro*q.size() + bin] > 0) {
+        file6 << q[bin] << " " << sqm[bin] << endl;
+      }
+    }
+  }
+
   // obtain the number of molecules
   int nMol = -1;
   if (c != NULL) {
@@ -381,7 +640,7 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
     nMol = space()->nMol();
   }
 
-  const int maxBins = static_cast<int>(space()->minl()/2./dgr_);
+  const int maxBins = static_cast<int>(rMax_/dgr_);
 
   // compute and print radial distribution functions
   ss.str("");
@@ -389,9 +648,8 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
   std::ofstream file5(ss.str().c_str());
   ss.str("");
   ss << "#r ";
-  vector<vector<vector<long long> > > &hist = histInter2_[iMacro];
-  vector<vector<vector<double> > > gr(hist.size(), vector<vector<double> >(
-    hist[0].size(), vector<double>(maxBins, 0.)));
+  vector<vector<vector<double> > > gr(nTypes_, vector<vector<double> >(
+    nTypes_, vector<double>(maxBins, 0.)));
   for (int bin = 0; bin < maxBins; ++bin) {
     ss.str("");
     const double r = dgr_*(bin + 0.5),
@@ -400,13 +658,14 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
       dv = 4./3.*PI*(pow(rmax, space()->dimen())-pow(rmin,
         space()->dimen()))/space()->volume();
     ss << r << " ";
-    for (unsigned int iType = 0; iType < hist.size(); ++iType) {
+    for (int iType = 0; iType < nTypes_; ++iType) {
       const int niType = nMol*space()->addMolList()[0]->nType()[iType];
-      for (unsigned int jType = 0; jType < hist[0].size(); ++jType) {
+      for (int jType = 0; jType < nTypes_; ++jType) {
         int normFac = 0;
         if (iType == jType) normFac = 1;
         const int njType = nMol*space()->addMolList()[0]->nType()[jType];
-        gr[iType][jType][bin] = (hist[iType][jType][bin])
+        gr[iType][jType][bin] =
+          histInter_[histIndex_(iMacro, iType, jType, bin)]
           /static_cast<double>( (niType - normFac)*njType*(countConf_[iMacro]) )
           /dv;
         if (iType <= jType) ss << gr[iType][jType][bin] << " ";
@@ -422,9 +681,9 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
 
   // find scaling factor from last 5% of gr
   int nlast = static_cast<int>(0.05*maxBins);
-  vector<vector<double> > sgr(hist.size(), vector<double>(hist[0].size(), 0.));
-  for (unsigned int iType = 0; iType < hist.size(); ++iType) {
-  for (unsigned int jType = 0; jType < hist[0].size(); ++jType) {
+  vector<vector<double> > sgr(nTypes_, vector<double>(nTypes_, 0.));
+  for (int iType = 0; iType < nTypes_; ++iType) {
+  for (int jType = 0; jType < nTypes_; ++jType) {
     for (int bin = maxBins - nlast; bin < maxBins; ++bin) {
       sgr[iType][jType] += gr[iType][jType][bin]/static_cast<double>(nlast);
     }
@@ -438,8 +697,8 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
     ss.str("");
     const double r = dgr_*(bin + 0.5);
     ss << r << " ";
-    for (unsigned int iType = 0; iType < hist.size(); ++iType) {
-      for (unsigned int jType = iType; jType < hist[0].size(); ++jType) {
+    for (int iType = 0; iType < nTypes_; ++iType) {
+      for (int jType = iType; jType < nTypes_; ++jType) {
         ss << gr[iType][jType][bin]/sgr[iType][jType] << " ";
       }
     }
@@ -482,13 +741,15 @@ void AnalyzeScatter::printer_(const string fileName, CriteriaWLTMMC *c,
           double normFacIn;
           normFacIn = static_cast<double>(nMol);
           Iq1 += Pq_[k][iType]*Pq_[k][jType]*
-            histIntra2_[iMacro][iType][jType][bin]*sqrinvqr/normFacIn
-            /static_cast<double>(countConf_[iMacro]);
+            histIntra_[histIndex_(iMacro, iType, jType, bin)]*sqrinvqr
+            /normFacIn/static_cast<double>(countConf_[iMacro]);
           // Iq2 += Pq_[k][iType]*Pq_[k][jType]*
-          //  histInter2_[iMacro][iType][jType][bin]*sqrinvqr/normFacIn
+          //  histInter_[histIndex_(iMacro, iType, jType, bin)]*sqrinvqr
+          //  /normFacIn
           //  /static_cast<double>(countConf_[iMacro]);
           // Iq2 += Pq_[k][iType]*Pq_[k][jType]*
-          //  histInter2_[iMacro][iType][jType][bin]*sqrinvqr/normFacIn
+          //  histInter_[histIndex_(iMacro, iType, jType, bin)]*sqrinvqr
+          //  /normFacIn
           //  /static_cast<double>(countConf_[iMacro])/sgr[iType][jType];
           // Iq3 += Pq_[k][iType]*Pq_[k][jType]*nid*sqrinvqr;
           if (nMol > 1) {
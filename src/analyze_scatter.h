@@ -17,6 +17,10 @@ namespace feasst {
 
 /**
  * Compute scattering, structure factor and radial distribution functions.
+ *
+ * Pair distances are binned with a cell list over a domain-wide grid, and
+ * are distributed among OpenMP threads with per-thread histograms.
+ * Histograms are stored flat, indexed by [macro][itype][jtype][bin].
  */
 class AnalyzeScatter : public Analyze {
  public:
@@ -26,7 +30,21 @@ class AnalyzeScatter : public Analyze {
   /// initialize SANS
   void initSANS(const double dgr,  //!< Distance between spatial bins.
     /// Number of macrostates in CriteriaWLTMMC.
-    const int nMacros = 1);
+    const int nMacros = 1,
+    /// Maximum pair distance. If <= 0, use half of the minimum box length.
+    /// Cell lists only reduce the cost when rMax is less than a third of
+    /// the box length.
+    const double rMax = 0.);
+
+  /**
+   * Accumulate the site structure factor, S(q) = |rho(q)|^2/N, from the
+   * Fourier transform of the site density for all reciprocal lattice
+   * vectors with n_x^2 + n_y^2 + n_z^2 <= kMax^2. S(q) is averaged in bins
+   * of width 2pi/max(L). The sum over sites is computed directly, with the
+   * phase factors of each site obtained by recursion. Assumes 3D.
+   * The S(q) accumulators are stored in the restart file.
+   */
+  void initStructureFactor(const int kMax);
 
   // update analysis every nFreq
   void update() { update(0); }
@@ -42,16 +60,22 @@ class AnalyzeScatter : public Analyze {
 
   // read-only access to protected variables
   vector<vector<vector<vector<long long> > > > histInter() const {
-    return histInter2_;
+    return unflatten_(histInter_);
   }
   vector<vector<vector<vector<long long> > > > histIntra() const {
-    return histIntra2_;
+    return unflatten_(histIntra_);
   }
   vector<double> iq() const { return iq_; }
   vector<vector<double> > iqm() const { return iqm_; }
   vector<double> qwave() const { return qwave_; }
   int qbins() const { return qbins_; }
 
+  /// Return the wave vector magnitude of the structure factor bins.
+  vector<double> sqWave() const;
+
+  /// Return the average structure factor of each bin in a macrostate.
+  vector<double> sq(const int iMacro = 0) const;
+
   /// initialize moments cutoff
   void initMoments(const int nMoments) { nMomentsCut_ = nMoments; }
 
@@ -71,6 +95,8 @@ class AnalyzeScatter : public Analyze {
  protected:
   double dgr_;  //!< distance spacing for gr
   int nbins_;   //!< number of bins in gr
+  double rMax_;  //!< maximum pair distance in gr
+  int nTypes_;   //!< number of particle types in histograms
   int qbins_;   //!< number of bins for sq
   vector<double> qwave_;  //!< wave vectors
   vector<vector<double> > Pq_;  //!< form factor, Pq[q][itype]
@@ -78,21 +104,47 @@ class AnalyzeScatter : public Analyze {
   vector<vector<double> > iqm_;   //!< SANS intensity for macrostates
 
   /// intermolecular histogram
-  vector<vector<vector<vector<long long> > > > histInter2_;
+  vector<long long> histInter_;
 
   /// intramolecular histogram
-  vector<vector<vector<vector<long long> > > > histIntra2_;
+  vector<long long> histIntra_;
+
+  /// Return the index of the histograms.
+  int histIndex_(const int iMacro, const int iType, const int jType,
+                 const int bin) const {
+    return ((iMacro*nTypes_ + iType)*nTypes_ + jType)*nbins_ + bin;
+  }
+
+  /// Return a histogram as nested vectors.
+  vector<vector<vector<vector<long long> > > > unflatten_(
+    const vector<long long> &hist) const;
 
   vector<long long> countConf_;
   vector<vector<double> > sgr_;   //!< histogram scale factor for g(r)->1
 
   // Extrapolation quantities
-  /// extrapolation histogram
-  vector<vector<vector<vector<vector<double> > > > > histMoments_;
+  /// extrapolation histogram, indexed by [macro][itype][jtype][moment][bin]
+  vector<double> histMoments_;
   /// maximum number of moments before Taylor series truncation
   ///  e.g., 3 (default) includes moments 0, 1 and 2
   int nMomentsCut_;
 
+  // scratch for update
+  vector<int> cellAtoms_, cellStart_, cellOfAtom_;
+  vector<vector<long long> > histThread_;
+
+  // structure factor
+  int sfKmax_;            //!< maximum reciprocal lattice vector
+  double sfDq_;           //!< width of structure factor bins
+  vector<int> sfMode_;    //!< n_x, n_y, n_z of each mode in the half space
+  vector<double> sfSum_;  //!< sum of S(q), indexed by [macro][bin]
+  vector<long long> sfCount_;  //!< number of modes, indexed by [macro][bin]
+  vector<double> sfModeSq_;    //!< |rho(q)|^2 of each mode
+  vector<double> eikr_, eiki_;  //!< exp(i k x) of each site, dimension, n
+
+  /// Accumulate the structure factor.
+  void updateStructureFactor_(const int iMacro);
+
   // shared print function
   void printer_(const string fileName, CriteriaWLTMMC *c = NULL,
                 const int iMacro = 0);
@@ -11,6 +11,7 @@
 #include <gtest/gtest.h>
 #include "mc_wltmmc.h"
 #include "pair_hard_sphere.h"
+#include "pair_lj.h"
 #include "analyze_scatter.h"
 #include "ui_abbreviated.h"
 #include "trial_transform.h"
@@ -76,3 +77,53 @@ TEST(AnalyzeScatter, args) {
     CATCH_PHRASE("is not recognized");
   }
 }
+
+TEST(AnalyzeScatter, cellListANDstructureFactor) {
+  Space s(3, {{"boxLength", "12"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.cg3_60_1_1"}});
+  for (int i = 0; i < 100; ++i) p.addMol();
+  AnalyzeScatter all(&p), cell(&p);
+  all.initSANS(0.1);
+  cell.initSANS(0.1, 1, 3.);
+  all.update();
+  cell.update();
+
+  // cell list histograms match all pairs within rMax
+  const vector<vector<vector<vector<long long> > > >
+    hAll = all.histInter(), hCell = cell.histInter(),
+    hAllIntra = all.histIntra(), hCellIntra = cell.histIntra();
+  long long nInter = 0;
+  for (int bin = 0; bin < 29; ++bin) {
+    for (int iType = 0; iType < s.nParticleTypes(); ++iType) {
+      for (int jType = 0; jType < s.nParticleTypes(); ++jType) {
+        EXPECT_EQ(hAll[0][iType][jType][bin], hCell[0][iType][jType][bin]);
+        EXPECT_EQ(hAllIntra[0][iType][jType][bin],
+                  hCellIntra[0][iType][jType][bin]);
+        nInter += hCell[0][iType][jType][bin];
+      }
+    }
+  }
+  EXPECT_GT(nInter, 0);
+
+  // two sites separated by half of the box in x
+  Space s2(3, {{"boxLength", "10"}});
+  PairLJ p2(&s2, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  p2.addMol(vector<double>({0., 0., 0.}));
+  p2.addMol(vector<double>({5., 0., 0.}));
+  AnalyzeScatter scat(&p2);
+  scat.initSANS(0.1);
+  scat.initStructureFactor(1);
+  scat.update();
+  EXPECT_NEAR(2.*PI/10., scat.sqWave()[1], DTOL);
+  EXPECT_NEAR(4./3., scat.sq()[1], 1e-8);
+
+  // the structure factor is restored from the restart file
+  scat.update();
+  scat.writeRestart("tmp/sqrst");
+  AnalyzeScatter scat2(&p2, "tmp/sqrst");
+  const vector<double> sq = scat.sq(), sq2 = scat2.sq();
+  EXPECT_EQ(sq.size(), sq2.size());
+  for (unsigned int bin = 0; bin < sq.size(); ++bin) {
+    EXPECT_NEAR(sq[bin], sq2[bin], 1e-12);
+  }
+}
@@ -0,0 +1,173 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif  // _OPENMP
+#include <climits>
+#include "./analyze_widom.h"
+
+namespace feasst {
+
+AnalyzeWidom::AnalyzeWidom(Pair *pair, const argtype &args)
+  : Analyze(pair, args) {
+  defaultConstruction_();
+  argparse_.initArgs(className_, args);
+
+  // parse beta
+  ASSERT(!argparse_.key("beta").empty(), "beta is required");
+  beta_ = argparse_.dble();
+
+  // parse molType
+  if (!argparse_.key("molType").empty()) {
+    molType_ = argparse_.str();
+  } else {
+    molType_ = space()->addMolListType(0);
+  }
+
+  // parse nInsert
+  nInsert_ = argparse_.key("nInsert").dflt("1000").integer();
+
+  // parse nBlock
+  boltzmann_.setBlock(argparse_.key("nBlock").dflt("10").integer());
+
+  // parse nThreads
+  if (!argparse_.key("nThreads").empty()) {
+    nThreads_ = argparse_.integer();
+  }
+
+  argparse_.checkAllArgsUsed();
+}
+
+AnalyzeWidom::AnalyzeWidom(Pair *pair, const char* fileName)
+  : Analyze(pair, fileName) {
+  defaultConstruction_();
+  beta_ = fstod("beta", fileName);
+  molType_ = fstos("molType", fileName);
+  nInsert_ = fstoi("nInsert", fileName);
+  boltzmann_.setBlock(fstoi("nBlock", fileName));
+  nThreads_ = fstoi("nThreads", fileName);
+}
+
+void AnalyzeWidom::writeRestart(const char* fileName) {
+  writeRestartBase(fileName);
+  std::ofstream file(fileName, std::ios_base::app);
+  file << std::setprecision(std::numeric_limits<double>::digits10+2)
+       << "# beta " << beta_ << endl;
+  file << "# molType " << molType_ << endl;
+  file << "# nInsert " << nInsert_ << endl;
+  file << "# nBlock " << boltzmann_.nBlock() << endl;
+  file << "# nThreads " << nThreads_ << endl;
+}
+
+void AnalyzeWidom::defaultConstruction_() {
+  className_.assign("AnalyzeWidom");
+  verbose_ = 0;
+  nThreads_ = 1;
+  #ifdef _OPENMP
+    nThreads_ = omp_get_max_threads();
+  #endif  // _OPENMP
+}
+
+void AnalyzeWidom::update(const int iMacro) {
+  const bool ghost = pair_->ghostEnerImplemented();
+
+  // copy the configuration for each thread, with independent random numbers
+  const int nThreads = std::max(1, std::min(nThreads_, nInsert_));
+  const unsigned long long seed =
+    static_cast<unsigned long long>(uniformRanNum(1, INT_MAX));
+  spaces_.resize(nThreads);
+  pairs_.resize(nThreads);
+  for (int t = 0; t < nThreads; ++t) {
+    if (spaces_[t] && spaces_[t]->copyPositions(*space())) {
+      if (!ghost) pairs_[t]->initEnergy();
+    } else {
+      spaces_[t] = space()->cloneShrPtr();
+      pairs_[t] = shared_ptr<Pair>(pair_->clone(spaces_[t].get()));
+    }
+    spaces_[t]->initRNG(seed, 0, t, 0);
+  }
+
+  // perform the test insertions
+  vector<double> sum(nThreads, 0.);
+  #ifdef _OPENMP
+  #pragma omp parallel for num_threads(nThreads) schedule(static, 1)
+  #endif  // _OPENMP
+  for (int t = 0; t < nThreads; ++t) {
+    Space* s = spaces_[t].get();
+    Pair* p = pairs_[t].get();
+    const int nInsert = nInsert_/nThreads + ((t < nInsert_ % nThreads) ? 1 : 0);
+    for (int i = 0; i < nInsert; ++i) {
+      s->initGhostMol(molType_.c_str(), s->randPosition());
+      double de;
+      if (ghost) {
+        de = p->ghostEner();
+      } else {
+        s->addGhostMol();
+        p->addPart();
+        const vector<int> mpart = s->lastMolIDVec();
+        de = p->multiPartEner(mpart, 3);
+        p->delPart(mpart);
+        s->delPart(mpart);
+      }
+      sum[t] += exp(-beta_*de);
+    }
+  }
+  double sumTot = 0.;
+  for (int t = 0; t < nThreads; ++t) sumTot += sum[t];
+  boltzmann_.accumulate(iMacro, sumTot/static_cast<double>(nInsert_));
+}
+
+double AnalyzeWidom::betaMuEx(const int iMacro) const {
+  return -log(boltzmann_.vec(iMacro).average());
+}
+
+void AnalyzeWidom::write() {
+  vector<double> m(boltzmann_.size());
+  for (int iMacro = 0; iMacro < boltzmann_.size(); ++iMacro) m[iMacro] = iMacro;
+  write_("iMacro", m);
+}
+
+void AnalyzeWidom::write(CriteriaWLTMMC *c) {
+  vector<double> m(c->nBin());
+  for (int bin = 0; bin < c->nBin(); ++bin) m[bin] = c->bin2m(bin);
+  write_(c->mType(), m);
+}
+
+void AnalyzeWidom::write_(const string mType, const vector<double> &m) {
+  stringstream ss;
+  ss << "# " << mType << " boltzAv boltzStd boltzBlockStdev betaMuEx "
+     << "betaMuExBlockStdev" << endl;
+  for (int bin = 0; bin < static_cast<int>(m.size()); ++bin) {
+    ss << m[bin] << " ";
+    if ( (boltzmann_.size() <= bin) ||
+         (boltzmann_.vec(bin).average() <= 0.) ) {
+      ss << "-1 -1 -1 -1 -1" << endl;
+    } else {
+      const Accumulator acc = boltzmann_.vec(bin);
+      ss << acc.average() << " " << acc.std() << " " << acc.blockStdev() << " "
+         << -log(acc.average()) << " " << acc.blockStdev()/acc.average()
+         << endl;
+    }
+  }
+  if (fileName_.empty()) {
+    cout << ss.str();
+  } else {
+    fileBackUp(fileName_.c_str());
+    std::ofstream file(fileName_.c_str());
+    file << ss.str();
+  }
+}
+
+shared_ptr<AnalyzeWidom> makeAnalyzeWidom(Pair *pair, const argtype &args) {
+  return make_shared<AnalyzeWidom>(pair, args);
+}
+
+}  // namespace feasst
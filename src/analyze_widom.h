@@ -0,0 +1,126 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef ANALYZE_WIDOM_H_
+#define ANALYZE_WIDOM_H_
+
+#include "./analyze.h"
+
+namespace feasst {
+
+/**
+ * Compute the excess chemical potential by Widom test insertions,
+ * \f$\beta\mu_{ex} = -\ln\langle\exp(-\beta\Delta U)\rangle\f$.
+ *
+ * Each update performs nInsert test insertions of a molecule at a random
+ * position and orientation. The insertions are spread over threads, each on
+ * its own copy of the current configuration, such that the simulation is
+ * unchanged. If the pair implements Pair::ghostEner, the test molecule is
+ * never added to the copy. Otherwise (e.g., Ewald), the test molecule is
+ * added to and deleted from the copy. The copies are made once and reused
+ * by later updates, which only copy the positions while the atoms and
+ * domain are unchanged.
+ *
+ * The average of \f$\exp(-\beta\Delta U)\f$ over the insertions of each
+ * update is accumulated for the macrostate of CriteriaWLTMMC, with block
+ * averages over updates for the error.
+ */
+class AnalyzeWidom : public Analyze {
+ public:
+  /// Constructor
+  AnalyzeWidom(Pair *pair,
+    /**
+     * allowed string key pairs (e.g., dictionary):
+     *
+     *  beta : inverse temperature (required).
+     *
+     *  molType : molecule type to insert, as given to Space::addMolInit.
+     *
+     *  - (default): the first type initialized with addMolInit.
+     *
+     *  nInsert : number of test insertions in each update.
+     *
+     *  - (default): 1000
+     *
+     *  nBlock : number of updates in each block average.
+     *
+     *  - (default): 10
+     *
+     *  nThreads : number of threads for the insertions.
+     *
+     *  - (default): the maximum number of OpenMP threads.
+     */
+    const argtype &args = argtype());
+
+  /// Perform test insertions and update the average for macrostate iMacro.
+  void update() { update(0); }
+  void update(const int iMacro);
+
+  /// Print the average and excess chemical potential of each macrostate.
+  void write();
+
+  /// Print the average and excess chemical potential of each macrostate.
+  void write(CriteriaWLTMMC *c);
+
+  /// Return the average of exp(-beta*dU) for each macrostate.
+  AccumulatorVec boltzmann() const { return boltzmann_; }
+
+  /// Return the excess chemical potential, times beta, of macrostate iMacro.
+  double betaMuEx(const int iMacro = 0) const;
+
+  /// Write restart file.
+  void writeRestart(const char* fileName);
+
+  /// Construct from restart file.
+  AnalyzeWidom(Pair *pair, const char* fileName);
+
+  ~AnalyzeWidom() {}
+  AnalyzeWidom* clone(Pair* pair) const {
+    AnalyzeWidom* a = new AnalyzeWidom(*this);
+    a->reconstruct(pair); a->clearCopies_(); return a;
+  }
+  shared_ptr<AnalyzeWidom> cloneShrPtr(Pair* pair) const {
+    return(std::static_pointer_cast<AnalyzeWidom, Analyze>(cloneImpl(pair)));
+  }
+
+ protected:
+  double beta_;
+  string molType_;
+  int nInsert_;
+  int nThreads_;
+  AccumulatorVec boltzmann_;   //!< average of exp(-beta*dU) per macrostate
+
+  /// copies of the configuration for each thread, which are reused by
+  /// updates while the atoms and domain are unchanged
+  vector<shared_ptr<Space> > spaces_;
+  vector<shared_ptr<Pair> > pairs_;
+
+  /// Do not share the copies of the configuration with a clone.
+  void clearCopies_() { spaces_.clear(); pairs_.clear(); }
+
+  void defaultConstruction_();
+
+  /// Print the accumulators, with the macrostate given by m[iMacro].
+  void write_(const string mType, const vector<double> &m);
+
+  // clone design pattern
+  virtual shared_ptr<Analyze> cloneImpl(Pair *pair) const {
+    shared_ptr<AnalyzeWidom> a = make_shared<AnalyzeWidom>(*this);
+    a->reconstruct(pair); a->clearCopies_(); return a;
+  }
+};
+
+/// Factory method
+shared_ptr<AnalyzeWidom> makeAnalyzeWidom(Pair *pair,
+  const argtype &args = argtype());
+
+}  // namespace feasst
+
+#endif  // ANALYZE_WIDOM_H_
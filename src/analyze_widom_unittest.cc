@@ -0,0 +1,129 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include "pair_lj.h"
+#include "pair_lj_coul_ewald.h"
+#include "mc.h"
+#include "analyze_widom.h"
+#include "trial_transform.h"
+#include "ui_abbreviated.h"
+
+using namespace feasst;
+
+TEST(AnalyzeWidom, lj) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  for (int i = 0; i < 50; ++i) p.addMol();
+  p.initEnergy();
+  const double peOld = p.peTot();
+  const int natom = s.natom();
+
+  // insertions spread over threads agree with a single thread
+  vector<double> betaMuEx;
+  for (int nThreads = 1; nThreads <= 4; nThreads += 3) {
+    AnalyzeWidom widom(&p, {{"beta", "1."}, {"nInsert", "20000"},
+      {"nThreads", str(nThreads)}});
+    widom.update();
+    betaMuEx.push_back(widom.betaMuEx());
+    EXPECT_EQ(natom, s.natom());
+    EXPECT_NEAR(peOld, p.peTot(), DTOL);
+  }
+  EXPECT_NEAR(betaMuEx[0], betaMuEx[1], 0.1);
+
+  // the ghost insertion agrees with adding and deleting the molecule
+  s.initGhostMol(s.addMolListType(0).c_str(), s.randPosition());
+  const double deGhost = p.ghostEner();
+  s.addGhostMol();
+  p.addPart();
+  const vector<int> mpart = s.lastMolIDVec();
+  EXPECT_NEAR(deGhost, p.multiPartEner(mpart, 3), 1e-10);
+  p.delPart(mpart);
+  s.delPart(mpart);
+
+  // use in MC, and restart
+  CriteriaMetropolis c(1., 1.);
+  MC mc(&s, &p, &c);
+  addTrialTransform(&mc, {{"transType", "translate"}, {"maxMoveParam", "1"}});
+  shared_ptr<AnalyzeWidom> widom = makeAnalyzeWidom(&p, {{"beta", "1."},
+    {"nInsert", "100"}, {"nBlock", "2"}});
+  widom->initFreq(10);
+  widom->initFreqPrint(100);
+  widom->initFileName("tmp/widom");
+  mc.initAnalyze(widom);
+  mc.runNumTrials(1000);
+  EXPECT_EQ(100, widom->boltzmann().vec(0).nValues());
+
+  // copies of the configuration reused from previous updates agree with new
+  // copies, given the same random numbers
+  AnalyzeWidom fresh(&p, {{"beta", "1."}, {"nInsert", "100"}});
+  widom->initRNG(123);
+  fresh.initRNG(123);
+  const double sumOld = widom->boltzmann().vec(0).sum();
+  widom->update();
+  fresh.update();
+  EXPECT_NEAR(fresh.boltzmann().vec(0).sum(),
+              widom->boltzmann().vec(0).sum() - sumOld, 1e-10);
+  EXPECT_LT(0, widom->boltzmann().vec(0).blockStdev());
+  widom->writeRestart("tmp/widomrst");
+  AnalyzeWidom widom2(&p, "tmp/widomrst");
+  widom2.update();
+  EXPECT_EQ(1, widom2.boltzmann().vec(0).nValues());
+}
+
+TEST(AnalyzeWidom, spce) {
+  const double boxl = 20., beta = 1./(525*8.3144621/1000);
+  Space s(3, {{"boxLength", str(boxl)}});
+  s.addMolInit("../forcefield/data.spce");
+  PairLJCoulEwald p(&s, {{"rCut", str(boxl/2.)}});
+  p.initBulkSPCE(5.6, 38);
+  CriteriaMetropolis c(beta, exp(-8.));
+  MC mc(&s, &p, &c);
+  transformTrial(&mc, "translate");
+  transformTrial(&mc, "rotate");
+  mc.nMolSeek(8, "../forcefield/data.spce", 1e5);
+  p.initEnergy();
+  const double peOld = p.peTot();
+  const int natom = s.natom();
+
+  // multi-site insertions with Ewald summation do not change the simulation
+  ASSERT_FALSE(p.ghostEnerImplemented());
+  AnalyzeWidom widom(&p, {{"beta", str(beta)}, {"nInsert", "200"},
+    {"nThreads", "2"}});
+  widom.update();
+  EXPECT_EQ(natom, s.natom());
+  EXPECT_NEAR(peOld, p.peTot(), 1e-10);
+  EXPECT_EQ(1, p.checkEnergy(1e-8, 0));
+  EXPECT_GT(widom.boltzmann().vec(0).average(), 0.);
+
+  // the energy of each insertion agrees with adding to the simulation
+  Space sCopy(s);
+  shared_ptr<Pair> pCopy(p.clone(&sCopy));
+  sCopy.initGhostMol(s.addMolListType(0).c_str(), s.randPosition());
+  sCopy.addGhostMol();
+  pCopy->addPart();
+  const vector<int> mpart = sCopy.lastMolIDVec();
+  const double de = pCopy->multiPartEner(mpart, 3);
+  const double peCopy = pCopy->peTot() + de;
+  pCopy->initEnergy();
+  EXPECT_NEAR(peCopy, pCopy->peTot(), 1e-8);
+
+  // after moves, reused copies agree with new copies
+  mc.runNumTrials(50);
+  AnalyzeWidom fresh(&p, {{"beta", str(beta)}, {"nInsert", "200"},
+    {"nThreads", "2"}});
+  widom.initRNG(123);
+  fresh.initRNG(123);
+  const double sumOld = widom.boltzmann().vec(0).sum();
+  widom.update();
+  fresh.update();
+  EXPECT_NEAR(fresh.boltzmann().vec(0).sum(),
+              widom.boltzmann().vec(0).sum() - sumOld, 1e-10);
+}
@@ -10,6 +10,7 @@
 
 #include "./base_random.h"
 #include "./random_mersenne_twister.h"
+#include "./random_philox.h"
 
 namespace feasst {
 
@@ -46,12 +47,23 @@ void BaseRandom::initRNG(const char* fileName) {
   stringstream ss;
   ss << fileName << "rng";
   if (fileExists(ss.str().c_str())) {
-    ranNum_ = std::make_shared<RandomMersenneTwister>(ss.str().c_str());
+    if (fstos("className", ss.str().c_str()) == "RandomPhilox") {
+      ranNum_ = std::make_shared<RandomPhilox>(ss.str().c_str());
+    } else {
+      ranNum_ = std::make_shared<RandomMersenneTwister>(ss.str().c_str());
+    }
   } else {
     clearRNG();
   }
 }
 
+void BaseRandom::initRNG(unsigned long long seed, const int window,
+  const int walker, const int trialType) {
+  if (seed == 0) seed = rand();
+  ranNum_ = std::make_shared<RandomPhilox>(seed,
+    RandomPhilox::streamID(window, walker, trialType));
+}
+
 void BaseRandom::clearRNG() {
   std::shared_ptr<Random> emptyRanNum;
   initRNG(emptyRanNum);
@@ -69,6 +81,11 @@ int BaseRandom::uniformRanNum(const int min, const int max) {
   return ranNum_->uniform(min, max);
 }
 
+void BaseRandom::uniformRanNum(const int n, double *ran) {
+  if (!ranNum_) initRNG();
+  ranNum_->uniform(n, ran);
+}
+
 double BaseRandom::stdNormRanNum() {
   const double u = uniformRanNum();
   const double v = uniformRanNum();
@@ -109,6 +126,11 @@ std::string BaseRandom::randomHash(const int length) {
 
 vector<double> BaseRandom::quatRandom() {
   vector<double> q(4);
+  quatRandomInPlace(&q[0]);
+  return q;
+}
+
+void BaseRandom::quatRandomInPlace(double *q) {
   double s1 = 2;
   double s2 = 2;
   while (s1 > 1) {
@@ -128,7 +150,6 @@ vector<double> BaseRandom::quatRandom() {
   s1 = sqrt((1 - s1)/s2);
   q[2] = q[2]*s1;
   q[3] = q[3]*s1;
-  return q;
 }
 
 vector<double> BaseRandom::quatRandom(
@@ -146,6 +167,24 @@ vector<double> BaseRandom::quatRandom(
   return q;
 }
 
+void BaseRandom::quatRandom(const int n, double *q) {
+  ranBuffer_.resize(4*n);
+  uniformRanNum(4*n, &ranBuffer_[0]);
+  for (int i = 0; i < n; ++i) {
+    const double *u = &ranBuffer_[4*i];
+    double *qi = &q[4*i];
+    const double r1 = sqrt(-2.*log(1. - u[0])),
+                 r2 = sqrt(-2.*log(1. - u[2]));
+    qi[0] = r1*cos(2.*PI*u[1]);
+    qi[1] = r1*sin(2.*PI*u[1]);
+    qi[2] = r2*cos(2.*PI*u[3]);
+    qi[3] = r2*sin(2.*PI*u[3]);
+    const double qsize = sqrt(qi[0]*qi[0] + qi[1]*qi[1] + qi[2]*qi[2]
+                            + qi[3]*qi[3]);
+    for (int j = 0; j < 4; ++j) qi[j] /= qsize;
+  }
+}
+
 vector<double> BaseRandom::ranShell(const double rabove, const double rbelow,
   const int dim) {
   vector<double> x(dim);
@@ -176,6 +215,20 @@ vector<double> BaseRandom::ranUnitSphere(const int dim) {
   return x;
 }
 
+void BaseRandom::ranUnitSphere(const int n, double *x) {
+  // uniform in the cosine of the polar angle and the azimuthal angle
+  ranBuffer_.resize(2*n);
+  uniformRanNum(2*n, &ranBuffer_[0]);
+  for (int i = 0; i < n; ++i) {
+    const double z = 2.*ranBuffer_[2*i] - 1.,
+                 phi = 2.*PI*ranBuffer_[2*i + 1],
+                 rxy = sqrt(1. - z*z);
+    x[3*i] = rxy*cos(phi);
+    x[3*i + 1] = rxy*sin(phi);
+    x[3*i + 2] = z;
+  }
+}
+
 int BaseRandom::ranFromCPDF(const vector<double> &cpdf) {
   double prev = -1, current = -1;
   const double ranNum = uniformRanNum();
@@ -197,6 +250,54 @@ int BaseRandom::ranFromCPDF(const vector<double> &cpdf) {
   return i;
 }
 
+void BaseRandom::initAlias(const vector<double> &weight, vector<double> *prob,
+  vector<int> *alias) {
+  const int n = static_cast<int>(weight.size());
+  double wtTot = 0.;
+  for (int i = 0; i < n; ++i) {
+    ASSERT(weight[i] >= 0, "weight(" << weight[i] << ") must be nonnegative");
+    wtTot += weight[i];
+  }
+  ASSERT(wtTot > 0, "sum of weights(" << wtTot << ") must be positive");
+
+  // split the scaled probabilities into those below and above average
+  prob->assign(n, 1.);
+  alias->resize(n);
+  vector<double> scaled(n);
+  vector<int> small, large;
+  for (int i = 0; i < n; ++i) {
+    (*alias)[i] = i;
+    scaled[i] = weight[i]*n/wtTot;
+    if (scaled[i] < 1.) {
+      small.push_back(i);
+    } else {
+      large.push_back(i);
+    }
+  }
+
+  // fill each small column with the remainder of a large column
+  while ( (small.size() > 0) && (large.size() > 0) ) {
+    const int s = small.back(), l = large.back();
+    small.pop_back();
+    (*prob)[s] = scaled[s];
+    (*alias)[s] = l;
+    scaled[l] -= 1. - scaled[s];
+    if (scaled[l] < 1.) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+}
+
+int BaseRandom::ranFromAlias(const vector<double> &prob,
+  const vector<int> &alias) {
+  const int n = static_cast<int>(prob.size());
+  const double ranNum = n*uniformRanNum();
+  const int i = std::min(static_cast<int>(ranNum), n - 1);
+  if (ranNum - i < prob[i]) return i;
+  return alias[i];
+}
+
 double BaseRandom::ranAngle(const double k0, const double t0, const int power) {
   int accept = 0, i = 0;
   double theta = 0;
@@ -44,6 +44,15 @@ class BaseRandom : public Base {
   /// Initialize random number generator by checkpoint file.
   void initRNG(const char* fileName);
 
+  /**
+   * Initialize the counter-based random number generator, RandomPhilox,
+   * with the substream given by the window, walker and trial type. For a
+   * given seed, each substream is independent and reproducible regardless
+   * of the number of threads. A zero seed is handled as above.
+   */
+  void initRNG(unsigned long long seed, const int window, const int walker,
+               const int trialType);
+
   /// Clear random number generator.
   void clearRNG();
 
@@ -53,6 +62,9 @@ class BaseRandom : public Base {
   /// Return uniform random integer between range min and max, inclusive.
   int uniformRanNum(const int min, const int max);
 
+  /// Fill ran with n uniform random numbers between 0 and 1.
+  void uniformRanNum(const int n, double *ran);
+
   /// Return standard normal random number using Box-Muller method
   double stdNormRanNum();
 
@@ -76,10 +88,19 @@ class BaseRandom : public Base {
    *  Franz J. Vesely, J. Comput. Phys., 47, 291-296 (1982). */
   vector<double> quatRandom();
 
+  /// Same as above, but fill q[4] without allocation.
+  void quatRandomInPlace(double *q);
+
   /** Return a quaternion which is randomly perturbed from the unit vector
    *  (e.g., identity rotation matrix) by an amount "maxPerturb" */
   vector<double> quatRandom(const double maxPerturb);
 
+  /**
+   * Fill q with n random quaternions, q[4*i + j], by normalizing four
+   * Gaussian random numbers from a bulk draw of uniform random numbers.
+   */
+  void quatRandom(const int n, double *q);
+
   /** Return random position within spherical shell defined by rabove and rbelow
    * in dim dimensions */
   vector<double> ranShell(const double rabove, const double rbelow,
@@ -88,10 +109,25 @@ class BaseRandom : public Base {
   /// Return random position on unit sphere in dim dimensions.
   vector<double> ranUnitSphere(const int dim = 3);
 
+  /// Fill x with n random positions on the unit sphere in 3D, x[3*i + dim].
+  void ranUnitSphere(const int n, double *x);
+
   /** Given cumulative discrete probability distribution, cpdf,
    *  return chosen integer element from uniform probability distribution. */
   int ranFromCPDF(const vector<double> &cpdf);
 
+  /**
+   * Initialize the alias table of Vose's method for the discrete probability
+   * distribution proportional to the nonnegative weight.
+   * The table is used by ranFromAlias to select an element in O(1).
+   */
+  static void initAlias(const vector<double> &weight, vector<double> *prob,
+                        vector<int> *alias);
+
+  /// Return element chosen with the alias table from initAlias, with a
+  /// single uniform random number.
+  int ranFromAlias(const vector<double> &prob, const vector<int> &alias);
+
   /** Return angle selected from probability distribution associated with
    *  harmonic bond bending energy, \f$ \beta U=k0(t-t0)^{power} \f$ from
    *  Frenkel and Smit, page 343, below Equation 13.3.6. */
@@ -115,6 +151,7 @@ class BaseRandom : public Base {
 
  protected:
   shared_ptr<Random> ranNum_;      //!< pointer to random number generator
+  vector<double> ranBuffer_;       //!< bulk uniform random numbers
 
   /// Derived objects may preform additional reconstruction.
   void reconstructDerived_();
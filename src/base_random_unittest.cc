@@ -72,3 +72,31 @@ TEST(BaseRandom, hash) {
   EXPECT_NE(hash, ran.randomHash());
   EXPECT_NE(hash, ran.randomHash());
 }
+
+TEST(BaseRandom, bulk) {
+  BaseRandom ran;
+  ran.initRNG(123, 0, 0, 0);
+  const int n = 1000;
+  vector<double> q(4*n), x(3*n);
+  ran.quatRandom(n, &q[0]);
+  ran.ranUnitSphere(n, &x[0]);
+  Accumulator z;
+  for (int i = 0; i < n; ++i) {
+    EXPECT_NEAR(1., q[4*i]*q[4*i] + q[4*i+1]*q[4*i+1] + q[4*i+2]*q[4*i+2]
+                  + q[4*i+3]*q[4*i+3], DTOL);
+    EXPECT_NEAR(1., x[3*i]*x[3*i] + x[3*i+1]*x[3*i+1] + x[3*i+2]*x[3*i+2],
+                DTOL);
+    z.accumulate(x[3*i+2]);
+  }
+  EXPECT_NEAR(0., z.average(), 0.1);
+
+  // the same substream reproduces the sequence
+  BaseRandom ran2;
+  ran2.initRNG(123, 0, 0, 0);
+  ran.initRNG(123, 0, 0, 0);
+  double u[5];
+  ran2.uniformRanNum(5, u);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(ran.uniformRanNum(), u[i]);
+  }
+}
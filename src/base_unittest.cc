@@ -54,6 +54,26 @@ TEST(BaseRandom, ranFromCPDF) {
   for (int i = 0; i < ncpdf; ++i) EXPECT_NEAR(cpdfran[i]/double(n), ncpdf/double(n), 0.2);
 }
 
+TEST(BaseRandom, ranFromAlias) {
+  BaseRandom math;
+  math.initRNG(123);
+  const vector<double> weight = {0.5, 0., 3., 1., 0.5};
+  vector<double> prob;
+  vector<int> alias;
+  BaseRandom::initAlias(weight, &prob, &alias);
+  const int n = 100000;
+  vector<double> hist(weight.size());
+  for (int i = 0; i < n; ++i) ++hist[math.ranFromAlias(prob, alias)];
+  EXPECT_EQ(0, hist[1]);
+  for (int i = 0; i < static_cast<int>(weight.size()); ++i) {
+    EXPECT_NEAR(weight[i]/5., hist[i]/n, 0.01);
+  }
+
+  // a single element is always selected
+  BaseRandom::initAlias({2.}, &prob, &alias);
+  EXPECT_EQ(0, math.ranFromAlias(prob, alias));
+}
+
 TEST(BaseRandom, quatRandomNorm) {
   ranInitByDate();
   BaseRandom math;
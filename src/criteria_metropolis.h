@@ -38,6 +38,7 @@ class CriteriaMetropolis : public Criteria {
   /// Return whether to accept (1) or reject (0).
   int accept(const double lnpMet, const double peNew, const char* moveType,
     const int reject) {
+    FEASST_PROFILE(ACCEPT);
     if ( (reject != 1) && (uniformRanNum() < exp(lnpMet)) ) return 1;
     return 0;
     (void) peNew; (void) moveType;  // avoid warning for unused parameters
@@ -19,6 +19,7 @@ CriteriaWLTMMC::CriteriaWLTMMC(const double beta, const argtype &args)
   defaultConstruction_();
   argparse_.initArgs(className_, args);
   mType_ = argparse_.key("mType").str();
+  orderRCut_ = argparse_.key("orderRCut").dflt("1.5").dble();
 
   // first, parse mMax
   if (!argparse_.key("mMax").empty()) {
@@ -79,6 +80,7 @@ CriteriaWLTMMC::CriteriaWLTMMC(const char* fileName)
   : Criteria(fileName) {
   defaultConstruction_();
   mType_.assign(fstos("mType", fileName));
+  if (mType_.compare("Q6") == 0) orderRCut_ = fstod("orderRCut", fileName);
   mMin_ = fstod("mMin", fileName);
   mMax_ = fstod("mMax", fileName);
   nBin_ = fstoi("nBin", fileName);
@@ -107,6 +109,9 @@ void CriteriaWLTMMC::defaultConstruction_() {
   tmmc_ = false;
   phaseBoundary_ = 0;
   nSmooth_ = 10;
+  orderRCut_ = 1.5;
+  orderSpace_ = NULL;
+  orderCacheRevision_ = -1;
 }
 
 CriteriaWLTMMC* CriteriaWLTMMC::clone() const {
@@ -127,6 +132,7 @@ shared_ptr<Criteria> CriteriaWLTMMC::cloneImpl_() const {
 
 int CriteriaWLTMMC::accept(const double lnpMet, const double peNew,
   const char* moveType, const int reject) {
+  FEASST_PROFILE(ACCEPT);
   int returnVal = -1;
   mNew_ = mMin_ - 1;
   if ( (mType_.compare("nmol") == 0) ||
@@ -169,6 +175,16 @@ int CriteriaWLTMMC::accept(const double lnpMet, const double peNew,
     } else {
       mNew_ = std::stod(moveType);
     }
+  } else if (mType_.compare("Q6") == 0) {
+    std::string moveTypeStr(moveType);
+    ASSERT(!stringInString("add", moveTypeStr) &&
+           !stringInString("del", moveTypeStr),
+      "Q6 macrostate does not support trials of type (" << moveTypeStr << ")");
+    if (reject == 1) {
+      mNew_ = mOld_;
+    } else {
+      mNew_ = orderSpace_->Q6(orderRCut_);
+    }
   } else {
     ASSERT(0, "unrecognized macrostate type (" << mType_ << ")");
   }
@@ -177,10 +193,18 @@ int CriteriaWLTMMC::accept(const double lnpMet, const double peNew,
 
   if (cTripleBanded_) {
     double pMet = exp(lnpMet);
-    const int mNewBin = bin(mNew_);
-    if ( (mNew_ > mMax_) || (mNew_ < mMin_) || (reject == 1) ) {
+    int mNewBin = bin(mNew_);
+    int rejectBin = reject;
+
+    // continuous order parameters may jump by more than one bin
+    if ( (mType_.compare("Q6") == 0) && (abs(mNewBin - mOldBin) > 1) ) {
+      mNew_ = mOld_;
+      mNewBin = mOldBin;
+      rejectBin = 1;
+    }
+    if ( (mNew_ > mMax_) || (mNew_ < mMin_) || (rejectBin == 1) ) {
       returnVal = 0;
-      if (reject == 1) pMet = 0;
+      if (rejectBin == 1) pMet = 0;
     } else if (uniformRanNum() < exp( lnPI_[mOldBin]
                                     - lnPI_[mNewBin] + lnpMet)) {
       returnVal = 1;
@@ -202,6 +226,10 @@ int CriteriaWLTMMC::accept(const double lnpMet, const double peNew,
   if (returnVal == 0) mNew_ = mOld_;
   ASSERT( (returnVal == 0) || (returnVal == 1), "returnVal(" << returnVal
     << "not 0 or 1");
+  if (mType_.compare("Q6") == 0) {
+    orderCache_ = mNew_;
+    orderCacheRevision_ = orderSpace_->revision();
+  }
   return returnVal;
 }
 
@@ -224,6 +252,14 @@ void CriteriaWLTMMC::store(Pair* pair) {
     mOld_ = pressure_;
   } else if (mType_.compare("lnpres") == 0) {
     mOld_ = log(pressure_);
+  } else if (mType_.compare("Q6") == 0) {
+    if ( (space == orderSpace_) &&
+         (space->revision() == orderCacheRevision_) ) {
+      mOld_ = orderCache_;
+    } else {
+      orderSpace_ = space;
+      mOld_ = space->Q6(orderRCut_);
+    }
   }
   peOld_ = pair->peTot();
   WARN(verbose_ == 1,  "mold " << mOld_);
@@ -276,12 +312,13 @@ void CriteriaWLTMMC::mUpdate_(const int mOldBin,   //!< bin of old state
           ++h_[mNewBin];
         }
       }
-      C_[mOldBin][index] += p;
-      C_[mOldBin][1] += 1-p;
+      C_[nColMat_*mOldBin + index] += p;
+      C_[nColMat_*mOldBin + 1] += 1-p;
     } else {
-      C_[mOldBin][mNewBin] += p;
-      C_[mOldBin][mOldBin] += 1-p;
+      C_[nColMat_*mOldBin + mNewBin] += p;
+      C_[nColMat_*mOldBin + mOldBin] += 1-p;
     }
+    cRowSum_[mOldBin] += 1.;
   }
 
   // Wang-Landau update
@@ -326,7 +363,7 @@ void CriteriaWLTMMC::mUpdate_(const int mOldBin,   //!< bin of old state
 
 void CriteriaWLTMMC::lnPIupdate() {
   if (tmmc_) {
-    c2lnPI(C_, &lnPI_);
+    c2lnPI(C_, cRowSum_, &lnPI_);
 
     // update number of sweeps
     if (*std::min_element(h_.begin(), h_.end()) >= nSweepVisPerBin_) {
@@ -409,37 +446,42 @@ void CriteriaWLTMMC::zeroStat() {
 void CriteriaWLTMMC::c2lnPI(
   const vector<vector<long double> > &col,
   vector<long double> *lnpiPtr) {
+  const int nCol = (col.size() > 0) ? static_cast<int>(col[0].size()) : 0;
+  vector<long double> colFlat(col.size()*nCol), colRowSum(col.size(), 0.);
+  for (int i = 0; i < static_cast<int>(col.size()); ++i) {
+    for (int j = 0; j < nCol; ++j) {
+      colFlat[nCol*i + j] = col[i][j];
+      colRowSum[i] += col[i][j];
+    }
+  }
+  c2lnPI(colFlat, colRowSum, lnpiPtr);
+}
+
+void CriteriaWLTMMC::c2lnPI(
+  const vector<long double> &col,
+  const vector<long double> &colRowSum,
+  vector<long double> *lnpiPtr) {
   vector<long double>& lnpi = *lnpiPtr;
-  double lnPIprev = 0.;
+  const int nCol = static_cast<int>(col.size())/nBin_;
+  // column of the transition to the next and previous bin
+  const int up = (cTripleBanded_) ? 2 : 1,
+            down = (cTripleBanded_) ? 0 : -1;
+  long double lnPIprev = 0.;
   lnpi[0] = lnPIprev;
-  double p01, p10, cSum1;
-  double cSum0 = std::accumulate(col[0].begin(), col[0].end(), 0.);
   for (int i = 1; i < nBin_; ++i) {
-    if (cSum0 == 0) {
+    const long double cSum0 = colRowSum[i-1], cSum1 = colRowSum[i];
+    if ( (cSum0 == 0) || (cSum1 == 0) ) {
       lnpi[i] = lnPIprev;
-      cSum0 = std::accumulate(col[i].begin(), col[i].end(), 0.);
     } else {
-      if (cTripleBanded_) {
-        p01 = col[i-1][2] / cSum0;
-      } else {
-        p01 = col[i-1][i] / cSum0;
-      }
-      cSum1 = std::accumulate(col[i].begin(), col[i].end(), 0.);
-      cSum0 = cSum1;
-      if (cSum1 == 0) {
+      const int off0 = (cTripleBanded_) ? 0 : i - 1,
+                off1 = (cTripleBanded_) ? 0 : i;
+      const long double p01 = col[nCol*(i-1) + off0 + up]/cSum0,
+                        p10 = col[nCol*i + off1 + down]/cSum1;
+      if (p10 == 0) {
         lnpi[i] = lnPIprev;
       } else {
-        if (cTripleBanded_) {
-          p10 = col[i][0] / cSum1;
-        } else {
-          p10 = col[i][i-1] / cSum1;
-        }
-        if (p10 == 0) {
-          lnpi[i] = lnPIprev;
-        } else {
-          lnpi[i] = lnPIprev + log(p01/p10);
-          lnPIprev = lnpi[i];
-        }
+        lnpi[i] = lnPIprev + log(p01/p10);
+        lnPIprev = lnpi[i];
       }
     }
   }
@@ -449,22 +491,35 @@ void CriteriaWLTMMC::c2lnPI(
 void CriteriaWLTMMC::lnPIupdate(
   const vector<std::shared_ptr<CriteriaWLTMMC> > &c) {
   if (tmmc_) {
-    // sum all collection matrices into one
-    vector<vector<long double> > C(static_cast<int>(
-      C_.size()), vector<long double>(static_cast<int>(C_[0].size()), 0.));
+    // sum all collection matrices into one, in place
+    cSumBuf_.assign(C_.size(), 0.);
+    cRowSumBuf_.assign(cRowSum_.size(), 0.);
     for (unsigned int i = 0; i < c.size(); ++i) {
-      for (unsigned int j = 0; j < C.size(); ++j) {
-        for (unsigned int k = 0; k < C[j].size(); ++k) {
-          C[j][k] = c[i]->C()[j][k];
-        }
+      const vector<long double> &col = c[i]->colMat();
+      const vector<long double> &colRowSum = c[i]->colMatRowSum();
+      for (unsigned int j = 0; j < cSumBuf_.size(); ++j) {
+        cSumBuf_[j] += col[j];
+      }
+      for (unsigned int j = 0; j < cRowSumBuf_.size(); ++j) {
+        cRowSumBuf_[j] += colRowSum[j];
       }
     }
 
     // update lnpi with total collection matrix
-    c2lnPI(C, &lnPI_);
+    c2lnPI(cSumBuf_, cRowSumBuf_, &lnPI_);
   }
 }
 
+vector<vector<long double> > CriteriaWLTMMC::C() const {
+  vector<vector<long double> > col(nBin_, vector<long double>(nColMat_));
+  for (int i = 0; i < nBin_; ++i) {
+    for (int j = 0; j < nColMat_; ++j) {
+      col[i][j] = C_[nColMat_*i + j];
+    }
+  }
+  return col;
+}
+
 void CriteriaWLTMMC::lnPIrw(const double activrw) {
   activrw_ = activrw;
   // cout << "activ " << activ_ << " rw " << activrw_ << endl;
@@ -481,6 +536,186 @@ void CriteriaWLTMMC::lnPIrw(const double activrw) {
   lnPInorm(&lnPIrw_);
 }
 
+void CriteriaWLTMMC::lnPIrw(const vector<double> &activrw,
+  vector<long double> *lnPIrws) const {
+  const int nActiv = static_cast<int>(activrw.size());
+  lnPIrws->resize(nActiv*nBin_);
+  vector<double> m(nBin_);
+  for (int bin = 0; bin < nBin_; ++bin) m[bin] = bin2m(bin);
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+  #endif  // _OPENMP
+  for (int ia = 0; ia < nActiv; ++ia) {
+    long double* lnpi = &(*lnPIrws)[ia*nBin_];
+    const double fac = log(activrw[ia]) - log(activ_);
+    long double shift = -std::numeric_limits<long double>::max();
+    for (int bin = 0; bin < nBin_; ++bin) {
+      lnpi[bin] = lnPI_[bin] + fac*m[bin];
+      if (lnpi[bin] > shift) shift = lnpi[bin];
+    }
+    long double area = 0.;
+    for (int bin = 0; bin < nBin_; ++bin) {
+      lnpi[bin] -= shift;
+      area += exp(lnpi[bin]);
+    }
+    const long double lns = log(area);
+    for (int bin = 0; bin < nBin_; ++bin) lnpi[bin] -= lns;
+  }
+}
+
+void CriteriaWLTMMC::peMoments_(vector<double> *peAv,
+  vector<double> *peVar) const {
+  ASSERT(mType_.compare("nmol") == 0, "reweighting with the energy moments "
+    << "assumes the macrostate is nmol, not " << mType_);
+  peAv->assign(nBin_, 0.);
+  peVar->assign(nBin_, 0.);
+  for (int bin = 0; bin < nBin_; ++bin) {
+    const double nValues = pe_[bin].nValues();
+    if (nValues > 0) {
+      (*peAv)[bin] = pe_[bin].sum()/nValues;
+      (*peVar)[bin] = pe_[bin].sumSq()/nValues - pow((*peAv)[bin], 2);
+    }
+  }
+}
+
+void CriteriaWLTMMC::rwState_(const double lnz, const double beta,
+  const double volume, const vector<double> &peAv,
+  const vector<double> &peVar, vector<long double> *lnpiPtr,
+  double *row) const {
+  vector<long double> &lnpi = *lnpiPtr;
+  lnpi.resize(nBin_);
+  const double dlnz = lnz - log(activ_), dbeta = beta - beta_;
+  long double shift = -std::numeric_limits<long double>::max();
+  for (int bin = 0; bin < nBin_; ++bin) {
+    lnpi[bin] = lnPI_[bin] + dlnz*bin2m(bin) - dbeta*peAv[bin]
+              + 0.5*dbeta*dbeta*peVar[bin];
+    if (lnpi[bin] > shift) shift = lnpi[bin];
+  }
+  long double area = 0.;
+  for (int bin = 0; bin < nBin_; ++bin) area += exp(lnpi[bin] - shift);
+  shift += log(area);
+  for (int bin = 0; bin < nBin_; ++bin) lnpi[bin] -= shift;
+
+  // split into at most two phases at the boundary bin, which belongs to the
+  // first phase as in phaseSplit
+  const vector<int> min = lnPIphaseBoundary(lnpi);
+  const int boundary = (min.size() == 0) ? nBin_ - 1 : min.back();
+  // energy moments in each bin are extrapolated to first order in dbeta
+  double areaPhase[2] = {0., 0.}, nPhase[2] = {0., 0.}, n = 0., u = 0.,
+         u2 = 0., nu = 0.;
+  for (int bin = 0; bin < nBin_; ++bin) {
+    const double p = exp(lnpi[bin]), m = bin2m(bin),
+                 uBin = peAv[bin] - dbeta*peVar[bin];
+    const int phase = (bin <= boundary) ? 0 : 1;
+    areaPhase[phase] += p;
+    nPhase[phase] += p*m;
+    n += p*m;
+    u += p*uBin;
+    u2 += p*(peVar[bin] + uBin*uBin);
+    nu += p*m*uBin;
+  }
+  const int nPhases = (min.size() == 0) ? 1 : 2;
+  row[0] = lnz;
+  row[1] = beta;
+  row[2] = nPhases;
+  row[3] = n;
+  row[4] = u;
+  row[12] = u2;
+  row[13] = nu;
+  for (int phase = 0; phase < 2; ++phase) {
+    if (phase < nPhases) {
+      row[6 + phase] = nPhase[phase]/areaPhase[phase];
+      row[8 + phase] = (-lnpi[0] + log(areaPhase[phase]))/volume/beta;
+      row[10 + phase] = log(areaPhase[phase]);
+    } else {
+      row[6 + phase] = row[8 + phase] = row[10 + phase] = -1;
+    }
+  }
+  // pressure of the most probable phase, as in lnPIpressure
+  row[5] = ( (nPhases == 2) && (areaPhase[1] > areaPhase[0]) ) ? row[9]
+                                                               : row[8];
+}
+
+void CriteriaWLTMMC::rwBatch(const vector<double> &lnzrw,
+  const vector<double> &betarw, const double volume,
+  vector<double> *data) const {
+  ASSERT(volume > 0, "volume(" << volume << ") must be positive");
+  vector<double> peAv, peVar;
+  peMoments_(&peAv, &peVar);
+  const int nLnz = static_cast<int>(lnzrw.size()),
+            nStates = nLnz*static_cast<int>(betarw.size());
+  data->resize(nStates*nRWBatchCols());
+  #ifdef _OPENMP
+  #pragma omp parallel
+  #endif  // _OPENMP
+  {
+    vector<long double> lnpi(nBin_);
+    #ifdef _OPENMP
+    #pragma omp for schedule(static)
+    #endif  // _OPENMP
+    for (int state = 0; state < nStates; ++state) {
+      rwState_(lnzrw[state % nLnz], betarw[state/nLnz], volume, peAv, peVar,
+               &lnpi, &(*data)[state*nRWBatchCols()]);
+    }
+  }
+}
+
+double CriteriaWLTMMC::lnzSat(const double betarw,
+  const double lnzGuess) const {
+  vector<double> peAv, peVar, row(nRWBatchCols());
+  peMoments_(&peAv, &peVar);
+  vector<long double> lnpi(nBin_);
+  double lnz = lnzGuess;
+  rwState_(lnz, betarw, 1., peAv, peVar, &lnpi, &row[0]);
+
+  // if the guess has one phase, try equal probability of the end bins
+  if (row[2] != 2) {
+    lnz += (lnpi.front() - lnpi.back())/(bin2m(nBin_ - 1) - bin2m(0));
+    rwState_(lnz, betarw, 1., peAv, peVar, &lnpi, &row[0]);
+    if (row[2] != 2) return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  // Newton iteration with d(lnArea0 - lnArea1)/dlnz = N0 - N1, where the
+  // step is halved until the new state still has two phases
+  for (int iter = 0; iter < 100; ++iter) {
+    const double f = row[10] - row[11];
+    if (fabs(f) < 1e-10) return lnz;
+    double step = -f/(row[6] - row[7]);
+    const double lnzOld = lnz;
+    for (int half = 0; half < 50; ++half) {
+      lnz = lnzOld + step;
+      rwState_(lnz, betarw, 1., peAv, peVar, &lnpi, &row[0]);
+      if (row[2] == 2) break;
+      step *= 0.5;
+    }
+    if (row[2] != 2) return std::numeric_limits<double>::quiet_NaN();
+  }
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+void CriteriaWLTMMC::satBatch(const vector<double> &betarw,
+  const double volume, vector<double> *data) const {
+  ASSERT(volume > 0, "volume(" << volume << ") must be positive");
+  vector<double> peAv, peVar;
+  peMoments_(&peAv, &peVar);
+  const int nStates = static_cast<int>(betarw.size());
+  data->resize(nStates*nRWBatchCols());
+  #ifdef _OPENMP
+  #pragma omp parallel
+  #endif  // _OPENMP
+  {
+    vector<long double> lnpi(nBin_);
+    #ifdef _OPENMP
+    #pragma omp for schedule(dynamic)
+    #endif  // _OPENMP
+    for (int state = 0; state < nStates; ++state) {
+      const double lnz = lnzSat(betarw[state], log(activ_));
+      rwState_(lnz, betarw[state], volume, peAv, peVar, &lnpi,
+               &(*data)[state*nRWBatchCols()]);
+    }
+  }
+}
+
 double CriteriaWLTMMC::lnPIrwsat_(const double activrw) {
   lnPIrw(activrw);
   vector<CriteriaWLTMMC> c = phaseSplit(lnPIrw_);
@@ -522,7 +757,8 @@ void CriteriaWLTMMC::initBins(const double mMax, const double mMin,
   } else if (mType_.compare("beta") == 0) {
     cTripleBanded_ = true;
   } else if ( (mType_.compare("pressure") == 0) ||
-              (mType_.compare("lnpres") == 0) ) {
+              (mType_.compare("lnpres") == 0) ||
+              (mType_.compare("Q6") == 0) ) {
     cTripleBanded_ = true;
   } else {
     ASSERT(0, "unrecognized macrostate type (" << mType_ << ")");
@@ -915,12 +1151,9 @@ int CriteriaWLTMMC::minNwlFlat(const vector<CriteriaWLTMMC*> c) {
 }
 
 void CriteriaWLTMMC::prefilColMat(const long double constant) {
-  C_.clear();
-  if (cTripleBanded_) {
-    C_.resize(nBin_, vector<long double>(3, constant));
-  } else {
-    C_.resize(nBin_, vector<long double>(nBin_, constant));
-  }
+  nColMat_ = (cTripleBanded_) ? 3 : nBin_;
+  C_.assign(nBin_*nColMat_, constant);
+  cRowSum_.assign(nBin_, nColMat_*constant);
 }
 
 void CriteriaWLTMMC::writeRestart(const char* fileName) {
@@ -936,7 +1169,7 @@ void CriteriaWLTMMC::writeRestart(const char* fileName) {
 
   if (collect_ && !tmmc_) {
     lnPIwlcomp.resize(lnPItmp.size());
-    c2lnPI(C_, &lnPIwlcomp);
+    c2lnPI(C_, cRowSum_, &lnPIwlcomp);
   }
 
   writeRestartBase(fileName);
@@ -951,7 +1184,9 @@ void CriteriaWLTMMC::writeRestart(const char* fileName) {
        << "# wlFlat " << wlFlat_ << endl
        << "# lnf " << lnf_ << endl
        << "# gwlmod " << g_ << endl
-       << "# mType " << mType_ << endl
+       << "# mType " << mType_ << endl;
+  if (mType_.compare("Q6") == 0) file << "# orderRCut " << orderRCut_ << endl;
+  file
        << std::setprecision(std::numeric_limits<long double>::digits10+2)
        << "# mMin " << mMin_ << endl
        << "# mMax " << mMax_ << endl
@@ -964,9 +1199,11 @@ void CriteriaWLTMMC::writeRestart(const char* fileName) {
 
   // header
   file << "# macrostate(" << mType_ << ") lnPi(m) ";
-  if (lnpi2pressure_.size() == C_.size()) file << "rho pressure ";
+  if (static_cast<int>(lnpi2pressure_.size()) == nBin_) {
+    file << "rho pressure ";
+  }
   file << "pe pe_stdev ";
-  if (peMUVT_.size() == C_.size()) file << "peMUVT ";
+  if (static_cast<int>(peMUVT_.size()) == nBin_) file << "peMUVT ";
   if (cTripleBanded_) file << "colMat(m-1) colMat(m) colMat(m+1) ";
   if (collect_ && !tmmc_) file << "lnPIwlcomp ";
   file << "h peNvalues ";
@@ -983,21 +1220,21 @@ void CriteriaWLTMMC::writeRestart(const char* fileName) {
     (*it)->lnPInorm();
   }
 
-  for (unsigned int i = 0; i < C_.size(); ++i) {
+  for (int i = 0; i < nBin_; ++i) {
     file << bin2m(i) << " ";
     file << std::setprecision(std::numeric_limits<long double>::digits10+2)
          << lnPItmp[i] << " ";
     file << std::setprecision(ss);
-    if (lnpi2pressure_.size() == C_.size()) {
+    if (static_cast<int>(lnpi2pressure_.size()) == nBin_) {
       file << bin2m(i)/volume_ << " " << lnpi2pressure_[i] << " ";
     }
     file << pe_[i].average() << " " << pe_[i].std() << " ";
-    if (peMUVT_.size() == C_.size()) {
+    if (static_cast<int>(peMUVT_.size()) == nBin_) {
       file << peMUVT_[i] << " ";
     }
-    for (unsigned int j = 0; j < C_[i].size(); ++j) {
+    for (int j = 0; j < nColMat_; ++j) {
       file << std::setprecision(std::numeric_limits<long double>::digits10+2)
-           << C_[i][j] << " ";
+           << C_[nColMat_*i + j] << " ";
     }
     file << std::setprecision(ss);
     if (collect_ && !tmmc_) file << lnPIwlcomp[i] << " ";
@@ -1055,9 +1292,10 @@ void CriteriaWLTMMC::readlnPIEnerCol(const char* fileName) {
     fs >> tmp[0] >> lnPI_[i] >> tmp[1] >> tmp[2] >> tmp[3] >> tmp[4] >> tmp[5];
     pe_[i].accumulate(tmp[1]);
     if (cTripleBanded_) {
-      C_[i][0] = tmp[3];
-      C_[i][1] = tmp[4];
-      C_[i][2] = tmp[5];
+      C_[3*i] = tmp[3];
+      C_[3*i + 1] = tmp[4];
+      C_[3*i + 2] = tmp[5];
+      cRowSum_[i] = C_[3*i] + C_[3*i + 1] + C_[3*i + 2];
     } else {
       ASSERT(0,
         "reading non-triple banded collection matrix is not implemented");
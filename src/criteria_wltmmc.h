@@ -38,6 +38,13 @@ class CriteriaWLTMMC : public Criteria {
      *  - beta : temperature expanded ensemble
      *  - pressure : thermodynamic pressure
      *  - lnpres : logarithmic pressure
+     *  - Q6 : global Steinhardt bond order of the first atom of each
+     *    molecule (see Space::bondOrder), recomputed after each trial.
+     *    Trials which change the number of molecules are not supported,
+     *    and trials which jump by more than one bin are rejected.
+     *
+     * orderRCut : neighbor cut-off distance for the Q6 macrostate
+     *   (default: 1.5).
      *
      * mMax : maximum floating point value of macrostate.
      * mMin : minimum floating point value of macrostate.
@@ -66,10 +73,14 @@ class CriteriaWLTMMC : public Criteria {
    *  "nmolstage", for number of molecules with growth expanded ensemble,
    *  "pairOrder" for order parameter defined by the Pair class,
    *  "beta" for inverse temperature,
-   *  "pressure" for the thermodynamic pressure, and
-   *  "lnpres" for logarithmic pressure. */
+   *  "pressure" for the thermodynamic pressure,
+   *  "lnpres" for logarithmic pressure, and
+   *  "Q6" for the global Steinhardt bond order. */
   string mType() const { return mType_; }
 
+  /// Return the neighbor cut-off distance of the Q6 macrostate.
+  double orderRCut() const { return orderRCut_; }
+
   /// Return minimum value of macrostate.
   double mMin() const { return mMin_; }
 
@@ -162,6 +173,16 @@ class CriteriaWLTMMC : public Criteria {
   void c2lnPI(const vector<vector<long double> > &col,
               vector<long double> *lnpiPtr);
 
+  /**
+   * Convert a flat collection matrix, col, with row sums, colRowSum, to
+   * the probability distribution, lnPI.
+   * The collection matrix is stored by rows of nColMat() elements, which
+   * are the transitions to m-1, m and m+1 if triple banded.
+   */
+  void c2lnPI(const vector<long double> &col,
+              const vector<long double> &colRowSum,
+              vector<long double> *lnpiPtr);
+
   /// Return area for a given lnPI.
   template<class T>
   double lnPIarea(const vector<T> &lnPI) const {
@@ -214,7 +235,7 @@ class CriteriaWLTMMC : public Criteria {
   /* Return phase boundaries, e.g. lnPI minima that are not first and last
    * points. */
   template<class T>
-  vector<int> lnPIphaseBoundary(const vector<T> &lnPI) {
+  vector<int> lnPIphaseBoundary(const vector<T> &lnPI) const {
     vector<int> min;
     if (phaseBoundary_ != 0) {
       min.push_back(phaseBoundary_);
@@ -299,6 +320,49 @@ class CriteriaWLTMMC : public Criteria {
   /// Reweight lnPI to different value of activity.
   void lnPIrw(const double activrw);
 
+  /**
+   * Reweight lnPI to each activity in activrw without changing lnPIrw().
+   * The normalized distributions are stored flat in lnPIrws, indexed by
+   * [iActiv*nBin() + bin].
+   */
+  void lnPIrw(const vector<double> &activrw,
+              vector<long double> *lnPIrws) const;
+
+  /**
+   * Reweight to each combination of ln(activity), lnzrw, and inverse
+   * temperature, betarw, in parallel.
+   * Temperature is extrapolated from the per-bin energy moments,
+   * lnPI(beta') = lnPI(beta) - dbeta<U> + dbeta^2(<U^2> - <U>^2)/2,
+   * and the average energy of each macrostate is extrapolated as
+   * <U>(beta') = <U> - dbeta(<U^2> - <U>^2). The macrostate must be the
+   * number of molecules. The energy moments U, U2 and NU are the averages
+   * of U, U^2 and NU over the reweighted distribution.
+   * Each state is a row of nRWBatchCols() values, stored flat in data, with
+   * columns given by rwBatchHeader(). The state index is iBeta*nLnz + iLnz.
+   */
+  void rwBatch(const vector<double> &lnzrw, const vector<double> &betarw,
+    const double volume, vector<double> *data) const;
+
+  /**
+   * Return the ln(activity) at which the two phases have equal probability,
+   * found by Newton iteration from lnzGuess at inverse temperature betarw.
+   * Return NaN if two phases are not found.
+   */
+  double lnzSat(const double betarw, const double lnzGuess) const;
+
+  /// Same as rwBatch, but reweight each betarw to saturation.
+  void satBatch(const vector<double> &betarw, const double volume,
+                vector<double> *data) const;
+
+  /// Return the number of columns of rwBatch.
+  static int nRWBatchCols() { return 14; }
+
+  /// Return the column names of rwBatch. Values of a missing phase are -1.
+  static string rwBatchHeader() {
+    return "lnz beta nPhases N U pressure N0 N1 pressure0 pressure1 lnArea0 "
+           "lnArea1 U2 NU";
+  }
+
 // HWH mins
 //  /** Reweight to saturation conditions my minizing the differences in peak
 //   *  heights. */
@@ -441,7 +505,16 @@ class CriteriaWLTMMC : public Criteria {
   vector<long double> lnPI() { return lnPI_; }
   vector<long double> lnPIrw() const { return lnPIrw_; }
   vector<long double> lnPIaggre() const { return lnPIaggre_; }
-  vector<vector<long double> > C() const { return C_; }
+  vector<vector<long double> > C() const;
+
+  /// Return the number of stored elements in each row of collection matrix.
+  int nColMat() const { return nColMat_; }
+
+  /// Return the flat collection matrix, as described in c2lnPI.
+  const vector<long double> & colMat() const { return C_; }
+
+  /// Return the sum of each row of the collection matrix.
+  const vector<long double> & colMatRowSum() const { return cRowSum_; }
   double lastbin2m() const { return bin2m(nBin_ - 1); }
   double mOld() const { return mOld_; }
   double mNew() const { return mNew_; }
@@ -473,6 +546,17 @@ class CriteriaWLTMMC : public Criteria {
 
  protected:
   string mType_;      //!< definition of macrostate
+  double orderRCut_;  //!< neighbor cut-off distance of Q6 macrostate
+
+  /// Space of the current trial for the Q6 macrostate, set by store.
+  /// It is not owned, and is only dereferenced by the accept which follows
+  /// the store that set it.
+  Space* orderSpace_;
+
+  /// Q6 of the configuration after the last trial, which is reused by the
+  /// next store if orderSpace_ is unmodified (see Space::revision)
+  double orderCache_;
+  long long orderCacheRevision_;  //!< revision when orderCache_ was stored
   double mMin_;       //!< minimum value of macrostate
   double mMax_;      //!< maximum value of macrostate
   int nBin_;          //!< number of bins for macrostate
@@ -487,7 +571,12 @@ class CriteriaWLTMMC : public Criteria {
   vector<Accumulator> pe_;    //!< nvt potential energy
   vector<double> peMUVT_;     //!< muvt potential energy, U^MUVT=sum(PI(N)*U(N))
   bool cTripleBanded_;        //!< is collection matrix triple banded
-  vector<vector<long double> > C_;     //!< collection matrix
+  vector<long double> C_;     //!< flat collection matrix, [bin*nColMat_ + j]
+  vector<long double> cRowSum_;  //!< sum of each row of collection matrix
+  int nColMat_;               //!< elements in each collection matrix row
+
+  // buffers for the sum of collection matrices over windows
+  vector<long double> cSumBuf_, cRowSumBuf_;
 
   /// number of times the system moves back and forth between mMin to mMax
   int nTunnels_;
@@ -529,6 +618,14 @@ class CriteriaWLTMMC : public Criteria {
   double volume_;                 //!< volume of space, input from pressure
 
   void setlnPI_(const int index, const long double &val) { lnPI_[index] = val; }
+
+  // reweight to one state into lnpi, and store the rwBatch row in row
+  void rwState_(const double lnz, const double beta, const double volume,
+    const vector<double> &peAv, const vector<double> &peVar,
+    vector<long double> *lnpi, double *row) const;
+
+  // store the per-bin average and variance of the potential energy
+  void peMoments_(vector<double> *peAv, vector<double> *peVar) const;
   int phaseBoundary_;           //!< bin index for setting phase boundary
 
   /// defaults in constructor
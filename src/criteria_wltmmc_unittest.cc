@@ -13,6 +13,11 @@
 #include "criteria.h"
 #include "criteria_metropolis.h"
 #include "criteria_wltmmc.h"
+#include "pair_lj.h"
+#include "mc.h"
+#include "trial_add.h"
+#include "trial_delete.h"
+#include "trial_transform.h"
 
 using namespace feasst;
 
@@ -229,3 +234,122 @@ TEST(CriteriaWLTMMC, mMaxVSmMaxCenter) {
   EXPECT_EQ(c1->mMax(), c2->mMax());
 }
 
+
+TEST(CriteriaWLTMMC, flatColMatANDlnPIrwVec) {
+  const double beta = 1./1.5, activ = exp(-1.568214);
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molType", "../forcefield/data.atom"}});
+  shared_ptr<CriteriaWLTMMC> c = make_shared<CriteriaWLTMMC>(beta, activ,
+    "nmol", 0, 5);
+  MC mc(&s, &p, c.get());
+  transformTrial(&mc, "translate");
+  deleteTrial(&mc);
+  addTrial(&mc, "../forcefield/data.atom");
+  c->collectInit();
+  c->tmmcInit();
+  mc.runNumTrials(500);
+
+  // cached row sums match the triple banded collection matrix
+  EXPECT_EQ(3, c->nColMat());
+  const vector<vector<long double> > col = c->C();
+  EXPECT_EQ(c->nBin(), static_cast<int>(col.size()));
+  long double nUpdate = 0.;
+  for (int bin = 0; bin < c->nBin(); ++bin) {
+    EXPECT_NEAR(col[bin][0] + col[bin][1] + col[bin][2],
+                c->colMatRowSum()[bin], 1e-10);
+    nUpdate += c->colMatRowSum()[bin];
+  }
+  EXPECT_GT(nUpdate, 0.);
+
+  // flat and nested collection matrices give the same lnPI
+  vector<long double> lnpiNested(c->nBin()), lnpiFlat(c->nBin());
+  c->c2lnPI(col, &lnpiNested);
+  c->c2lnPI(c->colMat(), c->colMatRowSum(), &lnpiFlat);
+  for (int bin = 0; bin < c->nBin(); ++bin) {
+    EXPECT_NEAR(lnpiNested[bin], lnpiFlat[bin], 1e-12);
+  }
+
+  // summing a window with itself leaves lnPI unchanged
+  c->lnPIupdate();
+  const vector<long double> lnpi = c->lnPI();
+  c->lnPIupdate({c, c});
+  for (int bin = 0; bin < c->nBin(); ++bin) {
+    EXPECT_NEAR(lnpi[bin], c->lnPI()[bin], 1e-12);
+  }
+
+  // reweight to many activities at once
+  const vector<double> activrw = {activ, 0.5*activ, 2.*activ};
+  vector<long double> lnpirws;
+  c->lnPIrw(activrw, &lnpirws);
+  EXPECT_EQ(3*c->nBin(), static_cast<int>(lnpirws.size()));
+  for (int ia = 0; ia < 3; ++ia) {
+    c->lnPIrw(activrw[ia]);
+    for (int bin = 0; bin < c->nBin(); ++bin) {
+      EXPECT_NEAR(c->lnPIrw()[bin], lnpirws[ia*c->nBin() + bin], 1e-12);
+    }
+  }
+}
+
+TEST(CriteriaWLTMMC, rwBatchANDlnzSat) {
+  const double beta = 1./0.7, activ = 0.0183156, volume = 512;
+  CriteriaWLTMMC c(beta, activ, "nmol", 0, 255);
+  c.readCollectMat("../unittest/colMat3.txt");
+
+  // batch reweighting matches reweighting one activity at a time
+  const vector<double> lnzs = {log(activ), log(activ) - 0.1, -4.2};
+  vector<double> data;
+  c.rwBatch(lnzs, {beta}, volume, &data);
+  const int nCols = CriteriaWLTMMC::nRWBatchCols();
+  EXPECT_EQ(3*nCols, static_cast<int>(data.size()));
+  for (int i = 0; i < 3; ++i) {
+    c.lnPIrw(exp(lnzs[i]));
+    EXPECT_NEAR(lnzs[i], data[i*nCols], 1e-15);
+    EXPECT_NEAR(c.lnPIrwaverage(), data[i*nCols + 3], 1e-8);
+    EXPECT_EQ(c.lnPIrwnumPhases(), data[i*nCols + 2]);
+    EXPECT_NEAR(c.lnPIrwpressure(volume), data[i*nCols + 5], 1e-8);
+  }
+
+  // at saturation, both phases are equally probable
+  const double lnzsat = c.lnzSat(beta, log(activ));
+  ASSERT_FALSE(std::isnan(lnzsat));
+  c.satBatch({beta}, volume, &data);
+  EXPECT_EQ(2, data[2]);
+  EXPECT_NEAR(lnzsat, data[0], 1e-12);
+  EXPECT_NEAR(data[10], data[11], 1e-8);
+  EXPECT_NEAR(data[10], log(0.5), 1e-8);
+  EXPECT_LT(data[6], data[7]);
+}
+
+TEST(CriteriaWLTMMC, rwBatchEnergyMoments) {
+  const double beta = 1./1.5, activ = exp(-1.568214);
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molType", "../forcefield/data.atom"}});
+  CriteriaWLTMMC c(beta, activ, "nmol", 0, 5);
+  MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate");
+  deleteTrial(&mc);
+  addTrial(&mc, "../forcefield/data.atom");
+  c.collectInit();
+  c.tmmcInit();
+  mc.runNumTrials(2000);
+
+  // energy moments satisfy dN/dbeta = -(<NU> - <N><U>) at constant lnz
+  const double db = 1e-5;
+  const int nCols = CriteriaWLTMMC::nRWBatchCols();
+  vector<double> data;
+  c.rwBatch({log(activ)}, {beta - db, beta, beta + db}, s.volume(), &data);
+  const double *row = &data[nCols];
+  const double covNU = row[13] - row[3]*row[4];
+  EXPECT_GT(row[12] - row[4]*row[4], 0.);
+  EXPECT_LT(row[4], 0.);
+  EXPECT_NEAR((data[2*nCols + 3] - data[3])/(2.*db), -covNU,
+              1e-4*fabs(covNU));
+
+  // reweighting with energy moments assumes the macrostate is nmol
+  CriteriaWLTMMC cEnergy(beta, activ, "energy", -10, 0, 10);
+  try {
+    cEnergy.rwBatch({log(activ)}, {beta}, s.volume(), &data);
+    CATCH_PHRASE("assumes the macrostate is nmol");
+  }
+}
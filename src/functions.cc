@@ -104,29 +104,45 @@ void ranInitForRepro(const int seed) {
 }
 
 vector<vector<double> > quat2rot(vector<double> q) {
-  vector<vector<double> > r(3, vector<double>(3));
   ASSERT(q.size() == 4, "1quaterion is a 4d vector in 3d");
-  r[0][0] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
-  r[1][0] = 2*(q[0]*q[1] + q[2]*q[3]);
-  r[2][0] = 2*(q[2]*q[0] - q[1]*q[3]);
-  r[0][1] = 2*(q[0]*q[1] - q[2]*q[3]);
-  r[1][1] = q[1]*q[1] - q[2]*q[2] - q[0]*q[0] + q[3]*q[3];
-  r[2][1] = 2*(q[1]*q[2] + q[0]*q[3]);
-  r[0][2] = 2*(q[2]*q[0] + q[1]*q[3]);
-  r[1][2] = 2*(q[1]*q[2] - q[0]*q[3]);
-  r[2][2] = q[2]*q[2] - q[0]*q[0] - q[1]*q[1] + q[3]*q[3];
+  double rot[9];
+  quat2rot(&q[0], rot);
+  vector<vector<double> > r(3, vector<double>(3));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) r[i][j] = rot[3*i+j];
+  }
   return r;
 }
 
+void quat2rot(const double *q, double *r) {
+  r[0] = q[0]*q[0] - q[1]*q[1] - q[2]*q[2] + q[3]*q[3];
+  r[3] = 2*(q[0]*q[1] + q[2]*q[3]);
+  r[6] = 2*(q[2]*q[0] - q[1]*q[3]);
+  r[1] = 2*(q[0]*q[1] - q[2]*q[3]);
+  r[4] = q[1]*q[1] - q[2]*q[2] - q[0]*q[0] + q[3]*q[3];
+  r[7] = 2*(q[1]*q[2] + q[0]*q[3]);
+  r[2] = 2*(q[2]*q[0] + q[1]*q[3]);
+  r[5] = 2*(q[1]*q[2] - q[0]*q[3]);
+  r[8] = q[2]*q[2] - q[0]*q[0] - q[1]*q[1] + q[3]*q[3];
+}
+
 vector<vector<double> > theta2rot(double theta) {
+  double rot[4];
+  theta2rot(theta, rot);
   vector<vector<double> > r(2, vector<double>(2));
-  r[0][0] = cos(theta);
-  r[0][1] = -sin(theta);
-  r[1][0] = -r[0][1];
-  r[1][1] = r[0][0];
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < 2; ++j) r[i][j] = rot[2*i+j];
+  }
   return r;
 }
 
+void theta2rot(const double theta, double *r) {
+  r[0] = cos(theta);
+  r[1] = -sin(theta);
+  r[2] = -r[1];
+  r[3] = r[0];
+}
+
 vector<vector<double> > matMul(const vector<vector<double> > &a,
   const vector<vector<double> > &b) {
   vector<vector<double> > c(int(a.size()), vector<double>(int(b[0].size())));
@@ -465,28 +481,141 @@ double complexVec2norm(vector<std::complex<double> > compVec) {
   return norm;
 }
 
+void sphericalHarmonics(const int l, const double *r, double *re,
+  double *im) {
+  const double rxy2 = r[0]*r[0] + r[1]*r[1],
+               rr = sqrt(rxy2 + r[2]*r[2]),
+               ct = r[2]/rr,
+               st = sqrt(std::max(0., 1. - ct*ct));
+  double cphi = 1., sphi = 0.;
+  if (rxy2 > 0.) {
+    const double rxy = sqrt(rxy2);
+    cphi = r[0]/rxy;
+    sphi = r[1]/rxy;
+  }
+
+  // associated Legendre polynomials, P_l^m(cos(theta)), by recursion in l
+  // from P_m^m, and exp(i*m*phi) by recursion in m
+  double pmm = 1., cmphi = 1., smphi = 0.;
+  for (int m = 0; m <= l; ++m) {
+    if (m > 0) {
+      pmm *= -static_cast<double>(2*m - 1)*st;
+      const double c = cmphi*cphi - smphi*sphi;
+      smphi = smphi*cphi + cmphi*sphi;
+      cmphi = c;
+    }
+    double plm = pmm;
+    if (l > m) {
+      double plm2 = pmm;
+      plm = ct*(2*m + 1)*pmm;
+      for (int ll = m + 2; ll <= l; ++ll) {
+        const double plmNew = ((2*ll - 1)*ct*plm - (ll + m - 1)*plm2)
+                            /static_cast<double>(ll - m);
+        plm2 = plm;
+        plm = plmNew;
+      }
+    }
+
+    // normalization, sqrt((2l+1)/(4pi) (l-m)!/(l+m)!)
+    double norm = (2*l + 1)/(4.*PI);
+    for (int k = l - m + 1; k <= l + m; ++k) norm /= static_cast<double>(k);
+    norm = sqrt(norm);
+    re[m] = norm*plm*cmphi;
+    im[m] = norm*plm*smphi;
+  }
+}
+
+/// Return the factorial as a double, to avoid integer overflow.
+static double factorialDouble_(const int x) {
+  double result = 1.;
+  for (int i = 2; i <= x; ++i) result *= static_cast<double>(i);
+  return result;
+}
+
+double wigner3j(const int l1, const int l2, const int l3,
+  const int m1, const int m2, const int m3) {
+  if ( (m1 + m2 + m3 != 0) || (abs(m1) > l1) || (abs(m2) > l2) ||
+       (abs(m3) > l3) || (l3 < abs(l1 - l2)) || (l3 > l1 + l2) ) {
+    return 0.;
+  }
+  const double delta = factorialDouble_(l1 + l2 - l3)
+    *factorialDouble_(l1 - l2 + l3)*factorialDouble_(-l1 + l2 + l3)
+    /factorialDouble_(l1 + l2 + l3 + 1);
+  const double pre = sqrt(delta*factorialDouble_(l1 + m1)
+    *factorialDouble_(l1 - m1)*factorialDouble_(l2 + m2)
+    *factorialDouble_(l2 - m2)*factorialDouble_(l3 + m3)
+    *factorialDouble_(l3 - m3));
+  const int kMin = std::max(0, std::max(l2 - l3 - m1, l1 - l3 + m2)),
+            kMax = std::min(l1 + l2 - l3, std::min(l1 - m1, l2 + m2));
+  double sum = 0.;
+  for (int k = kMin; k <= kMax; ++k) {
+    const double term = 1./(factorialDouble_(k)
+      *factorialDouble_(l3 - l2 + k + m1)*factorialDouble_(l3 - l1 + k - m2)
+      *factorialDouble_(l1 + l2 - l3 - k)*factorialDouble_(l1 - k - m1)
+      *factorialDouble_(l2 - k + m2));
+    sum += (k % 2 == 0) ? term : -term;
+  }
+  const int phase = l1 - l2 - m3;
+  return ( (abs(phase) % 2 == 0) ? 1. : -1.)*pre*sum;
+}
+
+void symEigenvalues3(const double *a, double *evalues) {
+  // trigonometric solution of the characteristic equation
+  const double p1 = a[1]*a[1] + a[2]*a[2] + a[5]*a[5];
+  const double q = (a[0] + a[4] + a[8])/3.;
+  if (p1 == 0.) {
+    evalues[0] = a[0];
+    evalues[1] = a[4];
+    evalues[2] = a[8];
+  } else {
+    const double p2 = (a[0] - q)*(a[0] - q) + (a[4] - q)*(a[4] - q)
+                    + (a[8] - q)*(a[8] - q) + 2.*p1;
+    const double p = sqrt(p2/6.);
+    double b[9];
+    for (int i = 0; i < 9; ++i) b[i] = a[i]/p;
+    for (int i = 0; i < 3; ++i) b[4*i] -= q/p;
+    const double detb = b[0]*(b[4]*b[8] - b[5]*b[7])
+                      - b[1]*(b[3]*b[8] - b[5]*b[6])
+                      + b[2]*(b[3]*b[7] - b[4]*b[6]);
+    const double r = std::max(-1., std::min(1., 0.5*detb));
+    const double phi = acos(r)/3.;
+    evalues[2] = q + 2.*p*cos(phi);
+    evalues[0] = q + 2.*p*cos(phi + 2.*PI/3.);
+    evalues[1] = 3.*q - evalues[0] - evalues[2];
+  }
+  std::sort(evalues, evalues + 3);
+}
+
 int feasstRound(double x) { return floor(x + 0.5); }
 
 vector<vector<double> > Euler2RotMat(const vector<double> euler) {
   ASSERT(euler.size() == 3, "assumes 3D, but size of euler is "
     << euler.size());
+  double rot[9];
+  Euler2RotMat(&euler[0], rot);
   vector<vector<double> > R(3, vector<double>(3));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) R[i][j] = rot[3*i+j];
+  }
+  return R;
+}
+
+void Euler2RotMat(const double *euler, double *R) {
   const double sphi = sin(euler[0]),
                cphi = cos(euler[0]),
                stheta = sin(euler[1]),
                ctheta = cos(euler[1]),
                spsi = sin(euler[2]),
                cpsi = cos(euler[2]);
-  R[0][0] = cpsi*cphi - ctheta*sphi*spsi; //a11
-  R[0][1] = cpsi*sphi + ctheta*cphi*spsi; //a12
-  R[0][2] = spsi*stheta;                  //a13
-  R[1][0] = -spsi*cphi - ctheta*sphi*cpsi;//a21
-  R[1][1] = -spsi*sphi + ctheta*cphi*cpsi;//a22
-  R[1][2] = cpsi*stheta;                  //a23
-  R[2][0] = stheta*sphi;                  //a31
-  R[2][1] = -stheta*cphi;                 //a32
-  R[2][2] = ctheta;                       //a33
-  return R;
+  R[0] = cpsi*cphi - ctheta*sphi*spsi; //a11
+  R[1] = cpsi*sphi + ctheta*cphi*spsi; //a12
+  R[2] = spsi*stheta;                  //a13
+  R[3] = -spsi*cphi - ctheta*sphi*cpsi;//a21
+  R[4] = -spsi*sphi + ctheta*cphi*cpsi;//a22
+  R[5] = cpsi*stheta;                  //a23
+  R[6] = stheta*sphi;                  //a31
+  R[7] = -stheta*cphi;                 //a32
+  R[8] = ctheta;                       //a33
 }
 
 vector<vector<double> > RotMat2Euler(const vector<vector<double> > rotMat) {
@@ -186,9 +186,16 @@ void ranInitForRepro(const int seed = 1346867550);
  */
 vector<vector<double> > quat2rot(vector<double> quaternion);
 
+/// Fill the 3x3 rotation matrix, rot[3*i+j], from the quaternion q[4],
+/// without allocation.
+void quat2rot(const double *q, double *rot);
+
 /// \return 2d rotation matrix from angle
 vector<vector<double> > theta2rot(double theta);
 
+/// Fill the 2x2 rotation matrix, rot[2*i+j], from angle.
+void theta2rot(const double theta, double *rot);
+
 /// \return product of all elements of a vector
 template<class T>
 T product(const vector<T> &vec) {
@@ -464,6 +471,22 @@ vector<std::complex<double> > cart2sphereHarm6(vector<double> rCart);
 /// \return sum of vector of complex numbers multiplied by its conjugate
 double complexVec2norm(vector<std::complex<double> > compVec);
 
+/**
+ * Fill re[m] and im[m], for m = 0, ..., l, with the spherical harmonics,
+ * Y_l^m, in the direction of the cartesian vector r[3], without allocation.
+ * Includes the Condon-Shortley phase, such that
+ * Y_l^{-m} = (-1)^m conj(Y_l^m).
+ */
+void sphericalHarmonics(const int l, const double *r, double *re, double *im);
+
+/// \return the Wigner 3j symbol, (l1 l2 l3; m1 m2 m3), from the Racah formula.
+double wigner3j(const int l1, const int l2, const int l3,
+  const int m1, const int m2, const int m3);
+
+/// Fill evalues[3] with the eigenvalues, in ascending order, of the symmetric
+/// 3x3 matrix a[3*i+j].
+void symEigenvalues3(const double *a, double *evalues);
+
 /** \return rounded double to nearest integer. This rounding is implemented
  *  as floor(x+0.5), such that feasstRound(-0.5) == 0. The cplusplus library
  *  round(-0.5) from math.h results in round(-0.5) == -1, such that rounding
@@ -482,6 +505,10 @@ int feasstRound(double x);
  */
 vector<vector<double> > Euler2RotMat(const vector<double> euler);
 
+/// Fill the 3x3 rotation matrix, rot[3*i+j], from euler angles, euler[3],
+/// without allocation.
+void Euler2RotMat(const double *euler, double *rot);
+
 /// \return euler angles from rotation matrix (same convention as Euler2RotMat)
 vector<vector<double> > RotMat2Euler(const vector<vector<double> > rotMat);
 
@@ -132,6 +132,23 @@ TEST(Functions, quat2rot) {
   EXPECT_EQ(r[2][1], 0);
 }
 
+TEST(Functions, quat2rotFlat) {
+  BaseRandom ran;
+  double q[4], rot[9], euler[3] = {0.3, 1.2, -2.1};
+  ran.quatRandomInPlace(q);
+  EXPECT_NEAR(1., q[0]*q[0] + q[1]*q[1] + q[2]*q[2] + q[3]*q[3], 1e-14);
+  quat2rot(q, rot);
+  vector<vector<double> > r = quat2rot(vector<double>(q, q + 4));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) EXPECT_EQ(r[i][j], rot[3*i+j]);
+  }
+  Euler2RotMat(euler, rot);
+  r = Euler2RotMat(vector<double>(euler, euler + 3));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) EXPECT_EQ(r[i][j], rot[3*i+j]);
+  }
+}
+
 TEST(Functions, product) {
   vector<double> x(4);
   x.at(0) = 1.5; x.at(1) = 2.3; x.at(2) = 3.5; x.at(3) = 50;
@@ -623,3 +640,21 @@ TEST(Functions, vecRestartPrinter) {
   }
 }
 
+
+TEST(Functions, wigner3j) {
+  EXPECT_NEAR(1./sqrt(3.), wigner3j(1, 1, 0, 1, -1, 0), 1e-14);
+  EXPECT_NEAR(-sqrt(2./35.), wigner3j(2, 2, 2, 0, 0, 0), 1e-14);
+  EXPECT_NEAR(-0.09305950021129075, wigner3j(6, 6, 6, 0, 0, 0), 1e-14);
+  EXPECT_EQ(0., wigner3j(6, 6, 6, 1, 1, 1));
+}
+
+TEST(Functions, symEigenvalues3) {
+  const double a[9] = {2., 1., 0.,
+                       1., 2., 0.,
+                       0., 0., 5.};
+  double evalues[3];
+  symEigenvalues3(a, evalues);
+  EXPECT_NEAR(1., evalues[0], 1e-14);
+  EXPECT_NEAR(3., evalues[1], 1e-14);
+  EXPECT_NEAR(5., evalues[2], 1e-14);
+}
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <climits>
 #include "./trial_add.h"
 #include "./trial_delete.h"
 #include "./trial_transform.h"
@@ -98,6 +99,12 @@ MC::MC(const char* fileName) {
   }
 
   nAttempts_ = fstoll("nAttempts", fileName);
+  strtmp = fstos("rngSeed", fileName);
+  if (!strtmp.empty()) {
+    rngSeed_ = stoull(strtmp);
+    rngWindow_ = fstoi("rngWindow", fileName);
+    rngWalker_ = fstoi("rngWalker", fileName);
+  }
   logFileName_ = fstos("logFileName", fileName);
   nFreqLog_ = fstoi("nFreqLog", fileName);
   strtmp = fstos("nFreqXTC", fileName);
@@ -107,7 +114,17 @@ MC::MC(const char* fileName) {
   }
 
   nFreqCheckE_ = fstoi("nFreqCheckE", fileName);
+  strtmp = fstos("nSampleCheckE", fileName);
+  if (!strtmp.empty()) {
+    nSampleCheckE_ = stoi(strtmp);
+    nFreqFullCheckE_ = fstoi("nFreqFullCheckE", fileName);
+  }
   nFreqTune_ = fstoi("nFreqTune", fileName);
+  strtmp = fstos("nFreqAdapt", fileName);
+  if (!strtmp.empty()) {
+    nFreqAdapt_ = stoll(strtmp);
+    adaptMinProb_ = fstod("adaptMinProb", fileName);
+  }
   nFreqRestart_ = fstoi("nFreqRestart", fileName);
   checkEtol_ = fstod("checkEtol", fileName);
   strtmp = fstos("production", fileName);
@@ -129,6 +146,7 @@ MC::MC(const char* fileName) {
 
   // initialize energy
   pair_->initEnergy();
+  peRun_ = pair_->peTot();
 
   // print to log file, but comment out the initial line (to test restarts)
   printLogHeader_ = 2;
@@ -144,12 +162,23 @@ void MC::defaultConstruction_() {
   nFreqLog_ = 1e6;
   nFreqXTC_ = 0;
   nFreqCheckE_ = 1e6;
+  nSampleCheckE_ = 0;
+  nFreqFullCheckE_ = 0;
+  nCheckE_ = 0;
+  nCheckEFull_ = 0;
+  maxSampleDiffE_ = 0.;
+  peRun_ = 0.;
   nFreqTune_ = 0;
+  nFreqAdapt_ = 0;
+  adaptMinProb_ = 0.;
   nFreqRestart_ = 1e8;
   printLogHeader_ = 1;
   checkEtol_ = 1e-7;
   nAttempts_ = 0;
   production_ = 0;
+  rngSeed_ = 0;
+  rngWindow_ = 0;
+  rngWalker_ = 0;
   setProductionFileDescription();
 }
 
@@ -216,7 +245,11 @@ void MC::reconstruct() {
     }
   }
 
-  // clone and reconstruct all analyzers
+  // clone and reconstruct all analyzers, with a new pipeline
+  if (analysisPipeline_) {
+    analysisPipeline_->flush();
+    analysisPipeline_ = analysisPipeline_->cloneShrPtr();
+  }
   for (unsigned int ia = 0; ia < analyzeVec_.size(); ++ia) {
     shared_ptr<Analyze> an = analyzeVec_[ia]->cloneShrPtr(pair);
     analyzeVec_[ia] = an;
@@ -248,11 +281,29 @@ void MC::initTrial(shared_ptr<Trial> trial) {
   trial->reconstruct(pair_, criteria_);
   trialVec_.push_back(trial);
   trialWeight_.push_back(weight);
+  if (rngSeed_ != 0) {
+    trial->initRNG(rngSeed_, rngWindow_, rngWalker_, 3 + nTrials());
+  }
 
   // update cumulative probability of trials
   updateCumulativeProb_();
 }
 
+void MC::seedRNG(const unsigned long long seed, const int window,
+  const int walker) {
+  ASSERT(seed != 0, "seed must be nonzero");
+  rngSeed_ = seed;
+  rngWindow_ = window;
+  rngWalker_ = walker;
+  initRNG(seed, window, walker, 0);
+  space_->initRNG(seed, window, walker, 1);
+  pair_->initRNG(seed, window, walker, 2);
+  criteria_->initRNG(seed, window, walker, 3);
+  for (int t = 0; t < nTrials(); ++t) {
+    trialVec_[t]->initRNG(seed, window, walker, 4 + t);
+  }
+}
+
 void MC::removeTrial(int iTrial) {
   if (iTrial == -1) iTrial = nTrials() - 1;
   ASSERT(iTrial < nTrials(), "iTrial(" << iTrial << ") is too big,"
@@ -279,11 +330,26 @@ void MC::attemptTrial() {
   // catch errors and potential problems on first attempt
   if (nAttempts_ == 0) {
     pair_->initEnergy();
+    peRun_ = pair_->peTot();
     ASSERT(trialVec_.size() != 0, "no trial moves defined");
   }
 
-  const int itrial = ranFromCPDF(trialCumulativeProb_);
-  trialVec_[itrial]->attempt();
+  const int itrial = ranFromAlias(trialAliasProb_, trialAlias_);
+  #ifdef FEASST_PROFILE_
+    Profile::Scope profileScope(&profile_);
+    const long long nInteractions = profile_.nInteractions();
+    const Profile::clock::time_point start = Profile::clock::now();
+  #endif  // FEASST_PROFILE_
+  if (nFreqAdapt_ > 0) {
+    attemptAdapt_(itrial);
+  } else {
+    trialVec_[itrial]->attempt();
+  }
+  #ifdef FEASST_PROFILE_
+    profile_.addTrial(itrial, Profile::seconds(start),
+                      profile_.nInteractions() - nInteractions);
+  #endif  // FEASST_PROFILE_
+  peRun_ += trialVec_[itrial]->de();
   peAccumulator_.accumulate(pair_->peTot());
   nMolAccumulator_.accumulate(space_->nMol());
   ++nAttempts_;
@@ -298,6 +364,7 @@ void MC::zeroStat() {
   }
   peAccumulator_.reset();
   nMolAccumulator_.reset();
+  profile_.zeroStat();
   nAttempts_ = 0;
 }
 
@@ -308,11 +375,11 @@ void MC::printStat() {
     std::ofstream log_(logFileName_.c_str(),
                        std::ofstream::out | std::ofstream::app);
     if (printLogHeader_ > 0) {
-      log_ << "#attempts pe/nMol ";
-      for (unsigned int i = 0; i < trialVec_.size(); ++i) {
-        log_ << trialVec_[i]->printStat(true);
-      }
-      log_ << "configID" << endl;
+      log_ << "#" << statLine(true) << "configID";
+      #ifdef FEASST_PROFILE_
+        log_ << " " << profile_.printStat(trialNames_(), true);
+      #endif  // FEASST_PROFILE_
+      log_ << endl;
       if (printLogHeader_ == 2) {
         printLogHeader_ = -1;
       } else {
@@ -323,14 +390,45 @@ void MC::printStat() {
       log_ << "# ";
       printLogHeader_ = 0;
     }
-    log_ << nAttempts_ << " " << pePerMol() << " ";
-    for (unsigned int k = 0; k < trialVec_.size(); ++k) {
-      log_ << trialVec_[k]->printStat(false);
-    }
-    log_ << space_->configID() << endl;
+    log_ << statLine() << space_->configID();
+    #ifdef FEASST_PROFILE_
+      log_ << " " << profile_.printStat(trialNames_());
+    #endif  // FEASST_PROFILE_
+    log_ << endl;
   }
 }
 
+string MC::statLine(const bool header) {
+  stringstream ss;
+  if (header) {
+    ss << "attempts pe/nMol ";
+  } else {
+    ss << nAttempts_ << " " << pePerMol() << " ";
+  }
+  for (unsigned int t = 0; t < trialVec_.size(); ++t) {
+    ss << trialVec_[t]->printStat(header);
+  }
+  return ss.str();
+}
+
+void MC::printProfile() {
+  if (logFileName_.empty()) {
+    cout << profile_.summary(trialNames_());
+  } else {
+    std::ofstream log_(logFileName_.c_str(),
+                       std::ofstream::out | std::ofstream::app);
+    log_ << profile_.summary(trialNames_());
+  }
+}
+
+vector<string> MC::trialNames_() {
+  vector<string> names;
+  for (unsigned int t = 0; t < trialVec_.size(); ++t) {
+    names.push_back(trialVec_[t]->className());
+  }
+  return names;
+}
+
 double MC::pePerMol() {
   double pe = 0;
   if (space_->nMol() != 0) pe = pair_->peTot()/space_->nMol();
@@ -462,6 +560,7 @@ void MC::nMolSeek(
       /// scale volume to exactly the same as before
       space_->scaleDomain(originalVolume/space_->volume());
       pair_->initEnergy();
+      peRun_ = pair_->peTot();
       ASSERT(fabs((space_->volume() - originalVolume)/originalVolume) < DTOL,
         "volume(" << space_->volume() << ") is not same as before nMolSeek("
         << originalVolume << "). Difference: "
@@ -508,11 +607,11 @@ void MC::afterAttemptBase_() {
   // check energy, cell list and neigh list
   if (nFreqCheckE_ > 0) {
     if (nAttempts_ % nFreqCheckE_ == 0) {
-      if (space_->cellType() > 0) {
-        space_->checkCellList();
+      if (nSampleCheckE_ > 0) {
+        checkSample_();
+      } else {
+        checkFull_();
       }
-      pair_->checkEnergy(checkEtol_, 0);
-      if (pair_->neighOn()) pair_->checkNeigh();
     }
   }
 
@@ -568,15 +667,34 @@ void MC::afterAttemptBase_() {
     tuneTrialParameters_();
   }
 
+  // adapt trial weights
+  if ( (nFreqAdapt_ > 0) && (nAttempts_ % nFreqAdapt_ == 0) ) {
+    adaptTrialWeights_();
+  }
+
   // run analyzers if not multiple macrostates (e.g., no WLTMMC)
   if (className_.compare("MC") == 0) {
-    for (vector<shared_ptr<Analyze>>::iterator it = analyzeVec_.begin();
-         it != analyzeVec_.end(); ++it) {
-      if (nAttempts_ % (*it)->nFreq() == 0) {
-        (*it)->update();
-      }
-      if (nAttempts_ % (*it)->nFreqPrint() == 0) {
+    runAnalyze_();
+  }
+}
+
+void MC::runAnalyze_(const int iMacro, CriteriaWLTMMC *c) {
+  if (analyzeVec_.size() == 0) return;
+  FEASST_PROFILE(ANALYZE);
+  if (analysisPipeline_) {
+    analysisPipeline_->push(analyzeVec_, pair_, nAttempts_, iMacro, c);
+    return;
+  }
+  for (vector<shared_ptr<Analyze>>::iterator it = analyzeVec_.begin();
+       it != analyzeVec_.end(); ++it) {
+    if (nAttempts_ % (*it)->nFreq() == 0) {
+      (*it)->update(iMacro);
+    }
+    if (nAttempts_ % (*it)->nFreqPrint() == 0) {
+      if (c == NULL) {
         (*it)->write();
+      } else {
+        (*it)->write(c);
       }
     }
   }
@@ -604,6 +722,10 @@ void MC::run() {
   for (long long i = 0; i < npr_; ++i) {
     attemptTrial();
   }
+  flushAnalyze();
+  #ifdef FEASST_PROFILE_
+    printProfile();
+  #endif  // FEASST_PROFILE_
 }
 
 int MC::checkTrialCriteria() {
@@ -625,6 +747,7 @@ int MC::checkTrialCriteria() {
 }
 
 void MC::writeRestart(const char* fileName) {
+  FEASST_PROFILE(RESTART);
   fileBackUp(fileName);
   std::ofstream file(fileName);
   file << "# className " << className_ << endl;
@@ -657,16 +780,30 @@ void MC::writeRestart(const char* fileName) {
   file << "# nFreqXTC " << nFreqXTC_ << endl;
   file << "# XTCFileName " << XTCFileName_ << endl;
   file << "# nFreqCheckE " << nFreqCheckE_ << endl;
+  if (nSampleCheckE_ > 0) {
+    file << "# nSampleCheckE " << nSampleCheckE_ << endl;
+    file << "# nFreqFullCheckE " << nFreqFullCheckE_ << endl;
+  }
   file << "# nFreqTune " << nFreqTune_ << endl;
+  if (nFreqAdapt_ > 0) {
+    file << "# nFreqAdapt " << nFreqAdapt_ << endl;
+    file << "# adaptMinProb " << adaptMinProb_ << endl;
+  }
   file << "# nFreqRestart " << nFreqRestart_ << endl;
   file << "# checkEtol " << checkEtol_ << endl;
   if (production_ == 1) file << "# production " << production_ << endl;
   file << "# prodFileAppend " << prodFileAppend_ << endl;
+  if (rngSeed_ != 0) {
+    file << "# rngSeed " << rngSeed_ << endl;
+    file << "# rngWindow " << rngWindow_ << endl;
+    file << "# rngWalker " << rngWalker_ << endl;
+  }
 
   // write random number generator state
   writeRngRestart(fileName);
 
   // write analyzer restarts
+  flushAnalyze();
   if (analyzeVec_.size() != 0) {
     file << "# nRstFileAnalyze " << analyzeVec_.size() << endl;
   }
@@ -766,7 +903,9 @@ void MC::b2(const double tol, double &b2v, double &b2er, double boxl) {
   b2v = m2.average();
 }
 
-void MC::b2mayer(double *b2v, double *b2er, Pair *pairRef, const double tol, double boxl) {
+void MC::b2mayer(double *b2v, double *b2er, Pair *pairRef,
+  const double tol, double boxl, const double b2ref, double *db2dbeta,
+  int nChains, double maxMove) {
   b2init_();
   ASSERT(space() == pairRef->space(), "reference potential must point to the"
     << "same space object");
@@ -776,77 +915,120 @@ void MC::b2mayer(double *b2v, double *b2er, Pair *pairRef, const double tol, dou
   if (boxl == -1) {
     boxl = 2.*(2.*space_->maxMolDist() + pair_->rCut());
   }
-//  space.initBoxLength(boxl);
-//  const double boxlbig = boxl*1e6;
-//
-//  // equilibrate: tune maxMove parameters and make sure that initial
-//  // configuration has non-zero energy
-//  double peOld = 0.;
-//  const int maxIterations = 1e3;
-//  int iter = 0;
-//  pair_->initEnergy();
-//  while ( (peOld != 0.) && (iter < maxIterations) ) {
-//    runNumTrials(1e5);
-//    peOld = pair_->peTot();
-//    ++iter;
-//  }
-//  ASSERT(iter < maxIterations, "max iterations reached in equilibration");
-//
-//  pairRef.initEnergy();
-//  double f12old = exp(-peOld/temp) - 1,
-//         f12ref = exp(-pairRef.peTot()/temp) - 1;
-//
-//  // begin trial moves and averaging
-//  const double maxDisp = 0.1;
-//  Accumulator mayer, mayerRef;
-//  for (long long int itrial = 0; itrial < npr_; ++itrial) {
-//    // store old position
-//    space.xStore(mpart);
-//
-//    // move and rotate second molecule randomly within domain
-//    space_->randDisp(mpart, 0.5*boxl);
-//    space_->randRotate(mpart, -1);
-//
-//    // expand domain so there are no mirror images
-//    for (int dim=0; dim < space_->dimen(); ++dim) space_->initBoxLength(boxlbig, dim);
-//
-//    // compute energy and meyer function
-//    pair_->initEnergy();
-//    const double pe = pair_->peTot();
-//    // const double pe = pair_->multiPartEner(mpart, 0);
-//
-//    meyer.accumulate(-0.5*vol*(exp(-criteria_->beta()*pe) - 1));
-//    // cout << "pe " << pe << " meyer " << 1 - exp(-criteria_->beta()*pe)
-//    //      << " acc " << -0.5*vol*(exp(-criteria_->beta()*pe) - 1) << " v "
-//    //      << vol << endl;
-//
-//    if ( (itrial != 0) && (itrial % nFreqMovie_ == 0) ) {
-//      int flag = 0;
-//      if (itrial == nFreqMovie_) flag = 1;
-//      if (!movieFileName_.empty()) {
-//        pair_->printXYZ(movieFileName_.c_str(), flag);
-//      }
-//    }
-//
-//    if ( (itrial != 0) && (itrial % nFreqLog_ == 0) ) {
-//      m2.accumulate(meyer.average());
-//      if (m2.nValues() > 2) {
-//        b2er = m2.std()/sqrt(m2.nValues());
-//      } else {
-//        b2er = 1e200;
-//      }
-//      if (!logFileName_.empty()) {
-//        std::ofstream log_(logFileName_.c_str(),
-//                           std::ofstream::out | std::ofstream::app);
-//        log_ << itrial << " " << m2.average() << " " << b2er << " "
-//             << meyer.average() << endl;
-//      }
-//      meyer.reset();
-//      if ( (itrial != nFreqLog_) && ( (b2er < tol) ||
-//           (b2er/fabs(m2.average()) < tol) ) ) itrial = npr_;
-//    }
-//  }
-//  b2v = m2.average();
+  if (maxMove == -1) maxMove = 0.25*boxl;
+  const double boxlbig = boxl*1e6, beta = criteria_->beta();
+  const bool rotate = !space_->sphereSymMol();
+  if (nChains == 0) {
+    nChains = 1;
+    #ifdef _OPENMP
+      nChains = omp_get_max_threads();
+    #endif  // _OPENMP
+  }
+  const unsigned long long seed = (rngSeed_ != 0) ? rngSeed_ :
+    static_cast<unsigned long long>(uniformRanNum(1, INT_MAX));
+
+  // clone the space and pairs for each chain, in a domain without images and
+  // with the first site of the second molecule at the origin
+  vector<shared_ptr<Space> > spaces(nChains);
+  vector<shared_ptr<Pair> > pairs(nChains), pairRefs(nChains);
+  vector<double> pe(nChains), f(nChains), fRef(nChains);
+  for (int c = 0; c < nChains; ++c) {
+    spaces[c] = space_->cloneShrPtr();
+    spaces[c]->initRNG(seed, rngWindow_, c, 1);
+    for (int dim = 0; dim < space_->dimen(); ++dim) {
+      spaces[c]->initBoxLength(boxlbig, dim);
+    }
+    vector<double> r(space_->dimen());
+    for (int dim = 0; dim < space_->dimen(); ++dim) {
+      r[dim] = -spaces[c]->x(mpart[0], dim);
+    }
+    spaces[c]->transMol(1, r);
+    pairs[c] = shared_ptr<Pair>(pair_->clone(spaces[c].get()));
+    pairRefs[c] = shared_ptr<Pair>(pairRef->clone(spaces[c].get()));
+
+    // the reference may not have been updated when the molecules were added
+    pairRefs[c]->addPart();
+  }
+
+  // run each chain for nTrials, with acceptance probability |fnew|/|fold|
+  vector<Accumulator> sgn(nChains), ref(nChains), dbeta(nChains);
+  auto runChain = [&](const int c, const long long nTrials) {
+    Space* space = spaces[c].get();
+    for (long long itrial = 0; itrial < nTrials; ++itrial) {
+      space->xStore(mpart);
+      space->randDispNoWrap(mpart, maxMove);
+      if (rotate) space->randRotate(mpart, -1);
+      const double peNew = pairs[c]->multiPartEner(mpart, 0),
+                   fNew = exp(-beta*peNew) - 1.;
+      if (space->uniformRanNum() < fabs(fNew/f[c])) {
+        pe[c] = peNew;
+        f[c] = fNew;
+        fRef[c] = exp(-beta*pairRefs[c]->multiPartEner(mpart, 0)) - 1.;
+      } else {
+        space->restore(mpart);
+      }
+      const double fAbs = fabs(f[c]);
+      sgn[c].accumulate(f[c]/fAbs);
+      ref[c].accumulate(fRef[c]/fAbs);
+      const double boltz = exp(-beta*pe[c]);
+      dbeta[c].accumulate( (boltz == 0.) ? 0. : -pe[c]*boltz/fAbs);
+    }
+  };
+
+  // place the second molecule randomly until the Mayer function is nonzero
+  for (int c = 0; c < nChains; ++c) {
+    Space* space = spaces[c].get();
+    f[c] = 0.;
+    for (int attempt = 0; (f[c] == 0.) && (attempt < 1e6); ++attempt) {
+      space->xStore(mpart);
+      space->randDispNoWrap(mpart, 0.5*boxl);
+      if (rotate) space->randRotate(mpart, -1);
+      pe[c] = pairs[c]->multiPartEner(mpart, 0);
+      f[c] = exp(-beta*pe[c]) - 1.;
+      if (f[c] == 0.) space->restore(mpart);
+    }
+    ASSERT(f[c] != 0., "could not find a configuration with nonzero Mayer "
+      << "function within boxl(" << boxl << ")");
+    fRef[c] = exp(-beta*pairRefs[c]->multiPartEner(mpart, 0)) - 1.;
+  }
+
+  // run blocks of nFreqLog trials in each chain until tolerance is reached
+  Accumulator m2, sgnTot, refTot, dbetaTot;
+  *b2er = 1e200;
+  long long itrial = 0;
+  while (itrial < npr_) {
+    #ifdef _OPENMP
+    #pragma omp parallel for schedule(static, 1)
+    #endif  // _OPENMP
+    for (int c = 0; c < nChains; ++c) {
+      runChain(c, nFreqLog_);
+    }
+    itrial += nChains*nFreqLog_;
+
+    // each block of each chain gives an estimate
+    for (int c = 0; c < nChains; ++c) {
+      if (ref[c].sum() != 0) {
+        m2.accumulate(b2ref*sgn[c].sum()/ref[c].sum());
+      }
+      sgnTot.merge(sgn[c]);
+      refTot.merge(ref[c]);
+      dbetaTot.merge(dbeta[c]);
+      sgn[c].reset();
+      ref[c].reset();
+      dbeta[c].reset();
+    }
+    *b2v = b2ref*sgnTot.sum()/refTot.sum();
+    if (db2dbeta != NULL) *db2dbeta = b2ref*dbetaTot.sum()/refTot.sum();
+    if (m2.nValues() > 2) *b2er = m2.std()/sqrt(m2.nValues());
+    if (!logFileName_.empty()) {
+      std::ofstream log_(logFileName_.c_str(),
+                         std::ofstream::out | std::ofstream::app);
+      log_ << itrial << " " << *b2v << " " << *b2er << " "
+           << b2ref*dbetaTot.sum()/refTot.sum() << endl;
+    }
+    if ( (m2.nValues() > 2) &&
+         ( (*b2er < tol) || (*b2er/fabs(*b2v) < tol) ) ) itrial = npr_;
+  }
 }
 
 double MC::boylemin_(const double beta) {
@@ -910,6 +1092,180 @@ void MC::updateCumulativeProb_() {
     prob += trialWeight_[i]/wtTot;
     trialCumulativeProb_.push_back(prob);
   }
+  if (trialWeight_.size() > 0) {
+    initAlias(trialWeight_, &trialAliasProb_, &trialAlias_);
+  }
+}
+
+void MC::initAdaptTrialWeights(const argtype &args) {
+  ASSERT(nTrials() > 0, "initialize trials before adapting their weights");
+  std::stringstream minProb;
+  minProb << 0.25/nTrials();
+  argparse_.initArgs("initAdaptTrialWeights", args);
+  nFreqAdapt_ = argparse_.key("nFreq").dflt("10000").integer();
+  adaptMinProb_ = argparse_.key("minProb").dflt(minProb.str()).dble();
+  argparse_.checkAllArgsUsed();
+  ASSERT(nFreqAdapt_ > 0, "nFreq(" << nFreqAdapt_ << ") must be positive");
+  ASSERT( (adaptMinProb_ >= 0) && (adaptMinProb_*nTrials() <= 1. + DTOL),
+    "minProb(" << adaptMinProb_ << ") must be between 0 and 1/nTrials");
+  zeroAdapt_();
+}
+
+void MC::freezeTrialWeights() {
+  if (nFreqAdapt_ > 0) {
+    nFreqAdapt_ = 0;
+    if (!logFileName_.empty()) {
+      std::ofstream log_(logFileName_.c_str(),
+                         std::ofstream::out | std::ofstream::app);
+      log_ << "# " << className_ << " froze trial weights:";
+      for (int t = 0; t < nTrials(); ++t) log_ << " " << trialWeight_[t];
+      log_ << endl;
+    }
+  }
+}
+
+void MC::initSampledCheckE(const argtype &args) {
+  argparse_.initArgs("initSampledCheckE", args);
+  nSampleCheckE_ = argparse_.key("nSample").dflt("10").integer();
+  nFreqFullCheckE_ = argparse_.key("nFreqFull").dflt("100").integer();
+  argparse_.checkAllArgsUsed();
+  ASSERT(nSampleCheckE_ > 0, "nSample(" << nSampleCheckE_
+    << ") must be positive");
+  ASSERT(nFreqFullCheckE_ >= 0, "nFreqFull(" << nFreqFullCheckE_
+    << ") must not be negative");
+}
+
+void MC::checkFull_() {
+  ++nCheckEFull_;
+  if (space_->cellType() > 0) {
+    space_->checkCellList();
+  }
+  if (space_->cavityOn()) space_->checkCavity();
+  pair_->checkEnergy(checkEtol_, 0);
+  peRun_ = pair_->peTot();
+  if (pair_->neighOn()) pair_->checkNeigh();
+}
+
+namespace {
+// hash the number of attempts, such that the sampled molecules do not
+// consume random numbers of the Markov chain
+unsigned long long hashCheck(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+}
+
+void MC::checkSample_() {
+  ++nCheckE_;
+  const int nMol = space_->nMol();
+  vector<int> mols;
+  for (int i = 0; i < std::min(nSampleCheckE_, nMol); ++i) {
+    mols.push_back(static_cast<int>(
+      hashCheck(nAttempts_*nSampleCheckE_ + i) % nMol));
+  }
+
+  // sampled checks
+  int match = 1;
+  if (space_->cellType() > 0) match *= space_->checkCellListSample(mols);
+  if (pair_->neighOn()) match *= pair_->checkNeighSample(mols);
+  const double diff = std::max(pair_->checkEnergySample(mols),
+                                fabs(pair_->peTot() - peRun_));
+  maxSampleDiffE_ = std::max(maxSampleDiffE_, diff);
+  if (diff > checkEtol_) match = 0;
+  WARN(match == 0, "sampled check of the energy, cell list or neighbor list "
+    << "did not match after " << nAttempts_ << " attempts. Full check.");
+
+  // escalate to a full check
+  string check("sample");
+  double drift = 0.;
+  if ( (match == 0) ||
+       ( (nFreqFullCheckE_ > 0) && (nCheckE_ % nFreqFullCheckE_ == 0) ) ) {
+    check.assign((match == 0) ? "mismatch" : "full");
+    const double pe = pair_->peTot();
+    checkFull_();
+    drift = pe - pair_->peTot();
+  }
+
+  // drift log
+  if (!logFileName_.empty()) {
+    std::stringstream ss;
+    ss << logFileName_ << "drift";
+    const bool header = !std::ifstream(ss.str().c_str()).good();
+    std::ofstream file(ss.str().c_str(),
+                       std::ofstream::out | std::ofstream::app);
+    if (header) file << "# attempts check maxSampleDiff drift" << endl;
+    file << MAX_PRECISION << nAttempts_ << " " << check << " " << diff << " "
+         << drift << endl;
+  }
+}
+
+void MC::zeroAdapt_() {
+  adaptTime_.assign(nTrials(), 0.);
+  adaptDE2_.assign(nTrials(), 0.);
+  adaptAttempted_.assign(nTrials(), 0);
+  adaptAccepted_.assign(nTrials(), 0);
+}
+
+void MC::attemptAdapt_(const int iTrial) {
+  if (static_cast<int>(adaptTime_.size()) != nTrials()) zeroAdapt_();
+  const double peOld = pair_->peTot();
+  const long long accepted = trialVec_[iTrial]->accepted();
+  const Profile::clock::time_point start = Profile::clock::now();
+  trialVec_[iTrial]->attempt();
+  adaptTime_[iTrial] += Profile::seconds(start);
+  const double de = pair_->peTot() - peOld;
+  if (std::isfinite(de)) adaptDE2_[iTrial] += de*de;
+  ++adaptAttempted_[iTrial];
+  adaptAccepted_[iTrial] += trialVec_[iTrial]->accepted() - accepted;
+}
+
+void MC::adaptTrialWeights_() {
+  // wait until each trial has been attempted
+  const int nTrial = nTrials();
+  if (static_cast<int>(adaptTime_.size()) != nTrial) zeroAdapt_();
+  for (int t = 0; t < nTrial; ++t) {
+    if (adaptAttempted_[t] == 0) return;
+  }
+
+  // decorrelation is the squared energy change, or acceptance if no change
+  const bool useEnergy = std::accumulate(adaptDE2_.begin(), adaptDE2_.end(),
+                                         0.) > 0;
+  vector<double> efficiency(nTrial);
+  for (int t = 0; t < nTrial; ++t) {
+    const double decorrelation = (useEnergy) ? adaptDE2_[t] :
+      static_cast<double>(adaptAccepted_[t]);
+    efficiency[t] = (adaptTime_[t] > 0) ? decorrelation/adaptTime_[t] : 0.;
+  }
+  const double effTot = std::accumulate(efficiency.begin(), efficiency.end(),
+                                        0.);
+  if (effTot > 0) {
+    for (int t = 0; t < nTrial; ++t) {
+      trialWeight_[t] = adaptMinProb_ +
+        (1. - nTrial*adaptMinProb_)*efficiency[t]/effTot;
+    }
+
+    // additions and deletions share a weight for detailed balance
+    double wtExchange = 0.;
+    int nExchange = 0;
+    for (int t = 0; t < nTrial; ++t) {
+      if (exchangeTrial_(t)) {
+        wtExchange += trialWeight_[t];
+        ++nExchange;
+      }
+    }
+    for (int t = 0; t < nTrial; ++t) {
+      if (exchangeTrial_(t)) trialWeight_[t] = wtExchange/nExchange;
+    }
+    updateCumulativeProb_();
+  }
+  zeroAdapt_();
+}
+
+bool MC::exchangeTrial_(const int iTrial) const {
+  const string type = trialVec_[iTrial]->trialType();
+  return (type.compare(0, 3, "add") == 0) || (type.compare(0, 3, "del") == 0);
 }
 
 void MC::replaceCriteria(Criteria *criteria) {
@@ -940,6 +1296,7 @@ void MC::appendFileNames(const char* chars) {
   MC::appendProductionFileNames(chars);
 }
 void MC::appendProductionFileNames(const char* chars) {
+  flushAnalyze();
   if (!XTCFileName_.empty()) XTCFileName_.append(chars);
   if (!logFileName_.empty()) logFileName_.append(chars);
   for (unsigned int ia = 0; ia < analyzeVec_.size(); ++ia) {
@@ -949,10 +1306,12 @@ void MC::appendProductionFileNames(const char* chars) {
 
 void MC::initProduction() {
   production_ = 1;
+  freezeTrialWeights();
   appendProductionFileNames(prodFileAppend_.c_str());
   space_->clusterReset();
 
   // tell analyzers that production has begun
+  flushAnalyze();
   for (vector<shared_ptr<Analyze> >::iterator it = analyzeVec_.begin();
        it != analyzeVec_.end();
        ++it) {
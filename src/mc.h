@@ -22,6 +22,7 @@
 #endif  // _OPENMP
 #include "./accumulator.h"
 #include "./analyze.h"
+#include "./analysis_pipeline.h"
 #include "./base_random.h"
 
 namespace feasst {
@@ -56,6 +57,16 @@ class MC : public BaseRandom {
   /// HWH: Depreciate, but requires communication between processors for OMP.
   virtual void confSwapTrial();
 
+  /**
+   * Use independent substreams of the counter-based random number
+   * generator for this object, space, pair, criteria and each trial,
+   * including trials added later. Each call of WLTMMC::runNumSweeps gives
+   * its window clones substreams not yet used by this object or by
+   * previous calls.
+   */
+  void seedRNG(const unsigned long long seed, const int window = 0,
+               const int walker = 0);
+
   /// Remove trial with index in order of initialization.
   /// If iTrial is not provided, remove the last trial that was added.
   void removeTrial(int iTrial = -1);
@@ -118,10 +129,87 @@ class MC : public BaseRandom {
   void setNFreqCheckE(const double nfreq, const double tolerance)
     { nFreqCheckE_ = nfreq; checkEtol_ = tolerance; }
 
+  /**
+   * Replace the full checks of the energy, cell list and neighbor list,
+   * which occur every nfreq trials of setNFreqCheckE, with sampled checks.
+   *
+   * Each sampled check recomputes the energy of a random subset of molecules
+   * without the cell list, compares the cell and neighbor lists of those
+   * molecules with their positions, and checks the consistency of the cell
+   * and neighbor lists as a whole without rebuilding them.
+   * The total energy stored by Pair is also compared with the running sum of
+   * the energy change of each accepted trial since the last full check, which
+   * catches drift of the stored energy without recomputing it.
+   * A full check follows any mismatch, or every nFreqFull sampled checks.
+   * Each check is recorded in the drift log, logFileName + "drift", with the
+   * largest sampled difference in energy and, for full checks, the drift of
+   * the running energy from the recalculated total energy.
+   */
+  void initSampledCheckE(
+    /**
+     * allowed string key pairs (e.g., dictionary):
+     *
+     *  nSample : number of molecules sampled per check.
+     *
+     *  - (default): 10
+     *
+     *  nFreqFull : number of sampled checks per full check.
+     *    If 0, full checks only follow a mismatch.
+     *
+     *  - (default): 100
+     */
+    const argtype &args = argtype());
+
+  /// Return the number of full checks of the energy.
+  long long nCheckEFull() const { return nCheckEFull_; }
+
+  /// Return the largest sampled difference in energy.
+  double maxSampleDiffE() const { return maxSampleDiffE_; }
+
   /// Initialize frequency to tune trial parameters.
   /// Note that tuning does not obey detailed balance.
   void setNFreqTune(const double nfreq) { nFreqTune_ = nfreq; }
 
+  /**
+   * Adapt the trial weights during equilibration to maximize decorrelation
+   * per second of wall time.
+   *
+   * For each trial, the wall time per attempt, c, and the decorrelation per
+   * attempt, d, are measured. d is the mean squared change in potential
+   * energy, or the acceptance fraction if no trial changes the energy.
+   * Every nFreq trials, the probability to select each trial is set
+   * proportional to its efficiency, d/c, above a minimum probability such
+   * that all degrees of freedom are sampled.
+   *
+   * Trials which add and delete molecules are the reverse of each other, and
+   * thus share the average of their weights such that the probability to
+   * select a reverse move is unchanged.
+   *
+   * Note that adaptive weights do not obey detailed balance. The weights are
+   * frozen by initProduction (or freezeTrialWeights).
+   */
+  void initAdaptTrialWeights(
+    /**
+     * allowed string key pairs (e.g., dictionary):
+     *
+     *  nFreq : number of trials between each update of the weights.
+     *
+     *  - (default): 10000
+     *
+     *  minProb : minimum probability to select each trial.
+     *    Must not be larger than 1/nTrials.
+     *
+     *  - (default): 0.25/nTrials
+     */
+    const argtype &args = argtype());
+
+  /// Stop adapting the trial weights.
+  void freezeTrialWeights();
+
+  /// Return the number of trials between each update of the weights,
+  /// or 0 if the weights are frozen.
+  long long nFreqAdapt() const { return nFreqAdapt_; }
+
   /// Initialize restart file name and print every nfreq trials.
   void initRestart(const char* fileName, const int nfreq)
     { rstFileBaseName_.assign(fileName); rstFileName_.assign(fileName);
@@ -133,6 +221,16 @@ class MC : public BaseRandom {
     analyzeVec_.push_back(analyze);
   }
 
+  /**
+   * Run the analyzers on worker threads with an AnalysisPipeline, instead of
+   * inline with the trials. See AnalysisPipeline for the arguments.
+   */
+  void initAnalysisPipeline(const argtype &args = argtype()) {
+    analysisPipeline_ = makeAnalysisPipeline(args); }
+
+  /// Wait for the analysis pipeline, if any, to finish queued configurations.
+  void flushAnalyze() { if (analysisPipeline_) analysisPipeline_->flush(); }
+
   // determine maximum number of particles for a given temperature
   //   and large activity
   virtual int nMolMax(const long long npr, const double activ,
@@ -144,6 +242,21 @@ class MC : public BaseRandom {
   void printStat();     //!< print status of all trials to log
   double pePerMol();     //!< print potential energy per molecule
 
+  /// Return the attempts, potential energy per molecule and status of all
+  /// trials, as printed to the log, or their header.
+  string statLine(const bool header = false);
+
+  /**
+   * Print the profile of wall times and counts to the log, or to standard
+   * output if there is no log. The profile is only recorded when compiled
+   * with -DUSE_PROFILE=ON, in which case it is also printed at the end of
+   * run() and its columns are appended to each line of the log.
+   */
+  void printProfile();
+
+  /// Return the profile of wall times and counts since zeroStat.
+  const Profile& profile() const { return profile_; }
+
   /// turn on neigh list for avb trials,
   //   or check that it is on with matching region
   void neighAVBInit(const double rAbove,  //!< upper bound of spherical shell
@@ -172,16 +285,37 @@ class MC : public BaseRandom {
     { vector<double> rtrn; double b2v, b2s; b2(tol, b2v, b2s);
       rtrn.push_back(b2v); rtrn.push_back(b2s); return rtrn; }
 
-  /*
+  /**
    * Compute second virial coefficient by Mayer sampling Monte Carlo.
    * https://doi.org/10.1103/PhysRevLett.92.220601
+   *
+   * Independent chains sample the position and orientation of the second
+   * molecule with probability proportional to the absolute value of the
+   * Mayer function, |f|, and are distributed among OpenMP threads.
+   * Each chain has its own clone of the space and pair, with a separate
+   * random number stream, and only the energy between the two molecules is
+   * computed. B2 = b2ref <f/|f|> / <fref/|f|>, where fref is the Mayer
+   * function of the reference potential.
+   * Every nFreqLog trials of each chain, the block estimates are used to
+   * check the tolerance, until at most npr trials in total.
    */
   void b2mayer(
     double *b2v,              //!< return value of the second virial coefficient
     double *b2er,             //!< standard deviation of the mean
     Pair *pairRef,            //!< reference potential
     const double tol = 1e-4,  //!< terminate trials when tolerance reached
-    double boxl = -1          //!< box length containing all nonzero energy
+    /// Box length in which the second molecule is initially placed.
+    double boxl = -1,
+    /// Second virial coefficient of the reference potential. If 1, B2 is
+    /// returned in units of the reference.
+    const double b2ref = 1.,
+    /// If not NULL, return the derivative with respect to inverse
+    /// temperature, dB2/dbeta, from the same samples.
+    double *db2dbeta = NULL,
+    /// Number of chains. If 0, use the maximum number of OpenMP threads.
+    int nChains = 0,
+    /// Maximum displacement of the second molecule. If -1, use boxl/4.
+    double maxMove = -1
   );
 
 // HWH mins
@@ -235,6 +369,8 @@ class MC : public BaseRandom {
   Accumulator peAccumulator() const { return peAccumulator_; }
   long long nFreqLog() const { return nFreqLog_; }
   vector <shared_ptr <Analyze> > analyzeVec() const { return analyzeVec_; }
+  shared_ptr<AnalysisPipeline> analysisPipeline() const {
+    return analysisPipeline_; }
   bool spaceOwned() const { return spaceOwned_; }
   int production() const { return production_; }
 
@@ -260,6 +396,41 @@ class MC : public BaseRandom {
   vector<shared_ptr<Trial> > trialVec_;  //!< vector of trials
   vector<double> trialWeight_;           //!< vector of trial weights
   vector<double> trialCumulativeProb_;   //!< cumulative probability of trials
+  vector<double> trialAliasProb_;        //!< alias table to select trials
+  vector<int> trialAlias_;               //!< alias table to select trials
+
+  // adaptive trial weights
+  long long nFreqAdapt_;        //!< trials between updates, 0 if frozen
+  double adaptMinProb_;         //!< minimum probability of each trial
+  vector<double> adaptTime_;    //!< wall time of attempts of each trial
+  vector<double> adaptDE2_;     //!< sum of squared energy change
+  vector<long long> adaptAttempted_, adaptAccepted_;
+
+  /// Attempt trial iTrial, and record its cost and decorrelation.
+  void attemptAdapt_(const int iTrial);
+
+  /// Update the trial weights from the efficiency of each trial.
+  void adaptTrialWeights_();
+
+  /// Zero the cost and decorrelation of each trial.
+  void zeroAdapt_();
+
+  /// Return true if trial iTrial adds or deletes molecules.
+  bool exchangeTrial_(const int iTrial) const;
+
+  // sampled energy, cell list and neighbor list checks
+  int nSampleCheckE_;           //!< molecules per sampled check, 0 if full
+  int nFreqFullCheckE_;         //!< sampled checks per full check
+  long long nCheckE_;           //!< number of checks
+  long long nCheckEFull_;       //!< number of full checks
+  double maxSampleDiffE_;       //!< largest sampled difference in energy
+  double peRun_;                //!< running energy, from the change of trials
+
+  /// Check the energy, cell list and neighbor list of the entire system.
+  void checkFull_();
+
+  /// Check a random subset of molecules, and escalate to a full check.
+  void checkSample_();
   #ifdef MPI_H_
     /// vector of ConfSwap trials
     vector<shared_ptr<TrialConfSwapTXT> > trialConfSwapVec_;
@@ -281,6 +452,9 @@ class MC : public BaseRandom {
   //  if -1, print line with "#" but not header
   int printLogHeader_;
 
+  Profile profile_;           //!< wall times and counts of hot paths
+  vector<string> trialNames_();  //!< names of trials for the profile
+
   string logFileName_;        //!< log file name
   long long nFreqLog_;    //!< frequency to print to log
   string XTCFileName_;        //!< XTC file name
@@ -291,6 +465,9 @@ class MC : public BaseRandom {
   string rstFileName_;        //!< restart file name
   string rstFileBaseName_;    //!< restart file base name
   std::string prodFileAppend_;
+  unsigned long long rngSeed_;  //!< seed of substreams, if nonzero
+  int rngWindow_;             //!< window of substreams
+  int rngWalker_;             //!< walker of substreams
   long long npr_;         //!< number of trials in simulaiton
   double checkEtol_;          //!< tolerance for energy check
   int production_;           //!< flag for production simulation
@@ -298,11 +475,16 @@ class MC : public BaseRandom {
 
   // analyzers
   vector<shared_ptr<Analyze> > analyzeVec_;
+  shared_ptr<AnalysisPipeline> analysisPipeline_;
+
+  /// Update and print the analyzers, inline or with the pipeline.
+  /// If c is not NULL, print for each macrostate of c.
+  void runAnalyze_(const int iMacro = 0, CriteriaWLTMMC *c = NULL);
 
   // virial coefficient
   void b2init_();
 
-  /// update cumulative probability of trials
+  /// update cumulative probability and alias table of trials
   void updateCumulativeProb_();
 
   /// tune move parameters
@@ -0,0 +1,121 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include "./mc_batch.h"
+
+namespace feasst {
+
+MCBatch::MCBatch(const argtype &args) {
+  className_.assign("MCBatch");
+  argparse_.initArgs(className_, args);
+  const int nHardware = static_cast<int>(std::thread::hardware_concurrency());
+  nThreads_ = argparse_.key("nThreads").dflt(str(std::max(1, nHardware)))
+                                       .integer();
+  ASSERT(nThreads_ > 0, "nThreads(" << nThreads_ << ") must be positive");
+  seed_ = std::stoull(argparse_.key("seed").dflt("0").str());
+  while (seed_ == 0) seed_ = rand();
+  argparse_.checkAllArgsUsed();
+  nFreqLog_ = 0;
+}
+
+void MCBatch::add(shared_ptr<MC> mc) {
+  mc->seedRNG(seed_, 0, nSystems());
+  mcs_.push_back(mc);
+}
+
+void MCBatch::addClones(const MC &mc, const int nClones) {
+  for (int i = 0; i < nClones; ++i) {
+    shared_ptr<MC> clone = mc.cloneShrPtr();
+    stringstream ss;
+    ss << "s" << nSystems();
+    clone->appendFileNames(ss.str().c_str());
+    add(clone);
+  }
+}
+
+void MCBatch::initLog(const char* fileName, const long long nFreq) {
+  ASSERT(nFreq > 0, "nFreq(" << nFreq << ") must be positive");
+  logFileName_.assign(fileName);
+  nFreqLog_ = nFreq;
+  logHeader_.clear();
+}
+
+void MCBatch::runNumTrials(const long long nTrials) {
+  seconds_.assign(nSystems(), 0.);
+  next_ = 0;
+  exception_ = nullptr;
+  const int nWorkers = std::min(nThreads_, nSystems());
+  vector<std::thread> workers;
+  for (int w = 0; w < nWorkers; ++w) {
+    workers.push_back(std::thread(&MCBatch::work_, this, nTrials));
+  }
+  for (unsigned int w = 0; w < workers.size(); ++w) {
+    workers[w].join();
+  }
+  if (exception_) std::rethrow_exception(exception_);
+}
+
+void MCBatch::work_(const long long nTrials) {
+  for (int iSystem = next_++; iSystem < nSystems(); iSystem = next_++) {
+    {
+      // stop at the first error
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exception_) return;
+    }
+    try {
+      run_(iSystem, nTrials);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!exception_) exception_ = std::current_exception();
+    }
+  }
+}
+
+void MCBatch::run_(const int iSystem, const long long nTrials) {
+  const std::chrono::steady_clock::time_point begin =
+    std::chrono::steady_clock::now();
+  MC* mc = mcs_[iSystem].get();
+  long long remaining = nTrials;
+  while (remaining > 0) {
+    // run until the next log, if any
+    long long n = remaining;
+    if (!logFileName_.empty()) {
+      n = std::min(n, nFreqLog_ - mc->nAttempts() % nFreqLog_);
+    }
+    mc->runNumTrials(n);
+    remaining -= n;
+    if (!logFileName_.empty() && (mc->nAttempts() % nFreqLog_ == 0)) {
+      log_(iSystem);
+    }
+  }
+  seconds_[iSystem] = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - begin).count();
+}
+
+void MCBatch::log_(const int iSystem) {
+  const string header = mcs_[iSystem]->statLine(true),
+               line = mcs_[iSystem]->statLine();
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ofstream log(logFileName_.c_str(),
+                    std::ofstream::out | std::ofstream::app);
+  if (header != logHeader_) {
+    log << "#system " << header << endl;
+    logHeader_ = header;
+  }
+  log << iSystem << " " << line << endl;
+}
+
+shared_ptr<MCBatch> makeMCBatch(const argtype &args) {
+  return make_shared<MCBatch>(args);
+}
+
+}  // namespace feasst
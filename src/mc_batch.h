@@ -0,0 +1,123 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef MC_BATCH_H_
+#define MC_BATCH_H_
+
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "./mc.h"
+
+namespace feasst {
+
+/**
+ * Run many independent simulations (e.g., of different temperatures or
+ * model parameters) in one process, on a pool of threads.
+ *
+ * Each thread runs one simulation at a time, and takes the next simulation
+ * when it is done. Clones of a template simulation share the read-only data
+ * which was set up once in the template, such as the force field parameters,
+ * the reference molecules of Space::addMolList and the tables of the pair
+ * (e.g., the erfc table of the Ewald sum). Thus, the parsing of data files,
+ * tabulation and process startup are not repeated for each simulation.
+ *
+ * Each simulation is seeded with MC::seedRNG(seed, 0, iSystem), such that
+ * the results do not depend on the number of threads, and any one
+ * simulation may be reproduced alone.
+ * The status of each simulation may be written to one consolidated log.
+ */
+class MCBatch : public Base {
+ public:
+  /// Constructor
+  explicit MCBatch(
+    /**
+     * allowed string key pairs (e.g., dictionary):
+     *
+     *  nThreads : number of threads.
+     *
+     *  - (default): the number of hardware threads.
+     *
+     *  seed : seed of the random number generator of all simulations.
+     *
+     *  - (default): random.
+     */
+    const argtype &args = argtype());
+
+  /// Add a simulation.
+  void add(shared_ptr<MC> mc);
+
+  /**
+   * Add nClones clones of mc, which share its read-only data.
+   * The number of the simulation in the batch is appended to the names of
+   * their output files (e.g., log, restart and analyzers).
+   */
+  void addClones(const MC &mc, const int nClones);
+
+  /// Return the number of simulations.
+  int nSystems() const { return static_cast<int>(mcs_.size()); }
+
+  /// Return simulation iSystem.
+  shared_ptr<MC> mc(const int iSystem) const { return mcs_[iSystem]; }
+
+  /**
+   * Every nFreq trials of each simulation, append the simulation number and
+   * MC::statLine to the file. A header is written whenever the columns
+   * differ from the previous line.
+   */
+  void initLog(const char* fileName, const long long nFreq);
+
+  /// Run nTrials trials of each simulation.
+  void runNumTrials(const long long nTrials);
+
+  /// Return the number of threads.
+  int nThreads() const { return nThreads_; }
+
+  /// Return the seed.
+  unsigned long long seed() const { return seed_; }
+
+  /// Return the wall time, in seconds, of each simulation in the last run.
+  vector<double> seconds() const { return seconds_; }
+
+  ~MCBatch() {}
+
+ protected:
+  int nThreads_;
+  unsigned long long seed_;
+  vector<shared_ptr<MC> > mcs_;
+  string logFileName_;
+  long long nFreqLog_;
+  string logHeader_;      //!< columns of the last line of the log
+  vector<double> seconds_;
+  std::atomic<int> next_;     //!< next simulation to run
+  std::mutex mutex_;
+  std::exception_ptr exception_;
+
+  /// Run the next simulation until none are left.
+  void work_(const long long nTrials);
+
+  /// Run nTrials trials of simulation iSystem.
+  void run_(const int iSystem, const long long nTrials);
+
+  /// Append the status of simulation iSystem to the log.
+  void log_(const int iSystem);
+
+  // threads hold pointers to this object, which must not move
+  MCBatch(const MCBatch&) = delete;
+  MCBatch& operator=(const MCBatch&) = delete;
+};
+
+/// Factory method
+shared_ptr<MCBatch> makeMCBatch(const argtype &args = argtype());
+
+}  // namespace feasst
+
+#endif  // MC_BATCH_H_
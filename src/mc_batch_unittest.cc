@@ -0,0 +1,75 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include "pair_lj.h"
+#include "criteria_metropolis.h"
+#include "trial_add.h"
+#include "trial_delete.h"
+#include "trial_transform.h"
+#include "mc_batch.h"
+
+using namespace feasst;
+
+TEST(MCBatch, clonesANDthreads) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  CriteriaMetropolis c(1., exp(-2.));
+  MC mc(&s, &p, &c);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+
+  // the same simulations with one or three threads
+  vector<shared_ptr<MCBatch> > batches;
+  for (const string nThreads : {"1", "3"}) {
+    batches.push_back(makeMCBatch({{"nThreads", nThreads}, {"seed", "1234"}}));
+    batches.back()->addClones(mc, 4);
+    batches.back()->mc(3)->criteria()->betaset(0.8);
+  }
+  std::remove("tmp/mcbatchlog");
+  batches[1]->initLog("tmp/mcbatchlog", 100);
+  for (int ib = 0; ib < 2; ++ib) batches[ib]->runNumTrials(500);
+  EXPECT_EQ(3, batches[1]->nThreads());
+  EXPECT_EQ(4, static_cast<int>(batches[1]->seconds().size()));
+  for (int i = 0; i < 4; ++i) {
+    shared_ptr<MC> mc1 = batches[0]->mc(i), mc3 = batches[1]->mc(i);
+    EXPECT_EQ(500, mc3->nAttempts());
+    EXPECT_EQ(mc1->pair()->peTot(), mc3->pair()->peTot());
+    EXPECT_EQ(mc1->space()->nMol(), mc3->space()->nMol());
+    EXPECT_EQ(1, mc3->pair()->checkEnergy(1e-9, 0));
+
+    // the reference molecules are shared with the template
+    EXPECT_EQ(s.addMolList()[0], mc3->space()->addMolList()[0]);
+  }
+  EXPECT_NE(batches[1]->mc(0)->pair()->peTot(),
+            batches[1]->mc(1)->pair()->peTot());
+
+  // each simulation may be reproduced alone
+  shared_ptr<MC> alone = mc.cloneShrPtr();
+  alone->seedRNG(1234, 0, 2);
+  alone->runNumTrials(500);
+  EXPECT_EQ(alone->pair()->peTot(), batches[1]->mc(2)->pair()->peTot());
+
+  // one consolidated log, with one header and a line per system and print
+  std::ifstream file("tmp/mcbatchlog");
+  string line;
+  int nHeader = 0, nLine = 0;
+  while (std::getline(file, line)) {
+    if (line[0] == '#') {
+      ++nHeader;
+    } else {
+      ++nLine;
+    }
+  }
+  EXPECT_EQ(1, nHeader);
+  EXPECT_EQ(4*5, nLine);
+}
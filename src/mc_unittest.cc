@@ -13,12 +13,14 @@
 #include "pair_hard_sphere.h"
 #include "pair_lj.h"
 #include "pair_lj_coul_ewald.h"
+#include "pair_squarewell.h"
 #include "mc_wltmmc.h"
 #include "ui_abbreviated.h"
 #include "trial_add.h"
 #include "trial_delete.h"
 #include "trial_transform.h"
 #include "bond.h"
+#include "random_philox.h"
 
 using namespace feasst;
 
@@ -224,6 +226,109 @@ TEST(MC, ljnvtmetropANDremoveTrial) {
   }
 }
 
+// return the average number of molecules over nTrials
+double nMolAv(MC *mc, const int nTrials) {
+  Accumulator nMol;
+  for (int i = 0; i < nTrials; ++i) {
+    mc->attemptTrial();
+    nMol.accumulate(mc->space()->nMol());
+  }
+  return nMol.average();
+}
+
+TEST(MC, adaptTrialWeights) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  CriteriaMetropolis c(1., exp(-4.));
+  MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+  mc.initAdaptTrialWeights({{"nFreq", "1000"}, {"minProb", "0.1"}});
+  mc.setNFreqCheckE(1000, 1e-8);
+  mc.runNumTrials(5000);
+  EXPECT_EQ(1000, mc.nFreqAdapt());
+
+  // weights are probabilities above the minimum, and select trials as such
+  vector<double> weight = mc.trialWeight();
+  EXPECT_NEAR(1., std::accumulate(weight.begin(), weight.end(), 0.), 1e-12);
+  for (int t = 0; t < mc.nTrials(); ++t) {
+    EXPECT_LE(0.1 - 1e-12, weight[t]);
+  }
+  EXPECT_NE(weight[0], weight[1]);
+
+  // reverse moves share a weight
+  EXPECT_DOUBLE_EQ(weight[1], weight[2]);
+
+  // weights are frozen for production
+  mc.initProduction();
+  EXPECT_EQ(0, mc.nFreqAdapt());
+  mc.zeroStat();
+  const double nAdapt = nMolAv(&mc, 20000);
+  EXPECT_EQ(weight, mc.trialWeight());
+  for (int t = 0; t < mc.nTrials(); ++t) {
+    EXPECT_NEAR(weight[t], mc.trialVec()[t]->attempted()/20000., 0.015);
+  }
+
+  // the average number of molecules agrees with fixed weights
+  Space sFixed(3, {{"boxLength", "8"}});
+  PairLJ pFixed(&sFixed, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  MC fixed(&sFixed, &pFixed, &c);
+  fixed.seedRNG(1234);
+  transformTrial(&fixed, "translate", 0.5);
+  deleteTrial(&fixed);
+  addTrial(&fixed, sFixed.addMolListType(0).c_str());
+  fixed.runNumTrials(5000);
+  EXPECT_NEAR(nMolAv(&fixed, 20000), nAdapt, 0.1*nAdapt);
+  try {
+    mc.initAdaptTrialWeights({{"minProb", "0.5"}});
+    CATCH_PHRASE("must be between 0 and 1/nTrials");
+  }
+}
+
+TEST(MC, sampledCheckE) {
+  Space s(3, {{"boxLength", "9"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  s.updateCells(p.rCutMaxAll());
+  CriteriaMetropolis c(1., exp(-2.));
+  MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+  mc.initLog("tmp/sampledCheckE", 1e3);
+  std::remove("tmp/sampledCheckEdrift");
+  mc.setNFreqCheckE(100, 1e-8);
+  mc.initSampledCheckE({{"nSample", "5"}, {"nFreqFull", "4"}});
+  mc.runNumTrials(2000);
+  EXPECT_EQ(5, mc.nCheckEFull());
+  EXPECT_LT(mc.maxSampleDiffE(), 1e-8);
+
+  // one line per check in the drift log, after the header
+  std::ifstream file("tmp/sampledCheckEdrift");
+  string line;
+  int nLines = 0, nFull = 0;
+  while (std::getline(file, line)) {
+    ++nLines;
+    if (line.find("full") != string::npos) ++nFull;
+  }
+  EXPECT_EQ(1 + 20, nLines);
+  EXPECT_EQ(5, nFull);
+
+  // drift of the stored energy is found by the next sampled check
+  p.update(1e-3);
+  try {
+    mc.runNumTrials(100);
+    CATCH_PHRASE("Energy check of full system did not match");
+  }
+
+  try {
+    mc.initSampledCheckE({{"nSample", "0"}});
+    CATCH_PHRASE("must be positive");
+  }
+}
+
 TEST(MC, ljmuvttmmc) {
   const double beta = 1./1.5, activ = exp(-1.568214), boxl = pow(512, 1./3.);
   const int nMolMax = 3;
@@ -395,6 +500,9 @@ TEST(MC, equltl43muvttmmcANDinitWindows) {
   transformTrial(&mc, "rotate");
   deleteTrial(&mc);
   addTrial(&mc, "../forcefield/data.equltl43");
+  #ifdef _OPENMP
+    mc.confSwapTrial();
+  #endif  // _OPENMP
  // mc.initTrial(new TrialDelete());
  // mc.initTrial(new TrialAdd("../forcefield/data.equltl43"));
 //  mc.deleteTrial();
@@ -419,12 +527,26 @@ TEST(MC, equltl43muvttmmcANDinitWindows) {
   // its possible the number of processors is too large for
   //  the number of particles (nMolMax)
   mc.initWindows(1);
+  mc.seedRNG(1234);
+
+  // configuration swaps draw from the substream of their trial index
+  #ifdef _OPENMP
+    mc.trialConfSwap(0)->writeRngRestart("tmp/llswap");
+    EXPECT_EQ(RandomPhilox::streamID(0, 0, 4 + 4),
+              stoull(fstos("stream", "tmp/llswaprng")));
+  #endif  // _OPENMP
 
   mc.setNFreqCheckE(npr/2, 1e-9);
   mc.initColMat("tmp/coll", 2*npr);
   mc.initLog("tmp/ll", 1e3);
   mc.initRestart("tmp/llr", 2*npr);
   mc.runNumSweeps(0, npr);
+
+  // clones of each call use substreams distinct from the parent's
+  const int nWindow = mc.nWindows();
+  EXPECT_EQ(1, stoi(fstos("rngWindow", "tmp/llr_core0")));
+  mc.runNumSweeps(0, npr);
+  EXPECT_EQ(1 + nWindow, stoi(fstos("rngWindow", "tmp/llr_core0")));
 //  mc.nMolSeekInRange();
 //  for (long long i = 0; i < npr; ++i) {
 //    mc.attemptTrial();
@@ -501,3 +623,22 @@ TEST(MC, b2hardsphere) {
   EXPECT_NEAR(b2, 2./3.*PI, tol*3);
 }
 
+TEST(MC, b2mayerSquareWell) {
+  Space s(3);
+  PairSquareWell p(&s, {{"rCut", "1.5"}});
+  p.initData("../forcefield/data.lj");
+  p.rCutijset(0, 0, 1.5);
+  PairHardSphere ref(&s);
+  ref.initData("../forcefield/data.lj");
+  CriteriaMetropolis c(1, 1);
+  MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  mc.setNumTrials(1e7);
+  mc.initLog("tmp/b2mayer", 1e4);
+  double b2, b2er, db2dbeta;
+  const double b2hs = 2./3.*PI, lambda3 = pow(1.5, 3);
+  mc.b2mayer(&b2, &b2er, &ref, 2e-3, -1, b2hs, &db2dbeta, 4, 0.5);
+  EXPECT_NEAR(b2hs*(1. - (lambda3 - 1.)*(exp(1.) - 1.)), b2, 5.*b2er);
+  EXPECT_NEAR(-b2hs*(lambda3 - 1.)*exp(1.), db2dbeta, 0.05);
+}
+
@@ -54,6 +54,10 @@ WLTMMC::WLTMMC(const char* fileName)
     betaInc_ = fstoi("betaInc", fileName);
     lnzInc_ = fstoi("lnzInc", fileName);
   }
+  strtmp = fstos("nSweepCall", fileName);
+  if (!strtmp.empty()) {
+    nSweepCall_ = stoi(strtmp);
+  }
 
   strtmp = fstos("procFileAppend", fileName);
   if (!strtmp.empty()) {
@@ -80,6 +84,7 @@ void WLTMMC::defaultConstruction_() {
   initWindows(0);
   betaInc_ = 0;
   lnzInc_ = 0;
+  nSweepCall_ = 0;
   densThresConfigBias_ = 0;
   nMolSeekTarget_ = -1;
   wlFlatProd_ = -1;
@@ -143,15 +148,7 @@ void WLTMMC::afterAttempt_() {
   }
 
   // run analyzers
-  for (vector<shared_ptr<Analyze>>::iterator it = analyzeVec_.begin();
-       it != analyzeVec_.end(); ++it) {
-    if (nAttempts_ % (*it)->nFreq() == 0) {
-      (*it)->update(c_->iMacro());
-    }
-    if (nAttempts_ % (*it)->nFreqPrint() == 0) {
-      (*it)->write(c_);
-    }
-  }
+  runAnalyze_(c_->iMacro(), c_);
 }
 
 int WLTMMC::nMolMax(const long long npr,   //!< number of steps in production run
@@ -185,6 +182,10 @@ void WLTMMC::runNumSweeps(const int nSweeps,  //!< target number of sweeps
       }
     #endif  // _OPENMP
     vector<shared_ptr<WLTMMC> > clones(nWindow_);
+
+    // the clones of each call use new substreams, distinct from this object
+    const int rngWindowFirst = rngWindow_ + 1 + nSweepCall_*nWindow_;
+    ++nSweepCall_;
     #ifdef _OPENMP
       #pragma omp parallel private(t)
       {
@@ -200,6 +201,9 @@ void WLTMMC::runNumSweeps(const int nSweeps,  //!< target number of sweeps
     #endif  // _OPENMP
     clones[t] = this->cloneShrPtr();
     clones[t]->initWindows(0);        // turn off windowing of clones
+    if (rngSeed_ != 0) {
+      clones[t]->seedRNG(rngSeed_, rngWindowFirst + t, rngWalker_);
+    }
 
     // append output files with processor number
     stringstream ss;
@@ -301,6 +305,10 @@ void WLTMMC::runNumSweeps(const int nSweeps,  //!< target number of sweeps
     if (t == 0) writeRestart(rstFileName_.c_str());
 
     runNumSweepsExec_(t, nSweeps, &clones);
+    clones[t]->flushAnalyze();
+    #ifdef FEASST_PROFILE_
+      clones[t]->printProfile();
+    #endif  // FEASST_PROFILE_
 
     #ifdef _OPENMP
       }
@@ -314,6 +322,10 @@ void WLTMMC::runNumSweeps(const int nSweeps,  //!< target number of sweeps
           ) {
       attemptTrial();
     }
+    flushAnalyze();
+    #ifdef FEASST_PROFILE_
+      printProfile();
+    #endif  // FEASST_PROFILE_
   }
 }
 
@@ -549,6 +561,7 @@ void WLTMMC::writeRestart(const char* fileName) {
     file << "# betaInc " << betaInc_ << endl;
     file << "# lnzInc " << lnzInc_ << endl;
   }
+  if (nSweepCall_ != 0) file << "# nSweepCall " << nSweepCall_ << endl;
   file << "# densThresConfigBias " << densThresConfigBias_ << endl;
   file << "# procFileAppend " << procFileAppend_ << endl;
 
@@ -615,6 +628,7 @@ void WLTMMC::runNumSweepsRestart(
   }
 
   runNumSweepsExec_(t, nSweeps, &clones);
+  clones[t]->flushAnalyze();
 
   #ifdef _OPENMP
     }
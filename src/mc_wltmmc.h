@@ -148,6 +148,7 @@ class WLTMMC : public MC {
   int nOverlap_;  //!< window overlap
   double betaInc_;  //!< parallel tempering if != 0
   double lnzInc_;  //!< parallel tempering if != 0
+  int nSweepCall_;  //!< number of windowed calls, for distinct clone streams
 
   // configurational bias flags
   double densThresConfigBias_;  //!< set configurational bias density threshold
@@ -123,6 +123,7 @@ void Pair::defaultConstruction_() {
   orderMin_ = order_;
   orderMax_ = order_;
   rCutSq_ = rCut_ * rCut_;
+  trialKind_ = -1;
   fill(rCut_, rCutij_);
   rCutMaxAll_ = rCut_;
   dimen_ = space_->dimen(),
@@ -143,6 +144,7 @@ void Pair::defaultConstruction_() {
     << ") is too large for the minimum box length(" << space_->minl()/2.
     << ").");
   cheapEnergy_ = false;
+  noCell_ = false;
   if (atomCut_ == 0) {
     neigh_.resize(space_->nMol(), vector<int>(0));
     neighCut_.resize(space_->nMol(), vector<int>(0));
@@ -383,8 +385,8 @@ void Pair::initNeighList(
 }
 
 void Pair::buildNeighList() {
+  FEASST_PROFILE(NEIGH);
   // shorthand for read-only space variables
-  const int dimen = space_->dimen();
   int nMol = space_->nMol();
   const vector<double> x = space_->x();
   const vector<double> l = space_->boxLength();
@@ -421,37 +423,13 @@ void Pair::buildNeighList() {
           jpart = jMol;
         }
 
-        // separation distance with periodic boundary conditions
-        vector<double> rij(space_->dimen());
-        for (int dim = 0; dim < dimen; ++dim) {
-          rij[dim] = x[dimen*ipart+dim] - x[dimen*jpart+dim];
-        }
-        const vector<double> dx = space_->pbc(rij);
-        for (int dim = 0; dim < dimen; ++dim) {
-          rij[dim] += dx[dim];
-        }
-        const double r2 = vecDotProd(rij, rij);
-
-        if (r2 < rCutSq_) {
-          if (neighTypeScreen_ == 1) {
-            if ( ( (neighType_[0] == type[ipart]) &&
-                   (neighType_[1] == type[jpart]) ) ||
-                 ( (neighType_[1] == type[ipart]) &&
-                   (neighType_[0] == type[jpart]) ) ) {
-              neighCut_[iMol].push_back(jMol);
-              neighCut_[jMol].push_back(iMol);
-              if ( (r2 < neighAboveSq_) && (r2 > neighBelowSq_) ) {
-                neigh_[iMol].push_back(jMol);
-                neigh_[jMol].push_back(iMol);
-              }
-            }
-          } else {
-            neighCut_[iMol].push_back(jMol);
-            neighCut_[jMol].push_back(iMol);
-            if ( (r2 < neighAboveSq_) && (r2 > neighBelowSq_) ) {
-              neigh_[iMol].push_back(jMol);
-              neigh_[jMol].push_back(iMol);
-            }
+        const int neighbor = neighPair_(ipart, jpart, x, type);
+        if (neighbor > 0) {
+          neighCut_[iMol].push_back(jMol);
+          neighCut_[jMol].push_back(iMol);
+          if (neighbor == 2) {
+            neigh_[iMol].push_back(jMol);
+            neigh_[jMol].push_back(iMol);
           }
         }
       }
@@ -459,11 +437,41 @@ void Pair::buildNeighList() {
   }
 }
 
-void Pair::updateBase(const vector<int> mpart, const int flag,
-  const char* uptype, vector<vector<int> > &neigh,
+int Pair::neighPair_(const int ipart, const int jpart,
+  const vector<double> &x, const vector<int> &type) {
+  // separation distance with periodic boundary conditions
+  const int dimen = space_->dimen();
+  vector<double> rij(dimen);
+  for (int dim = 0; dim < dimen; ++dim) {
+    rij[dim] = x[dimen*ipart+dim] - x[dimen*jpart+dim];
+  }
+  const vector<double> dx = space_->pbc(rij);
+  for (int dim = 0; dim < dimen; ++dim) {
+    rij[dim] += dx[dim];
+  }
+  const double r2 = vecDotProd(rij, rij);
+
+  if (r2 < rCutSq_) {
+    if (neighTypeScreen_ == 1) {
+      if ( !( ( (neighType_[0] == type[ipart]) &&
+                (neighType_[1] == type[jpart]) ) ||
+              ( (neighType_[1] == type[ipart]) &&
+                (neighType_[0] == type[jpart]) ) ) ) {
+        return 0;
+      }
+    }
+    if ( (r2 < neighAboveSq_) && (r2 > neighBelowSq_) ) {
+      return 2;
+    }
+    return 1;
+  }
+  return 0;
+}
+
+void Pair::updateBase(const vector<int> &mpart, const int flag,
+  const UpdatePhase phase, vector<vector<int> > &neigh,
   vector<vector<int> > &neighOne, vector<vector<int> > &neighOneOld) {
-  std::string uptypestr(uptype);
-  if (uptypestr.compare("store") == 0) {
+  if (phase == STORE_PHASE) {
     if (flag == 0 || flag == 2 || flag == 4) {
       neighOne.clear();
     }
@@ -481,7 +489,7 @@ void Pair::updateBase(const vector<int> mpart, const int flag,
       }
     }
   }
-  if (uptypestr.compare("update") == 0) {
+  if (phase == UPDATE_PHASE) {
     // update neighbor list using the precomputed neighOne vectors called during
     // energy computation
     //  this is done by replacing neigh with precomputed neighOne
@@ -628,6 +636,53 @@ int Pair::checkNeigh() {
   return neighMatch;
 }
 
+int Pair::checkNeighSample(const vector<int> &mols) {
+  const vector<double> x = space_->x();
+  const vector<int> type = space_->type();
+  const vector<int> &mol = space_->mol();
+  const vector<int> &mol2part = space_->mol2part();
+  const int n = (atomCut_ == 0) ? space_->nMol() : space_->natom();
+  if (static_cast<int>(neigh_.size()) != n) return 0;
+  int neighMatch = 1;
+
+  // the neighbor list is symmetric
+  for (int i = 0; i < n; ++i) {
+    for (unsigned int j = 0; j < neigh_[i].size(); ++j) {
+      const int jn = neigh_[i][j];
+      if ( (jn < 0) || (jn >= n) ||
+           (std::find(neigh_[jn].begin(), neigh_[jn].end(), i) ==
+            neigh_[jn].end()) ) {
+        neighMatch = 0;
+      }
+    }
+  }
+
+  // the neighbors of the sampled molecules agree with their positions
+  for (unsigned int im = 0; im < mols.size(); ++im) {
+    const int iMol = mols[im];
+    int iBegin = iMol, iEnd = iMol + 1;
+    if (atomCut_ != 0) {
+      iBegin = mol2part[iMol];
+      iEnd = mol2part[iMol + 1];
+    }
+    for (int i = iBegin; i < iEnd; ++i) {
+      const int ipart = (atomCut_ == 0) ? mol2part[i] : i;
+      vector<int> neigh;
+      for (int j = 0; j < n; ++j) {
+        const int jpart = (atomCut_ == 0) ? mol2part[j] : j;
+        if ( (j != i) && ( (atomCut_ == 0) || (mol[i] != mol[j]) ) &&
+             (neighPair_(ipart, jpart, x, type) == 2) ) {
+          neigh.push_back(j);
+        }
+      }
+      vector<int> neighOld = neigh_[i];
+      std::sort(neighOld.begin(), neighOld.end());
+      if (neigh != neighOld) neighMatch = 0;
+    }
+  }
+  return neighMatch;
+}
+
 int Pair::checkEnergy(const double tol, const int flag) {
   double peTot1 = 0., peTot2 = 0.;
 
@@ -691,6 +746,19 @@ int Pair::checkEnergy(const double tol, const int flag) {
   return 1;
 }
 
+double Pair::checkEnergySample(const vector<int> &mols) {
+  double diffMax = 0.;
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    const vector<int> mpart = space_->imol2mpart(mols[i]);
+    const double pe = multiPartEner(mpart, 0);
+    noCell_ = true;
+    const double peNoCell = multiPartEner(mpart, 0);
+    noCell_ = false;
+    diffMax = std::max(diffMax, fabs(pe - peNoCell));
+  }
+  return diffMax;
+}
+
 void Pair::initLMPData(const string fileName) {
   // open LAMMPS data file
   std::ifstream file(fileName.c_str());
@@ -778,22 +846,22 @@ void Pair::initPairData(const int natype,
   }
 }
 
-void Pair::update(const vector<int> mpart, const int flag, const char* uptype) {
+void Pair::update(const vector<int> &mpart, const int flag,
+  const UpdatePhase phase) {
   if (neighOn_) {
     // rebuilt neighlist if all particles are updated
     if (static_cast<int>(mpart.size()) != space_->natom()) {
-      updateBase(mpart, flag, uptype, neigh_, neighOne_, neighOneOld_);
+      updateBase(mpart, flag, phase, neigh_, neighOne_, neighOneOld_);
     }
   }
-  std::string uptypestr(uptype);
 
-  if (uptypestr.compare("store") == 0) {
+  if (phase == STORE_PHASE) {
     if (flag == 0 || flag == 2 || flag == 3) {
       deSR_ = peSRone_;
     }
   }
 
-  if (uptypestr.compare("update") == 0) {
+  if (phase == UPDATE_PHASE) {
     if (flag == 0) {
       peTot_ += peSRone_ - deSR_;
     }
@@ -806,6 +874,19 @@ void Pair::update(const vector<int> mpart, const int flag, const char* uptype) {
   }
 }
 
+void Pair::update(const vector<int> &mpart, const int flag,
+  const char* uptype) {
+  FEASST_PROFILE(UPDATE);
+  const std::string uptypestr(uptype);
+  if (uptypestr.compare("store") == 0) {
+    update(mpart, flag, STORE_PHASE);
+  } else if (uptypestr.compare("update") == 0) {
+    update(mpart, flag, UPDATE_PHASE);
+  } else {
+    ASSERT(0, "unrecognized uptype(" << uptype << ")");
+  }
+}
+
 void Pair::epsijset(const int iSiteType, const int jSiteType,
   const double eps) {
   epsij_.at(iSiteType).at(jSiteType) = eps;
@@ -821,57 +902,157 @@ double Pair::exVol(
   const int nGrid,    //!< number of grid points in each dimension
   const double dProbe                  //!< diameber of probe
   ) {
-  ASSERT(dimen_ == 3, "exVol requires 3 dimensions");
-  const double voldiff = space_->minl() - pow(space_->volume(),
-    1./static_cast<double>(dimen_));
-  ASSERT(fabs(voldiff) <= 1e-12,
-    "box must be a cube to compute excluded volume");
   ASSERT(nGrid % 2 == 0, "nGrid(" << nGrid << ") must be even");
+  vector<int> occupancy;
+  const double vol = exVolGrid(nGrid, dProbe, &occupancy);
 
-  // search through equally-spaced grid of points to find fraction that overlap
-  // with molecules, based on sig
-  const vector<double> &x = space_->x();
-  const vector<double> l = space_->boxLength();
-  const double dGrid = l[0]/static_cast<double>(nGrid);
-  const int natom = space_->natom();
-  double dx, dy, dz, r2;
-  int overlaps = 0;
-  for (int xi = 0; xi < nGrid; ++xi) {
-  for (int yi = 0; yi < nGrid; ++yi) {
+  // isolated molecules may not overlap with grid points on the boundary
+  int index = 0;
   for (int zi = 0; zi < nGrid; ++zi) {
-    const double xx = (xi + 0.5 - nGrid/2.) * dGrid;
-    const double yy = (yi + 0.5 - nGrid/2.) * dGrid;
-    const double zz = (zi + 0.5 - nGrid/2.) * dGrid;
-    bool overlap = false;
-    int iAtom = 0;
-    while ( (!overlap) && (iAtom < natom) ) {
-      dx = xx - x[dimen_*iAtom];
-      dy = yy - x[dimen_*iAtom+1];
-      dz = zz - x[dimen_*iAtom+2];
-      r2 = dx*dx + dy*dy + dz*dz;
-//      cout << "r2 " << r2 << " " ;
-//      cout << "xx " << xx << " " << yy << " " << zz << " ";
-//      cout << "type " << space_->type()[iAtom] << " ";
-      const double sig = sig_[space_->type()[iAtom]];
-      double sigtmp;
-      if (fabs(sig) < DTOL) {
-        sigtmp = 0.;
-      } else {
-        sigtmp = 0.5*(sig + dProbe);
+  for (int yi = 0; yi < nGrid; ++yi) {
+  for (int xi = 0; xi < nGrid; ++xi) {
+    if (occupancy[index] == 1) {
+      if (xi == 0 || yi == 0 || zi == 0 ||
+          xi == nGrid -1 || yi == nGrid -1 || zi == nGrid - 1)
+          ASSERT(0, "box not large enough for exVol");
+    }
+    ++index;
+  }}}
+  return vol;
+}
+
+double Pair::exVolGrid(const int nGrid, const double dProbe,
+  vector<int> *occupancy) {
+  ASSERT(dimen_ == 3, "exVolGrid requires 3 dimensions");
+  ASSERT(nGrid > 0, "nGrid(" << nGrid << ") must be positive");
+  const double lx = space_->boxLength(0), ly = space_->boxLength(1),
+    lz = space_->boxLength(2), xyTilt = space_->xyTilt(),
+    xzTilt = space_->xzTilt(), yzTilt = space_->yzTilt();
+
+  // squared exclusion radius of each site type, and the largest radius
+  const int nType = static_cast<int>(sig_.size());
+  vector<double> rEx2(nType, 0.);
+  double rExMax = 0.;
+  for (int iType = 0; iType < nType; ++iType) {
+    if (fabs(sig_[iType]) >= DTOL) {
+      const double rEx = 0.5*(sig_[iType] + dProbe);
+      rEx2[iType] = rEx*rEx;
+      rExMax = std::max(rExMax, rEx);
+    }
+  }
+
+  // distance between opposite faces of the domain for each box vector
+  const double height[3] = {space_->boxHeight(0), space_->boxHeight(1),
+                            space_->boxHeight(2)};
+
+  // bin sites by fractional coordinate into cells no thinner than rExMax,
+  // and search a stencil of neighboring cells and their periodic images
+  int nCellVec[3], nStencil[3];
+  for (int dim = 0; dim < dimen_; ++dim) {
+    nCellVec[dim] = nGrid;
+    if (rExMax > 0) {
+      nCellVec[dim] = std::max(1, std::min(nGrid,
+        static_cast<int>(height[dim]/rExMax)));
+    }
+    nStencil[dim] = static_cast<int>(ceil(rExMax*nCellVec[dim]/height[dim]));
+  }
+  const int nCell = nCellVec[0]*nCellVec[1]*nCellVec[2];
+  const int natom = space_->natom();
+  const vector<double> &x = space_->x();
+  const vector<int> &type = space_->type();
+  vector<double> frac(dimen_*natom);
+  vector<int> cellOfSite(natom), cellStart(nCell + 1, 0);
+  for (int iAtom = 0; iAtom < natom; ++iAtom) {
+    const double fz = x[dimen_*iAtom + 2]/lz,
+      fy = (x[dimen_*iAtom + 1] - yzTilt*fz)/ly,
+      fx = (x[dimen_*iAtom] - xyTilt*fy - xzTilt*fz)/lx;
+    const double f[3] = {fx, fy, fz};
+    int cell = 0;
+    for (int dim = dimen_ - 1; dim >= 0; --dim) {
+      double fWrap = f[dim] + 0.5;
+      fWrap -= floor(fWrap);
+      frac[dimen_*iAtom + dim] = fWrap;
+      const int c = std::min(static_cast<int>(fWrap*nCellVec[dim]),
+                             nCellVec[dim] - 1);
+      cell = cell*nCellVec[dim] + c;
+    }
+    cellOfSite[iAtom] = cell;
+    ++cellStart[cell + 1];
+  }
+  for (int cell = 0; cell < nCell; ++cell) {
+    cellStart[cell + 1] += cellStart[cell];
+  }
+  vector<int> cellSites(natom);
+  {
+    vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+    for (int iAtom = 0; iAtom < natom; ++iAtom) {
+      cellSites[fill[cellOfSite[iAtom]]++] = iAtom;
+    }
+  }
+
+  // return true if any site excludes the grid point with fractional
+  // coordinates s, which lies in the cell with indices c
+  auto excluded = [&](const double *s, const int *c) {
+    for (int oz = -nStencil[2]; oz <= nStencil[2]; ++oz) {
+      const int jcz = c[2] + oz,
+                wz = ((jcz % nCellVec[2]) + nCellVec[2]) % nCellVec[2];
+      const double shiftz = floor(jcz/static_cast<double>(nCellVec[2]));
+      for (int oy = -nStencil[1]; oy <= nStencil[1]; ++oy) {
+        const int jcy = c[1] + oy,
+                  wy = ((jcy % nCellVec[1]) + nCellVec[1]) % nCellVec[1];
+        const double shifty = floor(jcy/static_cast<double>(nCellVec[1]));
+        for (int ox = -nStencil[0]; ox <= nStencil[0]; ++ox) {
+          const int jcx = c[0] + ox,
+                    wx = ((jcx % nCellVec[0]) + nCellVec[0]) % nCellVec[0];
+          const double shiftx = floor(jcx/static_cast<double>(nCellVec[0]));
+          const int jCell = (wz*nCellVec[1] + wy)*nCellVec[0] + wx;
+          for (int jj = cellStart[jCell]; jj < cellStart[jCell + 1]; ++jj) {
+            const int iAtom = cellSites[jj];
+            const double fx = frac[dimen_*iAtom] + shiftx - s[0],
+              fy = frac[dimen_*iAtom + 1] + shifty - s[1],
+              fz = frac[dimen_*iAtom + 2] + shiftz - s[2];
+            const double dx = lx*fx + xyTilt*fy + xzTilt*fz,
+              dy = ly*fy + yzTilt*fz, dz = lz*fz;
+            if (dx*dx + dy*dy + dz*dz < rEx2[type[iAtom]]) return true;
+          }
+        }
       }
-      if (r2 < sigtmp*sigtmp) {
-        overlap = true;
-        ++overlaps;
-        if (xi == 0 || yi == 0 || zi == 0 ||
-            xi == nGrid -1 || yi == nGrid -1 || zi == nGrid - 1)
-            ASSERT(0, "box not large enough for exVol");
+    }
+    return false;
+  };
+
+  // search through equally-spaced grid of points to find fraction that
+  // overlap with sites, with slabs of constant z distributed among threads
+  const long long nPoints = static_cast<long long>(nGrid)*nGrid*nGrid;
+  if (occupancy != NULL) occupancy->assign(nPoints, 0);
+  long long overlaps = 0;
+  #ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic) reduction(+:overlaps)
+  #endif  // _OPENMP
+  for (int zi = 0; zi < nGrid; ++zi) {
+    double s[3];
+    int c[3];
+    s[2] = (zi + 0.5)/static_cast<double>(nGrid);
+    c[2] = std::min(static_cast<int>(s[2]*nCellVec[2]), nCellVec[2] - 1);
+    for (int yi = 0; yi < nGrid; ++yi) {
+      s[1] = (yi + 0.5)/static_cast<double>(nGrid);
+      c[1] = std::min(static_cast<int>(s[1]*nCellVec[1]), nCellVec[1] - 1);
+      for (int xi = 0; xi < nGrid; ++xi) {
+        s[0] = (xi + 0.5)/static_cast<double>(nGrid);
+        c[0] = std::min(static_cast<int>(s[0]*nCellVec[0]), nCellVec[0] - 1);
+        if (excluded(s, c)) {
+          ++overlaps;
+          if (occupancy != NULL) {
+            (*occupancy)[(static_cast<long long>(zi)*nGrid + yi)*nGrid + xi]
+              = 1;
+          }
+        }
       }
-      ++iAtom;
     }
-  }}}
+  }
 
   // use fraction of overlapping points to compute volume from boundary
-  return space_->volume()*overlaps/pow(nGrid, dimen_);
+  return space_->volume()*overlaps/static_cast<double>(nPoints);
 }
 
 void Pair::update(const double de) {
@@ -1119,6 +1300,291 @@ double Pair::multiPartEner(
   return 0;
 }
 
+double Pair::ghostEner(const int excludeMol) {
+  ASSERT(ghostEnerImplemented(), "ghostEner is not implemented for "
+    << className_ << " with atomCut(" << atomCut_ << ") intra(" << intra_
+    << ")");
+  const vector<double> &xGhost = space_->ghostX();
+  const vector<int> &typeGhost = space_->ghostType();
+
+  // sites of excludeMol are contiguous
+  int jExcludeBegin = -1, jExcludeEnd = -1;
+  if (excludeMol != -1) {
+    const vector<int> mpart = space_->imol2mpart(excludeMol);
+    jExcludeBegin = mpart.front();
+    jExcludeEnd = mpart.back();
+  }
+
+  // PBC optimization variables
+  const double lx = space_->boxLength(0);
+  const double ly = space_->boxLength(1);
+  double lz = 0.;
+  if (dimen_ >= 3) {
+    lz = space_->boxLength(2);
+  }
+  const double xyTilt = space_->xyTilt();
+  const double xzTilt = space_->xzTilt();
+  const double yzTilt = space_->yzTilt();
+  const double halflx = lx/2., halfly = ly/2., halflz = lz/2.;
+
+  double dx, dy, dz = 0., energy = 0., force = 0., pe = 0.;
+  int neighbor;
+  for (int isite = 0; isite < static_cast<int>(typeGhost.size()); ++isite) {
+    const int itype = typeGhost[isite];
+    ASSERT(itype < static_cast<int>(eps_.size()), "ghost site type(" << itype
+      << ") has no pair parameters");
+    if ( (eps_[itype] != 0) || (skipEPS0_ == 0) ) {
+      const double *xi = &xGhost[dimen_*isite];
+
+      // obtain neighList with cellList
+      if (useCellForSite_(itype)) {
+        space_->buildNeighListCellPosition(xi);
+      } else {
+        space_->initAtomCut(1);   // set neighListChosen to all atoms
+      }
+      const vector<int> &neigh = space_->neighListChosen();
+
+      // loop neighboring sites
+      for (unsigned int ineigh = 0; ineigh < neigh.size(); ++ineigh) {
+        const int jpart = neigh[ineigh];
+        const int jtype = static_cast<int>(space_->type(jpart));
+        if ( (nonphys_[jpart] == 0) &&
+             ((jpart < jExcludeBegin) || (jpart > jExcludeEnd)) &&
+             ((eps_[jtype] != 0) || (skipEPS0_ == 0)) ) {
+          // separation distance with periodic boundary conditions
+          dx = xi[0] - space_->x(jpart, 0);
+          dy = xi[1] - space_->x(jpart, 1);
+          if (dimen_ >= 3) {
+            dz = xi[2] - space_->x(jpart, 2);
+          }
+          TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
+                        xyTilt, xzTilt, yzTilt);
+          const double r2 = dx*dx + dy*dy + dz*dz;
+          const double rCut = rCutij_[itype][jtype];
+          if (r2 < rCut*rCut) {
+            FEASST_PROFILE_INTERACTION();
+            pairSiteSite_(itype, jtype, &energy, &force, &neighbor, dx, dy, dz);
+            pe += energy;
+          }
+        }
+      }
+    }
+  }
+  return pe;
+}
+
+void Pair::molNeighEner(const int iMol, vector<int> *mols,
+  vector<double> *pe) {
+  ASSERT(ghostEnerImplemented(), "molNeighEner is not implemented for "
+    << className_ << " with atomCut(" << atomCut_ << ") intra(" << intra_
+    << ")");
+  mols->clear();
+  pe->clear();
+  if (static_cast<int>(molNeighIndex_.size()) != space_->nMol()) {
+    molNeighIndex_.assign(space_->nMol(), -1);
+  }
+
+  // PBC optimization variables
+  const double lx = space_->boxLength(0);
+  const double ly = space_->boxLength(1);
+  double lz = 0.;
+  if (dimen_ >= 3) {
+    lz = space_->boxLength(2);
+  }
+  const double xyTilt = space_->xyTilt();
+  const double xzTilt = space_->xzTilt();
+  const double yzTilt = space_->yzTilt();
+  const double halflx = lx/2., halfly = ly/2., halflz = lz/2.;
+
+  double dx, dy, dz = 0., energy = 0., force = 0.;
+  int neighbor;
+  for (int ipart = space_->mol2part(iMol); ipart < space_->mol2part(iMol + 1);
+       ++ipart) {
+    const int itype = static_cast<int>(space_->type(ipart));
+    if ( (eps_[itype] != 0) || (skipEPS0_ == 0) ) {
+      // obtain neighList with cellList
+      if (useCellForSite_(itype)) {
+        space_->buildNeighListCellAtomCut(ipart);
+      } else {
+        space_->initAtomCut(1);   // set neighListChosen to all atoms
+      }
+      const vector<int> &neigh = space_->neighListChosen();
+
+      // loop neighboring sites of other molecules
+      for (unsigned int ineigh = 0; ineigh < neigh.size(); ++ineigh) {
+        const int jpart = neigh[ineigh];
+        const int jMol = space_->mol(jpart);
+        const int jtype = static_cast<int>(space_->type(jpart));
+        if ( (jMol != iMol) && (nonphys_[jpart] == 0) &&
+             ((eps_[jtype] != 0) || (skipEPS0_ == 0)) ) {
+          // separation distance with periodic boundary conditions
+          dx = space_->x(ipart, 0) - space_->x(jpart, 0);
+          dy = space_->x(ipart, 1) - space_->x(jpart, 1);
+          if (dimen_ >= 3) {
+            dz = space_->x(ipart, 2) - space_->x(jpart, 2);
+          }
+          TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
+                        xyTilt, xzTilt, yzTilt);
+          const double r2 = dx*dx + dy*dy + dz*dz;
+          const double rCut = rCutij_[itype][jtype];
+          if (r2 < rCut*rCut) {
+            FEASST_PROFILE_INTERACTION();
+            pairSiteSite_(itype, jtype, &energy, &force, &neighbor, dx, dy, dz);
+            if (molNeighIndex_[jMol] == -1) {
+              molNeighIndex_[jMol] = static_cast<int>(mols->size());
+              mols->push_back(jMol);
+              pe->push_back(0.);
+            }
+            (*pe)[molNeighIndex_[jMol]] += energy;
+          }
+        }
+      }
+    }
+  }
+  for (unsigned int i = 0; i < mols->size(); ++i) {
+    molNeighIndex_[(*mols)[i]] = -1;
+  }
+}
+
+double Pair::affineEner(const vector<double> &M,
+  const vector<double> &boxLength, const double xyTilt, const double xzTilt,
+  const double yzTilt) {
+  ASSERT(affineEnerImplemented(), "affineEner is not implemented for "
+    << className_ << " with atomCut(" << atomCut_ << ")");
+  ASSERT(static_cast<int>(M.size()) == dimen_*dimen_, "size of M("
+    << M.size() << ") must be dimen(" << dimen_ << ") squared");
+  const int natom = space_->natom();
+  const vector<int> mol2part = space_->mol2part();
+  const vector<int> mol = space_->mol();
+  const vector<int> type = space_->type();
+
+  // translate each molecule by M x, where x is its first site
+  affineX_.resize(dimen_*natom);
+  for (int iMol = 0; iMol < space_->nMol(); ++iMol) {
+    const int iFirst = mol2part[iMol];
+    double dr[3] = {0., 0., 0.};
+    for (int dim = 0; dim < dimen_; ++dim) {
+      for (int k = 0; k < dimen_; ++k) {
+        dr[dim] += M[dimen_*dim + k]*space_->x(iFirst, k);
+      }
+    }
+    for (int ipart = iFirst; ipart < mol2part[iMol + 1]; ++ipart) {
+      for (int dim = 0; dim < dimen_; ++dim) {
+        affineX_[dimen_*ipart + dim] = space_->x(ipart, dim) + dr[dim];
+      }
+    }
+  }
+
+  // PBC optimization variables
+  const double lx = boxLength[0];
+  const double ly = boxLength[1];
+  double lz = 0.;
+  if (dimen_ >= 3) {
+    lz = boxLength[2];
+  }
+  const double halflx = lx/2., halfly = ly/2., halflz = lz/2.;
+
+  // if Space would use a cell list, bin the transformed sites into
+  // fractional cells of the new domain at least dCellMin wide
+  int nCellVec[3] = {1, 1, 1};
+  bool cell = useCellForSite_();
+  for (int dim = 0; (dim < dimen_) && cell; ++dim) {
+    nCellVec[dim] = static_cast<int>(space_->boxHeight(dim, boxLength,
+      xyTilt, xzTilt, yzTilt)/space_->dCellMin());
+    if (nCellVec[dim] < 3) cell = false;
+  }
+  if (cell) {
+    affineHead_.assign(nCellVec[0]*nCellVec[1]*nCellVec[2], -1);
+    affineNext_.resize(natom);
+    affineCell_.resize(dimen_*natom);
+    for (int ipart = natom - 1; ipart >= 0; --ipart) {
+      const double *xi = &affineX_[dimen_*ipart];
+      double f[3] = {0., 0., 0.};
+      if (dimen_ >= 3) {
+        f[2] = xi[2]/lz;
+        f[1] = (xi[1] - yzTilt*f[2])/ly;
+        f[0] = (xi[0] - xyTilt*f[1] - xzTilt*f[2])/lx;
+      } else {
+        f[1] = xi[1]/ly;
+        f[0] = (xi[0] - xyTilt*f[1])/lx;
+      }
+      int iCell = 0;
+      for (int dim = dimen_ - 1; dim >= 0; --dim) {
+        const int n = nCellVec[dim];
+        const int c = std::min(n - 1,
+          static_cast<int>((f[dim] - floor(f[dim]))*n));
+        affineCell_[dimen_*ipart + dim] = c;
+        iCell = iCell*n + c;
+      }
+      affineNext_[ipart] = affineHead_[iCell];
+      affineHead_[iCell] = ipart;
+    }
+  }
+
+  peSRone_ = 0.;
+  double dx, dy, dz = 0., energy = 0., force = 0.;
+  int neighbor;
+  for (int ipart = 0; ipart < natom - 1; ++ipart) {
+    const int itype = type[ipart];
+    if ( (eps_[itype] != 0) || (skipEPS0_ == 0) ) {
+      const int iMol = mol[ipart];
+      const double *xi = &affineX_[dimen_*ipart];
+
+      // obtain the sites after ipart in neighboring cells, or all of them
+      affineNeigh_.clear();
+      if (cell) {
+        const int *ci = &affineCell_[dimen_*ipart];
+        const int dzMax = (dimen_ >= 3) ? 1 : 0;
+        for (int dk = -dzMax; dk <= dzMax; ++dk) {
+          const int ck = (dimen_ >= 3) ?
+            (ci[2] + dk + nCellVec[2]) % nCellVec[2] : 0;
+          for (int dj = -1; dj <= 1; ++dj) {
+            const int cj = (ci[1] + dj + nCellVec[1]) % nCellVec[1];
+            for (int di = -1; di <= 1; ++di) {
+              const int cx = (ci[0] + di + nCellVec[0]) % nCellVec[0];
+              const int jCell = cx + nCellVec[0]*(cj + nCellVec[1]*ck);
+              for (int jpart = affineHead_[jCell]; jpart != -1;
+                   jpart = affineNext_[jpart]) {
+                if (jpart > ipart) affineNeigh_.push_back(jpart);
+              }
+            }
+          }
+        }
+      } else {
+        for (int jpart = ipart + 1; jpart < natom; ++jpart) {
+          affineNeigh_.push_back(jpart);
+        }
+      }
+
+      // loop neighboring sites
+      for (unsigned int ineigh = 0; ineigh < affineNeigh_.size(); ++ineigh) {
+        const int jpart = affineNeigh_[ineigh];
+        const int jtype = type[jpart];
+        if ( intraCheck_(ipart, jpart, iMol, mol[jpart]) &&
+             ((eps_[jtype] != 0) || (skipEPS0_ == 0)) ) {
+          // separation distance with periodic boundary conditions
+          const double *xj = &affineX_[dimen_*jpart];
+          dx = xi[0] - xj[0];
+          dy = xi[1] - xj[1];
+          if (dimen_ >= 3) {
+            dz = xi[2] - xj[2];
+          }
+          TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
+                        xyTilt, xzTilt, yzTilt);
+          const double r2 = dx*dx + dy*dy + dz*dz;
+          const double rCut = rCutij_[itype][jtype];
+          if (r2 < rCut*rCut) {
+            FEASST_PROFILE_INTERACTION();
+            pairSiteSite_(itype, jtype, &energy, &force, &neighbor, dx, dy, dz);
+            peSRone_ += energy;
+          }
+        }
+      }
+    }
+  }
+  return peSRone_;
+}
+
 double Pair::vrTot() {
   double vrTotTemp = 0.;
   for (int ipart = 0; ipart < space_->natom(); ++ipart) {
@@ -1256,6 +1722,7 @@ void Pair::allPartEnerForceMolCutInner(const double r2, const int iMol,
       dz = zisite - x[dimen_*jsite+2];
       TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
         xyTilt, xzTilt, yzTilt);
+      FEASST_PROFILE_INTERACTION();
       pairSiteSite_(itypesite, space_->type()[jsite],
                     &energy, &force, &neighbor, dx, dy, dz);
     }
@@ -1772,6 +2239,7 @@ double Pair::pairLoopSite_(const vector<int> &siteList, const int noCell) {
             const double r2 = dx*dx + dy*dy + dz*dz;
             const double rCut = rCutij_[itype][jtype];
             if (r2 < rCut*rCut) {
+              FEASST_PROFILE_INTERACTION();
               pairSiteSite_(itype, jtype, &energy, &force, &neighbor, dx, dy, dz);
               peSRone_ += energy;
               if (neighbor == 1) {
@@ -1827,6 +2295,7 @@ double Pair::pairLoopSite_(const vector<int> &siteList, const int noCell) {
                   const double r2 = dx*dx + dy*dy + dz*dz;
                   const double rCut = rCutij_[itype][jtype];
                   if (r2 < rCut*rCut) {
+                    FEASST_PROFILE_INTERACTION();
                     pairSiteSite_(itype, jtype, &energy, &force, &neighbor,
                                   dx, dy, dz);
                     peSRone_ += energy;
@@ -1872,6 +2341,7 @@ double Pair::pairLoopSite_(const vector<int> &siteList, const int noCell) {
             const double r2 = dx*dx + dy*dy + dz*dz;
             const double rCut = rCutij_[itype][jtype];
             if (r2 < rCut*rCut) {
+              FEASST_PROFILE_INTERACTION();
               pairSiteSite_(itype, jtype, &energy, &force, &neighbor, dx, dy, dz);
               peSRone_ += energy;
   //             if ( (neighbor == 1) && (neighOn_) ) {
@@ -1922,7 +2392,7 @@ void Pair::setNeighbor_(const double &r2, const int &siteIndex,
 }
 
 bool Pair::useCellForSite_(const int itype) {
-  if (space_->cellType() == 1) {
+  if ( (space_->cellType() == 1) && !noCell_ ) {
     if (cheapEnergy_) {
       return true;
     } else {
@@ -2040,6 +2510,7 @@ double Pair::pairLoopParticle_(const vector<int> &siteList, const int noCell) {
                     // optimized macro for PBC
                     TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
                                   xyTilt, xzTilt, yzTilt);
+                    FEASST_PROFILE_INTERACTION();
                     pairSiteSite_(itype, type[jSite], &energy, &force, &neighbor,
                                   dx, dy, dz);
                     peSRone_ += energy;
@@ -2109,6 +2580,7 @@ double Pair::pairLoopParticle_(const vector<int> &siteList, const int noCell) {
                   // optimized macro for PBC
                   TRICLINIC_PBC(dx, dy, dz, lx, ly, lz, halflx, halfly, halflz,
                                 xyTilt, xzTilt, yzTilt);
+                  FEASST_PROFILE_INTERACTION();
                   pairSiteSite_(itype, type[jSite], &energy, &force, &neighbor,
                                 dx, dy, dz);
                   peSRone_ += energy;
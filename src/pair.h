@@ -68,6 +68,46 @@ class Pair : public BaseRandom {
   /// Return potential energy of multiple particles.
   virtual double multiPartEner(const vector<int> multiPart, const int flag);
 
+  /**
+   * Return the potential energy of the ghost molecule generated by
+   * Space::initGhostMol with the current configuration, without adding the
+   * ghost to Space or changing the state of the pair.
+   * If excludeMol != -1, ignore the sites of molecule excludeMol, as if the
+   * ghost were to replace it.
+   */
+  virtual double ghostEner(const int excludeMol = -1);
+
+  /// Return whether ghostEner is implemented for this pair and its options.
+  virtual bool ghostEnerImplemented() const {
+    return (atomCut_ == 1) && (intra_ == 0); }
+
+  /**
+   * Compute the interaction of molecule iMol with each other molecule within
+   * the cut-off, without changing the state of the pair. The neighboring
+   * molecules are stored in mols, and their interactions with iMol in pe.
+   * Requires the cell list of iMol to be up to date.
+   * Implemented for the same pairs and options as ghostEner.
+   */
+  void molNeighEner(const int iMol, vector<int> *mols, vector<double> *pe);
+
+  /**
+   * Return the potential energy if each molecule were translated by M x,
+   * where x is the position of the first site of the molecule, in a domain
+   * with the given box lengths and tilt factors. M is a dimen x dimen matrix
+   * in row-major order (e.g., scaling dimension d by f is M_dd = f - 1).
+   * The transformed positions are computed on the fly, such that neither
+   * Space nor its cell list is changed, and an accepted trial must apply the
+   * same transformation to Space (e.g., with Space::scaleDomain or
+   * Space::modXYTilt). Forces are not computed.
+   * Sets peSRone_ for the bookkeeping of commitTrial.
+   */
+  virtual double affineEner(const vector<double> &M,
+    const vector<double> &boxLength, const double xyTilt = 0.,
+    const double xzTilt = 0., const double yzTilt = 0.);
+
+  /// Return whether affineEner is implemented for this pair and its options.
+  virtual bool affineEnerImplemented() const { return (atomCut_ == 1); }
+
   /**
    * Compute the interaction between two particles itype and jtype separated
    * by a squared distance r2=r*r.
@@ -106,12 +146,57 @@ class Pair : public BaseRandom {
     const int iMol, const int jMol, const double dx,
     const double dy, const double dz);
 
-  /// Store, restore or update variables to avoid recompute
+  /// Kind of trial, with values matching the flags of multiPartEner.
+  enum TrialKind {
+    MOVE_TRIAL = 0,     //!< particles move, same number of particles
+    DELETE_TRIAL = 2,   //!< particles are deleted
+    ADD_TRIAL = 3       //!< particles were just added
+  };
+
+  /// Phase of the store/update of a trial.
+  enum UpdatePhase {
+    STORE_PHASE,    //!< record contributions of the old configuration
+    UPDATE_PHASE    //!< apply the contributions of the new configuration
+  };
+
+  /// Store or update variables to avoid recompute
   /// of entire configuration after every trial particle move.
-  /// @param uptype description of update type
-  virtual void update(const vector<int> mpart,  //!< particles involved
+  virtual void update(const vector<int> &mpart,  //!< particles involved
     const int flag,   //!< type of move
-    const char* uptype);
+    const UpdatePhase phase);
+
+  /// Same as above, but with a description of the update type, "store" or
+  /// "update". Prefer beginTrial and commitTrial below in trials.
+  void update(const vector<int> &mpart, const int flag, const char* uptype);
+
+  /**
+   * Begin a trial by storing the energy contributions of the particles in
+   * mpart, which must have been computed with multiPartEner just before.
+   * This is the store phase of update, dispatched on TrialKind rather than
+   * a string. Staged energies, neighbor lists and structure factors are
+   * only applied by commitTrial, so Pair keeps no undo state, and
+   * rollbackTrial only closes the trial. Trials still store and restore
+   * the positions in Space with Space::xStore and Space::restore.
+   */
+  void beginTrial(const vector<int> &mpart, const TrialKind kind) {
+    FEASST_PROFILE(UPDATE);
+    update(mpart, kind, STORE_PHASE);
+    trialKind_ = kind;
+  }
+
+  /// Apply the trial begun with beginTrial (the update phase of update).
+  void commitTrial(const vector<int> &mpart) {
+    ASSERT(trialKind_ >= 0, "commitTrial without beginTrial");
+    FEASST_PROFILE(UPDATE);
+    update(mpart, trialKind_, UPDATE_PHASE);
+    trialKind_ = -1;
+  }
+
+  /// Close the trial begun with beginTrial without applying it.
+  void rollbackTrial() { trialKind_ = -1; }
+
+  /// Return the kind of the open trial, or -1 if none.
+  int trialKind() const { return trialKind_; }
 
   /**
    * Update total potential energy, peTot_ with energy change, de.
@@ -124,6 +209,11 @@ class Pair : public BaseRandom {
    */
   virtual void update(const double de);
 
+  /// Return whether update(de) alone keeps the state of the pair consistent
+  /// after molecules are moved, because the pair stores no position-dependent
+  /// terms other than the total energy (e.g., no Fourier-space terms).
+  virtual bool updateDeImplemented() const { return true; }
+
   // For CriteriaMayer, simply set the total potential energy.
   virtual void updatePeTot(const double peTot);
 
@@ -192,6 +282,13 @@ class Pair : public BaseRandom {
   /// Return 1 if re-built neighborlist matchces current neighborlist.
   int checkNeigh();
 
+  /**
+   * Return 1 if a sample of the neighbor list has no errors, without
+   * rebuilding it. The neighbor list must be symmetric, and the neighbors of
+   * each molecule in mols (or each of its sites) must agree with positions.
+   */
+  int checkNeighSample(const vector<int> &mols);
+
   /**
    * Store, restore or update neighbor list variables to avoid recompute of
    * entire configuration after every particle change.
@@ -205,9 +302,9 @@ class Pair : public BaseRandom {
    * @param neighOneOld neighbor list to update
    */
   void updateBase(
-    const vector<int> mpart,    //!< particles involved in move
+    const vector<int> &mpart,    //!< particles involved in move
     const int flag,
-    const char* uptype,    //!< description of update type
+    const UpdatePhase phase,    //!< store or update
     vector<vector<int> > &neigh,   //!< neighbor list to update
     vector<vector<int> > &neighOne,   //!< neighbor list to update
     vector<vector<int> > &neighOneOld);
@@ -225,6 +322,15 @@ class Pair : public BaseRandom {
    */
   int checkEnergy(const double tol, const int flag);
 
+  /**
+   * Return the largest absolute difference, over the molecules in mols,
+   * between the energy of the molecule as computed in trials (e.g., with the
+   * cell list) and as recomputed without the cell list.
+   * This does not check the stored total energy, peTot (see
+   * MC::initSampledCheckE).
+   */
+  double checkEnergySample(const vector<int> &mols);
+
   /// Initialize pair data.
   void initPairData(const int natype, const vector<double> eps,
     const vector<double> sig, const vector<double> sigref);
@@ -258,10 +364,28 @@ class Pair : public BaseRandom {
   /// Note: The site types in LMP start from 1, but FEASST starts from 0.
   void epsijset(const int iSiteType, const int jSiteType, const double eps);
 
-  /// Return excluded volume of all molecules in space, using sig_.
+  /** Return excluded volume of all molecules in space, using sig_.
+   *  The molecules must be isolated from the boundaries of the domain. */
   double exVol(const int nGrid, const double dProbe);
   double exVol(const int nGrid) { return exVol(nGrid, 1.); }
 
+  /** Return the volume excluded to the center of a spherical probe of
+   *  diameter dProbe by all sites in the periodic domain, using sig_.
+   *  The domain may be non-cubic or tilted, and is sampled by nGrid points
+   *  along each box vector.
+   *  Sites are binned into cells no thinner than the largest exclusion
+   *  radius, so that each grid point only tests nearby sites, and slabs of
+   *  the grid are distributed among OpenMP threads.
+   *  If occupancy is not NULL, it is filled with 1 for excluded and 0 for
+   *  accessible grid points, with the x index varying fastest. */
+  double exVolGrid(const int nGrid, const double dProbe,
+                   vector<int> *occupancy = NULL);
+
+  /// Return the volume accessible to the center of the probe.
+  double accVolGrid(const int nGrid, const double dProbe,
+                    vector<int> *occupancy = NULL) {
+    return space_->volume() - exVolGrid(nGrid, dProbe, occupancy); }
+
   /// Update clusters of entire system.
   virtual void updateClusters(const double rCCut) {
     space_->peStore_ = peTot();
@@ -447,6 +571,7 @@ class Pair : public BaseRandom {
   double peTot_;    //!< total potential energy
   double peSR_;
   double deSR_;
+  int trialKind_;   //!< kind of open trial, or -1 if none
   double peSRone_;  //!< lennard jones potential energy from subset of particles
   /// lennard jones potential energy from subset of particles
   double peSRoneAlt_;
@@ -509,6 +634,8 @@ class Pair : public BaseRandom {
   int fastDelMol_;                   //!< molecule last deleted by fast method
   /// cheap potential calculation for CBMC multiple first-bead insertions
   bool cheapEnergy_;
+  /// do not use the cell list (error checking)
+  bool noCell_;
   /// atomic or molecule distance based cut-off, neigh list is by atom if 1,
   //  or by molecule if 0
   int atomCut_;
@@ -534,6 +661,13 @@ class Pair : public BaseRandom {
 
   vector<int> nonphys_;  // identifies particles as non-physical, pair ignores
 
+  // scratch for molNeighEner: index of each molecule in mols, or -1
+  vector<int> molNeighIndex_;
+
+  // scratch for affineEner: transformed positions and a linked cell list
+  vector<double> affineX_;
+  vector<int> affineCell_, affineHead_, affineNext_, affineNeigh_;
+
   /// Return true if there is an intramolecular interaction between ipart,
   /// and jpart which belong to iMol and jMol, respectively.
   bool intraCheck_(const int ipart, const int jpart,
@@ -609,6 +743,13 @@ class Pair : public BaseRandom {
     const double &dz       //!< z-dimension separation
     ) { ASSERT(0, "not implemented"); }
 
+  /**
+   * Return 2 if sites ipart and jpart are neighbors, 1 if they are only
+   * within the cut-off (neighCut), or 0 otherwise.
+   */
+  int neighPair_(const int ipart, const int jpart, const vector<double> &x,
+    const vector<int> &type);
+
   /// Return whether or not to use a cell list
   bool useCellForSite_(
     /// Particle type. Use -1 for all types.
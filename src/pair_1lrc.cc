@@ -130,9 +130,10 @@ void PairLRC::initLRC() {
     }
   }
 //  cout << "Init LRCs" << endl << vec2str(lrcPreCalc_) << endl;
+  initLRCCounts_();
 }
 
-double PairLRC::computeLRC(const vector<int> msite) {
+double PairLRC::computeLRC(const vector<int> &msite) {
   double enlrc = 0.;
   if (lrcFlag == 0) return enlrc;
   if (lrcPreCalc_.size() == 0) {
@@ -140,32 +141,118 @@ double PairLRC::computeLRC(const vector<int> msite) {
   }
   // If msite is empty, loop over all sites
   if (msite.size() == 0) {
-    for (int iType = 0; iType < space_->nParticleTypes(); ++iType) {
-      for (int jType = 0; jType < space_->nParticleTypes(); ++jType) {
-        const int nanb = space_->nType()[iType]*space_->nType()[jType];
-        enlrc += static_cast<double>(nanb)/space_->volume()
-                *lrcPreCalc_[iType][jType];
-      }
+    // recompute the rows from scratch to avoid accumulating round-off
+    initLRCCounts_();
+    for (int iType = 0; iType < static_cast<int>(lrcRow_.size()); ++iType) {
+      enlrc += nTypeLRC_[iType]*lrcRow_[iType];
     }
   } else {
+    updateLRCCounts_();
+
     // Find the number of particles of each type
-    vector<int> msiteTypes(space_->nParticleTypes(), 0);
     for (int imsite = 0; imsite < static_cast<int>(msite.size()); ++imsite) {
-      ++msiteTypes[space()->type()[msite[imsite]]];
+      const int iType = static_cast<int>(space_->type(msite[imsite]));
+      if (msiteTypeCount_[iType] == 0) msiteTypeList_.push_back(iType);
+      ++msiteTypeCount_[iType];
     }
 
-    for (int iType = 0; iType < space_->nParticleTypes(); ++iType) {
-      for (int jType = 0; jType < space_->nParticleTypes(); ++jType) {
-        const double ni = space_->nType()[iType],
-                     nia = msiteTypes[iType],
-                     nj = space_->nType()[jType],
-                     nja = msiteTypes[jType];
-        enlrc += (ni*nja + nia*nj - nia*nja)/space_->volume()
-                 *lrcPreCalc_[iType][jType];
+    // (ni*nja + nia*nj - nia*nja)*Cij summed over ij, with Cij symmetric
+    for (unsigned int i = 0; i < msiteTypeList_.size(); ++i) {
+      const int iType = msiteTypeList_[i];
+      double nCmsite = 0.;
+      for (unsigned int j = 0; j < msiteTypeList_.size(); ++j) {
+        const int jType = msiteTypeList_[j];
+        nCmsite += msiteTypeCount_[jType]*lrcPreCalc_[iType][jType];
       }
+      enlrc += msiteTypeCount_[iType]*(2.*lrcRow_[iType] - nCmsite);
+    }
+
+    // reset for the next call
+    for (unsigned int i = 0; i < msiteTypeList_.size(); ++i) {
+      msiteTypeCount_[msiteTypeList_[i]] = 0;
+    }
+    msiteTypeList_.clear();
+  }
+  return enlrc/space_->volume();
+}
+
+double PairLRC::computeLRCGhost(const int excludeMol) {
+  if (lrcFlag == 0) return 0.;
+  if (lrcPreCalc_.size() == 0) {
+    initLRC();
+  }
+  updateLRCCounts_();
+
+  // number of ghost sites of each type, ni, is stored in msiteTypeCount_
+  const vector<int> &typeGhost = space_->ghostType();
+  for (int isite = 0; isite < static_cast<int>(typeGhost.size()); ++isite) {
+    const int iType = typeGhost[isite];
+    if (msiteTypeCount_[iType] == 0) msiteTypeList_.push_back(iType);
+    ++msiteTypeCount_[iType];
+  }
+  vector<int> mpartExclude;
+  if (excludeMol != -1) mpartExclude = space_->imol2mpart(excludeMol);
+
+  // ni*(2*Ri - 2*sum_e C(i,e) + nj*Cij) summed over ij, where e are the sites
+  // of excludeMol, which are not present when the ghost is added
+  double delrc = 0.;
+  for (unsigned int i = 0; i < msiteTypeList_.size(); ++i) {
+    const int iType = msiteTypeList_[i];
+    double nCmsite = 0.;
+    for (unsigned int j = 0; j < msiteTypeList_.size(); ++j) {
+      const int jType = msiteTypeList_[j];
+      nCmsite += msiteTypeCount_[jType]*lrcPreCalc_[iType][jType];
     }
+    for (unsigned int e = 0; e < mpartExclude.size(); ++e) {
+      const int eType = static_cast<int>(space_->type(mpartExclude[e]));
+      nCmsite -= 2.*lrcPreCalc_[iType][eType];
+    }
+    delrc += msiteTypeCount_[iType]*(2.*lrcRow_[iType] + nCmsite);
+  }
+
+  // reset for the next call
+  for (unsigned int i = 0; i < msiteTypeList_.size(); ++i) {
+    msiteTypeCount_[msiteTypeList_[i]] = 0;
+  }
+  msiteTypeList_.clear();
+  return delrc/space_->volume();
+}
+
+void PairLRC::initLRCCounts_() {
+  const int nTypes = space_->nParticleTypes();
+  nTypeLRC_.resize(nTypes);
+  lrcRow_.assign(nTypes, 0.);
+  msiteTypeCount_.assign(nTypes, 0);
+  msiteTypeList_.clear();
+  msiteTypeList_.reserve(nTypes);
+  for (int jType = 0; jType < nTypes; ++jType) {
+    nTypeLRC_[jType] = space_->nType(jType);
+  }
+  if (static_cast<int>(lrcPreCalc_.size()) >= nTypes) {
+    for (int iType = 0; iType < nTypes; ++iType) {
+      for (int jType = 0; jType < nTypes; ++jType) {
+        lrcRow_[iType] += lrcPreCalc_[iType][jType]*nTypeLRC_[jType];
+      }
+    }
+  }
+}
+
+void PairLRC::updateLRCCounts_() {
+  if (static_cast<int>(nTypeLRC_.size()) != space_->nParticleTypes()) {
+    initLRCCounts_();
+  } else {
+    for (int iType = 0; iType < static_cast<int>(nTypeLRC_.size()); ++iType) {
+      const int dn = space_->nType(iType) - nTypeLRC_[iType];
+      if (dn != 0) shiftLRCCount_(iType, dn);
+    }
+  }
+}
+
+void PairLRC::shiftLRCCount_(const int iType, const int dn) {
+  nTypeLRC_[iType] += dn;
+  for (int jType = 0; jType < static_cast<int>(lrcRow_.size()); ++jType) {
+    lrcRow_[jType] += lrcPreCalc_[jType][iType]*dn;
   }
-  return enlrc;
 }
 
 void PairLRC::linearShift(const int flag) {
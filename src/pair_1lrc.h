@@ -39,6 +39,18 @@ namespace feasst {
  * When a site or multiple sites are added simultaneously,
  * \f$\Delta U^{LRC}_{ij} \sim N_i N_{ja} + N_{ia} N_j - N_{ia} N_{ja} \f$,
  * where \f$N_{ia}\f$ is the number of sites of type i that were added.
+ *
+ * To avoid a loop over all sites for every trial, the number of sites of each
+ * type, \f$N_j\f$, is cached along with the per-type row,
+ * \f$R_i = \sum_j C_{ij} N_j\f$.
+ * Before each use, the cached numbers are compared with those of Space, and
+ * the rows are shifted for each type whose number changed, whether by
+ * insertion, deletion or a change of type (e.g., Space::settype).
+ * The change in energy upon insertion or deletion,
+ * \f$\Delta U^{LRC} = \sum_i N_{ia}(2R_i - \sum_j C_{ij} N_{ja})/V\f$,
+ * costs O(number of types) with no allocations.
+ * Because the row does not include the volume, it remains valid when the
+ * domain is scaled.
  */
 class PairLRC : public Pair {
  public:
@@ -51,7 +63,15 @@ class PairLRC : public Pair {
   /// Return the long-range contribution.
   double computeLRC(
     /// compute contribution from subset of sites. If empty, consider all sites.
-    const vector<int> msite = vector<int>());
+    const vector<int> &msite = vector<int>());
+
+  /**
+   * Return the change in the long-range contribution upon adding the ghost
+   * generated by Space::initGhostMol, without changing the cached number of
+   * each type. If excludeMol != -1, the sites of molecule excludeMol are
+   * considered absent, as in Pair::ghostEner.
+   */
+  double computeLRCGhost(const int excludeMol = -1);
 
   /// Initialize cut and shifted potential for all particle types if flag == 1.
   /// \f$ U = U_{LJ} - U(rCut)\f$ when \f$r < rCut\f$.
@@ -107,6 +127,28 @@ class PairLRC : public Pair {
   /// precalculation for tail corrections (long range corrections)
   vector<vector<double> > lrcPreCalc_;
 
+  /// cached number of sites of each type, as seen by the last update
+  vector<int> nTypeLRC_;
+
+  /// cached row of tail corrections, lrcRow_[i] = sum_j lrcPreCalc_[i][j]*N_j
+  vector<double> lrcRow_;
+
+  /// number of sites of each type in msite (reused by computeLRC)
+  vector<int> msiteTypeCount_;
+
+  /// types present in msite (reused by computeLRC)
+  vector<int> msiteTypeList_;
+
+  /// Recompute the cached number of each type and the rows from Space.
+  void initLRCCounts_();
+
+  /// Bring the cached number of each type up to date with Space, updating the
+  /// rows only for the types which changed.
+  void updateLRCCounts_();
+
+  /// Change the cached number of sites of type iType by dn.
+  void shiftLRCCount_(const int iType, const int dn);
+
   double peShift_;          //!< shift potential energy by this amount
   bool cutShiftFlag_;       //!< flag to cut and shift potential by constant
 
@@ -153,20 +153,20 @@ void PairHybrid::delPart(const vector<int> mpart) {
 }
 
 void PairHybrid::update(
-  const vector<int> mpart,    //!< particles involved in move
+  const vector<int> &mpart,    //!< particles involved in move
   const int flag,         //!< type of move
-  const char* uptype    //!< description of update type
+  const UpdatePhase phase    //!< store or update
   ) {
   if (selected_.size() > 0) {
     // compute from selected pair(s)
     for (unsigned int i = 0; i < selected_.size(); ++i) {
       const int iPair = selected_[i];
-      pairVec_[iPair]->update(mpart, flag, uptype);
+      pairVec_[iPair]->update(mpart, flag, phase);
     }
   } else {
     // all pairs
     for (int i = 0; i < nPairs(); ++i) {
-      pairVec_[i]->update(mpart, flag, uptype);
+      pairVec_[i]->update(mpart, flag, phase);
     }
   }
 }
@@ -41,13 +41,29 @@ class PairHybrid : public Pair {
   /// potential energy of multiple particles
   double multiPartEner(const vector<int> multiPart, const int flag);
 
+  /// ghostEner is not implemented for the hybrid of pairs.
+  bool ghostEnerImplemented() const { return false; }
+
+  /// affineEner is not implemented for the hybrid of pairs.
+  bool affineEnerImplemented() const { return false; }
+
+  /// update(de) is implemented if it is implemented for each pair.
+  bool updateDeImplemented() const {
+    for (unsigned int i = 0; i < pairVec_.size(); ++i) {
+      if (!pairVec_[i]->updateDeImplemented()) return false;
+    }
+    return true;
+  }
+
   double peTot();   // total potential energy of system
   double vrTot();   // total virial of system
 
   /// stores, restores or updates variables to avoid order recompute of entire
   //  configuration after every change
-  void update(const vector<int> mpart, const int flag, const char* uptype);
+  void update(const vector<int> &mpart, const int flag,
+    const UpdatePhase phase);
   void update(const double de);
+  using Pair::update;
 
   /// add particle(s)
   void addPart();
@@ -149,6 +149,24 @@ double PairLJ::multiPartEner(const vector<int> mpart, const int flag) {
   return pairLoopSite_(mpart) + peLRCone_;
 }
 
+double PairLJ::ghostEner(const int excludeMol) {
+  double pe = Pair::ghostEner(excludeMol);
+  if (!cheapEnergy_) {
+    pe += computeLRCGhost(excludeMol);
+  }
+  return pe;
+}
+
+double PairLJ::affineEner(const vector<double> &M,
+  const vector<double> &boxLength, const double xyTilt, const double xzTilt,
+  const double yzTilt) {
+  const double pe = Pair::affineEner(M, boxLength, xyTilt, xzTilt, yzTilt);
+
+  // the long range corrections are inversely proportional to the volume
+  peLRCone_ = computeLRC()*space_->volume()/product(boxLength);
+  return pe + peLRCone_;
+}
+
 void PairLJ::writeRestart(const char* fileName) {
   PairLRC::writeRestart(fileName);
   std::ofstream file(fileName, std::ios_base::app);
@@ -412,6 +430,7 @@ double PairLJ::pairLoopSite_(
 
         // no interaction beyond cut-off distance
         if (r2 < rCutSq_) {
+          FEASST_PROFILE_INTERACTION();
           r6inv = 1./(r2*r2*r2);
           peSRone_ += 4. * (r6inv*(r6inv - 1.)) + peShift;
           if (linearShiftFlag_) {
@@ -430,19 +449,18 @@ double PairLJ::pairLoopSite_(
 }
 
 void PairLJ::update(
-  const vector<int> mpart,
+  const vector<int> &mpart,
   const int flag,
-  const char* uptype) {
+  const UpdatePhase phase) {
   if (neighOn_) {
     // rebuilt neighlist if all particles are updated
     if (static_cast<int>(mpart.size()) != space_->natom()) {
-      updateBase(mpart, flag, uptype, neigh_, neighOne_, neighOneOld_);
-  //  updateBase(mpart, flag, uptype, neighCut_, neighCutOne_, neighCutOneOld_);
+      updateBase(mpart, flag, phase, neigh_, neighOne_, neighOneOld_);
+  //  updateBase(mpart, flag, phase, neighCut_, neighCutOne_, neighCutOneOld_);
     }
   }
-  std::string uptypestr(uptype);
 
-  if (uptypestr.compare("store") == 0) {
+  if (phase == STORE_PHASE) {
     if (flag == 0 || flag == 2 || flag == 3) {
       deLJ_ = peSRone_;
       deLRC_ = peLRCone_;
@@ -450,7 +468,7 @@ void PairLJ::update(
     }
   }
 
-  if (uptypestr.compare("update") == 0) {
+  if (phase == UPDATE_PHASE) {
     if (flag == 0) {
       peLJ_ += peSRone_ - deLJ_;
       peLRC_ += peLRCone_ - deLRC_;
@@ -112,6 +112,15 @@ class PairLJ : public PairLRC {
   /// potential energy of multiple particles
   double multiPartEner(const vector<int> multiPart, const int flag);
 
+  /// Potential energy of the ghost molecule, including long range corrections.
+  double ghostEner(const int excludeMol = -1);
+
+  /// Potential energy of an affine transformation, as in Pair::affineEner,
+  /// including long range corrections for the transformed volume.
+  double affineEner(const vector<double> &M, const vector<double> &boxLength,
+    const double xyTilt = 0., const double xzTilt = 0.,
+    const double yzTilt = 0.);
+
   /**
    * Potential energy and forces of all particles.
    *  if flag == 0, dummy calculation
@@ -127,7 +136,9 @@ class PairLJ : public PairLRC {
 
   // stores, restores or updates variables to avoid order recompute of entire
   //  configuration after every change
-  void update(const vector<int> mpart, const int flag, const char* uptype);
+  void update(const vector<int> &mpart, const int flag,
+    const UpdatePhase phase);
+  using Pair::update;
 
   PairLJ(Space* space, const char* fileName);
   ~PairLJ() {}
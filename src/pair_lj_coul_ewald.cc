@@ -122,7 +122,7 @@ double PairLJCoulEwald::allPartEnerForce(const int flag) {
 
 void PairLJCoulEwald::initEnergy() {
   allPartEnerForce(2);
-  update(space_->listAtoms(), 5, "update");
+  update(space_->listAtoms(), 5, UPDATE_PHASE);
   peLJ_ = peLJone_;
   peLRC_ = peLRCone_;
   peQReal_ = peQRealone_;
@@ -258,7 +258,7 @@ double PairLJCoulEwald::peTot() {
 
 void PairLJCoulEwald::delPart(
   const vector<int> mpart) {
-  delPartBase_(mpart);
+  PairLRC::delPart(mpart);
   int natom = space_->natom();
   for (int i = mpart.size() - 1; i >= 0; --i) {
     int ipart = mpart[i];
@@ -305,7 +305,7 @@ void PairLJCoulEwald::addPart() {
       eikiz_.insert(eikiz_.begin() + natomprev*k+natomprev, 0.);
     }
   }
-  addPartBase_();
+  PairLRC::addPart();
 }
 
 void PairLJCoulEwald::forcesFrr_() {
@@ -519,16 +519,15 @@ double PairLJCoulEwald::multiPartEner(const vector<int> multiPart,
 }
 
 void PairLJCoulEwald::update(
-  const vector<int> mpart,
+  const vector<int> &mpart,
   const int flag,
-  const char* uptype) {
+  const UpdatePhase phase) {
   if (neighOn_) {
-    updateBase(mpart, flag, uptype, neigh_, neighOne_, neighOneOld_);
-//  updateBase(mpart, flag, uptype, neighCut_, neighCutOne_, neighCutOneOld_);
+    updateBase(mpart, flag, phase, neigh_, neighOne_, neighOneOld_);
+//  updateBase(mpart, flag, phase, neighCut_, neighCutOne_, neighCutOneOld_);
   }
-  std::string uptypestr(uptype);
 
-  if (uptypestr.compare("store") == 0) {
+  if (phase == STORE_PHASE) {
     if (flag == 0 || flag == 2 || flag == 3) {
       deLJ_ = peLJone_;
       deLRC_ = peLRCone_;
@@ -537,7 +536,7 @@ void PairLJCoulEwald::update(
     }
   }
 
-  if (uptypestr.compare("update") == 0) {
+  if (phase == UPDATE_PHASE) {
     peQFrr_ = peQFrrone_;
     if (flag == 0) {
       peLJ_ += peLJone_ - deLJ_;
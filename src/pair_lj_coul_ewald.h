@@ -121,6 +121,15 @@ class PairLJCoulEwald : public PairLRC {
    */
   double multiPartEner(const vector<int> multiPart, const int flag);
 
+  /// ghostEner is not implemented for Ewald summation.
+  bool ghostEnerImplemented() const { return false; }
+
+  /// affineEner is not implemented for Ewald summation.
+  bool affineEnerImplemented() const { return false; }
+
+  /// update(de) does not update the Fourier-space terms of Ewald summation.
+  bool updateDeImplemented() const { return false; }
+
   /// function to calculate real-space interaction energy contribution a subset
   /// of particles
   double multiPartEnerReal(const vector<int> mpart, const int flag);
@@ -147,10 +156,10 @@ class PairLJCoulEwald : public PairLRC {
    *  flag==3, just inserted particle
    *  flag==5, computing entire configuration
    */
-  void update(const vector<int> mpart,  //!< particles involved in move
+  void update(const vector<int> &mpart,  //!< particles involved in move
     const int flag,   //!< type of move
-    /// description of update type
-    const char* uptype);
+    const UpdatePhase phase);
+  using Pair::update;
 
   double peTot();   //!< total potential energy of system
 
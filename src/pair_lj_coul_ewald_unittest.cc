@@ -177,6 +177,46 @@ TEST(PairLJCoulEwald, pairLJCoulEwaldmultiPartEne) {
   EXPECT_NEAR(1, (pePrev + de)/p.peTot(), 1e-11);
 }
 
+TEST(PairLJCoulEwald, trialTransaction) {
+  Space s(3);
+  s.initBoxLength(24.8586887);
+  s.readXYZBulk(3, "water", "../unittest/spce/test52.xyz");
+  s.addMolInit("../forcefield/data.spce");
+  PairLJCoulEwald p(&s, {{"rCut", "12.42934435"}});
+  p.initBulkSPCE(5.6, 38);
+  const vector<int> mpart = s.imol2mpart(0);
+  const double pe = p.peTot();
+
+  // rolled back moves leave the stored energies unchanged
+  p.multiPartEner(mpart, 0);
+  p.beginTrial(mpart, Pair::MOVE_TRIAL);
+  EXPECT_EQ(Pair::MOVE_TRIAL, p.trialKind());
+  s.xStore(mpart);
+  s.randDisp(mpart, 2);
+  p.multiPartEner(mpart, 1);
+  s.restore(mpart);
+  p.rollbackTrial();
+  EXPECT_EQ(-1, p.trialKind());
+  EXPECT_NEAR(pe, p.peTot(), 1e-12);
+  p.initEnergy();
+  EXPECT_NEAR(pe, p.peTot(), 1e-10);
+
+  // committed moves track the energy of the entire configuration
+  const double peOld = p.multiPartEner(mpart, 0);
+  p.beginTrial(mpart, Pair::MOVE_TRIAL);
+  s.randDisp(mpart, 2);
+  const double peNew = p.multiPartEner(mpart, 1);
+  p.commitTrial(mpart);
+  EXPECT_NEAR(pe + peNew - peOld, p.peTot(), 1e-10);
+  const double peCommit = p.peTot();
+  p.initEnergy();
+  EXPECT_NEAR(peCommit, p.peTot(), 1e-8);
+  try {
+    p.commitTrial(mpart);
+    CATCH_PHRASE("commitTrial without beginTrial");
+  }
+}
+
 TEST(PairLJCoulEwald, neigh) {
   ranInitByDate();
   Space s(3);
@@ -111,6 +111,38 @@ TEST(PairLJ, exVol) {
   EXPECT_NEAR(4.*PI/3., p.exVol(1e2), 3e-3);
 }
 
+TEST(PairLJ, exVolGridTriclinic) {
+  Space s(3);
+  s.initBoxLength(5., 0);
+  s.initBoxLength(4., 1);
+  s.initBoxLength(6., 2);
+  s.setXYTilt(1.);
+  s.setXZTilt(-0.5);
+  s.setYZTilt(0.7);
+  PairLJ p(&s);
+
+  // a site straddling the periodic boundary excludes a whole sphere
+  vector<double> xAdd(3, 0.);
+  xAdd[2] = 2.9;
+  p.addMol(xAdd);
+  vector<int> occupancy;
+  const int nGrid = 80;
+  const double vol = p.exVolGrid(nGrid, 1., &occupancy);
+  EXPECT_NEAR(4.*PI/3., vol, 2e-2);
+  int nExcluded = 0;
+  for (unsigned int i = 0; i < occupancy.size(); ++i) nExcluded += occupancy[i];
+  EXPECT_EQ(pow(nGrid, 3), occupancy.size());
+  EXPECT_NEAR(vol, s.volume()*nExcluded/pow(nGrid, 3), DTOL);
+  EXPECT_NEAR(s.volume() - vol, p.accVolGrid(nGrid, 1.), DTOL);
+
+  // two distant sites exclude twice the volume, and less for a point probe
+  xAdd[0] = 1.2;
+  xAdd[2] = 0.;
+  p.addMol(xAdd);
+  EXPECT_NEAR(8.*PI/3., p.exVolGrid(nGrid, 1.), 4e-2);
+  EXPECT_NEAR(2.*PI/6., p.exVolGrid(nGrid, 0.), 2e-2);
+}
+
 TEST(PairLJ, args) {
   {
     feasst::Space space;
@@ -449,3 +481,87 @@ TEST(PairLJ, InitAlphaAnalytical) {
 
   delete pcut;
 }
+
+TEST(PairLJ, LRCcachedCounts) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.cg3_60_1_1"}});
+  for (int i = 0; i < 10; ++i) p.addMol();
+  const double lrcAll = p.computeLRC();
+
+  // deletion
+  vector<int> mpart = s.imol2mpart(3);
+  const double lrcDel = p.computeLRC(mpart);
+  p.delPart(mpart);
+  s.delPart(mpart);
+  const double lrcAfterDel = p.computeLRC();
+  EXPECT_NEAR(lrcAll - lrcDel, lrcAfterDel, 1e-12);
+
+  // insertion
+  p.addMol();
+  mpart = s.lastMolIDVec();
+  EXPECT_NEAR(lrcAfterDel + p.computeLRC(mpart), lrcAll, 1e-12);
+
+  // volume change
+  p.scaleDomain(2.);
+  EXPECT_NEAR(lrcAll/2., p.computeLRC(), 1e-12);
+  EXPECT_NEAR(lrcDel/2., p.computeLRC(mpart), 1e-12);
+
+  // change of type at constant number of sites
+  s.settype(mpart.front(), 1);
+  const double lrcMol = p.computeLRC(mpart);
+  const double lrcAllType = p.computeLRC();
+  p.delPart(mpart);
+  s.delPart(mpart);
+  EXPECT_NEAR(lrcAllType - lrcMol, p.computeLRC(), 1e-12);
+}
+
+TEST(PairLJ, ghostEner) {
+  for (int cell = 0; cell < 2; ++cell) {
+    Space s(3, {{"boxLength", "12"}});
+    PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.cg3_60_1_1"}});
+    for (int i = 0; i < 12; ++i) p.addMol();
+    if (cell == 1) {
+      p.initAtomCut(1);
+      s.updateCells(p.rCutMaxAll());
+      EXPECT_EQ(1, s.cellType());
+    }
+    p.initEnergy();
+    const string molType = s.addMolListType(0);
+
+    // the ghost energy is the change in energy upon insertion, including lrc
+    for (int trial = 0; trial < 5; ++trial) {
+      const double peOld = p.peTot();
+      const int natom = s.natom();
+      s.initGhostMol(molType.c_str(), s.randPosition());
+      const double deGhost = p.ghostEner();
+      EXPECT_EQ(natom, s.natom());
+      s.addGhostMol();
+      p.addPart();
+      for (int site = 0; site < s.natom() - natom; ++site) {
+        for (int dim = 0; dim < s.dimen(); ++dim) {
+          EXPECT_NEAR(s.ghostX()[3*site + dim], s.x(natom + site, dim),
+                      10*DTOL);
+        }
+      }
+      p.initEnergy();
+      EXPECT_NEAR(peOld + deGhost, p.peTot(), 1e-10*fabs(p.peTot()) + 1e-10);
+    }
+
+    // replace a molecule with a ghost at the same position
+    const double peOld = p.peTot();
+    const int iMol = 3;
+    vector<int> mpart = s.imol2mpart(iMol);
+    vector<double> xFirst(3);
+    for (int dim = 0; dim < 3; ++dim) xFirst[dim] = s.x(mpart[0], dim);
+    const double deDel = -p.multiPartEner(mpart, 0);
+    s.initGhostMol(molType.c_str(), xFirst);
+    const double deGhost = p.ghostEner(iMol);
+    p.delPart(mpart);
+    s.delPart(mpart);
+    s.addGhostMol();
+    p.addPart();
+    p.initEnergy();
+    EXPECT_NEAR(peOld + deDel + deGhost, p.peTot(),
+                1e-10*fabs(p.peTot()) + 1e-10);
+  }
+}
@@ -92,6 +92,7 @@ double PairPatchKF::multiPartEnerNeigh(
 
       // no interaction beyond cut-off distance
       if (r2 < rCutSq_) {
+        FEASST_PROFILE_INTERACTION();
         // store new neighbor list
         if (neighOn_) {
           if ( (r2 < neighAboveSq_) && (r2 > neighBelowSq_) ) {
@@ -153,23 +154,21 @@ double PairPatchKF::multiPartEnerNeigh(
 }
 
 void PairPatchKF::update(
-  const vector<int> mpart,
+  const vector<int> &mpart,
   const int flag,
-  const char* uptype
-  ) {
+  const UpdatePhase phase) {
   if (neighOn_) {
-    updateBase(mpart, flag, uptype, neigh_, neighOne_, neighOneOld_);
-//  updateBase(mpart, flag, uptype, neighCut_, neighCutOne_, neighCutOneOld_);
+    updateBase(mpart, flag, phase, neigh_, neighOne_, neighOneOld_);
+//  updateBase(mpart, flag, phase, neighCut_, neighCutOne_, neighCutOneOld_);
   }
-  std::string uptypestr(uptype);
 
-  if (uptypestr.compare("store") == 0) {
+  if (phase == STORE_PHASE) {
     if (flag == 0 || flag == 2 || flag == 3) {
       deSR_ = peSRone_;
     }
   }
 
-  if (uptypestr.compare("update") == 0) {
+  if (phase == UPDATE_PHASE) {
     if (flag == 0) {
       peTot_ += peSRone_ - deSR_;
     }
@@ -381,6 +380,7 @@ double PairPatchKF::allPartEnerForce(const int flag) {
 
       // no interaction beyond cut-off distance
       if (r2 < rCutSq_) {
+        FEASST_PROFILE_INTERACTION();
         // hard sphere
         if (r2 < sigSq) {
           peSRone_ += NUM_INF;
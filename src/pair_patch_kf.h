@@ -49,12 +49,20 @@ class PairPatchKF : public Pair {
   /// potential energy of multiple particles
   double multiPartEner(const vector<int> multiPart, const int flag);
 
+  /// ghostEner is not implemented for patches.
+  bool ghostEnerImplemented() const { return false; }
+
+  /// affineEner is not implemented for patches.
+  bool affineEnerImplemented() const { return false; }
+
   /// potential energy of multiple particles optimized for neighbor list updates
   virtual double multiPartEnerNeigh(const vector<int> multiPart);
 
   /// stores, restores or updates variables to avoid order recompute of entire
   // configuration after every change
-  void update(const vector<int> mpart, const int flag, const char* uptype);
+  void update(const vector<int> &mpart, const int flag,
+    const UpdatePhase phase);
+  using Pair::update;
 
   /// Write xyz for visualization.
   /// @param initFlag open if flag is 1, append if flag is 0.
@@ -0,0 +1,102 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <iomanip>
+#include <sstream>
+#include "./profile.h"
+
+namespace feasst {
+
+thread_local Profile* Profile::current_ = NULL;
+
+namespace {
+const char* sectionName[Profile::NSECTION] = {"energy", "update", "accept",
+  "cell", "neigh", "restart", "analyze"};
+}
+
+void Profile::addTrial(const int iTrial, const double seconds,
+  const long long nInteractions) {
+  if (static_cast<int>(trialTime_.size()) <= iTrial) {
+    trialTime_.resize(iTrial + 1, 0.);
+    trialCount_.resize(iTrial + 1, 0);
+    trialInteractions_.resize(iTrial + 1, 0);
+  }
+  trialTime_[iTrial] += seconds;
+  ++trialCount_[iTrial];
+  trialInteractions_[iTrial] += nInteractions;
+}
+
+void Profile::zeroStat() {
+  for (int section = 0; section < NSECTION; ++section) {
+    time_[section] = 0.;
+    count_[section] = 0;
+  }
+  nInteractions_ = 0;
+  trialTime_.clear();
+  trialCount_.clear();
+  trialInteractions_.clear();
+}
+
+std::string Profile::printStat(const std::vector<std::string> &trialNames,
+  const bool header) const {
+  std::stringstream stat;
+  for (unsigned int t = 0; t < trialNames.size(); ++t) {
+    if (header) {
+      stat << trialNames[t] << t << "Time ";
+    } else {
+      stat << ((t < trialTime_.size()) ? trialTime_[t] : 0.) << " ";
+    }
+  }
+  for (int section = 0; section < NSECTION; ++section) {
+    if (header) {
+      stat << sectionName[section] << "Time ";
+    } else {
+      stat << time_[section] << " ";
+    }
+  }
+  long long nTrials = 0;
+  for (unsigned int t = 0; t < trialCount_.size(); ++t) {
+    nTrials += trialCount_[t];
+  }
+  if (header) {
+    stat << "interactionsPerTrial ";
+  } else {
+    stat << ((nTrials > 0) ? static_cast<double>(nInteractions_)/nTrials : 0.)
+         << " ";
+  }
+  return stat.str();
+}
+
+std::string Profile::summary(const std::vector<std::string> &trialNames) const {
+  double trialTot = 0.;
+  for (unsigned int t = 0; t < trialTime_.size(); ++t) trialTot += trialTime_[t];
+  std::stringstream ss;
+  ss << "# profile name count seconds microsecondsPerCall fractionOfTrialTime "
+     << "interactionsPerCall" << std::endl;
+  for (unsigned int t = 0; t < trialTime_.size(); ++t) {
+    const std::string name = (t < trialNames.size()) ? trialNames[t] : "Trial";
+    const double count = static_cast<double>(trialCount_[t]);
+    ss << "# profile " << name << t << " " << trialCount_[t] << " "
+       << trialTime_[t] << " "
+       << ((count > 0) ? 1e6*trialTime_[t]/count : 0.) << " "
+       << ((trialTot > 0) ? trialTime_[t]/trialTot : 0.) << " "
+       << ((count > 0) ? trialInteractions_[t]/count : 0.) << std::endl;
+  }
+  for (int section = 0; section < NSECTION; ++section) {
+    const double count = static_cast<double>(count_[section]);
+    ss << "# profile " << sectionName[section] << " " << count_[section] << " "
+       << time_[section] << " "
+       << ((count > 0) ? 1e6*time_[section]/count : 0.) << " "
+       << ((trialTot > 0) ? time_[section]/trialTot : 0.) << " -" << std::endl;
+  }
+  return ss.str();
+}
+
+}  // namespace feasst
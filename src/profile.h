@@ -0,0 +1,136 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace feasst {
+
+/**
+ * Wall time and counts of the hot paths of a Monte Carlo simulation.
+ *
+ * MC owns a Profile, which is current for the calling thread during each
+ * trial attempt. Instrumented sections (e.g., energy calculations in trials)
+ * add to the current Profile, if any. The instrumentation is only compiled
+ * with the FEASST_PROFILE_ flag (e.g., cmake -DUSE_PROFILE=ON), such that the
+ * hot paths are unchanged by default.
+ */
+class Profile {
+ public:
+  /// Instrumented sections.
+  enum Section {
+    ENERGY,     //!< Pair::multiPartEner and Pair::ghostEner in trials
+    UPDATE,     //!< Pair::update, beginTrial and commitTrial
+    ACCEPT,     //!< Criteria::accept
+    CELL,       //!< Space::buildCellList
+    NEIGH,      //!< Pair::buildNeighList
+    RESTART,    //!< MC::writeRestart
+    ANALYZE,    //!< MC analyzers, inline or queued to the pipeline
+    NSECTION
+  };
+
+  typedef std::chrono::steady_clock clock;
+
+  /// Return the seconds since start.
+  static double seconds(const clock::time_point start) {
+    return std::chrono::duration<double>(clock::now() - start).count(); }
+
+  /// Constructor
+  Profile() { zeroStat(); }
+
+  /// Add the wall time of one call of a section.
+  void add(const int section, const double seconds) {
+    time_[section] += seconds;
+    ++count_[section];
+  }
+
+  /// Add the wall time and number of site-site interactions of one attempt
+  /// of trial iTrial.
+  void addTrial(const int iTrial, const double seconds,
+                const long long nInteractions);
+
+  /// Count site-site interactions.
+  void addInteractions(const long long n = 1) { nInteractions_ += n; }
+
+  /// Reset all times and counts.
+  void zeroStat();
+
+  /// Return the columns of the log file, given the name of each trial.
+  std::string printStat(const std::vector<std::string> &trialNames,
+                        const bool header = false) const;
+
+  /// Return a summary table, given the name of each trial.
+  std::string summary(const std::vector<std::string> &trialNames) const;
+
+  /// Return the Profile current to the calling thread, or NULL.
+  static Profile* current() { return current_; }
+
+  /// Make a Profile current to the calling thread within a scope.
+  class Scope {
+   public:
+    explicit Scope(Profile *profile) : previous_(current_) {
+      current_ = profile; }
+    ~Scope() { current_ = previous_; }
+   private:
+    Profile *previous_;
+  };
+
+  /// Add the wall time of a scope to a section of the current Profile.
+  class Timer {
+   public:
+    explicit Timer(const int section) : section_(section),
+      profile_(current_) { if (profile_) start_ = clock::now(); }
+    ~Timer() { if (profile_) profile_->add(section_, seconds(start_)); }
+   private:
+    int section_;
+    Profile *profile_;
+    clock::time_point start_;
+  };
+
+  /// read-only access of private data-members
+  double time(const int section) const { return time_[section]; }
+  long long count(const int section) const { return count_[section]; }
+  long long nInteractions() const { return nInteractions_; }
+  std::vector<double> trialTime() const { return trialTime_; }
+  std::vector<long long> trialCount() const { return trialCount_; }
+  std::vector<long long> trialInteractions() const {
+    return trialInteractions_; }
+
+ private:
+  double time_[NSECTION];
+  long long count_[NSECTION];
+  long long nInteractions_;
+  std::vector<double> trialTime_;
+  std::vector<long long> trialCount_;
+  std::vector<long long> trialInteractions_;
+  static thread_local Profile* current_;
+};
+
+#ifdef FEASST_PROFILE_
+  #define FEASST_PROFILE_NAME_(line) feasstProfileTimer##line
+  #define FEASST_PROFILE_TIMER_(section, line) \
+    feasst::Profile::Timer FEASST_PROFILE_NAME_(line)(feasst::Profile::section)
+  /// Add the wall time of the enclosing scope to a section of Profile.
+  #define FEASST_PROFILE(section) FEASST_PROFILE_TIMER_(section, __LINE__)
+  /// Count a site-site interaction in Profile.
+  #define FEASST_PROFILE_INTERACTION() \
+    if (feasst::Profile::current()) feasst::Profile::current()->addInteractions()
+#else
+  #define FEASST_PROFILE(section)
+  #define FEASST_PROFILE_INTERACTION()
+#endif  // FEASST_PROFILE_
+
+}  // namespace feasst
+
+#endif  // PROFILE_H_
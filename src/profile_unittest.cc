@@ -0,0 +1,88 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include "pair_lj.h"
+#include "mc.h"
+#include "trial_add.h"
+#include "trial_delete.h"
+#include "trial_transform.h"
+#include "profile.h"
+
+using namespace feasst;
+
+TEST(Profile, scopeANDtimer) {
+  Profile profile;
+  EXPECT_TRUE(Profile::current() == NULL);
+  { Profile::Timer timer(Profile::ENERGY); }
+  EXPECT_EQ(0, profile.count(Profile::ENERGY));
+  {
+    Profile::Scope scope(&profile);
+    EXPECT_EQ(&profile, Profile::current());
+    for (int i = 0; i < 3; ++i) {
+      Profile::Timer timer(Profile::ENERGY);
+      profile.addInteractions(2);
+    }
+    profile.addTrial(1, 0.5, 6);
+  }
+  EXPECT_TRUE(Profile::current() == NULL);
+  EXPECT_EQ(3, profile.count(Profile::ENERGY));
+  EXPECT_LE(0., profile.time(Profile::ENERGY));
+  EXPECT_EQ(6, profile.nInteractions());
+  EXPECT_EQ(2, static_cast<int>(profile.trialTime().size()));
+  EXPECT_EQ(0, profile.trialCount()[0]);
+  EXPECT_EQ(1, profile.trialCount()[1]);
+  EXPECT_EQ(6, profile.trialInteractions()[1]);
+
+  // the header and values have the same number of columns, and trials of
+  // the same class are distinguished by their index
+  const vector<string> names = {"TrialA", "TrialA"};
+  std::stringstream header(profile.printStat(names, true)),
+                    values(profile.printStat(names));
+  string str;
+  int nHeader = 0, nValues = 0;
+  while (header >> str) ++nHeader;
+  while (values >> str) ++nValues;
+  EXPECT_EQ(2 + Profile::NSECTION + 1, nHeader);
+  EXPECT_EQ(nHeader, nValues);
+  EXPECT_EQ(0u,
+    profile.printStat(names, true).find("TrialA0Time TrialA1Time "));
+  EXPECT_NE(string::npos, profile.summary(names).find("TrialA1 1 0.5"));
+
+  profile.zeroStat();
+  EXPECT_EQ(0, profile.count(Profile::ENERGY));
+  EXPECT_EQ(0, static_cast<int>(profile.trialTime().size()));
+}
+
+TEST(Profile, mc) {
+  Space s(3, {{"boxLength", "8"}});
+  PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"}});
+  CriteriaMetropolis c(1., exp(-2.));
+  MC mc(&s, &p, &c);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc);
+  addTrial(&mc, s.addMolListType(0).c_str());
+  mc.runNumTrials(500);
+  #ifdef FEASST_PROFILE_
+    long long nTrials = 0;
+    for (int t = 0; t < mc.nTrials(); ++t) {
+      nTrials += mc.profile().trialCount()[t];
+    }
+    EXPECT_EQ(500, nTrials);
+    EXPECT_EQ(500, mc.profile().count(Profile::ACCEPT));
+    EXPECT_LT(0, mc.profile().count(Profile::ENERGY));
+    EXPECT_LT(0, mc.profile().nInteractions());
+  #else
+    // without the flag, the hot paths are not instrumented
+    EXPECT_EQ(0, mc.profile().count(Profile::ACCEPT));
+    EXPECT_EQ(0, static_cast<int>(mc.profile().trialTime().size()));
+  #endif  // FEASST_PROFILE_
+  EXPECT_TRUE(Profile::current() == NULL);
+}
@@ -41,6 +41,11 @@ class Random : public Base {
   /// Return uniform random number between 0 and 1.
   virtual double uniform() = 0;
 
+  /// Fill ran with n uniform random numbers between 0 and 1.
+  virtual void uniform(const int n, double *ran) {
+    for (int i = 0; i < n; ++i) ran[i] = uniform();
+  }
+
   /// Return uniform random integer between range min and max, inclusive.
   int uniform(const int min, const int max) {
     return int64() % (max - min + 1) + min;
@@ -0,0 +1,155 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include "random_philox.h"
+
+namespace feasst {
+
+RandomPhilox::RandomPhilox(const unsigned long long iseed,
+  const unsigned long long stream) : Random(iseed) {
+  defaultConstruction_();
+  stream_ = stream;
+  seed(iseed);
+}
+
+RandomPhilox::RandomPhilox(const char* fileName) : Random(fileName) {
+  defaultConstruction_();
+  seed_ = fstoull("seed", fileName);
+  stream_ = fstoull("stream", fileName);
+  counter_ = fstoull("counter", fileName);
+  bufferIndex_ = fstoi("bufferIndex", fileName);
+  if (bufferIndex_ < 4) fillBuffer_(counter_ - 1);
+}
+
+void RandomPhilox::defaultConstruction_() {
+  verbose_ = 0;
+  className_.assign("RandomPhilox");
+  stream_ = 0;
+  counter_ = 0;
+  bufferIndex_ = 4;
+}
+
+void RandomPhilox::seed(const unsigned long long iseed) {
+  Random::seed(iseed);
+  counter_ = 0;
+  bufferIndex_ = 4;
+}
+
+unsigned long long RandomPhilox::streamID(const int window, const int walker,
+  const int trialType) {
+  ASSERT( (window >= 0) && (window < (1 << 24)),
+    "window(" << window << ") is out of range");
+  ASSERT( (walker >= 0) && (walker < (1 << 20)),
+    "walker(" << walker << ") is out of range");
+  ASSERT( (trialType >= 0) && (trialType < (1 << 20)),
+    "trialType(" << trialType << ") is out of range");
+  return (static_cast<unsigned long long>(window) << 40)
+       + (static_cast<unsigned long long>(walker) << 20)
+       + static_cast<unsigned long long>(trialType);
+}
+
+shared_ptr<RandomPhilox> RandomPhilox::substream(const int window,
+  const int walker, const int trialType) const {
+  return make_shared<RandomPhilox>(seed_,
+    streamID(window, walker, trialType));
+}
+
+void RandomPhilox::block(const uint32_t *ctr, const uint32_t *key,
+  uint32_t *out) {
+  const uint32_t m0 = 0xD2511F53, m1 = 0xCD9E8D57,
+                 w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+  uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3],
+           k0 = key[0], k1 = key[1];
+  for (int round = 0; round < 10; ++round) {
+    if (round > 0) {
+      k0 += w0;
+      k1 += w1;
+    }
+    const uint64_t p0 = static_cast<uint64_t>(m0)*c0,
+                   p1 = static_cast<uint64_t>(m1)*c2;
+    c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+    c1 = static_cast<uint32_t>(p1);
+    c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+    c3 = static_cast<uint32_t>(p0);
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+void RandomPhilox::fillBuffer_(const unsigned long long counter) {
+  const uint32_t ctr[4] = {static_cast<uint32_t>(counter),
+                           static_cast<uint32_t>(counter >> 32),
+                           static_cast<uint32_t>(stream_),
+                           static_cast<uint32_t>(stream_ >> 32)};
+  const uint32_t key[2] = {static_cast<uint32_t>(seed_),
+                           static_cast<uint32_t>(seed_ >> 32)};
+  block(ctr, key, buffer_);
+}
+
+uint32_t RandomPhilox::word_() {
+  if (bufferIndex_ == 4) {
+    fillBuffer_(counter_);
+    ++counter_;
+    bufferIndex_ = 0;
+  }
+  return buffer_[bufferIndex_++];
+}
+
+unsigned long long RandomPhilox::int64() {
+  const unsigned long long lo = word_();
+  return (static_cast<unsigned long long>(word_()) << 32) | lo;
+}
+
+double RandomPhilox::uniform() {
+  return toDouble_(int64());
+}
+
+void RandomPhilox::uniform(const int n, double *ran) {
+  // use the remainder of the buffer, then generate whole blocks directly
+  int i = 0;
+  while ( (i < n) && (bufferIndex_ != 4) && (bufferIndex_ != 0) ) {
+    ran[i++] = uniform();
+  }
+  const uint32_t key[2] = {static_cast<uint32_t>(seed_),
+                           static_cast<uint32_t>(seed_ >> 32)};
+  uint32_t ctr[4] = {0, 0, static_cast<uint32_t>(stream_),
+                     static_cast<uint32_t>(stream_ >> 32)};
+  uint32_t out[4];
+  for (; i + 1 < n; i += 2) {
+    ctr[0] = static_cast<uint32_t>(counter_);
+    ctr[1] = static_cast<uint32_t>(counter_ >> 32);
+    block(ctr, key, out);
+    ++counter_;
+    ran[i] = toDouble_((static_cast<unsigned long long>(out[1]) << 32)
+                       | out[0]);
+    ran[i + 1] = toDouble_((static_cast<unsigned long long>(out[3]) << 32)
+                           | out[2]);
+  }
+  if (i < n) ran[i] = uniform();
+}
+
+void RandomPhilox::writeRestart(const char* fileName) {
+  fileBackUp(fileName);
+  std::ofstream file(fileName);
+  file << "# className " << className_ << endl;
+  file << "# seed " << seed_ << endl;
+  file << "# stream " << stream_ << endl;
+  file << "# counter " << counter_ << endl;
+  file << "# bufferIndex " << bufferIndex_ << endl;
+}
+
+shared_ptr<RandomPhilox> makeRandomPhilox(const unsigned long long seed,
+  const unsigned long long stream) {
+  return make_shared<RandomPhilox>(seed, stream);
+}
+
+}  // namespace feasst
@@ -0,0 +1,93 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef RANDOM_PHILOX_H_
+#define RANDOM_PHILOX_H_
+
+#include <stdint.h>
+#include "random.h"
+
+namespace feasst {
+
+/**
+ * Counter-based Philox4x32-10 random number generator of
+ * J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw, SC11 (2011).
+ *
+ * Each block of four 32 bit random numbers is a bijection of a 128 bit
+ * counter, keyed by the seed. The first half of the counter is incremented
+ * for each block, while the second half is the stream, such that streams
+ * with the same seed are independent. The state is only the seed, stream
+ * and counter, so the checkpoint restarts the sequence exactly.
+ */
+class RandomPhilox : public Random {
+ public:
+  /// Construct from seed and stream.
+  RandomPhilox(const unsigned long long seed,
+               const unsigned long long stream = 0);
+
+  /// Construct from checkpoint file.
+  RandomPhilox(const char* fileName);
+
+  /**
+   * Return a unique stream for a window (< 2^24), walker (< 2^20) and
+   * trial type (< 2^20).
+   */
+  static unsigned long long streamID(const int window, const int walker,
+                                     const int trialType);
+
+  /// Return a generator with the same seed and the given substream.
+  shared_ptr<RandomPhilox> substream(const int window, const int walker,
+                                     const int trialType) const;
+
+  /// Return the stream.
+  unsigned long long stream() const { return stream_; }
+
+  /// Return the number of blocks generated.
+  unsigned long long counter() const { return counter_; }
+
+  /// Return the four 32 bit random numbers of a block.
+  static void block(const uint32_t *ctr, const uint32_t *key, uint32_t *out);
+
+  // Overloaders for virtual functions. See base class for comments.
+  using Random::uniform;
+  ~RandomPhilox() {}
+  void writeRestart(const char* fileName);
+  void seed(const unsigned long long seed);
+  double uniform();
+  void uniform(const int n, double *ran);
+  unsigned long long int64();
+
+ protected:
+  unsigned long long stream_;   //!< second half of the counter
+  unsigned long long counter_;  //!< first half of the counter
+  uint32_t buffer_[4];          //!< last block
+  int bufferIndex_;             //!< next unused element of the buffer
+
+  /// Return the next 32 bit random number.
+  uint32_t word_();
+
+  /// Generate the block of the given counter into the buffer.
+  void fillBuffer_(const unsigned long long counter);
+
+  /// Return a double in (0, 1) from 64 random bits.
+  static double toDouble_(const unsigned long long bits) {
+    return (static_cast<double>(bits >> 11) + 0.5)/9007199254740992.;
+  }
+
+  void defaultConstruction_();
+};
+
+/// Factory method
+shared_ptr<RandomPhilox> makeRandomPhilox(const unsigned long long seed,
+  const unsigned long long stream = 0);
+
+}  // namespace feasst
+
+#endif  // RANDOM_PHILOX_H_
@@ -11,6 +11,7 @@
 #include <gtest/gtest.h>
 #include <limits.h>
 #include "random_mersenne_twister.h"
+#include "random_philox.h"
 
 using namespace feasst;
 
@@ -38,3 +39,42 @@ TEST(Random, MersenneTwisterran) {
 //    EXPECT_EQ(ran.int64(), ran2.int64());
 //  }
 }
+
+TEST(Random, Philox) {
+  // known answer of Philox4x32-10
+  const uint32_t ctr[4] = {0, 0, 0, 0}, key[2] = {0, 0};
+  uint32_t out[4];
+  RandomPhilox::block(ctr, key, out);
+  EXPECT_EQ(0x6627e8d5u, out[0]);
+  EXPECT_EQ(0xe169c58du, out[1]);
+  EXPECT_EQ(0xbc57ac4cu, out[2]);
+  EXPECT_EQ(0x9b00dbd8u, out[3]);
+
+  // restart continues the sequence exactly
+  RandomPhilox ran(17, RandomPhilox::streamID(2, 1, 3));
+  ran.int64();
+  ran.uniform();
+  ran.uniform();
+  ran.writeRestart("tmp/rstphilox");
+  RandomPhilox ran2("tmp/rstphilox");
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(ran.int64(), ran2.int64());
+  }
+
+  // bulk generation matches the sequence of single draws
+  ran.uniform();
+  RandomPhilox ran3(ran);
+  double bulk[7];
+  ran.uniform(7, bulk);
+  for (int i = 0; i < 7; ++i) {
+    EXPECT_EQ(ran3.uniform(), bulk[i]);
+  }
+
+  // substreams are reproducible and differ from each other
+  shared_ptr<RandomPhilox> sub = ran.substream(2, 1, 4),
+                           sub2 = ran2.substream(2, 1, 4);
+  RandomPhilox ran4(17, RandomPhilox::streamID(2, 1, 3));
+  const unsigned long long first = sub->int64();
+  EXPECT_EQ(first, sub2->int64());
+  EXPECT_NE(first, ran4.int64());
+}
@@ -10,6 +10,9 @@
 
 #include <limits>
 #include <algorithm>
+#ifdef _OPENMP
+  #include <omp.h>
+#endif  // _OPENMP
 #include "./space.h"
 #include "./group.h"
 
@@ -130,7 +133,7 @@ Space::Space(const char* fileName) {
     // cout << " read particle positions" << endl;
     for (int i = 0; i < natom(); ++i) {
       for (int dim = 0; dim < dimen_; ++dim) {
-        fs >> x_[dimen_*i+dim];
+        fs >> xW_(i)[dim];
       }
       getline(fs, line);
     }
@@ -139,20 +142,30 @@ Space::Space(const char* fileName) {
     for (int iMol = 0; iMol < nMol(); ++iMol) {
       const int iAtom = mol2part_[iMol];
       for (int dim = 0; dim < dimen_; ++dim) {
-        fs >> x_[dimen_*iAtom + dim];
+        fs >> xW_(iAtom)[dim];
       }
       getline(fs, line);
-      for (int dim = 0; dim < dimen_; ++dim) {
-        xMolRef_[iMol][0][dim] = 0.;
-      }
-      for (unsigned int ipart = 1; ipart < xMolRef_[iMol].size(); ++ipart) {
+
+      // share the reference of the molecule type, unless it differs
+      const int nAtomMol = mol2part_[iMol+1] - mol2part_[iMol];
+      vector<double> xref(dimen_*nAtomMol, 0.);
+      for (int ipart = 1; ipart < nAtomMol; ++ipart) {
         for (int dim = 0; dim < dimen_; ++dim) {
-          fs >> xMolRef_[iMol][ipart][dim];
+          fs >> xref[dimen_*ipart + dim];
         }
         getline(fs, line);
       }
+      const int id = xMolRefPool_.id[iMol];
+      bool same = ( (id >= 0) && (xMolRefPool_.nAtom[id] == nAtomMol) );
+      for (int i = 0; same && (i < dimen_*nAtomMol); ++i) {
+        if (xref[i] != xMolRef(iMol, i/dimen_, i % dimen_)) same = false;
+      }
+      if (!same) {
+        double* xown = xMolRefOwn_(iMol);
+        for (int i = 0; i < dimen_*nAtomMol; ++i) xown[i] = xref[i];
+      }
       for (int qdim = 0; qdim < qdim_; ++qdim) {
-        fs >> qMol_[qdim_*iMol + qdim];
+        fs >> qMolW_(iMol)[qdim];
       }
       getline(fs, line);
       quat2pos(iMol);
@@ -173,6 +186,10 @@ Space::Space(const char* fileName) {
   } else {
     cellType_ = 0;
   }
+  strtmp = fstos("cavityRCut", fileName);
+  if (!strtmp.empty()) {
+    initCavity(stod(strtmp), fstoi("cavityNStencil", fileName));
+  }
 
   // initialize groups
   strtmp = fstos("num_groups", fileName);
@@ -204,6 +221,14 @@ Space::Space(const char* fileName) {
 
 void Space::defaultConstruction_() {
   verbose_ = 0;
+  bondOrderQ6Global_ = 0.;
+  nOld_ = 0;
+  nOldMulti_ = 0;
+  nOldMultiPart_ = 0;
+  journalOpen_ = false;
+  journalQMol_ = false;
+  natomJournal_ = 0;
+  revision_ = 0;
   storeUniqueConfigID();
   fastDel_ = false;
   fastDelMol_ = -1;
@@ -230,6 +255,8 @@ void Space::defaultConstruction_() {
   eulerFlag_ = 0;
   equiMolar_ = 0;
   percolation_ = 0;
+  cavityRCut_ = 0.;
+  cavityNStencil_ = 0;
 }
 
 Space::~Space() {
@@ -250,9 +277,7 @@ shared_ptr<Space> Space::cloneShrPtr() const {
 }
 
 void Space::reconstruct_() {
-  for (int i = static_cast<int>(addMolList_.size()) - 1; i >= 0; --i) {
-    addMolList_[i] = make_shared<Space>(*addMolList_[i]);
-  }
+  // addMolList_ is shared until modified (see addMolListOwned_)
   for (int i = static_cast<int>(atoms_.size()) - 1; i >= 0; --i) {
     atoms_[i] = make_shared<Atom>(*atoms_[i]);
   }
@@ -341,7 +366,7 @@ void Space::readXYZ(const char* fileName) {
   if (!xyzFileEOF()) {
     {
       std::istringstream iss(line); iss >> iAtom;
-      x_.resize(iAtom*dimen_);
+      xW_().resize(iAtom*dimen_);
       type_.resize(iAtom);
       nType_.resize(1, iAtom);
       mol_.resize(iAtom);
@@ -360,7 +385,7 @@ void Space::readXYZ(const char* fileName) {
       std::istringstream iss(line);
       string tmp;
       iss >> tmp >> coord[0] >> coord[1] >> coord[2];
-      for (int dim = 0; dim < dimen_; ++dim) x_[dimen_*i+dim] = coord[dim];
+      for (int dim = 0; dim < dimen_; ++dim) xW_(i)[dim] = coord[dim];
       listAtoms_.push_back(i);
       if (nTypes == 0) {
         type_[i] = nTypes;
@@ -431,13 +456,13 @@ void Space::readXYZ(std::ifstream& file) {
       for (int dim = 0; dim < dimen_; ++dim) {
         double coord;
         iss >> coord;
-        x_[dimen_*i+dim] = coord;
+        xW_(i)[dim] = coord;
       }
     }
   }
 }
 
-vector<double> Space::pbc(const vector<double> x) {
+vector<double> Space::pbc(const vector<double> x) const {
   vector<double> dx(dimen_, 0.);
   double dx1 = x[0], dxOld = dx1;
   double dy = x[1], dyOld = dy;
@@ -459,13 +484,16 @@ void Space::randDisp(const vector<int> &mpart, const double maxDisp) {
 
 void Space::randDispNoWrap(const vector<int> &mpart, const double maxDisp) {
   double maxDispTmp = maxDisp;
+  double ran[3];
+  ASSERT(dimen_ <= 3, "randDispNoWrap assumes dimen(" << dimen_ << ") <= 3");
+  uniformRanNum(dimen_, ran);
   for (int dim = 0; dim < dimen_; ++dim) {
     if (maxDisp == -1) maxDispTmp = boxLength_[dim]/2.;
-    const double disp = maxDispTmp*(2*uniformRanNum() - 1);
+    const double disp = maxDispTmp*(2*ran[dim] - 1);
     for (vector<int>::const_iterator it = mpart.begin();
          it != mpart.end();
          ++it) {
-      x_[dimen_*(*it)+dim] += disp;
+      xW_(*it)[dim] += disp;
 //    for (unsigned int i = 0; i < mpart.size(); ++i) {
 //      x_[dimen_*mpart[i]+dim] += disp;
     }
@@ -481,21 +509,22 @@ void Space::randRotate(const vector<int> mpart, const double maxDisp) {
       if (eulerFlag_ == 0) {
         // perturb quaternions by factor maxDisp, or,
         // completely randomly, if maxDisp <= 0
-        vector<double> q;
-        vector<double> qran = quatRandom();
+        double q[4], qran[4];
+        quatRandomInPlace(qran);
         if (maxDisp > 0) {
+          double qsize = 0.;
           for (int i = 0; i < qdim_; ++i) {
-            q.push_back(qMol_[iMol*qdim_+i] + maxDisp*qran[i]);
+            q[i] = qMol_[iMol*qdim_+i] + maxDisp*qran[i];
+            qsize += q[i]*q[i];
           }
-          const double qsize = sqrt(vecDotProd(q, q));
+          qsize = sqrt(qsize);
           for (int i = 0; i < qdim_; ++i) {
-            q[i] /= qsize;
+            qMolW_(iMol)[i] = q[i]/qsize;
           }
         } else {
-          q = qran;
-        }
-        for (int i = 0; i < qdim_; ++i) {
-          qMol_[iMol*qdim_+i] = q[i];
+          for (int i = 0; i < qdim_; ++i) {
+            qMolW_(iMol)[i] = qran[i];
+          }
         }
       } else {
         // perturb euler angles by a factor maxDisp, or completely randomly
@@ -503,13 +532,13 @@ void Space::randRotate(const vector<int> mpart, const double maxDisp) {
         ASSERT(maxDisp <= 0, "euler angle perturbation not implemented. "
           << "Use quaternions instead");
         for (int i = 0; i < qdim_-1; ++i) {
-          qMol_[iMol*qdim_+i] = e[i];
+          qMolW_(iMol)[i] = e[i];
         }
       }
     } else if (dimen_ == 2) {
       double theta = qMol_[iMol] + maxDisp*(uniformRanNum() - 0.5);
       theta += pbc2d(theta);
-      qMol_[iMol] = theta;
+      qMolW_(iMol)[0] = theta;
     }
 
     // update positions with new quaternions
@@ -544,7 +573,7 @@ void Space::randRotateAboutAxis(const vector<int> &mpart,
     const vector<vector<double> > rnew = matMul(r, rot);
     for (int i = 0; i < nSite; ++i) {
       for (int dim = 0; dim < dimen_; ++dim) {
-        x_[dimen_*mpart[i]+dim] += rnew[i][dim] - r[i][dim];
+        xW_(mpart[i])[dim] += rnew[i][dim] - r[i][dim];
       }
     }
 
@@ -611,7 +640,7 @@ void Space::randRotateMulti(const vector<int> mpart, const double maxDisp,
   vector<vector<double> > rnew = matMul(r, rot);
   for (int i = 0; i < natom; ++i) {
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*mpart[i]+dim] = rcm[dim] + rnew[i][dim];
+      xW_(mpart[i])[dim] = rcm[dim] + rnew[i][dim];
     }
   }
 
@@ -652,7 +681,7 @@ void Space::randRotateMulti(const vector<int> mpart, const double maxDisp,
         vector<vector<double> > RiNew = matMul(rotT, Ri);
         vector<vector<double> > euler = RotMat2Euler(RiNew);
         for (int dim = 0; dim < dimen_; ++dim) {
-          qMol_[qdim_*iMol+dim] = euler[0][dim];
+          qMolW_(iMol)[dim] = euler[0][dim];
         }
       }
       quat2pos(iMol);
@@ -687,10 +716,10 @@ void Space::delPart(const int ipart) {
     nMolType_[molid_[iMol]]--;
     molid_.erase(molid_.begin() + iMol);
     if (sphereSymMol_ == false) {
-      xMolRef_.erase(xMolRef_.begin() + iMol);
-      for (int qd = 0; qd < qdim_; ++qd) {
-        qMol_.erase(qMol_.begin() + qdim_*iMol);
-      }
+      xMolRefRelease_(xMolRefPool_.id[iMol]);
+      xMolRefPoolW_().id.erase(xMolRefPool_.id.begin() + iMol);
+      qMolW_().erase(qMol_.begin() + qdim_*iMol,
+                     qMol_.begin() + qdim_*(iMol+1));
     }
     listMols_.erase(listMols_.end() - 1);
     if ( (cellType_ > 0) && (atomCut_ == false) ) {
@@ -733,7 +762,11 @@ void Space::delPart(const int ipart) {
     }
   }
 
-  for (int dim = 0; dim < dimen_; ++dim) x_.erase(x_.begin() + dimen_*ipart);
+  if (cavityOn()) {
+    cavityCountSite_(cavityCellOfAtom_[ipart], -1);
+    cavityCellOfAtom_.erase(cavityCellOfAtom_.begin() + ipart);
+  }
+  xW_().erase(x_.begin() + dimen_*ipart, x_.begin() + dimen_*(ipart+1));
   --nType_[type_[ipart]];
   type_.erase(type_.begin() + ipart);
   mol_.erase(mol_.begin() + ipart);
@@ -802,7 +835,12 @@ void Space::delPart(const vector<int> mpart) {
       const int ipart = mpart[i];
       const int jpart = natom() - static_cast<int>(mpart.size()) + i;
       for (int dim = 0; dim < dimen_; ++dim) {
-        x_[dimen_*ipart+dim] = x_[dimen_*jpart+dim];
+        xW_(ipart)[dim] = x_[dimen_*jpart+dim];
+      }
+      if (cavityOn()) {
+        cavityCountSite_(cavityCellOfAtom_[ipart], -1);
+        cavityCellOfAtom_[ipart] = cavityCellOfAtom_[jpart];
+        cavityCountSite_(cavityCellOfAtom_[ipart], 1);
       }
       const int t = type_[ipart];
       type_[ipart] = type_[jpart];
@@ -850,13 +888,14 @@ void Space::delPart(const vector<int> mpart) {
       // << iMol << " jMol " << jMol << endl;
       // cout << "qMol beginning size " << qMol_.size() << endl;
       for (int qd = 0; qd < qdim_; ++qd) {
-        qMol_[qdim_*iMol+qd] = qMol_[qdim_*jMol+qd];
+        qMolW_(iMol)[qd] = qMol_[qdim_*jMol+qd];
       }
       for (int qd = 0; qd < qdim_; ++qd) {
-        qMol_.pop_back();
+        qMolW_().pop_back();
       }
-      xMolRef_[iMol] = xMolRef_[jMol];
-      xMolRef_.pop_back();
+      xMolRefRelease_(xMolRefPool_.id[iMol]);
+      xMolRefPoolW_().id[iMol] = xMolRefPool_.id[jMol];
+      xMolRefPoolW_().id.pop_back();
     }
     mol2part_.pop_back();
     moltype_.pop_back();
@@ -882,12 +921,16 @@ void Space::addPart(const vector<double> v, const int itype, const int imol) {
          << dimen_ << ") and position of new particle ("
          << v.size() << ") do not match");
 
-  for (int dim = 0; dim < dimen_; ++dim) x_.push_back(v[dim]);
+  xW_().insert(x_.end(), v.begin(), v.end());
   type_.push_back(itype);
   if (itype > nParticleTypes() - 1) nType_.resize(itype + 1);
   ++nType_[itype];
   mol_.push_back(imol);
   listAtoms_.push_back(natom() - 1);
+  if (cavityOn()) {
+    cavityCellOfAtom_.push_back(cavityCell_(&x_[dimen_*(natom() - 1)]));
+    cavityCountSite_(cavityCellOfAtom_.back(), 1);
+  }
 }
 
 void Space::readXYZBulk(const int nMolAtoms, const char* type,
@@ -968,33 +1011,85 @@ vector<int> Space::randMolSubset(const vector<int> jmMol) {
   return mpart;
 }
 
-void Space::restore(vector<int> mpart) {
-  ASSERT(xold_.size() >= mpart.size(), "restore() requires previous use of "
-    << "xStore()");
+void Space::restore(const vector<int> &mpart) {
+  ASSERT(nOld_ >= static_cast<int>(mpart.size()), "restore() requires "
+    << "previous use of xStore()");
   for (unsigned int i = 0; i < mpart.size(); ++i) {
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*mpart[i]+dim] = xold_[i][dim];
+      xW_(mpart[i])[dim] = xold_[dimen_*i+dim];
     }
   }
   if (sphereSymMol_ == false) {
     // assume that mpart is made of only one molecule
     const int iMol = mol_[mpart[0]];
     for (int dim = 0; dim < qdim_; ++dim) {
-      qMol_[qdim_*iMol+dim] = qMolOld_[0][dim];
+      qMolW_(iMol)[dim] = qMolOld_[dim];
     }
   }
 }
 
 void Space::restoreAll() {
-  ASSERT(xOldAll_.size() == x_.size(), "stored particle coordinates size "
-    << xOldAll_.size() << " does not match current size " << x_.size());
-  x_ = xOldAll_;
-  if (sphereSymMol_ == false) {
+  ASSERT(journalOpen_, "restoreAll() requires previous use of xStoreAll()");
+  ASSERT(natomJournal_ == natom(), "number of stored particles "
+    << natomJournal_ << " does not match current number " << natom());
+
+  // the journal itself is written back without the write accessors
+  for (unsigned int i = 0; i < xJournalAtom_.size(); ++i) {
+    std::copy(xOldAll_.begin() + dimen_*i, xOldAll_.begin() + dimen_*(i+1),
+              x_.begin() + dimen_*xJournalAtom_[i]);
+  }
+  if (journalQMol_) {
     ASSERT(qMol_.size() == qMolOldAll_.size(), "size mismatch");
     qMol_ = qMolOldAll_;
-    ASSERT(xMolRef_.size() == xMolRefOld_.size(), "size mismatch");
-    xMolRef_ = xMolRefOld_;
+    xMolRefPool_ = xMolRefPoolOld_;
   }
+  ++revision_;
+  journalClose_();
+  if (cavityOn()) updateCavityofallMol();
+}
+
+void Space::restoreMols(const vector<int> &mols) {
+  int ix = 0, iref = 0;
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    const int iMol = mols[i];
+    const int nAtom = mol2part_[iMol+1] - mol2part_[iMol];
+    ASSERT(ix + dimen_*nAtom <= static_cast<int>(xOldMols_.size()),
+      "restoreMols() requires previous use of xStoreMols()");
+    std::copy(xOldMols_.begin() + ix, xOldMols_.begin() + ix + dimen_*nAtom,
+              xW_(mol2part_[iMol], nAtom));
+    ix += dimen_*nAtom;
+    if (!sphereSymMol_) {
+      std::copy(qMolOldMols_.begin() + qdim_*i,
+                qMolOldMols_.begin() + qdim_*(i+1), qMolW_(iMol));
+      double* xref = xMolRefOwn_(iMol);
+      std::copy(xRefOldMols_.begin() + iref,
+                xRefOldMols_.begin() + iref + dimen_*nAtom, xref);
+      iref += dimen_*nAtom;
+    }
+  }
+}
+
+vector<vector<double> > Space::xold() const {
+  vector<vector<double> > xold(nOld_, vector<double>(dimen_));
+  for (int i = 0; i < nOld_; ++i) {
+    for (int dim = 0; dim < dimen_; ++dim) {
+      xold[i][dim] = xold_[dimen_*i+dim];
+    }
+  }
+  return xold;
+}
+
+vector<vector<vector<double> > > Space::xOldMulti() const {
+  vector<vector<vector<double> > > xOldMulti(nOldMulti_,
+    vector<vector<double> >(nOldMultiPart_, vector<double>(dimen_)));
+  for (int m = 0; m < nOldMulti_; ++m) {
+    for (int i = 0; i < nOldMultiPart_; ++i) {
+      for (int dim = 0; dim < dimen_; ++dim) {
+        xOldMulti[m][i][dim] = xOldMulti_[dimen_*(nOldMultiPart_*m+i)+dim];
+      }
+    }
+  }
+  return xOldMulti;
 }
 
 void Space::addMol(const char* type) {
@@ -1005,7 +1100,25 @@ void Space::addMol(const char* type) {
 
   if (sphereSymMol_ && (s->natom() > 1)) sphereSymMol_ = false;
   vector<vector<double> > xn = s->xMol().front();
-  if (!sphereSymMol_) xMolRef_.push_back(s->xMol().front());
+  if (!sphereSymMol_) {
+    // share the reference positions of the type
+    const int iType = findAddMolListIndex(typestr);
+    MolRefPool_ &pool = xMolRefPoolW_();
+    if (static_cast<int>(pool.typeID.size()) <= iType) {
+      pool.typeID.resize(iType + 1, -1);
+    }
+    if (pool.typeID[iType] == -1) {
+      const int id = xMolRefNew_(static_cast<int>(xn.size()), true);
+      for (unsigned int i = 0; i < xn.size(); ++i) {
+        for (int dim = 0; dim < dimen_; ++dim) {
+          pool.x[pool.start[id] + dimen_*i + dim] = xn[i][dim];
+        }
+      }
+      pool.typeID[iType] = id;
+    }
+    pool.id.push_back(pool.typeID[iType]);
+    ++pool.count[pool.typeID[iType]];
+  }
 
   // move molecule to random position within the box
   //  or if xAdd !null, to position xadd
@@ -1044,21 +1157,21 @@ void Space::addMol(const char* type) {
       if (dimen_ == 3) {
         if (eulerFlag_ == 0) {
           vector<double> qran = quatRandom();
-          for (int qd = 0; qd < qdim_; ++qd) qMol_.push_back(qran[qd]);
+          for (int qd = 0; qd < qdim_; ++qd) qMolW_().push_back(qran[qd]);
         } else {
           vector<double> eran = eulerRandom();
-          for (int qd = 0; qd < qdim_-1; ++qd) qMol_.push_back(eran[qd]);
-          qMol_.push_back(1);
+          for (int qd = 0; qd < qdim_-1; ++qd) qMolW_().push_back(eran[qd]);
+          qMolW_().push_back(1);
         }
       } else if (dimen_ == 2) {
-        qMol_.push_back(2*PI*uniformRanNum());
+        qMolW_().push_back(2*PI*uniformRanNum());
       }
     } else {
       if (dimen_ == 3) {
-        for (int qd = 0; qd < qdim_ - 1; ++qd) qMol_.push_back(0);
-        qMol_.push_back(1);
+        for (int qd = 0; qd < qdim_ - 1; ++qd) qMolW_().push_back(0);
+        qMolW_().push_back(1);
       } else if (dimen_ == 2) {
-        qMol_.push_back(0);
+        qMolW_().push_back(0);
       }
     }
     quat2pos(nMol()-1);
@@ -1083,6 +1196,7 @@ void Space::addMol(const char* type) {
   // wrap in box
   const vector<int> mpart = lastMolIDVec();
   wrap(mpart);
+  if (cavityOn()) updateCavityofiMol(nMol() - 1);
 
   // custom per atom (e.g., groups)
   for (vector<shared_ptr<Group> >::iterator it = groups_.begin();
@@ -1097,6 +1211,72 @@ void Space::addMol(const char* type) {
   }
 }
 
+/**
+ * generate a ghost molecule with a random orientation, without adding it
+ */
+void Space::initGhostMol(const char* type, const vector<double> &xFirst) {
+  ASSERT(static_cast<int>(xFirst.size()) == dimen_, "dimension("
+    << xFirst.size() << ") of ghost position does not match dimen("
+    << dimen_ << ")");
+  ghostMolType_.assign(type);
+  shared_ptr<Space> s = findAddMolInList(ghostMolType_);
+  const int nSite = s->natom();
+  ghostType_ = s->type();
+  ghostX_.resize(dimen_*nSite);
+  for (int dim = 0; dim < dimen_; ++dim) ghostX_[dim] = xFirst[dim];
+
+  // random orientation, as in addMol
+  ghostQ_.clear();
+  if (nSite > 1) {
+    if (dimen_ == 3) {
+      if (eulerFlag_ == 0) {
+        ghostQ_ = quatRandom();
+      } else {
+        const vector<double> eran = eulerRandom();
+        for (int qd = 0; qd < qdim_-1; ++qd) ghostQ_.push_back(eran[qd]);
+        ghostQ_.push_back(1);
+      }
+    } else if (dimen_ == 2) {
+      ghostQ_.push_back(2*PI*uniformRanNum());
+    }
+
+    // place the remaining sites relative to the first, as in quat2pos
+    double rot[9];
+    molRot_(&ghostQ_[0], rot);
+    for (int i = 1; i < nSite; ++i) {
+      for (int dim = 0; dim < dimen_; ++dim) {
+        double xnew = 0.;
+        for (int k = 0; k < dimen_; ++k) {
+          xnew += s->x(i, k)*rot[dimen_*k+dim];
+        }
+        ghostX_[dimen_*i+dim] = xFirst[dim] + xnew;
+      }
+    }
+  }
+}
+
+void Space::addGhostMol() {
+  ASSERT(ghostX_.size() > 0, "initGhostMol must precede addGhostMol");
+  shared_ptr<Space> s = findAddMolInList(ghostMolType_);
+  xAdd.resize(dimen_);
+  for (int dim = 0; dim < dimen_; ++dim) {
+    xAdd[dim] = ghostX_[dim] - s->x(0, dim);
+  }
+  addMol(ghostMolType_.c_str());
+
+  // addMol with xAdd does not rotate, so impose the orientation of the ghost
+  const int iMol = nMol() - 1;
+  if (!sphereSymMol_ && (ghostQ_.size() > 0)) {
+    for (int qd = 0; qd < qdim_; ++qd) {
+      qMolW_(iMol)[qd] = ghostQ_[qd];
+    }
+    quat2pos(iMol);
+    wrap(lastMolIDVec());
+    if (cellType_ > 0) updateCellofiMol(iMol);
+    if (cavityOn()) updateCavityofiMol(iMol);
+  }
+}
+
 /**
  * initialize the potential addition of molecules
  */
@@ -1257,7 +1437,7 @@ int Space::avb(const vector<int> mpart, const vector<int> jmpart,
   for (unsigned int i = 0; i < mpart.size(); ++i) {
     const int ipart = mpart[i];
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*ipart+dim] += xnew[dim] - xold[dim];
+      xW_(ipart)[dim] += xnew[dim] - xold[dim];
     }
   }
 
@@ -1270,75 +1450,140 @@ int Space::avb(const vector<int> mpart, const vector<int> jmpart,
   return bond;
 }
 
-void Space::xStore(const vector<int> mpart   //!< list of particles to store
+void Space::xStore(const vector<int> &mpart   //!< list of particles to store
   ) {
-  xold_.resize(static_cast<int>(mpart.size()), vector<double>(dimen()));
-  for (unsigned int i = 0; i < mpart.size(); ++i) {
+  journalClose_();
+  nOld_ = static_cast<int>(mpart.size());
+  if (static_cast<int>(xold_.size()) < dimen_*nOld_) {
+    xold_.resize(dimen_*nOld_);
+  }
+  for (int i = 0; i < nOld_; ++i) {
     for (int dim = 0; dim < dimen_; ++dim) {
-      xold_[i][dim] = x_[dimen_*mpart[i]+dim];
+      xold_[dimen_*i+dim] = x_[dimen_*mpart[i]+dim];
     }
   }
   if (sphereSymMol_ == false) {
     // assume that mpart is made of only one molecule
     const int iMol = mol_[mpart[0]];
-    qMolOld_.resize(1, vector<double>(qdim()));
+    qMolOld_.resize(qdim_);
     for (int dim = 0; dim < qdim_; ++dim) {
-      qMolOld_[0][dim] = qMol_[qdim_*iMol+dim];
+      qMolOld_[dim] = qMol_[qdim_*iMol+dim];
     }
   }
 }
 
 void Space::xStoreAll() {
-  xOldAll_ = x_;
-  if (sphereSymMol_ == false) {
-    qMolOldAll_ = qMol_;
-    xMolRefOld_ = xMolRef_;
+  journalClose_();
+  natomJournal_ = natom();
+  if (static_cast<int>(xJournaled_.size()) < natomJournal_) {
+    xJournaled_.resize(natomJournal_, false);
   }
+  journalOpen_ = true;
+  journalQMol_ = false;
 }
 
-void Space::xStoreMulti(const vector<int> mpart, const int flag) {
+void Space::journalX_(const int ipart, const int nAtom) {
+  const int iEnd = std::min(ipart + nAtom, std::min(natomJournal_, natom()));
+  for (int i = ipart; i < iEnd; ++i) {
+    if (!xJournaled_[i]) {
+      xJournaled_[i] = true;
+      xJournalAtom_.push_back(i);
+      xOldAll_.insert(xOldAll_.end(), x_.begin() + dimen_*i,
+                      x_.begin() + dimen_*(i+1));
+    }
+  }
+}
+
+void Space::journalClose_() {
+  for (unsigned int i = 0; i < xJournalAtom_.size(); ++i) {
+    xJournaled_[xJournalAtom_[i]] = false;
+  }
+  xJournalAtom_.clear();
+  xOldAll_.clear();
+  journalOpen_ = false;
+}
+
+void Space::xStoreMols(const vector<int> &mols) {
+  journalClose_();
+  xOldMols_.clear();
+  qMolOldMols_.clear();
+  xRefOldMols_.clear();
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    const int iMol = mols[i];
+    xOldMols_.insert(xOldMols_.end(), x_.begin() + dimen_*mol2part_[iMol],
+                     x_.begin() + dimen_*mol2part_[iMol+1]);
+    if (!sphereSymMol_) {
+      qMolOldMols_.insert(qMolOldMols_.end(), qMol_.begin() + qdim_*iMol,
+                          qMol_.begin() + qdim_*(iMol+1));
+      const int nAtom = mol2part_[iMol+1] - mol2part_[iMol];
+      const double* xref =
+        &xMolRefPool_.x[xMolRefPool_.start[xMolRefPool_.id[iMol]]];
+      xRefOldMols_.insert(xRefOldMols_.end(), xref, xref + dimen_*nAtom);
+    }
+  }
+}
+
+void Space::xStoreMulti(const vector<int> &mpart, const int flag) {
+  const int nPart = static_cast<int>(mpart.size());
+
   // restore if flag is positive
   if (flag >= 0) {
-    ASSERT(mpart.size() == xOldMulti_[flag].size(), "size mismatch");
-    for (unsigned int i = 0; i < mpart.size(); ++i) {
+    ASSERT(flag < nOldMulti_, "store(" << flag << ") does not exist");
+    ASSERT(nPart == nOldMultiPart_, "size mismatch");
+    for (int i = 0; i < nPart; ++i) {
       for (int dim = 0; dim < dimen_; ++dim) {
-        x_[dimen_*mpart[i]+dim] = xOldMulti_[flag][i][dim];
+        xW_(mpart[i])[dim] = xOldMulti_[dimen_*(nPart*flag+i)+dim];
       }
     }
     if (sphereSymMol_ == false) {
       // assume that mpart is made of only one molecule
       const int iMol = mol_[mpart[0]];
       for (int dim = 0; dim < qdim_; ++dim) {
-        qMol_[qdim_*iMol+dim] = qMolOldMulti_[flag][0][dim];
+        qMolW_(iMol)[dim] = qMolOldMulti_[qdim_*flag+dim];
       }
     }
 
   // store if flag is negative
   } else {
-    if (flag == -1) xOldMulti_.clear();
-    const int m = static_cast<int>(xOldMulti_.size());
-    xOldMulti_.resize(m+1, vector<vector<double> >
-      (static_cast<int>(mpart.size()), vector<double>(dimen())));
-    for (unsigned int i = 0; i < mpart.size(); ++i) {
+    journalClose_();
+    if (flag == -1) {
+      nOldMulti_ = 0;
+      nOldMultiPart_ = nPart;
+    }
+    ASSERT(nPart == nOldMultiPart_, "size mismatch");
+    const int m = nOldMulti_++;
+    if (static_cast<int>(xOldMulti_.size()) < dimen_*nPart*nOldMulti_) {
+      xOldMulti_.resize(dimen_*nPart*nOldMulti_);
+    }
+    for (int i = 0; i < nPart; ++i) {
       for (int dim = 0; dim < dimen_; ++dim) {
-        xOldMulti_[m][i][dim] = x_[dimen_*mpart[i]+dim];
+        xOldMulti_[dimen_*(nPart*m+i)+dim] = x_[dimen_*mpart[i]+dim];
       }
     }
     if (sphereSymMol_ == false) {
       // assume that mpart is made of only one molecule
       const int iMol = mol_[mpart[0]];
-      if (flag == -1) qMolOldMulti_.clear();
-      const int m = static_cast<int>(qMolOldMulti_.size());
-      qMolOldMulti_.resize(m+1, vector<vector<double> >
-        (1, vector<double>(qdim())));
+      if (static_cast<int>(qMolOldMulti_.size()) < qdim_*nOldMulti_) {
+        qMolOldMulti_.resize(qdim_*nOldMulti_);
+      }
       for (int dim = 0; dim < qdim_; ++dim) {
-        qMolOldMulti_[m][0][dim] = qMol_[qdim_*iMol+dim];
+        qMolOldMulti_[qdim_*m+dim] = qMol_[qdim_*iMol+dim];
       }
     }
   }
 }
 
-double Space::rsq(const vector<double> xi, const vector<double> xj) {
+double Space::rsqAtoms_(const int iAtom, const int jAtom) const {
+  double r[3] = {0., 0., 0.};
+  for (int dim = 0; dim < dimen_; ++dim) {
+    r[dim] = x_[dimen_*iAtom+dim] - x_[dimen_*jAtom+dim];
+  }
+  const double lz = (dimen_ == 3) ? boxLength_[2] : 0.;
+  pbc(&r[0], &r[1], &r[2], boxLength_[0], boxLength_[1], lz);
+  return r[0]*r[0] + r[1]*r[1] + r[2]*r[2];
+}
+
+double Space::rsq(const vector<double> xi, const vector<double> xj) const {
   vector<double> r(dimen_);
   for (int dim = 0; dim < dimen_; ++dim) {
     r[dim] = xi[dim] - xj[dim];
@@ -1363,7 +1608,7 @@ void Space::wrap(const vector<int> mpart) {
   for (unsigned int i = 0; i < mpart.size(); ++i) {
     const int ipart = mpart[i];
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*ipart+dim] += x[dim] - xold[dim];
+      xW_(ipart)[dim] += x[dim] - xold[dim];
     }
   }
   // if (cellType_ > 0) updateCellofiMol(mol_[mpart.front()]);
@@ -1379,41 +1624,52 @@ void Space::rwrap(vector<double> *rvecPtr) {
     }
   } else {
     if (dimen_ == 2) {
-      if (rvec[0] > (0.5*boxLength_[0] + rvec[1]/boxLength_[1]*xyTilt_)) {
-        dx[0] -= boxLength_[0];
+      if (rvec[1] >  0.5*boxLength_[1]) {
+        dx[1] -= boxLength_[1];
+        dx[0] -= xyTilt_;
+      } else if (rvec[1] < -0.5*boxLength_[1]) {
+        dx[1] += boxLength_[1];
+        dx[0] += xyTilt_;
       }
-      if (rvec[0] < (-0.5*boxLength_[0] + rvec[1]/boxLength_[1]*xyTilt_)) {
+      const double xy = (rvec[1] + dx[1])/boxLength_[1]*xyTilt_;
+      if (rvec[0] + dx[0] > 0.5*boxLength_[0] + xy) {
+        dx[0] -= boxLength_[0];
+      } else if (rvec[0] + dx[0] < -0.5*boxLength_[0] + xy) {
         dx[0] += boxLength_[0];
       }
-      if (rvec[1] >  0.5*boxLength_[1]) dx[1] -= boxLength_[1];
-      if (rvec[1] < -0.5*boxLength_[1]) dx[1] += boxLength_[1];
       for (int dim = 0; dim < dimen_; ++dim) {
         rvec[dim] += dx[dim];
       }
 
     } else if (dimen_ == 3) {
+      // wrap by the vectors of the triclinic cell, from z to x
       if (rvec[2] >  0.5*boxLength_[2]) {
         dx[2] -= boxLength_[2];
-        rvec[2] -= boxLength_[2];
+        dx[1] -= yzTilt_;
+        dx[0] -= xzTilt_;
       } else if (rvec[2] < -0.5*boxLength_[2]) {
         dx[2] += boxLength_[2];
-        rvec[2] += boxLength_[2];
+        dx[1] += yzTilt_;
+        dx[0] += xzTilt_;
       }
-      if (rvec[1] >  0.5*boxLength_[1] + rvec[2]/boxLength_[2]*yzTilt_) {
+      const double fz = (rvec[2] + dx[2])/boxLength_[2];
+      const double yz = fz*yzTilt_;
+      if (rvec[1] + dx[1] >  0.5*boxLength_[1] + yz) {
         dx[1] -= boxLength_[1];
-        rvec[1] -= boxLength_[1];
-      } else if (rvec[1] < -0.5*boxLength_[1] + rvec[2]/boxLength_[2]*yzTilt_) {
+        dx[0] -= xyTilt_;
+      } else if (rvec[1] + dx[1] < -0.5*boxLength_[1] + yz) {
         dx[1] += boxLength_[1];
-        rvec[1] += boxLength_[1];
+        dx[0] += xyTilt_;
       }
-      if (rvec[0] > (0.5*boxLength_[0] + rvec[1]/boxLength_[1]*xyTilt_
-          + rvec[2]/boxLength_[2]*xzTilt_)) {
+      const double fy = (rvec[1] + dx[1] - yz)/boxLength_[1];
+      const double xyz = fy*xyTilt_ + fz*xzTilt_;
+      if (rvec[0] + dx[0] > 0.5*boxLength_[0] + xyz) {
         dx[0] -= boxLength_[0];
-        rvec[0] -= boxLength_[0];
-      } else if (rvec[0] < (-0.5*boxLength_[0] + rvec[1]/boxLength_[1]*xyTilt_
-                 + rvec[2]/boxLength_[2]*xzTilt_)) {
+      } else if (rvec[0] + dx[0] < -0.5*boxLength_[0] + xyz) {
         dx[0] += boxLength_[0];
-        rvec[0] += boxLength_[0];
+      }
+      for (int dim = 0; dim < dimen_; ++dim) {
+        rvec[dim] += dx[dim];
       }
     }
   }
@@ -1432,16 +1688,22 @@ void Space::updateCells(const double dCellMin, const double rCut) {
   nCellVec_.clear();
   dCell_.clear();
   for (int dim = 0; dim < dimen_; ++dim) {
+    const double height = boxHeight(dim);
     nCellVec_.push_back(
-      static_cast<int>(boxLength_[dim]/static_cast<double>(dCellMin)));
-    dCell_.push_back(boxLength_[dim] / static_cast<double>(nCellVec_[dim]));
-    if ( (dCell_[dim] + rCut > boxLength_[dim]/2.) || (boxLength_[dim] == 0) ) {
+      static_cast<int>(height/static_cast<double>(dCellMin)));
+    dCell_.push_back(height / static_cast<double>(nCellVec_[dim]));
+    if ( (dCell_[dim] + rCut > height/2.) || (boxLength_[dim] == 0) ) {
       cellType_ = 0;
       WARN(verbose_ == 1, "cell list disabled due to dCell (" << dCell_[dim]
-        << ") + rCut (" << rCut << ") > boxLength_[dim]/2 (boxLength_[" << dim
-        << "]=" << boxLength_[dim] << ")");
+        << ") + rCut (" << rCut << ") > boxHeight(dim)/2 (boxHeight(" << dim
+        << ")=" << height << ")");
     }
   }
+  if ( (cellType_ == 2) && tilted() ) {
+    cellType_ = 0;
+    WARN(verbose_ == 1, "cell list disabled because dCellMin(" << dCellMin
+      << ") < rCut(" << rCut << ") is not implemented for tilted domains");
+  }
   nCell_ = product(nCellVec_);
   if ( (dimen_ == 3) && (cellType_ != 0) ) {
     if (cellType_ == 1) {
@@ -1581,6 +1843,7 @@ vector<vector<double> > Space::cellCorners_(const int m) {
 }
 
 int Space::rvec2m_(const vector<double> &r) {
+  if (tilted()) return fractionalCell_(&r[0], nCellVec_);
   int cell = -1;
   if (dimen_ == 3) {
     const int xc = static_cast<int>
@@ -1625,6 +1888,7 @@ int Space::iatom2m(const double &ipart) {
 }
 
 void Space::buildCellList() {
+  FEASST_PROFILE(CELL);
   if (cellType_ != 1) {
     ASSERT(0, "cellType other than 1 isn't implemented");
   } else if (cellType_ == 1) {
@@ -1659,9 +1923,10 @@ vector<int> Space::lastMolIDVec() {
 void Space::qMolInit() {
   // update molecule numbers and xMol
   xMolGen();
-  xMolRef_ = xMol_;
+  xMolRefPoolW_() = MolRefPool_();
+  xMolRefPoolW_().id.resize(nMol(), -1);
   sphereSymMol_ = false;
-  qMol_.resize(nMol()*qdim_);
+  qMolW_().resize(nMol()*qdim_);
   for (int i = 0; i < nMol(); ++i) {
     qMolInit(i);
   }
@@ -1669,62 +1934,137 @@ void Space::qMolInit() {
 
 void Space::qMolInit(const int iMol) {
   if (dimen_ == 3) {
-    for (int dim = 0; dim < dimen_; ++dim) qMol_[qdim_*iMol+dim] = 0;
-    qMol_[qdim_*iMol+dimen_] = 1;
+    for (int dim = 0; dim < dimen_; ++dim) qMolW_(iMol)[dim] = 0;
+    qMolW_(iMol)[dimen_] = 1;
   } else if (dimen_ == 2) {
-    qMol_[iMol] = 0;
+    qMolW_(iMol)[0] = 0;
   }
 
-  // initialize xMolRef_ with positions
-  for (int ipart = mol2part_[iMol]; ipart < mol2part_[iMol+1]; ++ipart) {
-    const int i = ipart - mol2part_[iMol];
+  // initialize reference with positions, shifted such that the first atom
+  // is zero, e.g. xMolRef[][0][] == 0
+  double* xref = xMolRefOwn_(iMol);
+  const int iPartPivot = mol2part_[iMol];
+  for (int ipart = iPartPivot; ipart < mol2part_[iMol+1]; ++ipart) {
+    const int i = ipart - iPartPivot;
     for (int dim = 0; dim < dimen_; ++dim) {
-      xMolRef_[iMol][i][dim] = x(ipart, dim);
+      xref[dimen_*i+dim] = x(ipart, dim) - x(iPartPivot, dim);
     }
   }
+}
+
+int Space::nAtomRef_(const int iMol) const {
+  const int id = xMolRefPool_.id[iMol];
+  if (id >= 0) return xMolRefPool_.nAtom[id];
+  return mol2part_[iMol+1] - mol2part_[iMol];
+}
 
-  // shift xMolRef_ such that the first atom is zero, e.g. xMolRef[][0][] == 0
-  if (xMolRef_[iMol].size() > 1) {
-    for (unsigned int i = 1; i < xMolRef_[iMol].size(); ++i) {
+void Space::quat2pos(const int iMol) {
+  const int id = xMolRefPool_.id[iMol];
+  if (id < 0) return;
+  const int nref = xMolRefPool_.nAtom[id];
+  const double* xref = &xMolRefPool_.x[xMolRefPool_.start[id]];
+  if (nref > 1) {
+    // rotate the reference positions, xnew = xref*rot, with a fixed-size
+    // rotation matrix rot[dimen_*i+j]
+    double rot[9];
+    molRot_(&qMol_[iMol*qdim_], rot);
+    const int iPartPivot = mol2part_[iMol];
+    for (int i = 1; i < nref; ++i) {
+      const int ipart = iPartPivot + i;
       for (int dim = 0; dim < dimen_; ++dim) {
-        xMolRef_[iMol][i][dim] -= xMolRef_[iMol][0][dim];
+        double xnew = 0.;
+        for (int k = 0; k < dimen_; ++k) {
+          xnew += xref[dimen_*i+k]*rot[dimen_*k+dim];
+        }
+        xW_(ipart)[dim] = x_[dimen_*iPartPivot+dim] + xnew;
       }
     }
   }
-  for (int dim = 0; dim < dimen_; ++dim) xMolRef_[iMol][0][dim] = 0.;
 }
 
-void Space::quat2pos(const int iMol) {
-  vector<vector<double> > xref = xMolRef_[iMol];
-  if (static_cast<int>(xref.size()) > 1) {
-    vector<vector<double> > r, xnew;
-    if (dimen_ == 3) {
-      if (eulerFlag_ == 0) {
-        vector<double> q(qdim_);
-        for (int i = 0; i < qdim_; ++i) q[i] = qMol_[iMol*qdim_+i];
-        r = quat2rot(q);
-        xnew = matMul(xref, r);
-      } else {
-        vector<double> e(dimen_);
-        for (int i = 0; i < dimen_; ++i) e[i] = qMol_[iMol*qdim_+i];
-        r = Euler2RotMat(e);
-        vector<vector<double> > xreftp = transpose(xref);
-        xnew = matMul(r, xreftp);
-        xnew = transpose(xnew);
+void Space::molRot_(const double *q, double *rot) const {
+  if (dimen_ == 3) {
+    if (eulerFlag_ == 0) {
+      quat2rot(q, rot);
+    } else {
+      // the euler rotation matrix is applied as rot*xref^T, so transpose
+      double euler[9];
+      Euler2RotMat(q, euler);
+      for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) rot[3*i+j] = euler[3*j+i];
       }
-
-    } else if (dimen_ == 2) {
-      r = theta2rot(qMol_[iMol]);
-      xnew = matMul(xref, r);
     }
-    const int iPartPivot = mol2part_[iMol];
-    for (unsigned int i = 1; i < xref.size(); ++i) {
-      const int ipart = mol2part_[iMol] + i;
+  } else if (dimen_ == 2) {
+    theta2rot(q[0], rot);
+  }
+}
+
+vector<vector<vector<double> > > Space::xMolRef() const {
+  vector<vector<vector<double> > > xref(xMolRefPool_.id.size());
+  for (int iMol = 0; iMol < static_cast<int>(xref.size()); ++iMol) {
+    const int nAtom = nAtomRef_(iMol);
+    xref[iMol].resize(nAtom, vector<double>(dimen_));
+    for (int iAtom = 0; iAtom < nAtom; ++iAtom) {
       for (int dim = 0; dim < dimen_; ++dim) {
-        x_[dimen_*ipart+dim] = x_[dimen_*iPartPivot+dim] + xnew[i][dim];
+        xref[iMol][iAtom][dim] = xMolRef(iMol, iAtom, dim);
+      }
+    }
+  }
+  return xref;
+}
+
+int Space::nMolRefStored() const {
+  int n = 0;
+  for (unsigned int id = 0; id < xMolRefPool_.count.size(); ++id) {
+    if ( (xMolRefPool_.count[id] > 0) || (xMolRefPool_.type[id]) ) ++n;
+  }
+  return n;
+}
+
+int Space::xMolRefNew_(const int nAtom, const bool type) {
+  MolRefPool_ &pool = xMolRefPoolW_();
+
+  // reuse the last released entry if it is the same size
+  if ( (!type) && (pool.free.size() > 0) &&
+       (pool.nAtom[pool.free.back()] == nAtom) ) {
+    const int id = pool.free.back();
+    pool.free.pop_back();
+    return id;
+  }
+  const int id = static_cast<int>(pool.start.size());
+  pool.start.push_back(static_cast<int>(pool.x.size()));
+  pool.nAtom.push_back(nAtom);
+  pool.count.push_back(0);
+  pool.type.push_back(type);
+  pool.x.resize(pool.x.size() + dimen_*nAtom, 0.);
+  return id;
+}
+
+void Space::xMolRefRelease_(const int id) {
+  MolRefPool_ &pool = xMolRefPoolW_();
+  if (id >= 0) {
+    --pool.count[id];
+    if ( (pool.count[id] == 0) && (!pool.type[id]) ) pool.free.push_back(id);
+  }
+}
+
+double* Space::xMolRefOwn_(const int iMol) {
+  MolRefPool_ &pool = xMolRefPoolW_();
+  const int id = pool.id[iMol];
+  if ( (id == -1) || (pool.count[id] > 1) || (pool.type[id]) ) {
+    const int nAtom = mol2part_[iMol+1] - mol2part_[iMol];
+    const int idNew = xMolRefNew_(nAtom);
+    if (id != -1) {
+      for (int i = 0; i < dimen_*nAtom; ++i) {
+        pool.x[pool.start[idNew] + i] = pool.x[pool.start[id] + i];
       }
+      xMolRefRelease_(id);
     }
+    pool.id[iMol] = idNew;
+    ++pool.count[idNew];
+    return &pool.x[pool.start[idNew]];
   }
+  return &pool.x[pool.start[id]];
 }
 
 void Space::settype(const int iatom, const int itype) {
@@ -1732,6 +2072,7 @@ void Space::settype(const int iatom, const int itype) {
   if (nParticleTypes() -1 < itype) nType_.resize(itype+1);
   type_.at(iatom) = itype;
   ++nType_.at(itype);
+  ++revision_;
 }
 
 void Space::buildNeighListCellAtomCut(const int ipart) {
@@ -1767,6 +2108,25 @@ void Space::buildNeighListCell(const int iMol) {
   }
 }
 
+void Space::buildNeighListCellPosition(const double *r) {
+  neighListCell_.clear();
+  neighListChosen_ = &neighListCell_;
+  ASSERT(cellType_ == 1, "only implemented for cellType_ == 1");
+  ASSERT(atomCut_,
+    "cellAtomCut must be on to use buildNeighListCellPosition");
+  vector<double> rvec(r, r + dimen_);
+  rwrap(&rvec);
+  const int iCell = rvec2m_(rvec);
+
+  // add sites in neighboring cells of r
+  for (unsigned int i = 0; i < neighCell_[iCell].size(); ++i) {
+    const int cell = neighCell_[iCell][i];
+    for (unsigned int j = 0; j < cellList_[cell].size(); ++j) {
+      neighListCell_.push_back(cellList_[cell][j]);
+    }
+  }
+}
+
 /**
  * turn off cell list
  */
@@ -1868,6 +2228,188 @@ void Space::updateCellofallMol() {
   }
 }
 
+double Space::boxHeight(const int dim, const vector<double> &boxLength,
+  const double xyTilt, const double xzTilt, const double yzTilt) const {
+  if (fabs(xyTilt) + fabs(xzTilt) + fabs(yzTilt) < DTOL) {
+    return boxLength[dim];
+  } else if ( (dimen_ == 3) && (dim == 0) ) {
+    const double ly = boxLength[1], lz = boxLength[2];
+    return product(boxLength)/sqrt(pow(ly*lz, 2) + pow(xyTilt*lz, 2) +
+                                   pow(xyTilt*yzTilt - ly*xzTilt, 2));
+  } else if ( (dimen_ == 3) && (dim == 1) ) {
+    const double lz = boxLength[2];
+    return boxLength[1]*lz/sqrt(lz*lz + yzTilt*yzTilt);
+  } else if ( (dimen_ == 2) && (dim == 0) ) {
+    const double ly = boxLength[1];
+    return product(boxLength)/sqrt(ly*ly + xyTilt*xyTilt);
+  }
+  return boxLength[dim];
+}
+
+void Space::initCavity(const double rCav, const int nStencil) {
+  ASSERT(rCav > 0, "rCav(" << rCav << ") must be positive");
+  ASSERT(nStencil >= 1, "nStencil(" << nStencil << ") must be positive");
+  cavityRCut_ = rCav;
+  cavityNStencil_ = nStencil;
+  cavityNCellVec_.assign(dimen_, 1);
+  int nCell = 1;
+  for (int dim = 0; dim < dimen_; ++dim) {
+    ASSERT(boxLength_[dim] > 0, "the domain must be set for initCavity");
+    cavityNCellVec_[dim] = std::max(1,
+      static_cast<int>(boxHeight(dim)*nStencil/rCav));
+    nCell *= cavityNCellVec_[dim];
+  }
+  cavityCount_.assign(nCell, 0);
+  cavityEmpty_.resize(nCell);
+  cavityEmptyIndex_.resize(nCell);
+  for (int cell = 0; cell < nCell; ++cell) {
+    cavityEmpty_[cell] = cell;
+    cavityEmptyIndex_[cell] = cell;
+  }
+  cavityCellOfAtom_.resize(natom());
+  for (int ipart = 0; ipart < natom(); ++ipart) {
+    cavityCellOfAtom_[ipart] = cavityCell_(&x_[dimen_*ipart]);
+    cavityCountSite_(cavityCellOfAtom_[ipart], 1);
+  }
+}
+
+int Space::cavityCell_(const double *x) const {
+  return fractionalCell_(x, cavityNCellVec_);
+}
+
+void Space::fractional_(const double *x, double *f) const {
+  f[2] = 0.;
+  if (dimen_ >= 3) f[2] = x[2]/boxLength_[2];
+  if (dimen_ >= 2) f[1] = (x[1] - yzTilt_*f[2])/boxLength_[1];
+  f[0] = (x[0] - xyTilt_*f[1] - xzTilt_*f[2])/boxLength_[0];
+}
+
+int Space::fractionalCell_(const double *x, const vector<int> &nCellVec)
+  const {
+  double f[3];
+  fractional_(x, f);
+  int cell = 0;
+  for (int dim = dimen_ - 1; dim >= 0; --dim) {
+    double fWrap = f[dim] + 0.5;
+    fWrap -= floor(fWrap);
+    const int c = std::min(static_cast<int>(fWrap*nCellVec[dim]),
+                           nCellVec[dim] - 1);
+    cell = cell*nCellVec[dim] + c;
+  }
+  return cell;
+}
+
+void Space::cavityStencil_(const int cell, vector<int> *cells) const {
+  int c[3] = {0, 0, 0}, n[3] = {1, 1, 1}, k[3] = {0, 0, 0};
+  int remain = cell;
+  for (int dim = 0; dim < dimen_; ++dim) {
+    n[dim] = cavityNCellVec_[dim];
+    c[dim] = remain % n[dim];
+    remain /= n[dim];
+    k[dim] = cavityNStencil_;
+  }
+  cells->clear();
+  for (int oz = -k[2]; oz <= k[2]; ++oz) {
+    const int jz = ((c[2] + oz) % n[2] + n[2]) % n[2];
+    for (int oy = -k[1]; oy <= k[1]; ++oy) {
+      const int jy = ((c[1] + oy) % n[1] + n[1]) % n[1];
+      for (int ox = -k[0]; ox <= k[0]; ++ox) {
+        const int jx = ((c[0] + ox) % n[0] + n[0]) % n[0];
+        cells->push_back((jz*n[1] + jy)*n[0] + jx);
+      }
+    }
+  }
+}
+
+void Space::cavityCountSite_(const int cell, const int delta) {
+  vector<int> cells;
+  cavityStencil_(cell, &cells);
+  for (unsigned int i = 0; i < cells.size(); ++i) {
+    const int jCell = cells[i];
+    const int countOld = cavityCount_[jCell];
+    cavityCount_[jCell] += delta;
+    if ( (countOld == 0) && (cavityCount_[jCell] != 0) ) {
+      // remove from the list of cavities by swapping with the last
+      const int index = cavityEmptyIndex_[jCell], last = cavityEmpty_.back();
+      cavityEmpty_[index] = last;
+      cavityEmptyIndex_[last] = index;
+      cavityEmpty_.pop_back();
+      cavityEmptyIndex_[jCell] = -1;
+    } else if ( (countOld != 0) && (cavityCount_[jCell] == 0) ) {
+      cavityEmptyIndex_[jCell] = static_cast<int>(cavityEmpty_.size());
+      cavityEmpty_.push_back(jCell);
+    }
+  }
+}
+
+vector<double> Space::randCavityPosition() {
+  ASSERT(nCavity() > 0, "no cavities for randCavityPosition");
+  int remain = cavityEmpty_[uniformRanNum(0, nCavity() - 1)];
+  double f[3] = {0., 0., 0.};
+  for (int dim = 0; dim < dimen_; ++dim) {
+    const int n = cavityNCellVec_[dim];
+    f[dim] = (remain % n + uniformRanNum())/static_cast<double>(n) - 0.5;
+    remain /= n;
+  }
+  vector<double> r(dimen_);
+  r[0] = boxLength_[0]*f[0] + xyTilt_*f[1] + xzTilt_*f[2];
+  if (dimen_ >= 2) r[1] = boxLength_[1]*f[1] + yzTilt_*f[2];
+  if (dimen_ >= 3) r[2] = boxLength_[2]*f[2];
+  return r;
+}
+
+int Space::nCavityWithout(const vector<int> &mpart, bool *inCavity) const {
+  // count each cell by the sites in mpart, and find cells with no other sites
+  vector<int> cells, stencil;
+  for (unsigned int i = 0; i < mpart.size(); ++i) {
+    cavityStencil_(cavityCellOfAtom_[mpart[i]], &stencil);
+    cells.insert(cells.end(), stencil.begin(), stencil.end());
+  }
+  std::sort(cells.begin(), cells.end());
+  int nCav = nCavity();
+  *inCavity = false;
+  const int firstCell = cavityCellOfAtom_[mpart.front()];
+  unsigned int i = 0;
+  while (i < cells.size()) {
+    unsigned int j = i;
+    while ( (j < cells.size()) && (cells[j] == cells[i]) ) ++j;
+    if (cavityCount_[cells[i]] == static_cast<int>(j - i)) {
+      ++nCav;
+      if (cells[i] == firstCell) *inCavity = true;
+    }
+    i = j;
+  }
+  return nCav;
+}
+
+void Space::updateCavityofiMol(const int iMol) {
+  for (int ipart = mol2part_[iMol]; ipart < mol2part_[iMol+1]; ++ipart) {
+    const int cellNew = cavityCell_(&x_[dimen_*ipart]);
+    if (cellNew != cavityCellOfAtom_[ipart]) {
+      cavityCountSite_(cavityCellOfAtom_[ipart], -1);
+      cavityCountSite_(cellNew, 1);
+      cavityCellOfAtom_[ipart] = cellNew;
+    }
+  }
+}
+
+void Space::updateCavityofallMol() {
+  for (int iMol = 0; iMol < nMol(); ++iMol) updateCavityofiMol(iMol);
+}
+
+int Space::checkCavity() {
+  const vector<int> count = cavityCount_, cellOfAtom = cavityCellOfAtom_;
+  const int nCav = nCavity();
+  initCavity(cavityRCut_, cavityNStencil_);
+  ASSERT(cellOfAtom == cavityCellOfAtom_, "cavity cells of atoms do not match"
+    << " a cavity grid built from scratch");
+  ASSERT(count == cavityCount_, "cavity grid counts do not match a cavity"
+    << " grid built from scratch");
+  ASSERT(nCav == nCavity(), "number of cavities(" << nCav << ") does not match"
+    << " a cavity grid built from scratch(" << nCavity() << ")");
+  return 1;
+}
+
 // stores current cell list, rebuilds, and compares
 int Space::checkCellList() {
   int cellMatch = 1;
@@ -1920,6 +2462,37 @@ int Space::checkCellList() {
   return cellMatch;
 }
 
+int Space::checkCellListSample(const vector<int> &mols) {
+  int cellMatch = 1;
+  const vector<int> &cell = (atomCut_) ? atom2cell_ : mol2cell_;
+  const int n = (atomCut_) ? natom() : nMol();
+  if (static_cast<int>(cell.size()) != n) return 0;
+
+  // each molecule (or site) is listed once, in the cell it is assigned to
+  int nListed = 0;
+  for (int iCell = 0; iCell < static_cast<int>(cellList_.size()); ++iCell) {
+    for (unsigned int j = 0; j < cellList_[iCell].size(); ++j) {
+      const int i = cellList_[iCell][j];
+      if ( (i < 0) || (i >= n) || (cell[i] != iCell) ) cellMatch = 0;
+      ++nListed;
+    }
+  }
+  if (nListed != n) cellMatch = 0;
+
+  // the cells of the sampled molecules agree with their positions
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    const int iMol = mols[i];
+    if (atomCut_) {
+      for (int ipart = mol2part_[iMol]; ipart < mol2part_[iMol+1]; ++ipart) {
+        if (atom2cell_[ipart] != iatom2m(ipart)) cellMatch = 0;
+      }
+    } else {
+      if (mol2cell_[iMol] != imol2m(iMol)) cellMatch = 0;
+    }
+  }
+  return cellMatch;
+}
+
 void Space::initLMPData(const std::string fileName, const int nTypesExist) {
   // open LAMMPS data file
   std::ifstream file(fileName.c_str());
@@ -2037,7 +2610,7 @@ void Space::initLMPData(const std::string fileName, const int nTypesExist) {
 
     // add new atom
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_.push_back(xtmp[dim]);
+      xW_().push_back(xtmp[dim]);
     }
     mol_.push_back(imol - 1);
     type_.push_back(itype - 1 + nTypesExist);
@@ -2136,9 +2709,9 @@ int Space::checkSizes() {
       ermesg << "qMol(" << qMol_.size()/qdim_ << ") doesn't match nMol("
              << nMol() << ")." << endl;
     }
-    if (static_cast<int>(xMolRef_.size()) != nMol()) {
+    if (static_cast<int>(xMolRefPool_.id.size()) != nMol()) {
       er = true;
-      ermesg << "xMolRef(" << xMolRef_.size() << ") doesn't match nMol("
+      ermesg << "xMolRef(" << xMolRefPool_.id.size() << ") doesn't match nMol("
              << nMol() << ")." << endl;
     }
   } else {
@@ -2147,9 +2720,9 @@ int Space::checkSizes() {
       ermesg << "qMol(" << qMol_.size() << ") should be zero for"
              << "spherically symmetric particle" << endl;
     }
-    if (static_cast<int>(xMolRef_.size()) != 0) {
+    if (static_cast<int>(xMolRefPool_.id.size()) != 0) {
       er = true;
-      ermesg << "xMolRef(" << xMolRef_.size() << ") should be zero"
+      ermesg << "xMolRef(" << xMolRefPool_.id.size() << ") should be zero"
              << "for spherically symmetric particle" << endl;
     }
   }
@@ -2219,6 +2792,14 @@ int Space::mvec2m2d_(const int &i, const int &j) const {
   return (i+mx)%mx + mx*((j+my)%my);
 }
 
+shared_ptr<Space> Space::addMolListOwned_(const string typeStr) {
+  const int iType = findAddMolListIndex(typeStr);
+  if (addMolList_[iType].use_count() > 1) {
+    addMolList_[iType] = make_shared<Space>(*addMolList_[iType]);
+  }
+  return addMolList_[iType];
+}
+
 shared_ptr<Space> Space::findAddMolInList(const string typeStr) const {
   bool match = false;
   for (unsigned int iaml = 0; iaml < addMolList_.size(); ++iaml) {
@@ -2249,17 +2830,20 @@ int Space::findAddMolListIndex(const string typeStr) {
 }
 
 void Space::scaleMol(const int iMol, const vector<double> bondLengths) {
-  vector<vector<double> > xMolRef = xMolRef_[iMol];
+  double* xref = xMolRefOwn_(iMol);
+  const int nAtomMol = nAtomRef_(iMol);
+  double x0[3];
+  for (int dim = 0; dim < dimen_; ++dim) x0[dim] = xref[dim];
 
   // for each atom in molecule
-  for (unsigned int iAtom = 0; iAtom < xMolRef.size(); ++iAtom) {
+  for (int iAtom = 0; iAtom < nAtomMol; ++iAtom) {
     double rinv = 1., r2 = 0.;
     for (int dim = 0; dim < dimen_; ++dim) {
-      r2 += pow(xMolRef[iAtom][dim] - xMolRef[0][dim], 2);
+      r2 += pow(xref[dimen_*iAtom+dim] - x0[dim], 2);
     }
     if (r2 != 0.) rinv = 1./sqrt(r2);
     for (int dim = 0; dim < dimen_; ++dim) {
-      xMolRef_[iMol][iAtom][dim] *= bondLengths[iAtom] * rinv;
+      xref[dimen_*iAtom+dim] *= bondLengths[iAtom] * rinv;
     }
   }
   quat2pos(iMol);
@@ -2305,6 +2889,11 @@ void Space::writeRestart(const char* fileName) {
     file << std::setprecision(std::numeric_limits<double>::digits10+2)
          << "# dCellMin " << dCellMin_ << endl;
   }
+  if (cavityOn()) {
+    file << std::setprecision(std::numeric_limits<double>::digits10+2)
+         << "# cavityRCut " << cavityRCut_ << endl
+         << "# cavityNStencil " << cavityNStencil_ << endl;
+  }
 
   // print addmolinits
   file << "# naddmolinits " << addMolListType_.size() << endl;
@@ -2390,10 +2979,11 @@ void Space::writeRestart(const char* fileName) {
              << x(iAtom, dim) << " ";
       }
       file << endl;
-      for (unsigned int ipart = 1; ipart < xMolRef_[iMol].size(); ++ipart) {
+      const int nAtomMol = nAtomRef_(iMol);
+      for (int ipart = 1; ipart < nAtomMol; ++ipart) {
         for (int dim = 0; dim < dimen_; ++dim) {
           file << std::setprecision(std::numeric_limits<double>::digits10+2)
-               << xMolRef_[iMol][ipart][dim] << " ";
+               << xMolRef(iMol, ipart, dim) << " ";
         }
         file << endl;
       }
@@ -2406,252 +2996,259 @@ void Space::writeRestart(const char* fileName) {
   }
 }
 
-/**
- * flood fill algorithm to identify clusters based on atomic distance cutoff
- */
-void Space::floodFill3d_(
-  const int clusterNode,  //!< atom on cluster edge to grow
-  const int clusterID,    //!< id of current cluster
-  const double rCut       //!< distance based cutoff to define cluster
-  ) {
-  // declare variables for optimization
-  const double xi = xcluster_[dimen_*clusterNode];
-  const double yi = xcluster_[dimen_*clusterNode+1];
-  const double zi = xcluster_[dimen_*clusterNode+2];
-  const double rCut2 = rCut * rCut;
-  double r2, dx, dy, dz, dx2, dy2, dz2;
-  const double lx = boxLength_[0], ly = boxLength_[1], lz = boxLength_[2],
-    halflx = lx/2., halfly = ly/2., halflz = lz/2.;
-
-  // find all nearest neighbors not already assigned a cluster type
-  // within rCut of clusterNode.
-  // Ror each neighbor, recursively active another floodFill
+void Space::prefilClusterVars_() {
+  // prefill cluster vector with -natom() if included and -natom-1 if excluded
+  cluster_.resize(natom());
   for (int i = 0; i < natom(); ++i) {
-    if (cluster_[i] == -natom()) {
-      // separation distance with periodic boundary conditions
-      dx = xi - xcluster_[dimen_*i];
-      dy = yi - xcluster_[dimen_*i+1];
-      dz = zi - xcluster_[dimen_*i+2];
-      dx2 = dy2 = dz2 = 0.;
-      if (dx >  halflx) {
-        dx -= lx;
-        dx2 = -lx;
-      }
-      if (dx < -halflx) {
-        dx += lx;
-        dx2 = lx;
-      }
-      if (dy >  halfly) {
-        dy -= ly;
-        dy2 = -ly;
-      }
-      if (dy < -halfly) {
-        dy += ly;
-        dy2 = ly;
-      }
-      if (dz >  halflz) {
-        dz -= lz;
-        dz2 = -lz;
-      }
-      if (dz < -halflz) {
-        dz += lz;
-        dz2 = lz;
-      }
-      r2 = dx*dx + dy*dy + dz*dz;
+    if (findInList(type_[i], clusterType_)) {
+    //if ( (findInList(type_[i], clusterType_)) || (clusterType_.size() == 0) ) {
+      cluster_[i] = -natom();
+    } else {
+      cluster_[i] = -natom()-1;
+    }
+  }
+  clusterMol_.resize(nMol());
+  std::fill(clusterMol_.begin(), clusterMol_.end(), -1);
+  xcluster_ = x_;
+}
 
-      if (r2 < rCut2) {
-        cluster_[i] = clusterID;
-        const int imol = mol_[i];
-        clusterMol_[imol] = clusterID;
+int Space::clusterFind_(const int iAtom) {
+  // find the root
+  int root = iAtom;
+  while (clusterParent_[root] != root) root = clusterParent_[root];
 
-        // move molecule in xcluster_ if pbc was used
-        if ((dx2 != 0) || (dy2 != 0) || (dz2 != 0)) {
-          for (int ipart = mol2part_[imol]; ipart < mol2part_[imol+1];
-               ++ipart) {
-            xcluster_[dimen_*ipart    ] -= dx2;
-            xcluster_[dimen_*ipart + 1] -= dy2;
-            xcluster_[dimen_*ipart + 2] -= dz2;
-          }
-        }
+  // compress the path, accumulating the image of each atom w.r.t. root
+  for (int dim = 0; dim < dimen_; ++dim) {
+    int image = 0;
+    for (int i = iAtom; i != root; i = clusterParent_[i]) {
+      image += clusterImage_[dimen_*i + dim];
+    }
+    for (int i = iAtom; i != root;) {
+      const int next = clusterParent_[i];
+      const int imageOld = clusterImage_[dimen_*i + dim];
+      clusterImage_[dimen_*i + dim] = image;
+      image -= imageOld;
+      i = next;
+    }
+  }
+  for (int i = iAtom; i != root;) {
+    const int next = clusterParent_[i];
+    clusterParent_[i] = root;
+    i = next;
+  }
+  return root;
+}
 
-        floodFill3d_(i, clusterID, rCut);
-      }
+void Space::clusterUnion_(const int iAtom, const int jAtom, const int *shift) {
+  const int iRoot = clusterFind_(iAtom), jRoot = clusterFind_(jAtom);
+  const int *iImage = &clusterImage_[dimen_*iAtom],
+            *jImage = &clusterImage_[dimen_*jAtom];
+  if (iRoot == jRoot) {
+    // an inconsistent image means the cluster is connected to its own image
+    for (int dim = 0; dim < dimen_; ++dim) {
+      if (iImage[dim] + shift[dim] != jImage[dim]) percolation_ = 1;
+    }
+  } else if (clusterRootSize_[iRoot] >= clusterRootSize_[jRoot]) {
+    clusterParent_[jRoot] = iRoot;
+    clusterRootSize_[iRoot] += clusterRootSize_[jRoot];
+    for (int dim = 0; dim < dimen_; ++dim) {
+      clusterImage_[dimen_*jRoot + dim] = iImage[dim] + shift[dim]
+                                        - jImage[dim];
+    }
+  } else {
+    clusterParent_[iRoot] = jRoot;
+    clusterRootSize_[jRoot] += clusterRootSize_[iRoot];
+    for (int dim = 0; dim < dimen_; ++dim) {
+      clusterImage_[dimen_*iRoot + dim] = jImage[dim] - shift[dim]
+                                        - iImage[dim];
     }
   }
 }
 
-/**
- * flood fill algorithm to identify clusters based on atomic distance cutoff
- */
-void Space::floodFill2d_(
-  const int clusterNode,  //!< atom on cluster edge to grow
-  const int clusterID,    //!< id of current cluster
-  const double rCut       //!< distance based cutoff to define cluster
-  ) {
-  // declare variables for optimization
-  const double xi = xcluster_[dimen_*clusterNode];
-  const double yi = xcluster_[dimen_*clusterNode+1];
-  const double rCut2 = rCut * rCut;
-  double r2, dx, dy, dx2, dy2;
-  const double lx = boxLength_[0], ly = boxLength_[1], halflx = lx/2.,
-    halfly = ly/2.;
-
-  // find all nearest neighbors not already assigned a cluster type
-  // within rCut of clusterNode
-  // For each neighbor, recursively active another floodFill
+void Space::clusterBonds_(const double rCut) {
+  ASSERT( (dimen_ == 2) || (dimen_ == 3),
+    "cluster analysis not implemented for dimen:" << dimen_);
+  ASSERT(!tilted(), "cluster analysis not implemented for tilted domains");
+
+  // bin the cluster atoms into cells at least as wide as rCut. If the domain
+  // is too small for three cells in each dimension, use only one cell.
+  int nCellVec[3] = {1, 1, 1};
+  bool useCells = (rCut > 0);
+  for (int dim = 0; dim < dimen_; ++dim) {
+    if (useCells) nCellVec[dim] = static_cast<int>(boxLength_[dim]/rCut);
+    if (nCellVec[dim] < 3) useCells = false;
+  }
+  if (!useCells) nCellVec[0] = nCellVec[1] = nCellVec[2] = 1;
+  const int nCell = nCellVec[0]*nCellVec[1]*nCellVec[2];
+  clusterCellStart_.assign(nCell + 1, 0);
+  clusterCellOfAtom_.resize(natom());
   for (int i = 0; i < natom(); ++i) {
     if (cluster_[i] == -natom()) {
-      // separation distance with periodic boundary conditions
-      dx = xi - xcluster_[dimen_*i];
-      dy = yi - xcluster_[dimen_*i+1];
-      dx2 = dy2 = 0.;
-      if (dx >  halflx) {
-        dx -= lx;
-        dx2 = -lx;
-      }
-      if (dx < -halflx) {
-        dx += lx;
-        dx2 = lx;
-      }
-      if (dy >  halfly) {
-        dy -= ly;
-        dy2 = -ly;
+      int cell = 0;
+      for (int dim = dimen_ - 1; dim >= 0; --dim) {
+        double f = x_[dimen_*i + dim]/boxLength_[dim] + 0.5;
+        f -= floor(f);
+        const int c = std::min(static_cast<int>(f*nCellVec[dim]),
+                               nCellVec[dim] - 1);
+        cell = cell*nCellVec[dim] + c;
       }
-      if (dy < -halfly) {
-        dy += ly;
-        dy2 = ly;
-      }
-      r2 = dx*dx + dy*dy;
-
-      if (r2 < rCut2) {
-        cluster_[i] = clusterID;
-        const int imol = mol_[i];
-        clusterMol_[imol] = clusterID;
-
-        // move molecule in xcluster_ if pbc was used
-        if ((dx2 != 0) || (dy2 != 0)) {
-          for (int ipart = mol2part_[imol]; ipart < mol2part_[imol+1];
-               ++ipart) {
-            xcluster_[dimen_*ipart    ] -= dx2;
-            xcluster_[dimen_*ipart + 1] -= dy2;
+      clusterCellOfAtom_[i] = cell;
+      ++clusterCellStart_[cell + 1];
+    }
+  }
+  for (int cell = 0; cell < nCell; ++cell) {
+    clusterCellStart_[cell + 1] += clusterCellStart_[cell];
+  }
+  clusterCellAtoms_.resize(clusterCellStart_[nCell]);
+  for (int i = 0; i < natom(); ++i) {
+    if (cluster_[i] == -natom()) {
+      clusterCellAtoms_[clusterCellStart_[clusterCellOfAtom_[i]]++] = i;
+    }
+  }
+  for (int cell = nCell; cell > 0; --cell) {
+    clusterCellStart_[cell] = clusterCellStart_[cell - 1];
+  }
+  clusterCellStart_[0] = 0;
+
+  // half stencil of neighboring cells, such that each pair is visited once
+  int stencil[13][3], nStencil = 0;
+  if (useCells) {
+    for (int dz = 0; dz <= ( (dimen_ == 3) ? 1 : 0); ++dz) {
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          if ( (dz > 0) || ( (dz == 0) && (dy > 0) ) ||
+               ( (dz == 0) && (dy == 0) && (dx > 0) ) ) {
+            stencil[nStencil][0] = dx;
+            stencil[nStencil][1] = dy;
+            stencil[nStencil][2] = dz;
+            ++nStencil;
           }
         }
-
-        floodFill2d_(i, clusterID, rCut);
       }
     }
   }
-}
 
-void Space::floodFillCell3d_(
-  const int clusterNode,  //!< atom on cluster edge to grow
-  const int clusterID,    //!< id of current cluster
-  const double rCut       //!< distance based cutoff to define cluster
-  ) {
-  // declare variables for optimization
-  const double xi = xcluster_[dimen_*clusterNode];
-  const double yi = xcluster_[dimen_*clusterNode+1];
-  const double zi = xcluster_[dimen_*clusterNode+2];
-  const double rCut2 = rCut * rCut;
-  double r2, dx, dy, dz, dx2, dy2, dz2;
-  const double lx = boxLength_[0], ly = boxLength_[1], lz = boxLength_[2],
-    halflx = lx/2., halfly = ly/2., halflz = lz/2.;
-  const int iCell = atom2cell_[clusterNode];
-
-  // find all nearest neighbors not already assigned a cluster type
-  // within rCut of clusterNode
-  // For each neighbor, recursively active another floodFillCell
-  for (unsigned int nc = 0; nc < neighCell_[iCell].size(); ++nc) {
-    const int jCell = neighCell_[iCell][nc];
-    for (unsigned int j = 0; j < cellList_[jCell].size(); ++j) {
-      const int i = cellList_[jCell][j];
-      if (cluster_[i] == -natom()) {
-        // separation distance with periodic boundary conditions
-        dx = xi - xcluster_[dimen_*i];
-        dy = yi - xcluster_[dimen_*i+1];
-        dz = zi - xcluster_[dimen_*i+2];
-        dx2 = dy2 = dz2 = 0.;
-        if (dx >  halflx) {
-          dx -= lx;
-          dx2 = -lx;
-        }
-        if (dx < -halflx) {
-          dx += lx;
-          dx2 = lx;
-        }
-        if (dy >  halfly) {
-          dy -= ly;
-          dy2 = -ly;
-        }
-        if (dy < -halfly) {
-          dy += ly;
-          dy2 = ly;
+  // find all bonds, distributing cells among threads. Each bond is stored as
+  // the two atoms followed by the image of the second relative to the first.
+  int nThreads = 1;
+  #ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+  #endif  // _OPENMP
+  clusterBondList_.resize(nThreads);
+  for (int t = 0; t < nThreads; ++t) clusterBondList_[t].clear();
+  const double rCut2 = rCut*rCut;
+  #ifdef _OPENMP
+  #pragma omp parallel num_threads(nThreads)
+  #endif  // _OPENMP
+  {
+    int thread = 0;
+    #ifdef _OPENMP
+      thread = omp_get_thread_num();
+    #endif  // _OPENMP
+    vector<int> &bonds = clusterBondList_[thread];
+    int shift[3];
+    #ifdef _OPENMP
+    #pragma omp for schedule(static)
+    #endif  // _OPENMP
+    for (int iCell = 0; iCell < nCell; ++iCell) {
+      const int icx = iCell % nCellVec[0],
+                icy = (iCell/nCellVec[0]) % nCellVec[1],
+                icz = iCell/(nCellVec[0]*nCellVec[1]);
+      for (int s = -1; s < nStencil; ++s) {
+        int jCell = iCell;
+        if (s >= 0) {
+          const int jcx = (icx + stencil[s][0] + nCellVec[0]) % nCellVec[0],
+                    jcy = (icy + stencil[s][1] + nCellVec[1]) % nCellVec[1],
+                    jcz = (icz + stencil[s][2] + nCellVec[2]) % nCellVec[2];
+          jCell = (jcz*nCellVec[1] + jcy)*nCellVec[0] + jcx;
         }
-        if (dz >  halflz) {
-          dz -= lz;
-          dz2 = -lz;
-        }
-        if (dz < -halflz) {
-          dz += lz;
-          dz2 = lz;
-        }
-        r2 = dx*dx + dy*dy + dz*dz;
-
-        if (r2 < rCut2) {
-          cluster_[i] = clusterID;
-          const int imol = mol_[i];
-          clusterMol_[imol] = clusterID;
-
-          // move molecule in xcluster_ if pbc was used
-          if ((dx2 != 0) || (dy2 != 0) || (dz2 != 0)) {
-            for (int ipart = mol2part_[imol]; ipart < mol2part_[imol+1];
-                 ++ipart) {
-              xcluster_[dimen_*ipart    ] -= dx2;
-              xcluster_[dimen_*ipart + 1] -= dy2;
-              xcluster_[dimen_*ipart + 2] -= dz2;
+        for (int ii = clusterCellStart_[iCell]; ii < clusterCellStart_[iCell+1];
+             ++ii) {
+          const int i = clusterCellAtoms_[ii];
+          int jjBegin = clusterCellStart_[jCell];
+          if (s == -1) jjBegin = ii + 1;
+          for (int jj = jjBegin; jj < clusterCellStart_[jCell+1]; ++jj) {
+            const int j = clusterCellAtoms_[jj];
+            double r2 = 0.;
+            for (int dim = 0; dim < dimen_; ++dim) {
+              double dx = x_[dimen_*i + dim] - x_[dimen_*j + dim];
+              const double l = boxLength_[dim];
+              shift[dim] = 0;
+              if (dx >  0.5*l) {
+                dx -= l;
+                shift[dim] = 1;
+              } else if (dx < -0.5*l) {
+                dx += l;
+                shift[dim] = -1;
+              }
+              r2 += dx*dx;
+            }
+            if (r2 < rCut2) {
+              bonds.push_back(i);
+              bonds.push_back(j);
+              for (int dim = 0; dim < dimen_; ++dim) {
+                bonds.push_back(shift[dim]);
+              }
             }
           }
-
-          floodFillCell3d_(i, clusterID, rCut);
         }
       }
     }
   }
 }
 
-void Space::prefilClusterVars_() {
-  // prefill cluster vector with -natom() if included and -natom-1 if excluded
-  cluster_.resize(natom());
-  for (int i = 0; i < natom(); ++i) {
-    if (findInList(type_[i], clusterType_)) {
-    //if ( (findInList(type_[i], clusterType_)) || (clusterType_.size() == 0) ) {
-      cluster_[i] = -natom();
-    } else {
-      cluster_[i] = -natom()-1;
+void Space::updateClusters(const double rCut) {
+  prefilClusterVars_();
+  percolation_ = 0;
+
+  // find bonds in parallel, then join them with a disjoint set
+  clusterBonds_(rCut);
+  clusterParent_.resize(natom());
+  clusterRootSize_.assign(natom(), 1);
+  clusterImage_.assign(dimen_*natom(), 0);
+  for (int i = 0; i < natom(); ++i) clusterParent_[i] = i;
+  const int bondSize = 2 + dimen_;
+  for (unsigned int t = 0; t < clusterBondList_.size(); ++t) {
+    const vector<int> &bonds = clusterBondList_[t];
+    for (unsigned int b = 0; b < bonds.size(); b += bondSize) {
+      clusterUnion_(bonds[b], bonds[b + 1], &bonds[b + 2]);
     }
   }
-  clusterMol_.resize(nMol());
-  std::fill(clusterMol_.begin(), clusterMol_.end(), -1);
-  xcluster_ = x_;
-}
 
-void Space::updateClusters(const double rCut) {
-  prefilClusterVars_();
+  // number the clusters in order of their lowest atom, which is also used as
+  // the reference image for unwrapping the cluster in xcluster_
   int nClusters = 0;
+  clusterSeed_.clear();
+  clusterMolAtom_.assign(nMol(), -1);
   for (int i = 0; i < natom(); ++i) {
-    if (cluster_[i] == -natom()) {
-      if ( (cellType_ == 1) && (rCut <= dCellMin()) && (dimen_ == 3) ) {
-        floodFillCell3d_(i, nClusters, rCut);
-      } else {
-        if (dimen_ == 3) {
-          floodFill3d_(i, nClusters, rCut);
-        } else if (dimen_ == 2) {
-          floodFill2d_(i, nClusters, rCut);
-        } else {
-          ASSERT(0, "floodFill algorithm not implemented for dimen:" << dimen_);
+    if (cluster_[i] != -natom()-1) {
+      const int root = clusterFind_(i);
+      if (cluster_[root] < 0) {
+        cluster_[root] = nClusters;
+        clusterSeed_.push_back(i);
+        ++nClusters;
+      }
+      cluster_[i] = cluster_[root];
+      clusterMol_[mol_[i]] = cluster_[i];
+      clusterMolAtom_[mol_[i]] = i;
+    }
+  }
+
+  // shift molecules to the image of their cluster
+  for (int iMol = 0; iMol < nMol(); ++iMol) {
+    const int i = clusterMolAtom_[iMol];
+    if (i != -1) {
+      const int seed = clusterSeed_[cluster_[i]];
+      for (int dim = 0; dim < dimen_; ++dim) {
+        const int image = clusterImage_[dimen_*i + dim]
+                        - clusterImage_[dimen_*seed + dim];
+        if (image != 0) {
+          for (int ipart = mol2part_[iMol]; ipart < mol2part_[iMol+1];
+               ++ipart) {
+            xcluster_[dimen_*ipart + dim] += image*boxLength_[dim];
+          }
         }
       }
-      ++nClusters;
     }
   }
 
@@ -2659,14 +3256,87 @@ void Space::updateClusters(const double rCut) {
   updateClusterVars(nClusters);
 }
 
+vector<int> Space::clusterOfMol(const int iMol, const double rCut) {
+  ASSERT( (iMol >= 0) && (iMol < nMol()), "iMol(" << iMol << ") out of range");
+  xcluster_.resize(x_.size());
+  if (static_cast<int>(clusterOfMolMark_.size()) != nMol()) {
+    clusterOfMolMark_.assign(nMol(), 0);
+  }
+  const bool cell = (cellType_ == 1) && atomCut_ && (dCellMin_ >= rCut);
+  const double rCut2 = rCut*rCut;
+
+  // PBC optimization variables
+  const double lx = boxLength_[0], ly = boxLength_[1],
+    lz = (dimen_ >= 3) ? boxLength_[2] : 0.;
+  const double halflx = lx/2., halfly = ly/2., halflz = lz/2.;
+
+  // the seed is not shifted
+  vector<int> mols(1, iMol);
+  clusterOfMolMark_[iMol] = 1;
+  for (int i = dimen_*mol2part_[iMol]; i < dimen_*mol2part_[iMol+1]; ++i) {
+    xcluster_[i] = x_[i];
+  }
+
+  // grow the cluster from each of its sites in turn
+  double dr[3] = {0., 0., 0.};
+  for (unsigned int im = 0; im < mols.size(); ++im) {
+    const int m = mols[im];
+    for (int ipart = mol2part_[m]; ipart < mol2part_[m+1]; ++ipart) {
+      if ( (clusterType_.size() == 0) ||
+           findInList(type_[ipart], clusterType_) ) {
+        if (cell) {
+          buildNeighListCellAtomCut(ipart);
+        } else {
+          neighListChosen_ = &listAtoms_;
+        }
+        const vector<int> &neigh = *neighListChosen_;
+        for (unsigned int ineigh = 0; ineigh < neigh.size(); ++ineigh) {
+          const int jpart = neigh[ineigh];
+          const int jMol = mol_[jpart];
+          if ( (clusterOfMolMark_[jMol] == 0) &&
+               ( (clusterType_.size() == 0) ||
+                 findInList(type_[jpart], clusterType_) ) ) {
+            for (int dim = 0; dim < dimen_; ++dim) {
+              dr[dim] = x_[dimen_*ipart + dim] - x_[dimen_*jpart + dim];
+            }
+            TRICLINIC_PBC(dr[0], dr[1], dr[2], lx, ly, lz, halflx, halfly,
+                          halflz, xyTilt_, xzTilt_, yzTilt_);
+            if (dr[0]*dr[0] + dr[1]*dr[1] + dr[2]*dr[2] < rCut2) {
+              clusterOfMolMark_[jMol] = 1;
+              mols.push_back(jMol);
+
+              // shift jMol to the image of ipart
+              for (int dim = 0; dim < dimen_; ++dim) {
+                const double shift = xcluster_[dimen_*ipart + dim] - dr[dim]
+                                   - x_[dimen_*jpart + dim];
+                for (int jAtom = mol2part_[jMol]; jAtom < mol2part_[jMol+1];
+                     ++jAtom) {
+                  xcluster_[dimen_*jAtom + dim] = x_[dimen_*jAtom + dim]
+                                                + shift;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+  for (unsigned int im = 0; im < mols.size(); ++im) {
+    clusterOfMolMark_[mols[im]] = 0;
+  }
+  return mols;
+}
+
 void Space::updateClusterVars(const int nClusters) {
   if (!accumulateClusterVars_) return;
   ASSERT(nClusters != 0, "no clusters found. Did you use addTypeForCluster"
     << "function to define clusters? Or is natom(" << natom() << ") == 0?");
   clusterSizes_.resize(nClusters);
   std::fill(clusterSizes_.begin(), clusterSizes_.end(), 0);
-  clusterList_.clear();
-  clusterList_.resize(nClusters);
+
+  // flat list of atoms in each cluster, ordered by cluster then atom index,
+  // with the first atom of cluster ic at clusterListStart_[ic]
+  clusterListStart_.assign(nClusters + 1, 0);
   for (int i = 0; i < natom(); ++i) {
     ASSERT(cluster_[i] != -natom(), "cluster is -natom");
     if (cluster_[i] != -natom()-1) {
@@ -2674,8 +3344,19 @@ void Space::updateClusterVars(const int nClusters) {
     }
     ASSERT(clusterMol_[mol_[i]] != -1,
       "clusterMol[mol[" << i << "]=" << mol_[i] << "]=-1");
-    clusterList_[clusterMol_[mol_[i]]].push_back(i);
+    ++clusterListStart_[clusterMol_[mol_[i]] + 1];
+  }
+  for (int ic = 0; ic < nClusters; ++ic) {
+    clusterListStart_[ic + 1] += clusterListStart_[ic];
+  }
+  clusterListAtoms_.resize(natom());
+  for (int i = 0; i < natom(); ++i) {
+    clusterListAtoms_[clusterListStart_[clusterMol_[mol_[i]]]++] = i;
+  }
+  for (int ic = nClusters; ic > 0; --ic) {
+    clusterListStart_[ic] = clusterListStart_[ic - 1];
   }
+  clusterListStart_[0] = 0;
 
   // accumulate cluster size and number statistics
   clusterSizeAccVec_.accumulate(nMol(), clusterAvSize());
@@ -2821,38 +3502,39 @@ void Space::swapPositions(Space *space) {
   ASSERT(dimen_ == space->dimen(), "dimen(" << dimen() << ") of space id "
     << id_ << " doesn't match dimen(" << space->dimen() << ") of space id "
     << space->id() << ")");
-  vector<double> x = x_;
-  for (unsigned int i = 0; i < x.size(); ++i) {
-    double xtmp = x_[i];
-    x_[i] = space->x_[i];
-    space->x_[i] = xtmp;
-  }
-  vector<double> qMol = qMol_;
-  for (unsigned int i = 0; i < qMol.size(); ++i) {
-    double qMoltmp = qMol_[i];
-    qMol_[i] = space->qMol_[i];
-    space->qMol_[i] = qMoltmp;
-  }
-  vector<vector<vector<double> > > xMolRef = xMolRef_;
-  for (unsigned int i = 0; i < xMolRef.size(); ++i) {
-    for (unsigned int j = 0; j < xMolRef[i].size(); ++j) {
-      for (unsigned int k = 0; k < xMolRef[i][j].size(); ++k) {
-        double xMolReftmp = xMolRef_[i][j][k];
-        xMolRef_[i][j][k] = space->xMolRef_[i][j][k];
-        space->xMolRef_[i][j][k] = xMolReftmp;
-      }
-    }
+  vector<double> &x = xW_(), &xOther = space->xW_();
+  std::swap_ranges(x.begin(), x.end(), xOther.begin());
+  vector<double> &qMol = qMolW_(), &qMolOther = space->qMolW_();
+  std::swap_ranges(qMol.begin(), qMol.end(), qMolOther.begin());
+  std::swap(xMolRefPoolW_(), space->xMolRefPoolW_());
+}
+
+bool Space::copyPositions(const Space &space) {
+  if ( (dimen_ != space.dimen_) || (type_ != space.type_) ||
+       (mol2part_ != space.mol2part_) || (moltype_ != space.moltype_) ||
+       (boxLength_ != space.boxLength_) ||
+       (xyTilt_ != space.xyTilt_) || (xzTilt_ != space.xzTilt_) ||
+       (yzTilt_ != space.yzTilt_) ) {
+    return false;
   }
+  xW_() = space.x_;
+  qMolW_() = space.qMol_;
+  xMolRefPoolW_() = space.xMolRefPool_;
+  if (cellType_ > 0) updateCellofallMol();
+  if (cavityOn()) updateCavityofallMol();
+  return true;
 }
 
-double Space::maxMolDist() {
+double Space::maxMolDist() const {
   double max = 0.;
-  xMolGen();
 
-  // loop through all existing molecules
-  for (unsigned int i = 0; i < xMol_.size(); ++i) {
-    for (unsigned int j = 1; j < xMol_[i].size(); ++j) {
-      const double r2 = rsq(xMol_[i][0], xMol_[i][j]);
+  // loop through all existing molecules, from their first atom
+  int first = 0;
+  for (int iAtom = 1; iAtom < natom(); ++iAtom) {
+    if (mol_[iAtom] != mol_[first]) {
+      first = iAtom;
+    } else {
+      const double r2 = rsqAtoms_(first, iAtom);
       if (r2 > max) max = r2;
     }
   }
@@ -2907,7 +3589,7 @@ void Space::transMol(const int iMol,    //!< molecule to translate
   for (unsigned int i = 0; i < mpart.size(); ++i) {
     const int ipart = mpart[i];
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*ipart+dim] += r[dim];
+      xW_(ipart)[dim] += r[dim];
     }
   }
 
@@ -2948,6 +3630,17 @@ vector<double> Space::rcom(const vector<int> mpart) {
   return rcom;
 }
 
+vector<vector<int> > Space::clusterList() const {
+  vector<vector<int> > clusterList;
+  if (clusterListStart_.size() == 0) return clusterList;
+  clusterList.resize(clusterListStart_.size() - 1);
+  for (unsigned int ic = 0; ic < clusterList.size(); ++ic) {
+    clusterList[ic].assign(clusterListAtoms_.begin() + clusterListStart_[ic],
+                           clusterListAtoms_.begin() + clusterListStart_[ic+1]);
+  }
+  return clusterList;
+}
+
 vector<int> Space::mpart2mmol(const vector<int> mpart) {
   vector<int> molList;
   int iMolPrev = -1;
@@ -3002,7 +3695,7 @@ void Space::printClusterStat(const char* fileName) {
 void Space::xClusterGen() {
   xcluster_ = x_;
   for (int ic = 0; ic < nClusters(); ++ic) {
-    const int iMol = mol_[clusterList_[ic][0]];
+    const int iMol = mol_[clusterListAtoms_[clusterListStart_[ic]]];
     const int ipart = mol2part_[iMol];
     for (int jMol = 0; jMol < nMol(); ++jMol) {
       if ( (jMol != iMol) && (clusterMol_[jMol] == ic) ) {
@@ -3030,12 +3723,13 @@ void Space::xClusterShape() {
 
   // loop through each cluster
   for (int ic = 0; ic < nClusters(); ++ic) {
-    const int cSize = static_cast<int>(clusterList_[ic].size());
+    const int cSize = clusterListStart_[ic+1] - clusterListStart_[ic];
+    const int *clusterAtoms = &clusterListAtoms_[clusterListStart_[ic]];
 
     // find the COM of cluster
     vector<double> xcCOM(dimen_, 0.);
     for (int j = 0; j < cSize; ++j) {
-      const int ipart = clusterList_[ic][j];
+      const int ipart = clusterAtoms[j];
       for (int dim = 0; dim < dimen_; ++dim) {
         xcCOM[dim] += xcluster_[dimen_*ipart + dim] /
           static_cast<double>(cSize);
@@ -3043,27 +3737,25 @@ void Space::xClusterShape() {
     }
 
     // compute the gyration tensor of cluster
-    vector<vector<double> > xcGy(dimen_, vector<double>(dimen_, 0.));
+    ASSERT(dimen_ == 3,
+      "asphericity computation assumes dim(" << dimen_ << ") = 3");
+    double xcGy[9] = {0.};
     for (int j = 0; j < cSize; ++j) {
-      const int ipart = clusterList_[ic][j];
+      const int ipart = clusterAtoms[j];
       for (int idim = 0; idim < dimen_; ++idim) {
         const double xi = xcluster_[dimen_*ipart + idim] - xcCOM[idim];
         for (int jdim = 0; jdim < dimen_; ++jdim) {
           const double xj = xcluster_[dimen_*ipart + jdim] - xcCOM[jdim];
-          xcGy[idim][jdim] += xi*xj / static_cast<double>(cSize);
+          xcGy[dimen_*idim + jdim] += xi*xj / static_cast<double>(cSize);
         }
       }
     }
 
-
     // find eigenvalues of gyration tensor
     vector<double> evalues(dimen_);
-    vector<vector<double> > evectors(dimen_, vector<double>(dimen_));
-    ASSERT(0, "implement eigen value and eigen vector calculation");
+    symEigenvalues3(xcGy, &evalues[0]);
 
     // compute the shape parameters
-    ASSERT(dimen_ == 3,
-      "asphericity computation assumes dim(" << dimen_ << ") = 3");
     std::sort(evalues.begin(), evalues.end());
     const double lx2 = evalues[0];
     const double ly2 = evalues[1];
@@ -3113,7 +3805,7 @@ int Space::readXTC(const char* fileName,
   }
   for (int i = 0; i < natom(); ++i) {
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*i+dim] = x_xtc[i][dim];
+      xW_(i)[dim] = x_xtc[i][dim];
     }
   }
 
@@ -3180,6 +3872,7 @@ void Space::setAtomInSphere(const int iAtom, const int jAtom, const double r) {
     xset(x(jAtom, dim)+xnew[dim], iAtom, dim);
   }
   if (cellType_ != 0) updateCellofiMol(mol_[iAtom]);
+  if (cavityOn()) updateCavityofiMol(mol_[iAtom]);
 }
 
 void Space::setAtomInCircle(
@@ -3217,6 +3910,7 @@ void Space::setAtomInCircle(
   }
 
   if (cellType_ != 0) updateCellofiMol(mol_[iAtom]);
+  if (cavityOn()) updateCavityofiMol(mol_[iAtom]);
 }
 
 void Space::modBondAngle(const int iAtom, const int jAtom, const int kAtom,
@@ -3251,6 +3945,7 @@ void Space::modBondAngle(const int iAtom, const int jAtom, const int kAtom,
 
   // update cell list
   if (cellType_ != 0) updateCellofiMol(mol_[iAtom]);
+  if (cavityOn()) updateCavityofiMol(mol_[iAtom]);
 
   // update qMol_ and xMolRef_ (but not xMol_)
   qMolInit(mol_[iAtom]);
@@ -3260,7 +3955,7 @@ void Space::modBondAngle(const int angleType, const double theta,
   const char* molType) {
   // update angle parameters
   string molTypeStr(molType);
-  shared_ptr<Space> s = findAddMolInList(molTypeStr);
+  shared_ptr<Space> s = addMolListOwned_(molTypeStr);
   s->qMolInit();
   s->modAngleParams(angleType, 1, theta);
 
@@ -3348,6 +4043,7 @@ void Space::setAtomInBranch(const int a1, const int a2, const int a3,
   xset(L*y3+x(a4, 1), a3, 1);
   xset(L*z3+x(a4, 2), a3, 2);
   if (cellType_ != 0) updateCellofiMol(mol_[a1]);
+  if (cavityOn()) updateCavityofiMol(mol_[a1]);
 }
 
 vector<double> Space::bondParams(const int iAtom, const int jAtom) {
@@ -3574,7 +4270,7 @@ void Space::solveBranch_(const double x1, const double y1, const double z1,
 void Space::pivotMol(const int iMol, const vector<double> r) {
   for (int iAtom = mol2part_[iMol]; iAtom < mol2part_[iMol+1]; ++iAtom) {
     for (int dim = 0; dim < dimen_; ++dim) {
-      x_[dimen_*iAtom+dim] = 2*r[dim] - x_[dimen_*iAtom+dim];
+      xW_(iAtom)[dim] = 2*r[dim] - x_[dimen_*iAtom+dim];
     }
   }
 
@@ -3656,14 +4352,7 @@ void Space::scaleDomain(const double factor, const int dim) {
     "factor(" << factor << ") in scaleDomain cannot be negative");
 
   // scale the box subject to bounds
-  double factorActual = factor;
-  if (maxlFlag_ != 0) {
-    // check that the box isn't scaled beyond limits
-    const double lNew = boxLength_[dim]*factor;
-    if (lNew > maxl_[dim]) {
-      factorActual = maxl_[dim]/boxLength_[dim];
-    }
-  }
+  const double factorActual = boundScaleFactor(factor, dim);
   initBoxLength(boxLength_[dim]*factorActual, dim);
 
   // loop through each molecule, and scale based on the position
@@ -3672,11 +4361,30 @@ void Space::scaleDomain(const double factor, const int dim) {
   for (int iMol = 0; iMol < nMol(); ++iMol) {
     const double dx = (factorActual - 1.)*x(mol2part_[iMol], dim);
     for (int iAtom = mol2part_[iMol]; iAtom < mol2part_[iMol+1]; ++iAtom) {
-      x_[dimen_*iAtom + dim] += dx;
+      xW_(iAtom)[dim] += dx;
     }
   }
 
   if (cellType() > 0) updateCells();
+  if (cavityOn()) initCavity(cavityRCut_, cavityNStencil_);
+}
+
+double Space::boundScaleFactor(const double factor, const int dim) const {
+  if (maxlFlag_ != 0) {
+    // check that the box isn't scaled beyond limits
+    const double lNew = boxLength_[dim]*factor;
+    if (lNew > maxl_[dim]) {
+      return maxl_[dim]/boxLength_[dim];
+    }
+  }
+  return factor;
+}
+
+double Space::boundTilt(const double tilt, const int dim) const {
+  const double maxPercBox = 0.25;
+  if (tilt >  maxPercBox*boxLength_[dim]) return  maxPercBox*boxLength_[dim];
+  if (tilt < -maxPercBox*boxLength_[dim]) return -maxPercBox*boxLength_[dim];
+  return tilt;
 }
 
 void Space::avb(const int iAtom, const int jAtom, const double rAbove,
@@ -3712,64 +4420,228 @@ void Space::avb(const int iAtom, const int jAtom, const double rAbove,
   xset(iAtom, xnew);
 }
 
-double Space::Q6(const double rCut) {
-  xMolGen();
-  vector<double> rij(3);
-  vector<std::complex<double> > sphH(13);
-  int nBond = 0;
-  for (int iMol = 0; iMol < nMol()-1; ++iMol) {
-    const vector<double> xi = xMol()[iMol][0];
-    for (int jMol = iMol+1; jMol < nMol(); ++jMol) {
-      const vector<double> xj = xMol()[jMol][0];
-      for (int dim = 0; dim < dimen(); ++dim) {
-        rij[dim] = xi[dim] - xj[dim];
+void Space::bondOrder(const double rCut) {
+  const int nMols = nMol();
+  const double rCut2 = rCut*rCut;
+
+  // bin the first atom of each molecule into cells at least as wide as rCut,
+  // or use a single cell if the domain is tilted or too small
+  int nCellVec[3] = {1, 1, 1};
+  bool useCells = (rCut > 0) && (!tilted());
+  for (int dim = 0; dim < dimen_; ++dim) {
+    if (useCells) nCellVec[dim] = static_cast<int>(boxLength_[dim]/rCut);
+    if (nCellVec[dim] < 3) useCells = false;
+  }
+  if (!useCells) nCellVec[0] = nCellVec[1] = nCellVec[2] = 1;
+  const int nCell = nCellVec[0]*nCellVec[1]*nCellVec[2];
+  vector<int> cellOfMol(nMols);
+  bondOrderCellStart_.assign(nCell + 1, 0);
+  for (int iMol = 0; iMol < nMols; ++iMol) {
+    int cell = 0;
+    for (int dim = dimen_ - 1; dim >= 0; --dim) {
+      double f = x_[dimen_*mol2part_[iMol] + dim]/boxLength_[dim] + 0.5;
+      f -= floor(f);
+      const int c = std::min(static_cast<int>(f*nCellVec[dim]),
+                             nCellVec[dim] - 1);
+      cell = cell*nCellVec[dim] + c;
+    }
+    cellOfMol[iMol] = cell;
+    ++bondOrderCellStart_[cell + 1];
+  }
+  for (int cell = 0; cell < nCell; ++cell) {
+    bondOrderCellStart_[cell + 1] += bondOrderCellStart_[cell];
+  }
+  bondOrderCellMols_.resize(nMols);
+  {
+    vector<int> fill(bondOrderCellStart_.begin(), bondOrderCellStart_.end()-1);
+    for (int iMol = 0; iMol < nMols; ++iMol) {
+      bondOrderCellMols_[fill[cellOfMol[iMol]]++] = iMol;
+    }
+  }
+  const int nNeighCell = (useCells ? ( (dimen_ == 3) ? 27 : 9) : 1);
+
+  // Wigner 3j symbols of w6, indexed by [(m1+6)*13 + m2+6]
+  static const vector<double> w3j = [] {
+    vector<double> w(13*13);
+    for (int m1 = -6; m1 <= 6; ++m1) {
+      for (int m2 = -6; m2 <= 6; ++m2) {
+        w[(m1 + 6)*13 + m2 + 6] = wigner3j(6, 6, 6, m1, m2, -m1 - m2);
+      }
+    }
+    return w;
+  }();
+
+  // the third box length only exists in 3D
+  const double lz = (dimen_ == 3) ? boxLength_[2] : 0.;
+  bondOrderQ4_.resize(nMols);
+  bondOrderQ6_.resize(nMols);
+  bondOrderW6_.resize(nMols);
+  bondOrderNeigh_.resize(nMols);
+  double q6mGlobalRe[7] = {0.}, q6mGlobalIm[7] = {0.};
+  long long nBondTwice = 0;
+  #ifdef _OPENMP
+  #pragma omp parallel
+  #endif  // _OPENMP
+  {
+    double y4re[5], y4im[5], y6re[7], y6im[7], q4re[5], q4im[5], q6re[7],
+           q6im[7], q6mRe[7] = {0.}, q6mIm[7] = {0.}, rij[3] = {0., 0., 0.};
+    long long nBondThread = 0;
+    #ifdef _OPENMP
+    #pragma omp for schedule(dynamic, 64)
+    #endif  // _OPENMP
+    for (int iMol = 0; iMol < nMols; ++iMol) {
+      const int iPart = mol2part_[iMol];
+      for (int m = 0; m < 5; ++m) q4re[m] = q4im[m] = 0.;
+      for (int m = 0; m < 7; ++m) q6re[m] = q6im[m] = 0.;
+      int nNeigh = 0;
+      const int iCell = cellOfMol[iMol];
+      const int icx = iCell % nCellVec[0],
+                icy = (iCell/nCellVec[0]) % nCellVec[1],
+                icz = iCell/(nCellVec[0]*nCellVec[1]);
+      for (int s = 0; s < nNeighCell; ++s) {
+        int jCell = iCell;
+        if (useCells) {
+          const int jcx = (icx + s % 3 - 1 + nCellVec[0]) % nCellVec[0],
+                    jcy = (icy + (s/3) % 3 - 1 + nCellVec[1]) % nCellVec[1],
+                    jcz = (icz + s/9 - ( (dimen_ == 3) ? 1 : 0)
+                           + nCellVec[2]) % nCellVec[2];
+          jCell = (jcz*nCellVec[1] + jcy)*nCellVec[0] + jcx;
+        }
+        for (int jj = bondOrderCellStart_[jCell];
+             jj < bondOrderCellStart_[jCell + 1]; ++jj) {
+          const int jMol = bondOrderCellMols_[jj];
+          if (jMol != iMol) {
+            const int jPart = mol2part_[jMol];
+            for (int dim = 0; dim < dimen_; ++dim) {
+              rij[dim] = x_[dimen_*iPart + dim] - x_[dimen_*jPart + dim];
+            }
+            pbc(&rij[0], &rij[1], &rij[2], boxLength_[0], boxLength_[1], lz);
+            const double r2 = rij[0]*rij[0] + rij[1]*rij[1] + rij[2]*rij[2];
+            if (r2 < rCut2) {
+              sphericalHarmonics(4, rij, y4re, y4im);
+              sphericalHarmonics(6, rij, y6re, y6im);
+              for (int m = 0; m < 5; ++m) {
+                q4re[m] += y4re[m];
+                q4im[m] += y4im[m];
+              }
+              for (int m = 0; m < 7; ++m) {
+                q6re[m] += y6re[m];
+                q6im[m] += y6im[m];
+              }
+              ++nNeigh;
+            }
+          }
+        }
       }
-      const vector<double> dx = pbc(rij);
-      for (int dim = 0; dim < dimen(); ++dim) {
-        rij[dim] += dx[dim];
+
+      // global sums over bonds, and local parameters from the averages
+      for (int m = 0; m < 7; ++m) {
+        q6mRe[m] += q6re[m];
+        q6mIm[m] += q6im[m];
       }
-      const double r2 = vecDotProd(rij, rij);
-      if (r2 < rCut*rCut) {
-        const vector<std::complex<double> > sphHTmp = cart2sphereHarm6(rij);
-        for (unsigned int i = 0; i < sphH.size(); ++i) {
-          sphH[i] += sphHTmp[i];
+      nBondThread += nNeigh;
+      bondOrderNeigh_[iMol] = nNeigh;
+      double q4norm = 0., q6norm = 0., w6 = 0.;
+      if (nNeigh > 0) {
+        // sum |q_lm|^2 over m = -l, ..., l from m >= 0
+        for (int m = 0; m < 5; ++m) {
+          q4norm += ( (m == 0) ? 1. : 2.)*(q4re[m]*q4re[m] + q4im[m]*q4im[m]);
+        }
+        for (int m = 0; m < 7; ++m) {
+          q6norm += ( (m == 0) ? 1. : 2.)*(q6re[m]*q6re[m] + q6im[m]*q6im[m]);
+        }
+
+        // w6 = sum over m1 + m2 + m3 = 0 of 3j * q6m1 q6m2 q6m3 / |q6|^3
+        std::complex<double> q6m[13];
+        for (int m = 0; m <= 6; ++m) {
+          q6m[6 + m] = std::complex<double>(q6re[m], q6im[m]);
+          q6m[6 - m] = ( (m % 2 == 0) ? 1. : -1.)*std::conj(q6m[6 + m]);
+        }
+        std::complex<double> w(0., 0.);
+        for (int m1 = -6; m1 <= 6; ++m1) {
+          for (int m2 = std::max(-6, -6 - m1); m2 <= std::min(6, 6 - m1);
+               ++m2) {
+            w += w3j[(m1 + 6)*13 + m2 + 6]*q6m[6 + m1]*q6m[6 + m2]
+                *q6m[6 - m1 - m2];
+          }
         }
-        ++nBond;
+        w6 = w.real()/pow(q6norm, 1.5);
+        const double nNeighInv = 1./static_cast<double>(nNeigh);
+        q4norm *= nNeighInv*nNeighInv;
+        q6norm *= nNeighInv*nNeighInv;
       }
+      bondOrderQ4_[iMol] = sqrt(4.*PI/9.*q4norm);
+      bondOrderQ6_[iMol] = sqrt(4.*PI/13.*q6norm);
+      bondOrderW6_[iMol] = w6;
+    }
+    #ifdef _OPENMP
+    #pragma omp critical
+    #endif  // _OPENMP
+    {
+      for (int m = 0; m < 7; ++m) {
+        q6mGlobalRe[m] += q6mRe[m];
+        q6mGlobalIm[m] += q6mIm[m];
+      }
+      nBondTwice += nBondThread;
     }
   }
-  for (unsigned int i = 0; i < sphH.size(); ++i) {
-    sphH[i] /= static_cast<double>(nBond);
+
+  // global Q6 from the average over all bonds
+  double q6norm = 0.;
+  if (nBondTwice > 0) {
+    for (int m = 0; m < 7; ++m) {
+      q6norm += ( (m == 0) ? 1. : 2.)*(q6mGlobalRe[m]*q6mGlobalRe[m]
+                                     + q6mGlobalIm[m]*q6mGlobalIm[m]);
+    }
+    q6norm /= static_cast<double>(nBondTwice)*static_cast<double>(nBondTwice);
   }
-  return sqrt(4*PI/13.*complexVec2norm(sphH));
+  bondOrderQ6Global_ = sqrt(4.*PI/13.*q6norm);
 }
 
 void Space::setXYTilt(const double xyTilt) {
   ASSERT(xyTilt <= boxLength_[0], "the xyTilt(" << xyTilt << ") cannot be"
     << "larger than the box(" << boxLength_[0] << ")");
   xyTilt_ = xyTilt;
+  updateCellsTilt_();
 }
 
 void Space::setXZTilt(const double xzTilt) {
   ASSERT(xzTilt <= boxLength_[0], "the xzTilt(" << xzTilt << ") cannot be"
     << "larger than the box(" << boxLength_[0] << ")");
   xzTilt_ = xzTilt;
+  updateCellsTilt_();
 }
 
 void Space::setYZTilt(const double yzTilt) {
   ASSERT(yzTilt <= boxLength_[1], "the yzTilt(" << yzTilt << ") cannot be"
     << "larger than the box(" << boxLength_[1] << ")");
   yzTilt_ = yzTilt;
+  updateCellsTilt_();
+}
+
+void Space::updateCellsTilt_() {
+  if (cellType_ == 1) {
+    bool valid = true;
+    for (int dim = 0; dim < dimen_; ++dim) {
+      if (boxHeight(dim) < nCellVec_[dim]*dCellMin_) valid = false;
+    }
+    if (valid) {
+      for (int dim = 0; dim < dimen_; ++dim) {
+        dCell_[dim] = boxHeight(dim)/static_cast<double>(nCellVec_[dim]);
+      }
+      updateCellofallMol();
+    } else {
+      updateCells(dCellMin_);
+    }
+  }
+
+  // the number of cavity cells depends on the heights of the domain
+  if (cavityOn()) initCavity(cavityRCut_, cavityNStencil_);
 }
 
 void Space::modXYTilt(const double deltaXYTilt) {
   const double xyTiltOld = xyTilt_;
-  xyTilt_ += deltaXYTilt;
-
-  // limit xyTilt to some percentage of the box
-  const double maxPercBox = 0.25;
-  if (xyTilt_ >  maxPercBox*boxLength_[0]) xyTilt_ =  maxPercBox*boxLength_[0];
-  if (xyTilt_ < -maxPercBox*boxLength_[0]) xyTilt_ = -maxPercBox*boxLength_[0];
+  xyTilt_ = boundTilt(xyTilt_ + deltaXYTilt, 0);
 
   // transform the particles, based on the position of the first site
   // of each 'molecule'
@@ -3781,16 +4653,12 @@ void Space::modXYTilt(const double deltaXYTilt) {
       xset(x(iAtom, 0) + dx, iAtom, 0);
     }
   }
+  updateCellsTilt_();
 }
 
 void Space::modXZTilt(const double deltaXZTilt) {
   const double xzTiltOld = xzTilt_;
-  xzTilt_ += deltaXZTilt;
-
-  // limit xzTilt to some percentage of the box
-  const double maxPercBox = 0.25;
-  if (xzTilt_ >  maxPercBox*boxLength_[0]) xzTilt_ =  maxPercBox*boxLength_[0];
-  if (xzTilt_ < -maxPercBox*boxLength_[0]) xzTilt_ = -maxPercBox*boxLength_[0];
+  xzTilt_ = boundTilt(xzTilt_ + deltaXZTilt, 0);
 
   // transform the particles, based on the position of the first site
   // of each 'molecule'
@@ -3802,16 +4670,12 @@ void Space::modXZTilt(const double deltaXZTilt) {
       xset(x(iAtom, 0) + dx, iAtom, 0);
     }
   }
+  updateCellsTilt_();
 }
 
 void Space::modYZTilt(const double deltaYZTilt) {
   const double yzTiltOld = yzTilt_;
-  yzTilt_ += deltaYZTilt;
-
-  // limit yzTilt to some percentage of the box
-  const double maxPercBox = 0.25;
-  if (yzTilt_ >  maxPercBox*boxLength_[1]) yzTilt_ =  maxPercBox*boxLength_[1];
-  if (yzTilt_ < -maxPercBox*boxLength_[1]) yzTilt_ = -maxPercBox*boxLength_[1];
+  yzTilt_ = boundTilt(yzTilt_ + deltaYZTilt, 1);
 
   // transform the particles, based on the position of the first site
   // of each 'molecule'
@@ -3823,21 +4687,18 @@ void Space::modYZTilt(const double deltaYZTilt) {
       xset(x(iAtom, 1) + dx, iAtom, 1);
     }
   }
+  updateCellsTilt_();
 }
 
-double Space::minBondLength() {
+double Space::minBondLength() const {
   double min = 1e50;
-  xMolGen();
 
-  // loop through all existing molecules
-  for (unsigned int iMol = 0; iMol < xMol_.size(); ++iMol) {
-    for (unsigned int iPart = 0; iPart < xMol_[iMol].size(); ++iPart) {
-      for (unsigned int jPart = 0; jPart < xMol_[iMol].size(); ++jPart) {
-        if (iPart != jPart) {
-          const double r2 = rsq(xMol_[iMol][iPart], xMol_[iMol][jPart]);
-          if (r2 < min) min = r2;
-        }
-      }
+  // loop through all pairs of atoms in existing molecules
+  for (int iAtom = 0; iAtom < natom(); ++iAtom) {
+    for (int jAtom = iAtom + 1;
+         (jAtom < natom()) && (mol_[jAtom] == mol_[iAtom]); ++jAtom) {
+      const double r2 = rsqAtoms_(iAtom, jAtom);
+      if (r2 < min) min = r2;
     }
   }
 
@@ -3934,14 +4795,18 @@ void Space::swapPositions(const int iMol, const int jMol) {
     const double dx = x_[dimen_*mol2part_[iMol]+dim]
                     - x_[dimen_*mol2part_[jMol]+dim];
     for (int iatom = mol2part_[iMol]; iatom < mol2part_[iMol+1]; ++iatom) {
-      x_[dimen_*iatom+dim] -= dx;
+      xW_(iatom)[dim] -= dx;
     }
     for (int iatom = mol2part_[jMol]; iatom < mol2part_[jMol+1]; ++iatom) {
-      x_[dimen_*iatom+dim] += dx;
+      xW_(iatom)[dim] += dx;
     }
   }
   if (cellType_ > 0) updateCellofiMol(iMol);
   if (cellType_ > 0) updateCellofiMol(jMol);
+  if (cavityOn()) {
+    updateCavityofiMol(iMol);
+    updateCavityofiMol(jMol);
+  }
 }
 
 void Space::printxyzvmd(const char* fileName, const int initFlag) {
@@ -4014,7 +4879,7 @@ void Space::initJSONData(
       stringstream ss;
       ss << "dim" << dim;
       const double x = j["atoms"][i][ss.str().c_str()];
-      x_.push_back(x);
+      xW_().push_back(x);
     }
     const int imol = j["atoms"][i]["mol"];
     mol_.push_back(imol - 1);
@@ -4133,17 +4998,16 @@ void Space::replicate(const int nx, const int ny, const int nz) {
             // positions
             xset(x(ipart, dim) + lshift[dim]*boxOrig[dim], ipartBig, dim);
 
-            // reference positions
-            if (!sphereSymMol_) {
-              const int iAtom = ipart - mol2part_[iMol];
-              xMolRef_[iMolBig][iAtom][dim] = xMolRef_[iMol][iAtom][dim];
-            }
           }
           ++ipartBig;
         }
 
-        // orientations
+        // share reference positions and orientations
         if (!sphereSymMol_) {
+          MolRefPool_ &pool = xMolRefPoolW_();
+          xMolRefRelease_(pool.id[iMolBig]);
+          pool.id[iMolBig] = pool.id[iMol];
+          ++pool.count[pool.id[iMol]];
           for (int qd = 0; qd < qdim_; ++qd) {
             qMolAlt(iMolBig, qd, qMol(iMol, qd));
           }
@@ -4155,7 +5019,7 @@ void Space::replicate(const int nx, const int ny, const int nz) {
 }
 
 void Space::pbc(double * dx, double * dy, double * dz,
-                const double &lx, const double &ly, const double &lz) {
+                const double &lx, const double &ly, const double &lz) const {
   if (dimen_ >= 3) {
     if (fabs(*dz) > 0.5*lz) {
       if (*dz < 0.) {
@@ -18,6 +18,7 @@
 #include "./functions.h"
 #include "./histogram.h"
 #include "./base_random.h"
+#include "./profile.h"
 #ifdef XDRFILE_H_
   extern "C" {
     #include "xdrfile.h"
@@ -54,7 +55,8 @@ class Space : public BaseRandom {
 
   /** Return a deep copy of self. Note that this pointer was constructed with
    *  the "new" directive, which means that it requires a subsequent delete to
-   *  avoid a memory leak. */
+   *  avoid a memory leak. The reference molecules of addMolList are
+   *  read-only, and are shared with the clone until modified. */
   Space* clone() const;
 
   /** Return a deep copy of self as shared pointer with automated memory
@@ -114,14 +116,14 @@ class Space : public BaseRandom {
   /** Return the change in position according to periodic boundary conditions.
    *  Assumes box centered about the origin, and that the particle only
    *  needs be wrapped once. */
-  vector<double> pbc(const vector<double> x);
+  vector<double> pbc(const vector<double> x) const;
 
   /** Modify the separation distances due to minimum periodic images
    *  Assumes box centered about the origin, and that the particle only
    *  needs be wrapped once.
    *  This is the "optimized" version used by pairLoop */
   void pbc(double * dx, double * dy, double * dz,
-           const double &lx, const double &ly, const double &lz);
+           const double &lx, const double &ly, const double &lz) const;
 
   /// Return random molecule as vector of particle numbers.
   vector<int> randMol();
@@ -142,16 +144,24 @@ class Space : public BaseRandom {
 
   /** Stores position of particles listed in mpart, and also orientations
    *  if not spherically symmetric. */
-  void xStore(const vector<int> mpart);
+  void xStore(const vector<int> &mpart);
 
-  /// Store position and orientation of all particles.
+  /** Open a copy-on-write journal to restore all particles. Positions are
+   *  saved per atom, and orientations and reference positions all at once,
+   *  the first time they are modified before the next restoreAll(),
+   *  xStore(), xStoreMols() or xStoreMulti(). */
   void xStoreAll();
 
+  /** Store the positions, orientations and reference positions of the
+   *  molecules in mols, which may be more than one, at a cost in proportion
+   *  to their number of particles (e.g., for cluster moves). */
+  void xStoreMols(const vector<int> &mols);
+
   /** Store position of particles listed in mpart, and also orientations if
    *  not spherically symmetric. But for Multi implementation, store multiple
    *  instances of the coordinates before writing over them (e.g., for use
    *  with configurational bias). */
-  void xStoreMulti(const vector<int> mpart,
+  void xStoreMulti(const vector<int> &mpart,
     /** if flag == -1, clear all previous stores, then store particles in mpart
      * if flag == -2, store another mpart
      * if flag == positive integer, restore mpart particles from the 'index'th
@@ -160,19 +170,22 @@ class Space : public BaseRandom {
 
   /** Restore list of particles, mpart, to the positions and orientations
    *  when the last xStore() was called. */
-  void restore(const vector<int> mpart);
+  void restore(const vector<int> &mpart);
 
   /** Restore all particles to positions and orientations when last xStore()
    * was called. */
   void restoreAll();
 
+  /// Restore the molecules in mols, as stored by the last xStoreMols().
+  void restoreMols(const vector<int> &mols);
+
   /// Set particle iPart to position "pos".
-  void xset(double pos, int iPart, int dim) {x_[iPart*dimen_+dim] = pos; }
+  void xset(double pos, int iPart, int dim) { xW_(iPart)[dim] = pos; }
 
   /// Set particle iPart to position "pos".
   void xset(const int iPart, vector<double> pos)
     {for (int j = 0; j < static_cast<int>(pos.size()); ++j)
-      x_[dimen_*iPart+j] = pos[j]; }
+      xW_(iPart)[j] = pos[j]; }
 
   /// Set length of domain boundary to "boxl" in given dimension.
   void initBoxLength(double length, int dimension) {
@@ -226,6 +239,26 @@ class Space : public BaseRandom {
   /// Alternative addMol for index of order of addMolInits.
   void addMol(const int index = 0) { addMol(addMolListType_[index].c_str()); }
 
+  /**
+   * Generate a ghost molecule of the given type, with its first site at
+   * xFirst and a random orientation, without adding it to Space.
+   * The energy of the ghost may be computed with Pair::ghostEner, and the
+   * ghost may be added to Space with the same pose by addGhostMol.
+   */
+  void initGhostMol(const char* type, const vector<double> &xFirst);
+
+  /// Add the ghost molecule to Space with the pose given by initGhostMol.
+  void addGhostMol();
+
+  /// Return the positions of the ghost sites, ghostX()[dimen*site + dim].
+  const vector<double>& ghostX() const { return ghostX_; }
+
+  /// Return the types of the ghost sites.
+  const vector<int>& ghostType() const { return ghostType_; }
+
+  /// Return the molecule type of the ghost.
+  string ghostMolType() const { return ghostMolType_; }
+
   /** Returns whether or not fast deletion method is applicable.
    *  Use a faster delete method if molecule of same type was the last
    *  molecule to be added.is at the by putting last molecule where mpart
@@ -290,9 +323,18 @@ class Space : public BaseRandom {
            const double rBelow, const char* region);
 
   /// Return squared distance between two points subject to PBCs.
-  double rsq(const vector<double> xi, const vector<double> xj);
+  double rsq(const vector<double> xi, const vector<double> xj) const;
 
-  /// Initialize cells in cell list
+  /**
+   * Initialize cells in cell list. The cells are in fractional coordinates of
+   * the domain, such that the cell list remains valid for tilted domains.
+   * The number of cells in each dimension is based on the perpendicular
+   * width of the domain (boxHeight), such that the perpendicular width of
+   * each cell is at least dCellMin.
+   * If the tilt factors change, the cells are updated incrementally, and only
+   * rebuilt if a perpendicular width of the cells falls below dCellMin.
+   * For tilted domains, dCellMin must not be less than rCut.
+   */
   void updateCells(const double dCellMin,  //!< minimm cell size
     /// maximum cutoff radius for interactions
     const double rCut);
@@ -320,6 +362,10 @@ class Space : public BaseRandom {
   /// Generate neighbor list for particle ipart from cell list by atom cuttoff.
   void buildNeighListCellAtomCut(const int ipart);
 
+  /// Generate neighbor list for a position, r, which need not be a site in
+  /// Space, from cell list by atom cutoff.
+  void buildNeighListCellPosition(const double *r);
+
   void cellOff();                             //!< Turn off cell list.
   void updateCellofiMol(const int iMol);      //!< Updates cell for iMol.
   void updateCellofallMol();                  //!< Updates cell for all mols.
@@ -327,9 +373,59 @@ class Space : public BaseRandom {
   /// Return 1 if no errors found in cell list.
   int checkCellList();
 
+  /**
+   * Return 1 if no errors found in a sample of the cell list, without
+   * rebuilding it. Every entry of the cell list must agree with the cell of
+   * its molecule (or site), and the cell of each molecule in mols (or each of
+   * its sites) must agree with its position.
+   */
+  int checkCellListSample(const vector<int> &mols);
+
   /// Initialize cut-off method for cell list.
   void initAtomCut(const int flag);
 
+  /** Maintain a grid of cavity cells, in fractional coordinates of the
+   *  domain, for cavity-biased insertion. Each site is counted by all cells
+   *  within nStencil cells of its own, and a cell is a cavity when its count
+   *  is zero. The cells are no narrower than rCav/nStencil, such that every
+   *  point in a cavity is at least rCav from all sites.
+   *  The grid is updated incrementally as molecules are added, deleted or
+   *  moved by trials, and rebuilt when the domain is scaled or tilted.
+   *  Other changes of positions require updateCavityofiMol or
+   *  updateCavityofallMol. */
+  void initCavity(const double rCav, const int nStencil = 2);
+
+  /// Return true if the cavity grid is maintained.
+  bool cavityOn() const { return cavityRCut_ > 0; }
+
+  /// Return the number of cavity cells.
+  int nCavity() const { return static_cast<int>(cavityEmpty_.size()); }
+
+  /// Return the volume of one cell of the cavity grid.
+  double cavityCellVolume() const {
+    return volume()/static_cast<double>(cavityCount_.size()); }
+
+  /// Return a random position, uniformly within a random cavity cell.
+  vector<double> randCavityPosition();
+
+  /** Return the number of cavity cells if the sites in mpart were removed,
+   *  and whether the first site in mpart would then be in a cavity. */
+  int nCavityWithout(const vector<int> &mpart, bool *inCavity) const;
+
+  void updateCavityofiMol(const int iMol);   //!< Updates cavity for iMol.
+  void updateCavityofallMol();               //!< Updates cavity for all mols.
+
+  /// Return 1 if the cavity grid matches a grid built from scratch.
+  int checkCavity();
+
+  /// Return the distance between opposite faces of the domain for dimension.
+  double boxHeight(const int dim) const {
+    return boxHeight(dim, boxLength_, xyTilt_, xzTilt_, yzTilt_); }
+
+  /// As above, but for a domain with the given box lengths and tilt factors.
+  double boxHeight(const int dim, const vector<double> &boxLength,
+    const double xyTilt, const double xzTilt, const double yzTilt) const;
+
   /* Position of origin to add next molecule called by addMol().
    * By default, xAdd is NULL which results in a random position. */
   vector<double> xAdd;
@@ -345,11 +441,19 @@ class Space : public BaseRandom {
   /// Update current positions of molecule iMol using quaternions.
   void quat2pos(const int iMol);
 
-  /// Update current positions of molecules imMol using quaternions.
-  void quat2pos(const vector<int> imMol) {
+  /// Update current positions of molecules imMol using quaternions, as
+  /// for collective moves of many rigid molecules.
+  void quat2pos(const vector<int> &imMol) {
     for (unsigned int i = 0; i < imMol.size(); ++i) quat2pos(imMol[i]);
   }
 
+  /// Update current positions of all molecules using quaternions.
+  void quat2posAll() {
+    if (!sphereSymMol_) {
+      for (int iMol = 0; iMol < nMol(); ++iMol) quat2pos(iMol);
+    }
+  }
+
   /// Set particle type of iatom to itype.
   void settype(const int iatom, const int itype);
 
@@ -400,24 +504,45 @@ class Space : public BaseRandom {
                 const double stage)
                 { tagStage_ = stage; scaleMol(iMol, bondLengths); }
 
-  /// Update clusters of entire system.
+  /** Update clusters of entire system. Atoms of the types given by
+   *  addTypeForCluster are in the same cluster if they are within rCut.
+   *  Bonds are found with a temporary cell list (in parallel with OpenMP) and
+   *  joined with a disjoint set which also tracks periodic images, such that
+   *  percolation() is 1 if a cluster is connected to its own image. */
   void updateClusters(const double rCut);
 
   /// Add particle type to consider in cluster analysis.
   void addTypeForCluster(const int type) { clusterType_.push_back(type); }
 
+  /**
+   * Return the molecules in the cluster of molecule iMol, with iMol first.
+   * As in updateClusters, molecules are in the same cluster if atoms of the
+   * types given by addTypeForCluster (or of any type, if none were given)
+   * are within rCut. The cluster is grown from iMol with the cell list, if
+   * its cells are at least rCut wide, such that the cost scales with the size
+   * of the cluster and the number of neighbors, rather than the number of
+   * molecules. The unwrapped positions of the cluster, relative to the image
+   * of iMol, are stored in xcluster() for the sites of the cluster only.
+   */
+  vector<int> clusterOfMol(const int iMol, const double rCut);
+
   /// Delete all particles of a given type.
   void delTypePart(const int type);
 
   /// Swap the particle coordinates of two objects with equal particle numbers.
   void swapPositions(Space *space);
 
+  /** Copy the positions and orientations of space, which must have the same
+   *  atoms and domain, and update the cell list and cavity grid.
+   *  Return false, without any change, if the atoms or domain differ. */
+  bool copyPositions(const Space &space);
+
   /** Swap positions of iMol and jMol. Currently only implemented for
    *  configurations with only monoatomic particles e.g., nMol == natom */
   void swapPositions(const int iMol, const int jMol);
 
   /// Return maximum distance between molecule center and atom in molecule.
-  double maxMolDist();
+  double maxMolDist() const;
 
   /// Return list of all particles in molecule iMol.
   vector<int> imol2mpart(const int iMol);
@@ -538,6 +663,14 @@ class Space : public BaseRandom {
    *  maintain bonds lengths and angles. */
   void scaleDomain(const double factor, const int dim);
 
+  /// Return the factor by which scaleDomain would scale dimension dim, which
+  /// may be smaller than factor if the maximum box length is set.
+  double boundScaleFactor(const double factor, const int dim) const;
+
+  /// Return the tilt factor limited to a quarter of the box length in
+  /// dimension dim (e.g., dim=0 for xyTilt and xzTilt, or dim=1 for yzTilt).
+  double boundTilt(const double tilt, const int dim) const;
+
   /** Alternative scaleDomain which scales all dimensions by
    * \f$ factor^{1/dimen()} \f$, which is corresponds to scaling volume. */
   void scaleDomain(const double factor) { for (int dim = 0; dim < dimen_; ++dim)
@@ -546,7 +679,33 @@ class Space : public BaseRandom {
   /// Return the global, rotationally invariant q6 bond order parameter.
   double Q6(
     /// distance cut-off to define neighbors
-    const double rCut);
+    const double rCut) { bondOrder(rCut); return bondOrderQ6Global_; }
+
+  /**
+   * Compute the local bond order parameters, q4, q6 and w6, of each
+   * molecule, and the global Q6, from the bonds between the first atoms of
+   * molecules within rCut (Steinhardt, Nelson and Ronchetti, Phys. Rev. B
+   * 28, 784 (1983)). Neighbors are found with a cell list when the domain
+   * is not tilted and has at least three cells of width rCut in each
+   * dimension, and molecules are distributed among OpenMP threads.
+   */
+  void bondOrder(const double rCut);
+
+  /// Return the local q4 of each molecule from the last bondOrder.
+  const vector<double>& bondOrderQ4() const { return bondOrderQ4_; }
+
+  /// Return the local q6 of each molecule from the last bondOrder.
+  const vector<double>& bondOrderQ6() const { return bondOrderQ6_; }
+
+  /// Return the local w6 of each molecule from the last bondOrder.
+  const vector<double>& bondOrderW6() const { return bondOrderW6_; }
+
+  /// Return the number of neighbors of each molecule from the last bondOrder.
+  const vector<int>& bondOrderNeigh() const {
+    return bondOrderNeigh_; }
+
+  /// Return the global Q6 from the last bondOrder.
+  double bondOrderQ6Global() const { return bondOrderQ6Global_; }
 
   /**
    * Triclinic periodic cell is defined by a vector for each dimension.
@@ -565,6 +724,7 @@ class Space : public BaseRandom {
 
   /// Modify the tilt factors, and simultaneously transform the particles
   /// based on the position of the first site.
+  /// The tilt factors are limited by boundTilt.
   void modXYTilt(const double deltXYTilt);
 
   /// As above, but for XZ
@@ -574,7 +734,7 @@ class Space : public BaseRandom {
   void modYZTilt(const double deltYZTilt);
 
   /// Return minimum bond length in all molecules present or in addMolInit.
-  double minBondLength();
+  double minBondLength() const;
 
   /// Initialize euler angle representation for orientation.
   void initEuler(const int flag) { eulerFlag_ = flag; }
@@ -620,6 +780,10 @@ class Space : public BaseRandom {
   void storeUniqueConfigID();
   std::string const configID() { return configID_; }
 
+  /// Return a counter which changes with each modification of the
+  /// positions, orientations or types of the particles.
+  long long revision() const { return revision_; }
+
   /// Simulation domain volume
   double volume() const { return product(boxLength_); }
 
@@ -633,12 +797,13 @@ class Space : public BaseRandom {
   vector<double> x() const { return x_; }
   vector<double> xcluster() const { return xcluster_; }
   vector<vector<vector<double> > > xMol() const { return xMol_; }
-  vector<vector<double> > xold() const { return xold_; }
-  vector<vector<vector<double> > > xOldMulti() const { return xOldMulti_; }
+  vector<vector<double> > xold() const;
+  vector<vector<vector<double> > > xOldMulti() const;
   double x(int ipart, int dim) const { return x_[dimen_*ipart+dim]; }
   double xMol(int iMol, int dim) const {
     return x_[dimen_*mol2part_[iMol]+dim]; }
   vector<int> mol2part() const { return mol2part_; }
+  int mol2part(const int iMol) const { return mol2part_[iMol]; }
   vector<int> tag() const { return tag_; }
   double tagStage() const { return tagStage_; }
   vector<double> boxLength() const { return boxLength_; }
@@ -646,7 +811,9 @@ class Space : public BaseRandom {
   double type(const int i) const { return type_[i]; }
   vector<int> type() const { return type_; }
   vector<int> mol() const { return mol_; }
+  int mol(const int i) const { return mol_[i]; }
   vector<int> nType() const { return nType_; }
+  int nType(const int iType) const { return nType_[iType]; }
   vector<int> nMolType() const { return nMolType_; }
   vector<int> listAtoms() const { return listAtoms_; }
   vector<int> listMols() const { return listMols_; }
@@ -656,13 +823,25 @@ class Space : public BaseRandom {
   int nCell() const { return nCell_; }
   vector<string> moltype() const { return moltype_; }
   vector<int> molid() const { return molid_; }
-  vector<vector<vector<double> > > xMolRef() const { return xMolRef_; }
+  /// Return the reference positions of molecules, xMolRef[mol][atom][dim].
+  vector<vector<vector<double> > > xMolRef() const;
+
+  /// Return the reference position of atom iAtom in molecule iMol, or zero
+  /// if iMol has no reference positions.
+  double xMolRef(const int iMol, const int iAtom, const int dim) const {
+    const int id = xMolRefPool_.id[iMol];
+    if (id < 0) return 0.;
+    return xMolRefPool_.x[xMolRefPool_.start[id] + dimen_*iAtom + dim]; }
+
+  /// Return the number of reference geometries which are stored, once per
+  /// molecule type and once per molecule with a custom reference.
+  int nMolRefStored() const;
   vector<double> qMol() const { return qMol_; }
   double qMol(const int iMol, const int dim) const
     { return qMol_[qdim_*iMol+dim]; }
   vector<double> qMol(const int iMol) const;
   void qMolAlt(const int iMol, const int dim, const double q)
-    { qMol_[qdim_*iMol+dim] = q; }
+    { qMolW_(iMol)[dim] = q; }
   bool fastDel() const { return fastDel_; }
   int fastDelMol() const { return fastDelMol_; }
   int cellType() const { return cellType_; }
@@ -688,7 +867,13 @@ class Space : public BaseRandom {
     if (static_cast<int>(clusterSizes_.size()) == 0) { return 0;
     } else { return vecAverage(clusterSizes_); } }
   vector<int> clusterType() const { return clusterType_; }
-  vector<vector<int> > clusterList() const { return clusterList_; }
+  /// Return list of atoms in each cluster (see clusterListAtoms).
+  vector<vector<int> > clusterList() const;
+
+  /// Return flat list of atoms in each cluster, ordered by cluster.
+  /// The atoms in cluster ic begin at index clusterListStart()[ic].
+  vector<int> clusterListAtoms() const { return clusterListAtoms_; }
+  vector<int> clusterListStart() const { return clusterListStart_; }
 
   /// Number of clusters, averaged over each configuration, for given nMol
   AccumulatorVec clusterSizeAccVec() const { return clusterSizeAccVec_;}
@@ -786,11 +971,19 @@ class Space : public BaseRandom {
   vector<int> molid_;   //!< molid_[mol] = integer type of molecule
   vector<int> tag_;     //!< tag atom index, update with insertions or deletions
   double tagStage_;     //!< stage of tagged atom
-  vector<vector<double> > xold_;  //!< old atomic positions before randDisp
-  vector<double> xOldAll_;        //!< old atomic positions
-
-  /// stores series of old atomic positions
-  vector<vector<vector<double> > > xOldMulti_;
+  /// old atomic positions before randDisp, xold_[dimen_*i+dim], preallocated
+  /// to the largest number of particles stored
+  vector<double> xold_;
+  int nOld_;                      //!< number of particles in xold_
+  /// old atomic positions of the atoms in the xStoreAll journal,
+  /// xOldAll_[dimen_*i+dim] for atom xJournalAtom_[i]
+  vector<double> xOldAll_;
+
+  /// stores series of old atomic positions,
+  /// xOldMulti_[dimen_*(nOldMultiPart_*store+i)+dim]
+  vector<double> xOldMulti_;
+  int nOldMulti_;        //!< number of stores in xOldMulti_
+  int nOldMultiPart_;    //!< number of particles in each store of xOldMulti_
   vector<int> listAtoms_;  //!< list of consequetive integers (0 to nAtom() - 1)
   vector<int> listMols_;   //!< list of consequetive integers (0 to nMol() - 1)
   vector<int> cluster_;    //!< cluster id of particles (not auto updated)
@@ -801,8 +994,10 @@ class Space : public BaseRandom {
   /// list of atom types to consider in clustering algorithm
   vector<int> clusterType_;
 
-  /// for each cluster type, list of particles
-  vector<vector<int> > clusterList_;
+  /// for each cluster, list of particles (flat, see clusterListStart_)
+  vector<int> clusterListAtoms_;
+  /// index of the first particle of each cluster in clusterListAtoms_
+  vector<int> clusterListStart_;
   AccumulatorVec clusterSizeAccVec_;    //!< accumulator for cluster sizes
   AccumulatorVec clusterNumAccVec_;     //!< accumulator for number of clusters
 
@@ -814,17 +1009,43 @@ class Space : public BaseRandom {
   vector<double> clusterAcylindricity_;  //!< acylindricity of each cluster
   vector<double> clusterRelShapeAniso_;  //!< relative shape anisotropy
   vector<double> clusterRg_;             //!< radius of gyration of each cluster
+
+  // bond order parameters of each molecule
+  vector<double> bondOrderQ4_;
+  vector<double> bondOrderQ6_;
+  vector<double> bondOrderW6_;
+  vector<int> bondOrderNeigh_;
+  double bondOrderQ6Global_;
+  vector<int> bondOrderCellMols_;   //!< molecules sorted by cell
+  vector<int> bondOrderCellStart_;  //!< first index of each cell in above
   int preMicellarAgg_;   //!< cluster size as cut-off for premicellar aggregates
   int percolation_;      //!< flag if percolation was detected
 
-  /// flood fill algorithm to identify clusters based on atomic distance cutoff
-  void floodFill3d_(const int clusterNode, const int clusterID,
-                   const double rCut);
-  /// as above but uses cell list
-  void floodFillCell3d_(const int clusterNode, const int clusterID,
-                       const double rCut);
-  void floodFill2d_(const int clusterNode, const int clusterID,
-                   const double rCut);
+  // disjoint set (union-find) variables for distance-based clusters
+  vector<int> clusterParent_;     //!< parent of each atom in disjoint set
+  vector<int> clusterRootSize_;   //!< number of atoms under each root
+  /// periodic image of each atom relative to its parent, [natom*dimen]
+  vector<int> clusterImage_;
+  vector<int> clusterSeed_;       //!< lowest atom in each cluster
+  vector<int> clusterMolAtom_;    //!< atom which sets the cluster of each mol
+  vector<int> clusterCellAtoms_;  //!< cluster atoms sorted by cell
+  vector<int> clusterCellStart_;  //!< first index of each cell in above
+  vector<int> clusterCellOfAtom_;  //!< cell of each cluster atom
+  /// for each thread, bonds as (iAtom, jAtom, image of j relative to i)
+  vector<vector<int> > clusterBondList_;
+
+  vector<int> clusterOfMolMark_;   //!< flag molecules found by clusterOfMol
+
+  /// Return the root of iAtom in the disjoint set, compressing the path.
+  int clusterFind_(const int iAtom);
+
+  /// Join the sets of iAtom and jAtom, where the image of jAtom is shifted by
+  /// shift relative to iAtom. Sets percolation_ if already joined via a
+  /// different image.
+  void clusterUnion_(const int iAtom, const int jAtom, const int *shift);
+
+  /// Find all pairs of cluster atoms within rCut and store in clusterBondList_.
+  void clusterBonds_(const double rCut);
 
   /// flood fill algorithm using contact map obtained from Pair
   void floodFillContact_(const int clusterNode, const int clusterID,
@@ -872,6 +1093,33 @@ class Space : public BaseRandom {
   /// Return scalar cell index given 2D grid coordinates (i, j).
   int mvec2m2d_(const int &i, const int &j) const;
 
+  double cavityRCut_;          //!< cavity radius, or zero if no cavity grid
+  int cavityNStencil_;         //!< number of cells which count each site
+  vector<int> cavityNCellVec_;   //!< number of cavity cells in each dimension
+  vector<int> cavityCount_;      //!< number of sites counted by each cell
+  vector<int> cavityCellOfAtom_;   //!< cavity cell of each site
+  vector<int> cavityEmpty_;        //!< list of cavity cells
+  vector<int> cavityEmptyIndex_;   //!< index in the above, or -1
+
+  /// Return the cavity cell of the position x.
+  int cavityCell_(const double *x) const;
+
+  /// Return the fractional coordinates, f, of the position x.
+  void fractional_(const double *x, double *f) const;
+
+  /// Return the cell of the position x on a grid of nCellVec cells in
+  /// fractional coordinates.
+  int fractionalCell_(const double *x, const vector<int> &nCellVec) const;
+
+  /// Update the cell list after a change in the tilt factors.
+  void updateCellsTilt_();
+
+  /// Return the cells which count a site in cavity cell.
+  void cavityStencil_(const int cell, vector<int> *cells) const;
+
+  /// Add (delta = 1) or remove (delta = -1) the count of a site in cell.
+  void cavityCountSite_(const int cell, const int delta);
+
   void eraseMolFromCell_(const int iMol);     //!< removes molecule from cell
   void addMoltoCell_(const int iMol);         //!< adds molecule to cellList_
   void eraseAtomFromCell_(const int ipart);   //!< removes atom from cellList_
@@ -882,20 +1130,133 @@ class Space : public BaseRandom {
   bool sphereSymMol_;
   vector<double> qMol_;    //!< orientation of molecules via quaternions
   /// old orientation of molecules via quaternions
-  vector<vector<double> > qMolOld_;
+  vector<double> qMolOld_;
   vector<double> qMolOldAll_;  //!< old orientation of molecules via quaternions
-  /// multiple old orientation of molecules via quaternions
-  vector<vector<vector<double> > > qMolOldMulti_;
-  /// reference vector of molecules, xMolRef[mol][atom][dim]
-  vector<vector<vector<double> > > xMolRef_;
-  /// old reference vector of molecules
-  vector<vector<vector<double> > > xMolRefOld_;
+  /// multiple old orientation of molecules via quaternions,
+  /// qMolOldMulti_[qdim_*store+dim]
+  vector<double> qMolOldMulti_;
+  vector<double> xOldMols_;      //!< old positions of xStoreMols
+  vector<double> qMolOldMols_;   //!< old orientations of xStoreMols
+  vector<double> xRefOldMols_;   //!< old reference positions of xStoreMols
+
+  /** Reference positions of molecules, stored once per molecule type in
+   *  addMolList and once per molecule with a custom reference (e.g., from
+   *  qMolInit or scaleMol). Molecules only hold the id of an entry. */
+  struct MolRefPool_ {
+    /// positions of each entry id, x[start[id] + dimen_*atom + dim]
+    vector<double> x;
+    vector<int> start;      //!< start of each entry in x
+    vector<int> nAtom;      //!< number of atoms in each entry
+    vector<int> count;      //!< number of molecules sharing each entry
+    vector<bool> type;      //!< entry is for a molecule type in addMolList
+    vector<int> free;       //!< unused entries which are not types
+    vector<int> id;         //!< entry of each molecule
+    vector<int> typeID;     //!< entry of each type in addMolList, or -1
+  };
+  MolRefPool_ xMolRefPool_;
+  MolRefPool_ xMolRefPoolOld_;   //!< old reference positions of molecules
+
+  /// Compute the rotation matrix, rot[dimen_*i+j], for the orientation q,
+  /// such that the rotated reference positions are xref*rot.
+  void molRot_(const double *q, double *rot) const;
+
+  // ghost molecule generated by initGhostMol
+  string ghostMolType_;
+  vector<double> ghostX_;
+  vector<int> ghostType_;
+  vector<double> ghostQ_;   //!< orientation of the ghost, as in qMol_
+
+  /// Return the id of a new entry of nAtom reference positions.
+  int xMolRefNew_(const int nAtom, const bool type = false);
+
+  /// Return the number of reference positions of iMol, or its number of
+  /// atoms if it has no entry (e.g., spherically symmetric molecules).
+  int nAtomRef_(const int iMol) const;
+
+  /// Release entry id from one molecule.
+  void xMolRefRelease_(const int id);
+
+  /// Return reference positions of iMol which may be modified without
+  /// changing any other molecule.
+  double* xMolRefOwn_(const int iMol);
+
+  bool journalOpen_;   //!< xStoreAll journal is open
+  bool journalQMol_;   //!< qMol_ and references are saved in the journal
+  int natomJournal_;   //!< number of atoms when the journal was opened
+  long long revision_;  //!< modification counter (see revision())
+  vector<int> xJournalAtom_;   //!< atoms saved in the journal
+  vector<bool> xJournaled_;    //!< flag atoms saved in the journal
+
+  /// Save qMol_ and the reference positions in the open xStoreAll journal
+  /// before the first modification.
+  void journalAll_() {
+    if (journalOpen_ && !journalQMol_ && !sphereSymMol_) {
+      qMolOldAll_ = qMol_;
+      xMolRefPoolOld_ = xMolRefPool_;
+      journalQMol_ = true;
+    }
+  }
+
+  /// Save the positions of atoms ipart to ipart + nAtom - 1 in the open
+  /// xStoreAll journal, unless they are already saved.
+  void journalX_(const int ipart, const int nAtom);
+
+  /// Close the xStoreAll journal, keeping its buffers for the next one.
+  void journalClose_();
+
+  // x_, qMol_ and xMolRefPool_ are only modified through the write
+  // accessors below, which journal them while xStoreAll is open and
+  // increment revision_.
+
+  /// Return the position of atom ipart, followed by those of the next
+  /// nAtom - 1 atoms, for writing.
+  double* xW_(const int ipart, const int nAtom = 1) {
+    ++revision_;
+    if (journalOpen_) journalX_(ipart, nAtom);
+    return &x_[dimen_*ipart];
+  }
+
+  /// Return all positions for writing, or to add or remove atoms.
+  vector<double>& xW_() {
+    ++revision_;
+    if (journalOpen_) journalX_(0, natomJournal_);
+    return x_;
+  }
+
+  /// Return the orientation of molecule iMol for writing.
+  double* qMolW_(const int iMol) {
+    ++revision_;
+    journalAll_();
+    return &qMol_[qdim_*iMol];
+  }
+
+  /// Return all orientations for writing, or to add or remove molecules.
+  vector<double>& qMolW_() {
+    ++revision_;
+    journalAll_();
+    return qMol_;
+  }
+
+  /// Return the reference positions of all molecules for writing.
+  MolRefPool_& xMolRefPoolW_() {
+    ++revision_;
+    journalAll_();
+    return xMolRefPool_;
+  }
   int eulerFlag_;          //!< flag to use euler angles instead of quaternions
-  /// list of molecules that may be added to simulation
+  /// list of molecules that may be added to simulation, which may be shared
+  /// by clones, and are copied before modification (see addMolListOwned_)
   vector<shared_ptr<Space> > addMolList_;
   /// type of molecule that is listed in addMolList
   vector<string> addMolListType_;
 
+  /// Return the reference molecule of a type, after copying it if it is
+  /// shared with a clone.
+  shared_ptr<Space> addMolListOwned_(const string typeStr);
+
+  /// Return squared distance between atoms iAtom and jAtom subject to PBCs.
+  double rsqAtoms_(const int iAtom, const int jAtom) const;
+
   // i-o
   /// pointer xyz file to keep open while reading
   shared_ptr<std::ifstream> xyzFile_;
@@ -151,6 +151,78 @@ TEST(Space, randDispANDrestore) {
   EXPECT_EQ(1, int(s.xOldMulti().size()));
 }
 
+TEST(Space, xMolRefSharedByType) {
+  Space s(3);
+  s.initBoxLength(24.8586887);
+  s.addMolInit("../forcefield/data.spce");
+  for (int i = 0; i < 10; ++i) s.addMol();
+  EXPECT_EQ(10, s.nMol());
+  EXPECT_EQ(1, s.nMolRefStored());
+
+  // rotations only change the orientation
+  s.randRotate(s.imol2mpart(3), -1);
+  EXPECT_EQ(1, s.nMolRefStored());
+  EXPECT_NEAR(1., s.xMolRef(3, 1, 0)*s.xMolRef(3, 1, 0)
+    + s.xMolRef(3, 1, 1)*s.xMolRef(3, 1, 1)
+    + s.xMolRef(3, 1, 2)*s.xMolRef(3, 1, 2), 1e-10);
+
+  // a custom reference is stored for one molecule, and reused after deletion
+  s.qMolInit(3);
+  EXPECT_EQ(2, s.nMolRefStored());
+  EXPECT_EQ(s.xMolRef()[3][2][1], s.x(11, 1) - s.x(9, 1));
+  s.delPart(s.imol2mpart(3));
+  EXPECT_EQ(1, s.nMolRefStored());
+  s.addMol();
+  s.qMolInit(9);
+  EXPECT_EQ(2, s.nMolRefStored());
+  s.checkSizes();
+}
+
+TEST(Space, xStoreAllJournal) {
+  Space s(3);
+  s.initBoxLength(24.8586887);
+  s.readXYZBulk(3, "water", "../unittest/spce/test52.xyz");
+  s.addMolInit("../forcefield/data.spce");
+  const vector<double> x = s.x(), qMol = s.qMol();
+  const vector<int> mpart = s.imol2mpart(1);
+
+  // translations only save positions
+  s.xStoreAll();
+  s.randDisp(mpart, 2.);
+  s.restoreAll();
+  EXPECT_EQ(x, s.x());
+
+  // the first rotation saves orientations for restoreAll
+  s.xStoreAll();
+  s.randRotate(mpart, 2.);
+  s.randRotate(s.imol2mpart(2), 2.);
+  EXPECT_NE(qMol, s.qMol());
+  s.restoreAll();
+  EXPECT_EQ(x, s.x());
+  EXPECT_EQ(qMol, s.qMol());
+  try {
+    s.restoreAll();
+    CATCH_PHRASE("requires previous use of xStoreAll");
+  }
+
+  // public setters are journaled through the same write accessors
+  s.xStoreAll();
+  s.xset(1.2345, mpart.front(), 0);
+  s.qMolAlt(1, 0, 0.5);
+  s.restoreAll();
+  EXPECT_EQ(x, s.x());
+  EXPECT_EQ(qMol, s.qMol());
+
+  // multiple stores reuse the buffer after it is cleared
+  s.xStoreMulti(mpart, -1);
+  s.xStoreMulti(mpart, -2);
+  s.xStoreMulti(mpart, -1);
+  EXPECT_EQ(1, static_cast<int>(s.xOldMulti().size()));
+  s.randDisp(mpart, 2.);
+  s.xStoreMulti(mpart, 0);
+  EXPECT_EQ(x, s.x());
+}
+
 TEST(Space, randMol) {
   int dim=3;
   Space s(dim);
@@ -433,6 +505,17 @@ TEST(Space, cellListWater) {
   EXPECT_EQ(1, s.cellType());
   for (int dim=0; dim < s.dimen(); ++dim) EXPECT_EQ(ncell, s.nCellVec()[dim]);
   EXPECT_EQ(1, s.checkSizes());
+
+  // a molecule displaced without updating the cell list is found by samples
+  // which contain the molecule
+  EXPECT_EQ(1, s.checkCellListSample({0, 1, 2}));
+  for (int ipart = 0; ipart < 3; ++ipart) {
+    s.xset(s.x(ipart, 0) + boxl/2., ipart, 0);
+  }
+  EXPECT_EQ(1, s.checkCellListSample({1, 2}));
+  EXPECT_EQ(0, s.checkCellListSample({0, 1, 2}));
+  s.buildCellList();
+  EXPECT_EQ(1, s.checkCellListSample({0, 1, 2}));
 }
 
 // randomly update position of molecules with quaternions, and check that they did not change
@@ -741,6 +824,90 @@ TEST(Space, floodFill) {
   EXPECT_EQ(12, s.nClusters());
 }
 
+TEST(Space, clusterOfMol) {
+  Space s(3, {{"boxLength", "10"}});
+  s.initRNG(1234);
+  s.addMolInit("../forcefield/data.atom");
+  for (int i = 0; i < 150; ++i) {
+    s.xAdd = s.randPosition();
+    s.addMol("../forcefield/data.atom");
+  }
+  s.addTypeForCluster(0);
+  const double rCut = 1.5;
+  s.updateClusters(rCut);
+  const vector<int> clusterMol = s.clusterMol();
+  EXPECT_LT(1, s.nClusters());
+  int maxSize = 0;
+
+  // the same clusters are grown from each molecule, with and without cells
+  for (int cell = 0; cell < 2; ++cell) {
+    if (cell == 1) {
+      s.updateCells(rCut);
+      EXPECT_EQ(1, s.cellType());
+    }
+    for (int iMol = 0; iMol < s.nMol(); ++iMol) {
+      vector<int> mols = s.clusterOfMol(iMol, rCut);
+      EXPECT_EQ(iMol, mols.front());
+      std::sort(mols.begin(), mols.end());
+      vector<int> molsRef;
+      for (int jMol = 0; jMol < s.nMol(); ++jMol) {
+        if (clusterMol[jMol] == clusterMol[iMol]) molsRef.push_back(jMol);
+      }
+      EXPECT_EQ(molsRef, mols);
+      maxSize = std::max(maxSize, static_cast<int>(mols.size()));
+
+      // unwrapped neighbors are within rCut without periodic images
+      const vector<double> xcluster = s.xcluster();
+      for (unsigned int i = 1; i < mols.size(); ++i) {
+        double r2min = 1e10;
+        for (unsigned int j = 0; j < mols.size(); ++j) {
+          if (i != j) {
+            double r2 = 0.;
+            for (int dim = 0; dim < 3; ++dim) {
+              const double dx = xcluster[3*mols[i] + dim]
+                              - xcluster[3*mols[j] + dim];
+              r2 += dx*dx;
+            }
+            r2min = std::min(r2, r2min);
+          }
+        }
+        EXPECT_LT(r2min, rCut*rCut);
+      }
+    }
+  }
+  EXPECT_LT(1, maxSize);
+}
+
+TEST(Space, clusterPercolation) {
+  // a line of atoms spaced by unity which spans the periodic domain
+  Space s(3, {{"boxLength", "10"}});
+  s.addMolInit("../forcefield/data.atom");
+  for (int i = 0; i < 10; ++i) {
+    s.xAdd = {i - 4.5, 0.01*i, 0.};
+    s.addMol("../forcefield/data.atom");
+  }
+  s.addTypeForCluster(0);
+  s.updateClusters(1.1);
+  EXPECT_EQ(1, s.nClusters());
+  EXPECT_EQ(1, s.percolation());
+  s.updateClusters(0.9);
+  EXPECT_EQ(10, s.nClusters());
+  EXPECT_EQ(0, s.percolation());
+
+  // break the line, and check the unwrapped coordinates of the cluster
+  s.delPart(9);
+  s.updateClusters(1.1);
+  EXPECT_EQ(1, s.nClusters());
+  EXPECT_EQ(0, s.percolation());
+  EXPECT_EQ(9, int(s.clusterListAtoms().size()));
+  EXPECT_EQ(0, s.clusterListStart()[0]);
+  EXPECT_EQ(9, s.clusterListStart()[1]);
+  const vector<double> xc = s.xcluster();
+  for (int i = 1; i < 9; ++i) {
+    EXPECT_NEAR(1., fabs(xc[3*i] - xc[3*(i-1)]), 0.1);
+  }
+}
+
 TEST(Space, swapPositionsANDstoreAll) {
   Space s(3);
   s.addMolInit("../forcefield/data.cg3_60_43_1");
@@ -749,6 +916,7 @@ TEST(Space, swapPositionsANDstoreAll) {
   shared_ptr<Space> s2 = s.cloneShrPtr();
   s2->xStoreAll();
   const double posold = s.x(2, 2);
+  const vector<double> qMolOld = s2->qMol(), xOld = s2->x();
   vector<int> mpart;
   for (int i = 0; i < 4; ++i) mpart.push_back(i);
   s.randDisp(mpart, 2);
@@ -757,8 +925,19 @@ TEST(Space, swapPositionsANDstoreAll) {
   EXPECT_NE(posnew, posold);
   s.swapPositions(s2.get());
   EXPECT_NEAR(posnew, s2->x(2, 2), 1e-14);
+  EXPECT_NE(qMolOld, s2->qMol());
   s2->restoreAll();
   EXPECT_NEAR(posold, s2->x(2, 2), 1e-14);
+
+  // orientations and reference positions are restored with the positions
+  EXPECT_EQ(qMolOld, s2->qMol());
+  EXPECT_EQ(xOld, s2->x());
+  for (int iMol = 0; iMol < s2->nMol(); ++iMol) {
+    s2->quat2pos(iMol);
+  }
+  for (unsigned int i = 0; i < xOld.size(); ++i) {
+    EXPECT_NEAR(xOld[i], s2->x()[i], 1e-12);
+  }
 }
 
 TEST(Space, maxMolDist) {
@@ -772,6 +951,13 @@ TEST(Space, maxMolDist) {
   s.addMol("../forcefield/data.cg3_60_43_1");
   s.addMol("../forcefield/data.cg3_60_43_1");
   EXPECT_NEAR(0.7698, s.maxMolDist(), 1e-4);
+
+  // read-only, such that the reference molecules may be shared by clones
+  shared_ptr<Space> clone = s.cloneShrPtr();
+  const Space &cs = *clone;
+  EXPECT_EQ(s.addMolList()[0], cs.addMolList()[0]);
+  EXPECT_NEAR(0.7698, cs.maxMolDist(), 1e-4);
+  EXPECT_LT(0., cs.minBondLength());
 }
 
 TEST(Space, readXYZ) {
@@ -821,12 +1007,12 @@ TEST(Space, randRotateMulti) {
   }
   //s.printXYZ("tm1234.xyz", 0);
 
-// HWH eigenvalue  // compute shape of clusters
-//  s.xClusterShape();
-//  EXPECT_NEAR(s.clusterAsphericityAv(), 0.6204511597901633, 1e-5);
-//  EXPECT_NEAR(s.clusterAcylindricityAv(), 0.37957508233844489, 1e-5);
-//  EXPECT_NEAR(s.clusterRelShapeAnisoAv(), 0.026661790962870163, 1e-5);
-//  EXPECT_NEAR(s.clusterRgAv(), 2.1327427724005301, 1e-5);
+  // compute shape of clusters
+  s.xClusterShape();
+  EXPECT_NEAR(s.clusterAsphericityAv(), 0.6204511597901633, 1e-5);
+  EXPECT_NEAR(s.clusterAcylindricityAv(), 0.37957508233844489, 1e-5);
+  EXPECT_NEAR(s.clusterRelShapeAnisoAv(), 0.026661790962870163, 1e-5);
+  EXPECT_NEAR(s.clusterRgAv(), 2.1327427724005301, 1e-5);
 }
 
 TEST(Space, inertialTensor) {
@@ -1090,6 +1276,19 @@ TEST(Space, Q6) {
     std::ifstream file("../unittest/lattice/fcc.xyz");
     sFCC.readXYZ(file);
     EXPECT_NEAR(0.5745242597140704, sFCC.Q6(sqrt(2)/2+0.001), 1e-14);
+
+    // local bond order parameters of the fully coordinated fcc sites
+    sFCC.bondOrder(sqrt(2)/2+0.001);
+    int nBulk = 0;
+    for (int iMol = 0; iMol < sFCC.nMol(); ++iMol) {
+      if (sFCC.bondOrderNeigh()[iMol] == 12) {
+        ++nBulk;
+        EXPECT_NEAR(0.19094065395649334, sFCC.bondOrderQ4()[iMol], 1e-12);
+        EXPECT_NEAR(0.5745242597140704, sFCC.bondOrderQ6()[iMol], 1e-12);
+        EXPECT_NEAR(-0.013160600730646923, sFCC.bondOrderW6()[iMol], 1e-12);
+      }
+    }
+    EXPECT_LT(0, nBulk);
   }
 }
 
@@ -1104,6 +1303,20 @@ TEST(Space, xyTilt) {
   EXPECT_NEAR(s.minBondLength(), 1, 10*DTOL);
 }
 
+TEST(Space, rwrapTilted) {
+  Space s(3, {{"boxLength", "10"}});
+  s.setXYTilt(2.);
+  s.setXZTilt(-1.);
+  s.setYZTilt(1.5);
+
+  // wrapping is a translation by the vectors of the triclinic cell
+  vector<double> r = {0.5, 6., -5.5};
+  s.rwrap(&r);
+  EXPECT_NEAR(0.5 - 2. - 1., r[0], 1e-12);
+  EXPECT_NEAR(6. - 10. + 1.5, r[1], 1e-12);
+  EXPECT_NEAR(-5.5 + 10., r[2], 1e-12);
+}
+
 TEST(Space, SQ) {
   Space s(3);
   s.initBoxLength(12);
@@ -1308,3 +1521,70 @@ TEST(Space, argparse) {
   }
 }
 
+
+TEST(Space, cavity) {
+  Space s(3);
+  s.initBoxLength(8., 0);
+  s.initBoxLength(7., 1);
+  s.initBoxLength(9., 2);
+  s.setXYTilt(1.5);
+  s.addMolInit("../forcefield/data.spce");
+  for (int i = 0; i < 5; ++i) s.addMol();
+  const double rCav = 1.2;
+  s.initCavity(rCav);
+  EXPECT_TRUE(s.cavityOn());
+  EXPECT_GT(s.nCavity(), 0);
+  EXPECT_LT(s.nCavity()*s.cavityCellVolume(), s.volume());
+
+  // add, move, swap and delete molecules, and compare with a new grid
+  for (int i = 0; i < 10; ++i) s.addMol();
+  EXPECT_EQ(1, s.checkCavity());
+  for (int i = 0; i < 20; ++i) {
+    const vector<int> mpart = s.randMol();
+    s.randDisp(mpart, 2.);
+    s.updateCavityofiMol(s.mol()[mpart[0]]);
+  }
+  EXPECT_EQ(1, s.checkCavity());
+
+  // the number of cavities without a molecule matches its deletion
+  for (int i = 0; i < 5; ++i) {
+    const vector<int> mpart = s.randMol();
+    bool inCavity;
+    const int nCav = s.nCavityWithout(mpart, &inCavity);
+    s.delPart(mpart);
+    EXPECT_EQ(nCav, s.nCavity());
+    EXPECT_EQ(1, s.checkCavity());
+  }
+
+  // random positions in cavities are at least rCav away from all sites
+  for (int i = 0; i < 100; ++i) {
+    const vector<double> r = s.randCavityPosition();
+    for (int ipart = 0; ipart < s.natom(); ++ipart) {
+      vector<double> xi(s.dimen());
+      for (int dim = 0; dim < s.dimen(); ++dim) xi[dim] = s.x(ipart, dim);
+      EXPECT_GE(s.rsq(r, xi), rCav*rCav - 1e-10);
+    }
+  }
+
+  // the grid is rebuilt with fewer cells when the domain is compressed or
+  // tilted, so cavities remain at least rCav from all sites
+  const int nCell = static_cast<int>(s.volume()/s.cavityCellVolume() + 0.5);
+  s.scaleDomain(0.7);
+  s.modXYTilt(-1.);
+  EXPECT_EQ(1, s.checkCavity());
+  EXPECT_LT(static_cast<int>(s.volume()/s.cavityCellVolume() + 0.5), nCell);
+  for (int i = 0; i < 100; ++i) {
+    const vector<double> r = s.randCavityPosition();
+    for (int ipart = 0; ipart < s.natom(); ++ipart) {
+      vector<double> xi(s.dimen());
+      for (int dim = 0; dim < s.dimen(); ++dim) xi[dim] = s.x(ipart, dim);
+      EXPECT_GE(s.rsq(r, xi), rCav*rCav - 1e-10);
+    }
+  }
+
+  // the grid is restored from a restart file
+  s.writeRestart("tmp/cavityrst");
+  Space s2("tmp/cavityrst");
+  EXPECT_TRUE(s2.cavityOn());
+  EXPECT_EQ(s.nCavity(), s2.nCavity());
+}
@@ -8,10 +8,20 @@
  * appropriate acknowledgments of NIST's creation of the data/software.
  */
 
+#include <map>
+#include <mutex>
+#include <utility>
 #include "./table.h"
 
 namespace feasst {
 
+namespace {
+// erftables in use by any object in the process, by alpha and rCut
+std::mutex erfTableMutex;
+std::map<std::pair<double, double>, std::weak_ptr<const vector<double> > >
+  erfTableCache;
+}
+
 Table::Table() {
   defaultConstruction_();
 }
@@ -885,13 +895,22 @@ void erftable::init(const double alpha, const double rCut) {
   n_ = 2e5;
   ds_ = pow(2*rCut, 2)/static_cast<double>(n_);
   alpha_ = alpha;  // store alpha for exact evaluation
-  const double onStore = on_;
-  on_ = 0;
-  for (int i = 0; i < n_; ++i) {
-    const double s = static_cast<double>(i) * ds_;
-    vtab_.push_back(eval(s));
+
+  // reuse a table with the same parameters, if any
+  std::lock_guard<std::mutex> lock(erfTableMutex);
+  std::weak_ptr<const vector<double> >& cached =
+    erfTableCache[std::make_pair(alpha, rCut)];
+  table_ = cached.lock();
+  if (!table_) {
+    shared_ptr<vector<double> > vtab = make_shared<vector<double> >(n_);
+    for (int i = 0; i < n_; ++i) {
+      const double r = sqrt(static_cast<double>(i) * ds_);
+      (*vtab)[i] = erfc(alpha_*r)/r;
+    }
+    table_ = vtab;
+    cached = table_;
   }
-  on_ = onStore;
+  vtab_ = table_->data();
 }
 
 double erftable::eval(const double x) const {
@@ -11,6 +11,7 @@
 #ifndef TABLE_H_
 #define TABLE_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 #ifdef GSL_
@@ -129,11 +130,15 @@ class Table {
 /**
  * Tabulate the complimentary error function as used by the Ewald Sum.
  * erfc(alpha*r)/r
+ *
+ * The table is read-only once initialized, and is shared by copies (e.g.,
+ * clones of a pair) and by all tables initialized with the same alpha and
+ * rCut in the process, such that it is only computed and stored once.
  */
 class erftable {
  public:
   /// Constructor
-  erftable() { on_ = 1; }
+  erftable() { on_ = 1; vtab_ = NULL; }
   ~erftable() {}
 
   /**
@@ -150,8 +155,12 @@ class erftable {
   // if this flag is not 1, then use exact calculation instead
   void tableOff() { on_ = 0; }
 
+  /// Return the shared table.
+  shared_ptr<const vector<double> > table() const { return table_; }
+
  private:
-  vector<double> vtab_;
+  shared_ptr<const vector<double> > table_;
+  const double* vtab_;   //!< data of table_, for evaluation
   int n_;
   double ds_;
   double alpha_;
@@ -72,3 +72,19 @@ TEST(Table, lj) {
     //cout << "r " << r << " " << lj.interpolate(r*r) << endl;
   }
 }
+
+TEST(Table, erftableShared) {
+  erftable erft;
+  erft.init(0.2, 10.);
+  EXPECT_NEAR(erfc(0.2*3.)/3., erft.eval(9.), 1e-8);
+
+  // tables with the same parameters, and copies, share the data
+  erftable erft2, erft3;
+  erft2.init(0.2, 10.);
+  erft3.init(0.2, 12.);
+  EXPECT_EQ(erft.table(), erft2.table());
+  EXPECT_NE(erft.table(), erft3.table());
+  erftable erftCopy(erft);
+  EXPECT_EQ(erft.table(), erftCopy.table());
+  EXPECT_EQ(erft.eval(9.), erftCopy.eval(9.));
+}
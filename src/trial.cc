@@ -163,7 +163,7 @@ double Trial::multiFirstBead_(const int flag) {
       // -2 flag to store multiple positions
       space()->xStoreMulti(mpart_, -2);
     }
-    en_[i] = pair_->multiPartEner(mpart_, flag);
+    en_[i] = multiPartEner_(mpart_, flag);
     w_[i] = exp(-criteria_->beta()*en_[i]);
     // cout << "w" << i << " " << w_[i] << " " << en_[i] << " " << flag << endl;
     if (i != 0) w_[i] += w_[i-1];
@@ -247,8 +247,8 @@ double Trial::acceptPer() const {
 
 void Trial::trialMoveRecord_() {
   if (criteria_->className() != "CriteriaMayer") {
-    peOld_ = pair_->multiPartEner(mpart_, 0);
-    pair_->update(mpart_, 0, "store");
+    peOld_ = multiPartEner_(mpart_, 0);
+    pair_->beginTrial(mpart_, Pair::MOVE_TRIAL);
   } else {
     peOld_ = pair_->peTot();
   }
@@ -257,7 +257,7 @@ void Trial::trialMoveRecord_() {
 
 void Trial::trialMoveRecordAll_(const int flag) {
   peOld_ = pair_->allPartEnerForce(flag);
-  pair_->update(space()->listAtoms(), 0, "store");
+  pair_->beginTrial(space()->listAtoms(), Pair::MOVE_TRIAL);
   space()->xStoreAll();
 }
 
@@ -268,7 +268,7 @@ void Trial::trialMoveDecide_(const double def,
     if (space()->cellType() > 0) {
       space()->updateCellofiMol(space()->mol()[mpart_.front()]);
     }
-    const double pe = pair_->multiPartEner(mpart_, 1);
+    const double pe = multiPartEner_(mpart_, 1);
     de_ = pe - peOld_;
     lnpMet_ = log(preFac) - criteria_->beta()*(de_ - def);
     reject_ = 0;
@@ -276,8 +276,11 @@ void Trial::trialMoveDecide_(const double def,
     if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
                           reject_) == 1) {
       space()->wrap(mpart_);
+      if (space()->cavityOn()) {
+        space()->updateCavityofiMol(space()->mol()[mpart_.front()]);
+      }
       if (criteria_->className() != "CriteriaMayer") {
-        pair_->update(mpart_, 0, "update");
+        pair_->commitTrial(mpart_);
       } else {
         pair_->updatePeTot(pe);
       }
@@ -285,6 +288,7 @@ void Trial::trialMoveDecide_(const double def,
       trialAccept_();
     } else {
       space()->restore(mpart_);
+      pair_->rollbackTrial();
       if (space()->cellType() > 0) {
         space()->updateCellofiMol(space()->mol()[mpart_.front()]);
       }
@@ -302,6 +306,7 @@ void Trial::trialMoveDecide_(const double def,
     de_ = 0;
     criteria_->accept(lnpMet_, pair_->peTot() + de_,
                       trialType_.c_str(), reject_);
+    pair_->rollbackTrial();
     trialReject_();
   }
 }
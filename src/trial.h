@@ -108,6 +108,7 @@ class Trial : public BaseRandom {
   double acceptPer() const;   //!< return trial acceptance percentage
   double de() const { return de_; }    //!< change in energy from last trial
   double deTot() const { return deTot_; }
+  string trialType() const { return trialType_; }   //!< e.g., move, add, del
   int nf() const { return nf_; }
   bool avbOn() const { return avbOn_; }
   Criteria* criteria() const { return criteria_; }
@@ -150,6 +151,18 @@ class Trial : public BaseRandom {
 
   virtual void attempt1_() = 0;  // this is the implementation of a trial.
 
+  /// Return the energy of mpart, as Pair::multiPartEner, timed by Profile.
+  double multiPartEner_(const vector<int> &mpart, const int flag) {
+    FEASST_PROFILE(ENERGY);
+    return pair_->multiPartEner(mpart, flag);
+  }
+
+  /// Return the energy of the ghost, as Pair::ghostEner, timed by Profile.
+  double ghostEner_(const int excludeMol = -1) {
+    FEASST_PROFILE(ENERGY);
+    return pair_->ghostEner(excludeMol);
+  }
+
   void trialAccept_();     //!< call when accepting a trial
   void trialReject_();     //!< call when rejecting a trial
 
@@ -82,6 +82,24 @@ void TrialAdd::attempt1_() {
     trialType_.assign(ss.str());
   }
 
+  // with a cavity grid, insert the first site uniformly within a cavity
+  int nCavity = 0;
+  vector<double> xCavity;
+  if (space()->cavityOn()) {
+    ASSERT( (confineFlag_ == 0) && (addTwo == 0) && (!avbOn_) && (nf_ <= 1),
+      "cavity-biased insertion is not implemented with confine, addTwo, avb "
+      << "or multiple first beads");
+    nCavity = space()->nCavity();
+    if (nCavity > 0) xCavity = space()->randCavityPosition();
+  }
+
+  // when possible, evaluate a ghost and only add the molecule if accepted
+  if ( (addTwo == 0) && (!avbOn_) && (nf_ <= 1) &&
+       (space()->equiMolar() == 0) && pair_->ghostEnerImplemented() ) {
+    attemptGhost_(nCavity, xCavity);
+    return;
+  }
+
   if (confineFlag_ == 0) {
     // add molecule to entire box
     space()->addMol(molType_.c_str());
@@ -89,6 +107,16 @@ void TrialAdd::attempt1_() {
     // obtain vector of particle IDs of inserted molecule
     mpart_ = space()->lastMolIDVec();
 
+    if (nCavity > 0) {
+      const int iMol = space()->mol()[mpart_.front()];
+      for (int dim = 0; dim < space()->dimen(); ++dim) {
+        xCavity[dim] -= space()->x(mpart_.front(), dim);
+      }
+      space()->transMol(iMol, xCavity);
+      space()->updateCavityofiMol(iMol);
+      if (space()->cellType() > 0) space()->updateCellofiMol(iMol);
+    }
+
     if (addTwo != 0) {
       space()->addMol(molType_.c_str());
       const vector<int> mpart2 = space()->lastMolIDVec();
@@ -165,6 +193,10 @@ void TrialAdd::attempt1_() {
     const int iMolIndex = space()->findAddMolListIndex(molType_);
     const int nMolOfType = space()->nMolType()[iMolIndex];
     preFac_ = space()->volume()/static_cast<double>(nMolOfType);
+    if (space()->cavityOn()) {
+      preFac_ = nCavity*space()->cavityCellVolume()
+              / static_cast<double>(nMolOfType);
+    }
     lnpMet_ = log(preFac_);
   }
   space()->wrap(mpart_);
@@ -181,8 +213,8 @@ void TrialAdd::attempt1_() {
 
   // record energy contribution of selected particle
   if ( (preFac_ != 0) && (reject_ != 1) ) {
-    de_ = pair_->multiPartEner(mpart_, 3);
-    pair_->update(mpart_, 3, "store");
+    de_ = multiPartEner_(mpart_, 3);
+    pair_->beginTrial(mpart_, Pair::ADD_TRIAL);
     const int iMolIndex = space()->findAddMolListIndex(molType_);
     lnpMet_ += -criteria_->beta()*(de_ - def_)
             + log(criteria_->activ(iMolIndex));
@@ -196,12 +228,13 @@ void TrialAdd::attempt1_() {
   if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
                         reject_) == 1) {
     trialAccept_();
-    pair_->update(mpart_, 3, "update");
+    pair_->commitTrial(mpart_);
     WARN(verbose_ == 1, "insertion accepted " << de_);
 
   // if not accepted, remove molecule, assuming a molecule is described
   // by sequentially listed particles
   } else {
+    pair_->rollbackTrial();
     pair_->delPart(mpart_);
     space()->delPart(mpart_);
     WARN(verbose_ == 1, "insertion rejected " << de_);
@@ -209,6 +242,65 @@ void TrialAdd::attempt1_() {
   }
 }
 
+void TrialAdd::attemptGhost_(const int nCavity, vector<double> xFirst) {
+  // choose the position of the first site
+  if (!space()->cavityOn()) {
+    bool inRegion = false;
+    int tries = 0, maxTries = 1e4;
+    while (!inRegion && (tries < maxTries)) {
+      xFirst = space()->randPosition();
+      space()->rwrap(&xFirst);
+      if ( (confineFlag_ == 0) ||
+           ( (xFirst[confineDim_] <= confineUpper_) &&
+             (xFirst[confineDim_] >= confineLower_) ) ) {
+        inRegion = true;
+      }
+      ++tries;
+    }
+    ASSERT(tries != maxTries, "maximum number of attempts in confine");
+  }
+
+  int nMolOfType = 1;
+  if (molid_ < space()->nMolTypes()) {
+    nMolOfType += space()->nMolType()[molid_];
+  }
+  if (space()->cavityOn()) {
+    preFac_ = nCavity*space()->cavityCellVolume()
+            / static_cast<double>(nMolOfType);
+  } else {
+    preFac_ = space()->volume()/static_cast<double>(nMolOfType);
+  }
+  lnpMet_ = log(preFac_);
+
+  // record energy contribution of the ghost
+  if (preFac_ != 0) {
+    space()->initGhostMol(molType_.c_str(), xFirst);
+    de_ = ghostEner_();
+    lnpMet_ += -criteria_->beta()*de_ + log(criteria_->activ(molid_));
+    reject_ = 0;
+  } else {
+    reject_ = 1;
+    de_ = 0;
+    lnpMet_ = std::numeric_limits<double>::min();
+  }
+
+  if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
+                        reject_) == 1) {
+    // add the ghost to space, and update the pair as for a real insertion
+    space()->addGhostMol();
+    pair_->addPart();
+    mpart_ = space()->lastMolIDVec();
+    de_ = multiPartEner_(mpart_, 3);
+    pair_->beginTrial(mpart_, Pair::ADD_TRIAL);
+    trialAccept_();
+    pair_->commitTrial(mpart_);
+    WARN(verbose_ == 1, "insertion accepted " << de_);
+  } else {
+    WARN(verbose_ == 1, "insertion rejected " << de_);
+    trialReject_();
+  }
+}
+
 string TrialAdd::printStat(const bool header) {
   stringstream stat;
   stat << Trial::printStat(header);
@@ -23,6 +23,12 @@ class Criteria;
 
 /**
  * Attempt to add particle(s).
+ * If the pair implements Pair::ghostEner, the energy of the inserted molecule
+ * is computed without adding it to the space, and the molecule is added only
+ * if the trial is accepted.
+ * If the space maintains a cavity grid (see Space::initCavity), the first
+ * site is inserted uniformly within a random cavity, and the volume in the
+ * acceptance probability is replaced by the volume of the cavities.
  */
 class TrialAdd : public Trial {
  public:
@@ -61,6 +67,10 @@ class TrialAdd : public Trial {
   /// attempt insertion
   void attempt1_();
 
+  /// Attempt insertion of a ghost, which is only added to space if accepted.
+  /// If nCavity > 0, xFirst is the position of the first site in a cavity.
+  void attemptGhost_(const int nCavity, vector<double> xFirst);
+
   void defaultConstruction_();
 
   // clone design pattern
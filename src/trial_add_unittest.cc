@@ -10,6 +10,7 @@
 
 #include <gtest/gtest.h>
 #include "pair_lj.h"
+#include "pair_ideal.h"
 #include "trial_transform.h"
 #include "trial_add.h"
 #include "trial_delete.h"
@@ -82,3 +83,31 @@ TEST(TrialAdd, confine) {
   mc.runNumTrials(1e2);
 }
 
+
+TEST(TrialAdd, cavityIdealGas) {
+  // the average number of ideal gas particles, zV, is unchanged by the
+  // cavity bias
+  Space space(3);
+  space.initBoxLength(8);
+  stringstream addMol;
+  addMol << space.install_dir() << "/forcefield/data.lj";
+  PairIdeal pair(&space, {{"rCut", "1."}});
+  pair.initData(addMol.str());
+  pair.rCutijset(0, 0, 1.);
+  space.initCavity(1.);
+  const double nAv = 20.;
+  CriteriaMetropolis crit(1., nAv/space.volume());
+  MC mc(&space, &pair, &crit);
+  mc.seedRNG(2345);
+  transformTrial(&mc, "translate", 0.5);
+  deleteTrial(&mc, addMol.str().c_str());
+  addTrial(&mc, addMol.str().c_str());
+  mc.setNFreqCheckE(1e4, 1e-10);
+  Accumulator nMol;
+  for (int i = 0; i < 2e5; ++i) {
+    mc.attemptTrial();
+    nMol.accumulate(space.nMol());
+  }
+  EXPECT_NEAR(nAv, nMol.average(), 0.5);
+  EXPECT_LT(space.nCavity()*space.cavityCellVolume(), space.volume());
+}
@@ -0,0 +1,216 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <algorithm>
+#include "./trial_cluster.h"
+#include "./mc.h"
+
+namespace feasst {
+
+TrialCluster::TrialCluster(
+  const char* transType,
+  const double rCutCluster)
+  : Trial(),
+    transType_(transType),
+    rCutCluster_(rCutCluster) {
+  defaultConstruction_();
+}
+
+TrialCluster::TrialCluster(
+  Pair *pair,
+  Criteria *criteria,
+  const char* transType,
+  const double rCutCluster)
+  : Trial(pair, criteria),
+    transType_(transType),
+    rCutCluster_(rCutCluster) {
+  defaultConstruction_();
+}
+
+TrialCluster::TrialCluster(const char* fileName,
+  Pair *pair,
+  Criteria *criteria)
+  : Trial(pair, criteria, fileName) {
+  transType_ = fstos("transType", fileName);
+  rCutCluster_ = fstod("rCutCluster", fileName);
+  defaultConstruction_();
+  targAcceptPer = fstod("targAcceptPer", fileName);
+
+  // although maxMoveParam was already read in the base class
+  // read it again because it was over-written by defaultConstruction
+  maxMoveParam = fstod("maxMoveParam", fileName);
+}
+
+void TrialCluster::writeRestart(const char* fileName) {
+  writeRestartBase(fileName);
+  std::ofstream file(fileName, std::ios_base::app);
+  file << "# transType " << transType_ << endl;
+  file << "# rCutCluster " << rCutCluster_ << endl;
+  file << "# targAcceptPer " << targAcceptPer << endl;
+}
+
+void TrialCluster::defaultConstruction_() {
+  className_.assign("TrialCluster");
+  trialType_.assign("move");
+  verbose_ = 0;
+  maxMoveFlag = 1;
+  ASSERT( (transType_.compare("translate") == 0) ||
+          (transType_.compare("rotate") == 0),
+    "cluster transformation type (" << transType_ << ") not recognized");
+  if (maxMoveParam == maxMoveParamDefault_) maxMoveParam = 0.1;
+  targAcceptPer = 0.25;
+}
+
+double TrialCluster::rCutCluster() const {
+  if (rCutCluster_ > 0) {
+    return rCutCluster_;
+  }
+  return pair_->rCutMaxAll();
+}
+
+void TrialCluster::wrapCluster_(const vector<int> &mols) {
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    space()->wrap(space()->imol2mpart(mols[i]));
+    if (space()->cellType() > 0) {
+      space()->updateCellofiMol(mols[i]);
+    }
+  }
+}
+
+void TrialCluster::attempt1_() {
+  if (verbose_ == 1) {
+    cout << std::setprecision(std::numeric_limits<double>::digits10+2)
+         << "attempting cluster " << transType_ << " " << pair_->peTot()
+         << endl;
+  }
+  if (space()->nMol() <= 0) {
+    trialMoveDecide_(0, 0);   // ensured rejection, however, criteria can update
+    return void();
+  }
+
+  ASSERT(!pair_->neighOn(),
+    "TrialCluster is not implemented with neighbor lists");
+  ASSERT(pair_->updateDeImplemented(),
+    "TrialCluster only updates the total energy of Pair, and thus is not "
+    << "implemented with the Fourier-space terms of Ewald summation, or "
+    << "other terms that Pair::update(de) does not update");
+
+  // select a random molecule and find its cluster
+  const double rCut = rCutCluster();
+  const int iMol = uniformRanNum(0, space()->nMol() - 1);
+  vector<int> mols = space()->clusterOfMol(iMol, rCut);
+  std::sort(mols.begin(), mols.end());
+  mpart_.clear();
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    for (int ipart = space()->mol2part(mols[i]);
+         ipart < space()->mol2part(mols[i] + 1); ++ipart) {
+      mpart_.push_back(ipart);
+    }
+  }
+  peOld_ = clusterEner_(mols, 0);
+  space()->xStoreMols(mols);
+
+  // rigidly transform the unwrapped cluster
+  if (transType_.compare("translate") == 0) {
+    space()->randDispNoWrap(mpart_, maxMoveParam);
+  } else {
+    space()->randRotateMulti(mpart_, maxMoveParam);
+  }
+  wrapCluster_(mols);
+
+  // reject if the cluster of iMol is not the same in the new configuration
+  vector<int> molsNew = space()->clusterOfMol(iMol, rCut);
+  std::sort(molsNew.begin(), molsNew.end());
+  if (molsNew != mols) {
+    reject_ = 1;
+    lnpMet_ = std::numeric_limits<double>::min();
+    de_ = 0;
+  } else {
+    de_ = clusterEner_(mols, 1) - peOld_;
+    lnpMet_ = -criteria_->beta()*de_;
+    reject_ = 0;
+  }
+
+  // accept or reject
+  if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
+                        reject_) == 1) {
+    if (space()->cavityOn()) {
+      for (unsigned int i = 0; i < mols.size(); ++i) {
+        space()->updateCavityofiMol(mols[i]);
+      }
+    }
+    pair_->update(de_);
+    trialAccept_();
+  } else {
+    space()->restoreMols(mols);
+    if (space()->cellType() > 0) {
+      for (unsigned int i = 0; i < mols.size(); ++i) {
+        space()->updateCellofiMol(mols[i]);
+      }
+    }
+    trialReject_();
+  }
+}
+
+double TrialCluster::clusterEner_(const vector<int> &mols, const int flag) {
+  double pe = 0.;
+  for (unsigned int i = 0; i < mols.size(); ++i) {
+    pe += multiPartEner_(space()->imol2mpart(mols[i]), flag);
+  }
+  return pe;
+}
+
+void TrialCluster::tuneParameters() {
+  // determine limits and percentage changes
+  const double percent = 0.05;
+  const double lowerLimit = 1e-5;
+  double upperLimit;
+  if (transType_.compare("translate") == 0) {
+    upperLimit = space()->minl()/4.;
+    if (upperLimit == 0.) upperLimit = NUM_INF;
+  } else {
+    upperLimit = 1e1;
+  }
+  updateMaxMoveParam_(percent, upperLimit, lowerLimit, targAcceptPer);
+}
+
+string TrialCluster::printStat(const bool header) {
+  stringstream stat;
+  if (header) {
+    stat << "cluster" << transType_ << " maxMove ";
+  } else {
+    stat << acceptPer() << " " << maxMoveParam << " ";
+  }
+  return stat.str();
+}
+
+shared_ptr<TrialCluster> makeTrialCluster(Pair *pair, Criteria *criteria,
+  const char* transType, const double rCutCluster) {
+  return make_shared<TrialCluster>(pair, criteria, transType, rCutCluster);
+}
+
+shared_ptr<TrialCluster> makeTrialCluster(const char* transType,
+  const double rCutCluster) {
+  return make_shared<TrialCluster>(transType, rCutCluster);
+}
+
+void clusterTrial(MC *mc, const char* transType, const double rCutCluster,
+  const double maxMoveParam) {
+  shared_ptr<TrialCluster> trial = make_shared<TrialCluster>(transType,
+                                                             rCutCluster);
+  if (maxMoveParam != -1) trial->maxMoveParam = maxMoveParam;
+  mc->initTrial(trial);
+}
+void clusterTrial(shared_ptr<MC> mc, const char* transType,
+  const double rCutCluster, const double maxMoveParam) {
+  clusterTrial(mc.get(), transType, rCutCluster, maxMoveParam);
+}
+
+}  // namespace feasst
@@ -0,0 +1,133 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef TRIAL_CLUSTER_H_
+#define TRIAL_CLUSTER_H_
+
+#include <memory>
+#include <string>
+#include "./trial.h"
+
+namespace feasst {
+
+/**
+ * Attempt a rigid transformation of a cluster of molecules.
+ * To begin, select a random molecule, and find its cluster with
+ * Space::clusterOfMol, where molecules are in the same cluster if atoms of the
+ * types given by Space::addTypeForCluster are within rCutCluster.
+ * Then translate or rotate the cluster as a rigid body.
+ * For detailed balance, the trial is rejected if the cluster of the selected
+ * molecule in the new configuration is not the same set of molecules.
+ * Otherwise, the Metropolis criteria is applied to the energy of the cluster
+ * with all molecules outside of the cluster.
+ * Not implemented with neighbor lists or Ewald summation, because only the
+ * total energy of Pair is updated.
+ * Cluster moves relax aggregating systems, where single molecule moves rarely
+ * move an aggregate as a whole.
+ */
+class TrialCluster : public Trial {
+ public:
+  /**
+   * Constructor
+   * @param transType
+   *  For rigid cluster translations, "translate".
+   *  For rigid cluster rotations about the center of the cluster, "rotate".
+   * @param rCutCluster
+   *  Cluster cut-off distance. If negative, use Pair::rCutMaxAll.
+   */
+  TrialCluster(Pair *pair, Criteria *criteria, const char* transType,
+               const double rCutCluster = -1.);
+
+  /// This constructor is not often used, but its purpose is to initialize trial
+  /// for interface before using reconstruct to set object pointers.
+  explicit TrialCluster(const char* transType,
+                        const double rCutCluster = -1.);
+
+  /// Write restart file.
+  void writeRestart(const char* fileName);
+
+  /// Construct from restart file.
+  TrialCluster(const char* fileName, Pair *pair, Criteria *criteria);
+  ~TrialCluster() {}
+  TrialCluster* clone(Pair* pair, Criteria* criteria) const {
+    TrialCluster* t = new TrialCluster(*this);
+    t->reconstruct(pair, criteria); return t;
+  }
+  shared_ptr<TrialCluster> cloneShrPtr(
+    Pair* pair, Criteria* criteria) const {
+    return(std::static_pointer_cast<TrialCluster, Trial>(
+      cloneImpl(pair, criteria)));
+  }
+
+  // tune parameters (e.g., based on acceptance)
+  void tuneParameters();
+  double targAcceptPer;      //!< target acceptance percentage
+
+  // Overloaded from base class for status of specific trials.
+  string printStat(const bool header = false);
+
+  /// Return transType.
+  string transType() const { return transType_; }
+
+  /// Return the cluster cut-off distance.
+  double rCutCluster() const;
+
+ protected:
+  string transType_;     //!< type of transformation
+  double rCutCluster_;   //!< cluster cut-off distance
+
+  void attempt1_();
+
+  void defaultConstruction_();
+
+  // clone design pattern
+  virtual shared_ptr<Trial> cloneImpl(
+    Pair *pair, Criteria *criteria) const {
+    shared_ptr<TrialCluster> t = make_shared<TrialCluster>(*this);
+    t->reconstruct(pair, criteria);
+    return t;
+  }
+
+ private:
+  /// Wrap each molecule of the cluster and update its cell.
+  void wrapCluster_(const vector<int> &mols);
+
+  /**
+   * Return the sum of the energy of each molecule of the cluster.
+   * Interactions within the cluster are counted twice, but do not change
+   * with a rigid transformation, such that the change in this sum is the
+   * change in energy of the trial. This only requires Pair::multiPartEner of
+   * one molecule, as implemented by all pairs.
+   */
+  double clusterEner_(const vector<int> &mols, const int flag);
+};
+
+/// Factory method
+shared_ptr<TrialCluster> makeTrialCluster(Pair *pair, Criteria *criteria,
+  const char* transType, const double rCutCluster = -1.);
+
+/// Factory method
+shared_ptr<TrialCluster> makeTrialCluster(const char* transType,
+  const double rCutCluster = -1.);
+
+class MC;
+
+/// Add a "TrialCluster" object to the Monte Carlo object, mc.
+void clusterTrial(MC *mc, const char* transType, const double rCutCluster = -1.,
+                  const double maxMoveParam = -1);
+
+/// Add a "TrialCluster" object to the Monte Carlo object, mc.
+void clusterTrial(shared_ptr<MC> mc, const char* transType,
+                  const double rCutCluster = -1.,
+                  const double maxMoveParam = -1);
+
+}  // namespace feasst
+
+#endif  // TRIAL_CLUSTER_H_
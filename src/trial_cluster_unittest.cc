@@ -0,0 +1,152 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include <gtest/gtest.h>
+#include "pair_lj.h"
+#include "pair_patch_kf.h"
+#include "pair_lj_coul_ewald.h"
+#include "pair_hybrid.h"
+#include "criteria_metropolis.h"
+#include "mc.h"
+#include "trial_transform.h"
+#include "trial_cluster.h"
+#include "trial_gca.h"
+
+using namespace feasst;
+
+TEST(TrialCluster, translateANDrotate) {
+  for (int cell = 0; cell < 2; ++cell) {
+    // cold Lennard-Jones which aggregates, with or without a cell list
+    Space s(3, {{"boxLength", "12"}});
+    PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"},
+                  {"cutType", "lrc"}});
+    if (cell == 1) {
+      s.updateCells(p.rCutMaxAll());
+      EXPECT_EQ(1, s.cellType());
+    }
+    s.addTypeForCluster(0);
+    CriteriaMetropolis c(1./0.7, exp(-2.));
+    MC mc(&s, &p, &c);
+    mc.seedRNG(1234);
+    mc.nMolSeek(80);
+    transformTrial(&mc, "translate", 0.5);
+    mc.setNFreqCheckE(100, 1e-8);
+    clusterTrial(&mc, "translate", 1.5, 0.5);
+    clusterTrial(&mc, "rotate", 1.5, 0.5);
+    mc.runNumTrials(3000);
+    EXPECT_LT(0., mc.trialVec()[1]->acceptPer());
+    EXPECT_LT(0., mc.trialVec()[2]->acceptPer());
+    EXPECT_EQ(1, p.checkEnergy(1e-8, 0));
+    if (cell == 1) EXPECT_EQ(1, s.checkCellList());
+
+    // restart
+    mc.trialVec()[1]->writeRestart("tmp/trialclusterrst");
+    TrialCluster trial("tmp/trialclusterrst", &p, &c);
+    EXPECT_EQ("translate", trial.transType());
+    EXPECT_EQ(1.5, trial.rCutCluster());
+  }
+}
+
+TEST(TrialCluster, patchKF) {
+  Space s;
+  s.initBoxLength(10);
+  s.readXYZBulk(2, "onePatch", "../unittest/patch/onePatch50.xyz");
+  PairPatchKF p(&s, {{"rCut", "1.5"}, {"patchAngle", "90"}});
+  p.initEnergy();
+  s.updateCells(p.rCut(), p.rCut());
+  s.addTypeForCluster(0);
+  CriteriaMetropolis c(1./0.5, 1.);
+  MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  transformTrial(&mc, "translate", 0.1);
+  clusterTrial(&mc, "translate", 1.5, 0.5);
+  clusterTrial(&mc, "rotate", 1.5, 0.5);
+  mc.setNFreqCheckE(100, 1e-8);
+  mc.runNumTrials(2000);
+  EXPECT_LT(0., mc.trialVec()[1]->acceptPer());
+  EXPECT_LT(0., mc.trialVec()[2]->acceptPer());
+  EXPECT_LT(mc.trialVec()[2]->acceptPer(), 1.);
+  EXPECT_EQ(1, p.checkEnergy(1e-8, 1));
+
+  // rejected rotations restore the orientations of the cluster
+  ASSERT_FALSE(s.sphereSymMol());
+  const vector<double> x = s.x();
+  s.quat2posAll();
+  for (unsigned int i = 0; i < x.size(); ++i) {
+    EXPECT_NEAR(x[i], s.x()[i], 1e-10);
+  }
+
+  // the point reflection of the geometric cluster algorithm is not allowed
+  gcaTrial(&mc);
+  try {
+    mc.trialVec().back()->attempt();
+    CATCH_PHRASE("requires spherically symmetric molecules");
+  }
+}
+
+TEST(TrialCluster, ewald) {
+  Space s(3, {{"boxLength", "20"}});
+  s.addMolInit("../forcefield/data.spce");
+  PairLJCoulEwald p(&s, {{"rCut", "10"}});
+  p.initBulkSPCE(5.6, 38);
+  CriteriaMetropolis c(1., 1.);
+  MC mc(&s, &p, &c);
+  mc.nMolSeek(4, "../forcefield/data.spce", 1e5);
+  clusterTrial(&mc, "translate");
+  try {
+    mc.trialVec().back()->attempt();
+    CATCH_PHRASE("not implemented with the Fourier-space terms");
+  }
+
+  // nor with a hybrid of pairs which includes Ewald summation
+  PairHybrid ph(&s);
+  ph.addPair(&p);
+  ph.initEnergy();
+  EXPECT_FALSE(ph.updateDeImplemented());
+  MC mcHybrid(&s, &ph, &c);
+  clusterTrial(&mcHybrid, "translate");
+  try {
+    mcHybrid.trialVec().back()->attempt();
+    CATCH_PHRASE("not implemented with the Fourier-space terms");
+  }
+}
+
+TEST(TrialGCA, energy) {
+  for (int cell = 0; cell < 2; ++cell) {
+    Space s(3, {{"boxLength", "12"}});
+    PairLJ p(&s, {{"rCut", "3"}, {"molTypeInForcefield", "data.lj"},
+                  {"cutType", "none"}});
+    if (cell == 1) {
+      s.updateCells(p.rCutMaxAll());
+      EXPECT_EQ(1, s.cellType());
+    }
+    s.addTypeForCluster(0);
+    CriteriaMetropolis c(1./0.7, exp(-2.));
+    MC mc(&s, &p, &c);
+    mc.seedRNG(1234);
+    mc.nMolSeek(80);
+    transformTrial(&mc, "translate", 0.5);
+    mc.setNFreqCheckE(100, 1e-8);
+
+    // the interactions of a molecule with its neighbors sum to its energy
+    vector<int> mols;
+    vector<double> pe;
+    p.molNeighEner(0, &mols, &pe);
+    double peSum = 0.;
+    for (unsigned int i = 0; i < pe.size(); ++i) peSum += pe[i];
+    EXPECT_NEAR(p.multiPartEner(s.imol2mpart(0), 0), peSum, 1e-10);
+
+    gcaTrial(&mc);
+    mc.runNumTrials(2000);
+    EXPECT_EQ(1., mc.trialVec()[1]->acceptPer());
+    EXPECT_EQ(1, p.checkEnergy(1e-8, 0));
+    if (cell == 1) EXPECT_EQ(1, s.checkCellList());
+  }
+}
@@ -140,6 +140,22 @@ void TrialDelete::attempt1_() {
       }
     }
 
+    // with a cavity grid, the reverse insertion is uniform within a cavity,
+    // which must contain the first site after the deletion
+    if (space()->cavityOn() && (preFac_ != 0)) {
+      ASSERT( (confineFlag_ == 0) && (delTwo == 0) && (!avbOn_) && (nf_ <= 1),
+        "cavity-biased deletion is not implemented with confine, delTwo, avb "
+        << "or multiple first beads");
+      bool inCavity;
+      const int nCavity = space()->nCavityWithout(mpart_, &inCavity);
+      if (inCavity) {
+        preFac_ *= space()->volume()/(nCavity*space()->cavityCellVolume());
+      } else {
+        preFac_ = 0.;
+      }
+      lnpMet_ = log(preFac_);
+    }
+
     // check if particle types are constrained to be equimolar
     if (space()->equiMolar() >= 1) {
       const int iMol = space()->mol()[mpart_[0]],
@@ -190,8 +206,8 @@ void TrialDelete::attempt1_() {
       }
 
       // record energy contribution of molecule to delete
-      de_ = -1. * pair_->multiPartEner(mpart_, 2);
-      pair_->update(mpart_, 2, "store");
+      de_ = -1. * multiPartEner_(mpart_, 2);
+      pair_->beginTrial(mpart_, Pair::DELETE_TRIAL);
       int iMolIndex = -1;
       if (molType_.empty()) {
         iMolIndex = 0;
@@ -216,12 +232,13 @@ void TrialDelete::attempt1_() {
     // particles
     pair_->delPart(mpart_);
     space()->delPart(mpart_);
-    pair_->update(mpart_, 2, "update");
+    pair_->commitTrial(mpart_);
     trialAccept_();
     if (verbose_ == 1) cout << "deletion accepted " << de_ << std::endl;
 
   // if not accepted, restore
   } else {
+    pair_->rollbackTrial();
     if (verbose_ == 1) std::cout << "deletion rejected " << de_ << std::endl;
     trialReject_();
   }
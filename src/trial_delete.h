@@ -23,6 +23,10 @@ class Criteria;
 
 /**
  * Attempt to delete particle(s).
+ * If the space maintains a cavity grid (see Space::initCavity), the deletion
+ * is rejected unless the first site would be in a cavity without the
+ * molecule, and the volume in the acceptance probability is replaced by the
+ * volume of the cavities without the molecule.
  */
 class TrialDelete : public Trial {
  public:
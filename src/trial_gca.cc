@@ -0,0 +1,160 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#include "./trial_gca.h"
+#include "./mc.h"
+
+namespace feasst {
+
+TrialGCA::TrialGCA() : Trial() {
+  defaultConstruction_();
+}
+
+TrialGCA::TrialGCA(
+  Pair *pair,
+  Criteria *criteria)
+  : Trial(pair, criteria) {
+  defaultConstruction_();
+}
+
+TrialGCA::TrialGCA(const char* fileName,
+  Pair *pair,
+  Criteria *criteria)
+  : Trial(pair, criteria, fileName) {
+  defaultConstruction_();
+}
+
+void TrialGCA::defaultConstruction_() {
+  className_.assign("TrialGCA");
+  trialType_.assign("move");
+  verbose_ = 0;
+}
+
+void TrialGCA::pivot_(const int iMol, const vector<double> &pivot) {
+  space()->pivotMol(iMol, pivot);
+  space()->wrap(space()->imol2mpart(iMol));
+  if (space()->cellType() > 0) {
+    space()->updateCellofiMol(iMol);
+  }
+  if (space()->cavityOn()) {
+    space()->updateCavityofiMol(iMol);
+  }
+}
+
+void TrialGCA::addNeighDV_(const double sign) {
+  for (unsigned int i = 0; i < molNeigh_.size(); ++i) {
+    const int jMol = molNeigh_[i];
+    if (inCluster_[jMol] != 1) {
+      if (inCluster_[jMol] == 0) {
+        inCluster_[jMol] = 2;
+        touched_.push_back(jMol);
+      }
+      dV_[jMol] += sign*peNeigh_[i];
+    }
+  }
+}
+
+void TrialGCA::attempt1_() {
+  if (verbose_ == 1) {
+    cout << std::setprecision(std::numeric_limits<double>::digits10+2)
+         << "attempting gca " << pair_->peTot() << endl;
+  }
+  cluster_.clear();
+  if (space()->nMol() <= 1) {
+    trialMoveDecide_(0, 0);   // ensured rejection, however, criteria can update
+    return void();
+  }
+  ASSERT(!pair_->neighOn(), "TrialGCA is not implemented with neighbor lists");
+  ASSERT(space()->sphereSymMol(), "TrialGCA requires spherically symmetric "
+    << "molecules, because the point reflection would mirror chiral molecules");
+  ASSERT(pair_->ghostEnerImplemented(), "TrialGCA only updates the total "
+    << "energy of Pair, and requires Pair::molNeighEner");
+  const int nMol = space()->nMol();
+  if (static_cast<int>(inCluster_.size()) != nMol) {
+    inCluster_.assign(nMol, 0);
+    dV_.assign(nMol, 0.);
+  }
+  neighMol_.clear();
+  neighDV_.clear();
+
+  // select a random pivot and seed molecule
+  const vector<double> pivot = space()->randPosition();
+  const int seed = uniformRanNum(0, nMol - 1);
+  cluster_.push_back(seed);
+  inCluster_[seed] = 1;
+
+  // reflect each molecule in the cluster, and add its neighbors
+  const double beta = criteria_->beta();
+  for (unsigned int ic = 0; ic < cluster_.size(); ++ic) {
+    const int iMol = cluster_[ic];
+    touched_.clear();
+    pair_->molNeighEner(iMol, &molNeigh_, &peNeigh_);
+    addNeighDV_(-1.);
+    pivot_(iMol, pivot);
+    pair_->molNeighEner(iMol, &molNeigh_, &peNeigh_);
+    addNeighDV_(1.);
+    for (unsigned int t = 0; t < touched_.size(); ++t) {
+      const int jMol = touched_[t];
+      const double dV = dV_[jMol];
+      dV_[jMol] = 0.;
+      inCluster_[jMol] = 0;
+      if ( (dV > 0.) && (uniformRanNum() < 1. - exp(-beta*dV)) ) {
+        inCluster_[jMol] = 1;
+        cluster_.push_back(jMol);
+      } else {
+        neighMol_.push_back(jMol);
+        neighDV_.push_back(dV);
+      }
+    }
+  }
+
+  // the energy changes only between the cluster and molecules not added
+  for (unsigned int i = 0; i < neighMol_.size(); ++i) {
+    if (inCluster_[neighMol_[i]] == 0) {
+      de_ += neighDV_[i];
+    }
+  }
+  for (unsigned int ic = 0; ic < cluster_.size(); ++ic) {
+    inCluster_[cluster_[ic]] = 0;
+  }
+
+  // the move is rejection free, however, criteria can update
+  lnpMet_ = 0.;
+  reject_ = 0;
+  if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
+                        reject_) == 1) {
+    pair_->update(de_);
+    trialAccept_();
+  } else {
+    // the reflection is its own inverse
+    for (unsigned int ic = 0; ic < cluster_.size(); ++ic) {
+      pivot_(cluster_[ic], pivot);
+    }
+    trialReject_();
+  }
+}
+
+shared_ptr<TrialGCA> makeTrialGCA(Pair *pair, Criteria *criteria) {
+  return make_shared<TrialGCA>(pair, criteria);
+}
+
+shared_ptr<TrialGCA> makeTrialGCA() {
+  return make_shared<TrialGCA>();
+}
+
+void gcaTrial(MC *mc) {
+  shared_ptr<TrialGCA> trial = make_shared<TrialGCA>();
+  mc->initTrial(trial);
+}
+void gcaTrial(shared_ptr<MC> mc) {
+  gcaTrial(mc.get());
+}
+
+}  // namespace feasst
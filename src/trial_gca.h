@@ -0,0 +1,108 @@
+/*
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+#ifndef TRIAL_GCA_H_
+#define TRIAL_GCA_H_
+
+#include <memory>
+#include "./trial.h"
+
+namespace feasst {
+
+/**
+ * Geometric cluster algorithm, which moves clusters of molecules by a point
+ * reflection without rejection.
+ * See Liu and Luijten, https://doi.org/10.1103/PhysRevLett.92.035504
+ *
+ * To begin, select a random pivot point and a random molecule.
+ * Reflect the molecule through the pivot. For each molecule j, not yet in the
+ * cluster, that interacts with the reflected molecule, add j to the cluster
+ * with probability max(0, 1 - exp(-beta dV)), where dV is the change in their
+ * pair interaction. Repeat for each molecule added to the cluster.
+ * The energy of the cluster with the molecules that were not added is
+ * accumulated, such that Pair::peTot is updated without a full recompute.
+ *
+ * Requires Pair::molNeighEner, and is not implemented with neighbor lists.
+ * Molecules must be spherically symmetric, because the point reflection of a
+ * molecule with more than one site would mirror its chirality.
+ */
+class TrialGCA : public Trial {
+ public:
+  /// Constructor
+  TrialGCA(Pair *pair, Criteria *criteria);
+
+  /// This constructor is not often used, but its purpose is to initialize trial
+  /// for interface before using reconstruct to set object pointers.
+  TrialGCA();
+
+  /// Construct from restart file.
+  TrialGCA(const char* fileName, Pair *pair, Criteria *criteria);
+  ~TrialGCA() {}
+  TrialGCA* clone(Pair* pair, Criteria* criteria) const {
+    TrialGCA* t = new TrialGCA(*this);
+    t->reconstruct(pair, criteria); return t;
+  }
+  shared_ptr<TrialGCA> cloneShrPtr(
+    Pair* pair, Criteria* criteria) const {
+    return(std::static_pointer_cast<TrialGCA, Trial>(
+      cloneImpl(pair, criteria)));
+  }
+
+  /// Return the number of molecules moved by the last trial.
+  int clusterSize() const { return static_cast<int>(cluster_.size()); }
+
+ protected:
+  void attempt1_();
+
+  void defaultConstruction_();
+
+  // clone design pattern
+  virtual shared_ptr<Trial> cloneImpl(
+    Pair *pair, Criteria *criteria) const {
+    shared_ptr<TrialGCA> t = make_shared<TrialGCA>(*this);
+    t->reconstruct(pair, criteria);
+    return t;
+  }
+
+ private:
+  // scratch for each trial
+  vector<int> cluster_;        //!< molecules in the cluster, in order added
+  vector<int> inCluster_;      //!< 1 if in the cluster, 2 if touched
+  vector<double> dV_;          //!< change in interaction with each molecule
+  vector<int> touched_;        //!< molecules with a change in interaction
+  vector<int> neighMol_;       //!< molecules which were not added
+  vector<double> neighDV_;     //!< and their change in interaction
+  vector<int> molNeigh_;       //!< neighbors from Pair::molNeighEner
+  vector<double> peNeigh_;     //!< interactions from Pair::molNeighEner
+
+  /// Reflect iMol through the pivot, and update its cell and cavity.
+  void pivot_(const int iMol, const vector<double> &pivot);
+
+  /// Add the interactions of molNeigh_ with sign to dV_.
+  void addNeighDV_(const double sign);
+};
+
+/// Factory method
+shared_ptr<TrialGCA> makeTrialGCA(Pair *pair, Criteria *criteria);
+
+/// Factory method
+shared_ptr<TrialGCA> makeTrialGCA();
+
+class MC;
+
+/// Add a "TrialGCA" object to the Monte Carlo object, mc.
+void gcaTrial(MC *mc);
+
+/// Add a "TrialGCA" object to the Monte Carlo object, mc.
+void gcaTrial(shared_ptr<MC> mc);
+
+}  // namespace feasst
+
+#endif  // TRIAL_GCA_H_
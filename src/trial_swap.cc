@@ -96,19 +96,29 @@ void TrialSwap::attempt1_() {
   }
 
   // record energy of molecule then swap
+  const bool ghost = pair_->ghostEnerImplemented();
+  double deOld = 0.;
   if (reject_ != 1) {
-    de_ = -1. * pair_->multiPartEner(mpart_, 0);
-
-    // remove molecule
-    pair_->delPart(mpart_);
-    space()->delPart(mpart_);
+    deOld = -1. * multiPartEner_(mpart_, 0);
+    de_ = deOld;
+
+    // with a ghost, the new molecule is only added to space if accepted
+    if (ghost) {
+      const int iMol = space()->mol()[mpart_.front()];
+      space()->initGhostMol(molTypeNew.c_str(), xAdd);
+      de_ += ghostEner_(iMol);
+    } else {
+      // remove molecule
+      pair_->delPart(mpart_);
+      space()->delPart(mpart_);
 
-    // add new molecule at the same position
-    pair_->addMol(xAdd, molTypeNew.c_str());
+      // add new molecule at the same position
+      pair_->addMol(xAdd, molTypeNew.c_str());
 
-    // record energy of new molecule
-    mpart_ = space()->lastMolIDVec();
-    de_ += pair_->multiPartEner(mpart_, 0);
+      // record energy of new molecule
+      mpart_ = space()->lastMolIDVec();
+      de_ += multiPartEner_(mpart_, 0);
+    }
 
     lnpMet_ += -criteria_->beta()*de_
       + log(criteria_->activ(iMolIndexNew))
@@ -128,12 +138,20 @@ void TrialSwap::attempt1_() {
   // acceptance criteria
   if (criteria_->accept(lnpMet_, pair_->peTot() + de_,
                         trialType_.c_str(), reject_) == 1) {
+    if (ghost && (reject_ != 1)) {
+      pair_->delPart(mpart_);
+      space()->delPart(mpart_);
+      space()->addGhostMol();
+      pair_->addPart();
+      mpart_ = space()->lastMolIDVec();
+      de_ = deOld + multiPartEner_(mpart_, 0);
+    }
     trialAccept_();
     pair_->update(de_);
 
   // if not accepted, swap again
   } else {
-    if (reject_ != 1) {
+    if ( (!ghost) && (reject_ != 1) ) {
       pair_->delPart(mpart_);
       space()->delPart(mpart_);
       pair_->addMol(xAdd, molTypeOld.c_str());
@@ -26,6 +26,8 @@ class Criteria;
  * As currently implemented, the position of the first particle in the molecule
  * during swap is where the first particle in the other molecule is placed.
  * Thus, for multi-site particles, the orientation is random.
+ * If the pair implements Pair::ghostEner, the new molecule is evaluated as a
+ * ghost, and the swap is only performed in space if the trial is accepted.
  */
 class TrialSwap : public Trial {
  public:
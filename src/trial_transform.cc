@@ -163,60 +163,72 @@ void TrialTransform::attempt1_() {
           space()->wrap(space()->imol2mpart(iMol));
         }
         if (pair_->neighOn()) pair_->buildNeighList();
-        pair_->update(space()->listAtoms(), 0, "update");
+        pair_->commitTrial(space()->listAtoms());
         // cout << "accepted " << transType_ << " " << de_ << endl;
         trialAccept_();
       } else {
+        pair_->rollbackTrial();
         space()->restoreAll();
         if (space()->cellType() > 0) space()->updateCellofallMol();
         // cout << "rejected " << transType_ << " " << de_ << endl;
         trialReject_();
       }
+      if (space()->cavityOn()) space()->updateCavityofallMol();
 
     // floppy box
     } else if ( (transType_.compare("xytilt") == 0) ||
                 (transType_.compare("xztilt") == 0) ||
                 (transType_.compare("yztilt") == 0) ) {
-      trialMoveRecordAll_(0);
-
       // randomly attempt to increase or decrease tilt by maxMoveParam
       //  this must be accompanied by a transformation of the particles
       double dxyt = maxMoveParam*(2*uniformRanNum()-1);
       double tiltOld = 0.;
-      if (transType_.compare("xytilt") == 0) {
-        tiltOld = space()->xyTilt();
-        space()->modXYTilt(dxyt);
-      } else if (transType_.compare("xztilt") == 0) {
-        tiltOld = space()->xzTilt();
-        space()->modXZTilt(dxyt);
-      } else if (transType_.compare("yztilt") == 0) {
-        tiltOld = space()->yzTilt();
-        space()->modYZTilt(dxyt);
-      }
+      const bool affine = pair_->affineEnerImplemented();
+      if (affine) {
+        // compute energy of new configuration without changing space
+        peOld_ = pair_->allPartEnerForce(0);
+        pair_->beginTrial(space()->listAtoms(), Pair::MOVE_TRIAL);
+        de_ = affineEner_(dxyt) - peOld_;
+      } else {
+        trialMoveRecordAll_(0);
+        if (transType_.compare("xytilt") == 0) {
+          tiltOld = space()->xyTilt();
+        } else if (transType_.compare("xztilt") == 0) {
+          tiltOld = space()->xzTilt();
+        } else if (transType_.compare("yztilt") == 0) {
+          tiltOld = space()->yzTilt();
+        }
+        tiltAttempt_(dxyt);
 
-      // compute energy of new configuration
-      de_ = pair_->allPartEnerForce(1) - peOld_;
+        // compute energy of new configuration
+        de_ = pair_->allPartEnerForce(1) - peOld_;
+      }
       lnpMet_ = -criteria_->beta()*de_;
 
       // accept or reject with bias prefactor
       if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
           reject_) == 1) {
+        if (affine) tiltAttempt_(dxyt);
         if (pair_->neighOn()) pair_->buildNeighList();
-        pair_->update(space()->listAtoms(), 0, "update");
+        pair_->commitTrial(space()->listAtoms());
         space()->wrapMol();
+        if (space()->cellType() > 0) space()->updateCellofallMol();
+        if (space()->cavityOn()) space()->updateCavityofallMol();
         trialAccept_();
       } else {
-        space()->restoreAll();
-        if (transType_.compare("xytilt") == 0) {
-          space()->setXYTilt(tiltOld);
-        } else if (transType_.compare("xztilt") == 0) {
-          space()->setXZTilt(tiltOld);
-        } else if (transType_.compare("yztilt") == 0) {
-          space()->setYZTilt(tiltOld);
+        pair_->rollbackTrial();
+        if (!affine) {
+          space()->restoreAll();
+          if (transType_.compare("xytilt") == 0) {
+            space()->setXYTilt(tiltOld);
+          } else if (transType_.compare("xztilt") == 0) {
+            space()->setXZTilt(tiltOld);
+          } else if (transType_.compare("yztilt") == 0) {
+            space()->setYZTilt(tiltOld);
+          }
+          // restoring the tilt factor also updates the cell list
+          if (space()->cavityOn()) space()->updateCavityofallMol();
         }
-        ASSERT(space()->cellType() <= 0,
-          "xytilt trial move not implemented correctly with cell list");
-        if (space()->cellType() > 0) space()->updateCellofallMol();
         // cout << "rejected " << transType_ << " " << de_ << endl;
         trialReject_();
       }
@@ -237,24 +249,33 @@ void TrialTransform::attempt1_() {
                 (transType_.compare("lxmod") == 0) ||
                 (transType_.compare("lymod") == 0) ||
                 (transType_.compare("lzmod") == 0) ) {
-      trialMoveRecordAll_(0);
-      // cout << MAX_PRECISION << "uold " << pair_->peTot() << endl;
-
       // randomly attempt to increase or decrease (lx,ly,lz) by maxMoveParam
       //  this must be accompanied by a transformation of the particles
       const double dlnv = maxMoveParam*(2*uniformRanNum()-1),
        vOld = space()->volume(),
        fac = exp(log(vOld) + dlnv)/vOld;
       // cout << "fac " << fac << " vOld " << vOld << " pres " << criteria_->pressure() << " " << space()->xyTilt() << " " << space()->xzTilt() << " " << space()->yzTilt() << " " << space()->l(0) << " " << space()->l(1) << " " << space()->l(2) << endl;
-      scaleAttempt_(fac);
-      // cout << "vnew " << space()->volume() << endl;
-      space()->wrapMol();
+      const bool affine = pair_->affineEnerImplemented();
+      double vNew;
+      if (affine) {
+        // compute energy of new configuration without changing space
+        peOld_ = pair_->allPartEnerForce(0);
+        pair_->beginTrial(space()->listAtoms(), Pair::MOVE_TRIAL);
+        de_ = affineEner_(fac, &vNew) - peOld_;
+      } else {
+        trialMoveRecordAll_(0);
+        // cout << MAX_PRECISION << "uold " << pair_->peTot() << endl;
+        scaleAttempt_(fac);
+        // cout << "vnew " << space()->volume() << endl;
+        space()->wrapMol();
+        vNew = space()->volume();
 
-      // if box attempts to go beyond certain bounds, it may be modified
-      const double facActual = space()->volume()/vOld;
+        // compute energy of new configuration
+        de_ = pair_->allPartEnerForce(1) - peOld_;
+      }
 
-      // compute energy of new configuration
-      de_ = pair_->allPartEnerForce(1) - peOld_;
+      // if box attempts to go beyond certain bounds, it may be modified
+      const double facActual = vNew/vOld;
       lnpMet_ = -criteria_->beta()*(de_ + criteria_->pressure()*(vOld*
         (facActual-1.)) - (space()->nMol()+1)*log(facActual)/criteria_->beta());
       // cout << "de " << de_ << " pmet " << lnpMet_ << endl;
@@ -262,15 +283,22 @@ void TrialTransform::attempt1_() {
       // accept or reject with bias prefactor
       if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
                             reject_) == 1) {
+        if (affine) {
+          scaleAttempt_(fac);
+          space()->wrapMol();
+        }
         if (pair_->neighOn()) pair_->buildNeighList();
-        pair_->update(space()->listAtoms(), 0, "update");
+        pair_->commitTrial(space()->listAtoms());
         trialAccept_();
       } else {
-        scaleAttempt_(1./facActual);
-        space()->restoreAll();
-        ASSERT(space()->cellType() <= 0,
-          "xytilt trial move not implemented correctly with cell list");
-        if (space()->cellType() > 0) space()->updateCellofallMol();
+        pair_->rollbackTrial();
+        if (!affine) {
+          scaleAttempt_(1./facActual);
+          space()->restoreAll();
+          ASSERT(space()->cellType() <= 0,
+            "xytilt trial move not implemented correctly with cell list");
+          if (space()->cellType() > 0) space()->updateCellofallMol();
+        }
         // cout << "rejected " << transType_ << " " << de_ << endl;
         trialReject_();
       }
@@ -449,6 +477,64 @@ void TrialTransform::scaleAttempt_(const double factor) {
   }
 }
 
+void TrialTransform::tiltAttempt_(const double dTilt) {
+  if (transType_.compare("xytilt") == 0) {
+    space()->modXYTilt(dTilt);
+  } else if (transType_.compare("xztilt") == 0) {
+    space()->modXZTilt(dTilt);
+  } else if (transType_.compare("yztilt") == 0) {
+    space()->modYZTilt(dTilt);
+  } else {
+    ASSERT(0, "unrecognized transType_(" << transType_ << ") for tilt.");
+  }
+}
+
+double TrialTransform::affineEner_(const double param, double *vNew) {
+  // the transformations of Space::modXYTilt and Space::scaleDomain, subject
+  // to the same bounds
+  const int dimen = space()->dimen();
+  vector<double> M(dimen*dimen, 0.);
+  vector<double> l = space()->boxLength();
+  double xyTilt = space()->xyTilt(),
+         xzTilt = space()->xzTilt(),
+         yzTilt = space()->yzTilt();
+  if (transType_.compare("xytilt") == 0) {
+    const double tiltNew = space()->boundTilt(xyTilt + param, 0);
+    M[1] = (tiltNew - xyTilt)/l[1];
+    xyTilt = tiltNew;
+  } else if (transType_.compare("xztilt") == 0) {
+    const double tiltNew = space()->boundTilt(xzTilt + param, 0);
+    M[2] = (tiltNew - xzTilt)/l[2];
+    xzTilt = tiltNew;
+  } else if (transType_.compare("yztilt") == 0) {
+    const double tiltNew = space()->boundTilt(yzTilt + param, 1);
+    M[dimen + 2] = (tiltNew - yzTilt)/l[2];
+    yzTilt = tiltNew;
+  } else {
+    ASSERT( (param > DTOL) && (param < NUM_INF),
+      "cannot scale domain by a factor: " << param);
+    for (int dim = 0; dim < dimen; ++dim) {
+      double factor = 1.;
+      if (transType_.compare("vol") == 0) {
+        factor = pow(param, 1./dimen);
+      } else if ( (transType_.compare("lxmod") == 0) && (dim == 0) ) {
+        factor = param;
+      } else if ( (transType_.compare("lymod") == 0) && (dim == 1) ) {
+        factor = param;
+      } else if ( (transType_.compare("lzmod") == 0) && (dim == 2) ) {
+        factor = param;
+      }
+      if (factor != 1.) {
+        factor = space()->boundScaleFactor(factor, dim);
+        M[dimen*dim + dim] = factor - 1.;
+        l[dim] *= factor;
+      }
+    }
+  }
+  if (vNew != NULL) *vNew = product(l);
+  return pair_->affineEner(M, l, xyTilt, xzTilt, yzTilt);
+}
+
 shared_ptr<TrialTransform> makeTrialTransform(Pair *pair,
   Criteria *criteria, const char* transType) {
   return make_shared<TrialTransform>(pair, criteria, transType);
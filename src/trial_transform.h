@@ -36,6 +36,9 @@ class TrialTransform : public Trial {
    *    which changes the acceptance criteria (see Frenkel-Smit, page 119).
    *  For x-dimension box length change, "lxmod". Similarly "lymod", "lzmod".
    *    These volume changes are also performed in lnV.
+   *  If the pair implements Pair::affineEner, the tilt and volume changes
+   *    are evaluated without changing Space, which is only transformed if
+   *    the trial is accepted.
    */
   TrialTransform(Pair *pair, Criteria *criteria,
                  const char* transType);
@@ -94,6 +97,16 @@ class TrialTransform : public Trial {
   /// Attempt to scale the domain by a factor.
   void scaleAttempt_(const double factor);
 
+  /// Modify the tilt factor by dTilt, and transform the particles.
+  void tiltAttempt_(const double dTilt);
+
+  /**
+   * Return the energy, as Pair::affineEner, if the tilt factor were modified
+   * by param for tilt trials, or if the domain were scaled by the factor
+   * param for volume trials. If vNew is not NULL, store the new volume.
+   */
+  double affineEner_(const double param, double *vNew = NULL);
+
   void defaultConstruction_();
 
   // clone design pattern
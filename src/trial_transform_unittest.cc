@@ -10,7 +10,9 @@
 
 #include <gtest/gtest.h>
 #include "pair_hard_sphere.h"
+#include "pair_lj.h"
 #include "criteria_metropolis.h"
+#include "mc.h"
 #include "trial_transform.h"
 #include "./group.h"
 
@@ -71,3 +73,73 @@ TEST(TrialTransform, group) {
   }
 }
 
+TEST(TrialTransform, tiltCellList) {
+  // Lennard-Jones in a tilted domain with a cell list
+  feasst::Space s(3, {{"boxLength", "12"}});
+  feasst::PairLJ p(&s, {{"rCut", "2.5"}, {"molTypeInForcefield", "data.lj"}});
+  s.setXYTilt(1.);
+  s.setXZTilt(-0.5);
+  s.setYZTilt(0.7);
+  s.updateCells(p.rCutMaxAll());
+  feasst::CriteriaMetropolis c(1., exp(-2.));
+  feasst::MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  mc.nMolSeek(100);
+  feasst::transformTrial(&mc, "translate", 0.5);
+  mc.setNFreqCheckE(100, 1e-8);
+  EXPECT_EQ(1, s.cellType());
+  EXPECT_EQ(4*4*4, s.nCell());
+  feasst::transformTrial(&mc, "xytilt", 0.2);
+  feasst::transformTrial(&mc, "xztilt", 0.2);
+  feasst::transformTrial(&mc, "yztilt", 0.2);
+  mc.runNumTrials(2000);
+
+  // the cell list is updated, not disabled, by the tilt trials
+  EXPECT_NE(1., s.xyTilt());
+  EXPECT_EQ(1, s.cellType());
+  EXPECT_EQ(1, s.checkCellList());
+  vector<int> mols(s.nMol());
+  for (int iMol = 0; iMol < s.nMol(); ++iMol) mols[iMol] = iMol;
+  EXPECT_LT(p.checkEnergySample(mols), 1e-8);
+  EXPECT_EQ(1, p.checkEnergy(1e-8, 0));
+}
+
+TEST(TrialTransform, affineEner) {
+  feasst::Space s(3, {{"boxLength", "12"}});
+  feasst::PairLJ p(&s, {{"rCut", "2.5"}, {"molTypeInForcefield", "data.lj"}});
+  s.setXYTilt(1.);
+  s.setXZTilt(-0.5);
+  s.setYZTilt(0.7);
+  s.updateCells(p.rCutMaxAll());
+  feasst::CriteriaMetropolis c(1., exp(-2.));
+  feasst::MC mc(&s, &p, &c);
+  mc.seedRNG(1234);
+  mc.nMolSeek(100);
+  feasst::transformTrial(&mc, "translate", 0.5);
+  mc.setNFreqCheckE(100, 1e-8);
+  EXPECT_TRUE(p.affineEnerImplemented());
+
+  // the energy of a sheared and scaled domain, without changing space
+  const vector<double> x = s.x();
+  vector<double> M(9, 0.), l = s.boxLength();
+  M[1] = 0.3/l[1];
+  M[4] = 0.1;
+  l[1] *= 1.1;
+  const double pe = p.affineEner(M, l, s.xyTilt() + 0.3, s.xzTilt(),
+                                 s.yzTilt());
+  EXPECT_EQ(x, s.x());
+  EXPECT_EQ(12., s.boxLength(1));
+  s.modXYTilt(0.3);
+  s.scaleDomain(1.1, 1);
+  p.initEnergy();
+  EXPECT_NEAR(p.peTot(), pe, 1e-9);
+
+  // volume trials with a cell list are only applied when accepted
+  c.pressureset(0.02);
+  feasst::transformTrial(&mc, "vol", 0.01);
+  mc.runNumTrials(2000);
+  EXPECT_NE(12*12*13.2, s.volume());
+  EXPECT_EQ(1, s.cellType());
+  EXPECT_EQ(1, s.checkCellList());
+  EXPECT_EQ(1, p.checkEnergy(1e-8, 0));
+}
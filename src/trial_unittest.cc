@@ -42,7 +42,7 @@ TEST(Trial, cloneANDreconstruct) {
   TrialTransform tt(&p, &c, "translate");
   tt.maxMoveParam = 5;
   TrialDelete td(&p, &c);
-  TrialAdd ta(&p, &c, "../forcefield/data.atom");
+  TrialAdd ta(&p, &c, s.addMolListType(0).c_str());
 
   ranInitByDate();
   p.initEnergy();
@@ -77,13 +77,13 @@ void TrialXSwap::attempt1_() {
 //        mpart_.insert(mpart_.end(), jpart.begin(), jpart.end());
 
     // peOld_ = pair_->multiPartEner(mpart_, 0);
-    // pair_->update(mpart_, 0, "store");
+    // pair_->beginTrial(mpart_, Pair::MOVE_TRIAL);
     // space()->xStore(mpart_);
     // trialMoveRecord_();
-    peOld_ = pair_->multiPartEner(ipart, 0) + pair_->multiPartEner(jpart, 0);
+    peOld_ = multiPartEner_(ipart, 0) + multiPartEner_(jpart, 0);
     space()->swapPositions(iMol, jMol);
     double peNew;
-    peNew = pair_->multiPartEner(ipart, 0) + pair_->multiPartEner(jpart, 0);
+    peNew = multiPartEner_(ipart, 0) + multiPartEner_(jpart, 0);
     // cout << "peNew " << peNew << endl;
     // peNew = pair_->multiPartEner(mpart_, 0);
     // cout << "peNew " << peNew << endl;
@@ -95,7 +95,7 @@ void TrialXSwap::attempt1_() {
   // accept or reject
   if (criteria_->accept(lnpMet_, pair_->peTot() + de_, trialType_.c_str(),
                         reject_) == 1) {
-    // pair_->update(mpart_, 0, "update");
+    // pair_->commitTrial(mpart_);
     pair_->update(de_);
     trialAccept_();
   } else {
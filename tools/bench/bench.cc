@@ -0,0 +1,359 @@
+/**
+ * FEASST - Free Energy and Advanced Sampling Simulation Toolkit
+ * http://pages.nist.gov/feasst, National Institute of Standards and Technology
+ * Harold W. Hatch, harold.hatch@nist.gov
+ *
+ * Permission to use this data/software is contingent upon your acceptance of
+ * the terms of LICENSE.txt and upon your providing
+ * appropriate acknowledgments of NIST's creation of the data/software.
+ */
+
+/**
+ * Benchmark workloads for comparing the performance of FEASST versions.
+ *
+ * Usage: feasst_bench -w workload [-o output] [-s trialScale]
+ *
+ * Each run appends one line to the output file (or standard output) with
+ * the workload name, trials per second, nanoseconds per pair interaction,
+ * the peak resident set size in kB and, for aggregation workloads, the
+ * growth of the mean cluster size per second. Run one workload per process
+ * so that the peak resident set size is not shared between workloads.
+ * Compare two output files with tools/bench/compare.py.
+ */
+
+#include <sys/resource.h>
+#include <chrono>
+#ifdef _OPENMP
+  #include <omp.h>
+#endif  // _OPENMP
+#include "feasst.h"
+
+// wall clock time in seconds
+double wallTime() {
+  return std::chrono::duration<double>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// peak resident set size in kB
+long peakRSS() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// place nMol molecules on a simple cubic lattice which fills the domain
+void lattice(feasst::Pair* pair, const int nMol, const char* molType) {
+  feasst::Space* space = pair->space();
+  const int nSide = static_cast<int>(ceil(pow(nMol, 1./3.) - feasst::DTOL));
+  vector<double> x(3);
+  int n = 0;
+  for (int i = 0; (i < nSide) && (n < nMol); ++i) {
+    for (int j = 0; (j < nSide) && (n < nMol); ++j) {
+      for (int k = 0; (k < nSide) && (n < nMol); ++k) {
+        x[0] = space->boxLength(0)*((i + 0.5)/nSide - 0.5);
+        x[1] = space->boxLength(1)*((j + 0.5)/nSide - 0.5);
+        x[2] = space->boxLength(2)*((k + 0.5)/nSide - 0.5);
+        pair->addMol(x, molType);
+        ++n;
+      }
+    }
+  }
+}
+
+// nanoseconds per pair interaction of a full energy calculation, where the
+// number of pairs within rCut is estimated from the density of sites
+double nsPerPair(feasst::Pair* pair, const double rCut) {
+  feasst::Space* space = pair->space();
+  if (space->natom() < 2) return 0.;
+  const int nRepeat = 3;
+  const double begin = wallTime();
+  for (int i = 0; i < nRepeat; ++i) pair->initEnergy();
+  const double elapsed = (wallTime() - begin)/nRepeat;
+  const double natom = space->natom(),
+    nPair = 0.5*natom*(natom - 1)*4./3.*feasst::PI*pow(rCut, 3)
+            /space->volume();
+  return 1e9*elapsed/nPair;
+}
+
+// time a number of trials, and return the trials per second
+double trialsPerSecond(feasst::MC* mc, const long long nTrials) {
+  const double begin = wallTime();
+  mc->runNumTrials(nTrials);
+  return static_cast<double>(nTrials)/(wallTime() - begin);
+}
+
+// Lennard-Jones NVT with a cell list at a density of 0.5
+void ljNVT(const int nMol, const double scale, double* tps, double* nspp) {
+  const double rCut = 3.;
+  feasst::Space space(3);
+  space.initBoxLength(pow(nMol/0.5, 1./3.));
+  feasst::PairLJ pair(&space, {{"rCut", feasst::str(rCut)},
+    {"cutType", "lrc"}, {"molTypeInForcefield", "data.lj"}});
+  lattice(&pair, nMol, space.addMolListType(0).c_str());
+  space.updateCells(rCut);
+  pair.initEnergy();
+  feasst::CriteriaMetropolis criteria(1./1.5, 1.);
+  feasst::MC mc(&space, &pair, &criteria);
+  feasst::transformTrial(&mc, "translate", 0.3);
+  *nspp = nsPerPair(&pair, rCut);
+  *tps = trialsPerSecond(&mc, scale*1e5);
+}
+
+// SPC/E water with Ewald summation, grand canonical. If nSystems > 1, a batch
+// of simulations at different temperatures in one process, cloned from one
+// template which shares the force field and tables.
+void spceGCMC(const int nSystems, const double scale, double* tps,
+              double* nspp) {
+  const double rCut = 10., temp = 525.;
+  feasst::Space space(3);
+  space.initBoxLength(24.8586887);
+  feasst::PairLJCoulEwald pair(&space, {{"rCut", feasst::str(rCut)},
+    {"molTypeInForcefield", "data.spce"}, {"alphaL", "5.6"}, {"k2max", "38"}});
+  feasst::CriteriaMetropolis criteria(
+    1./(temp*feasst::idealGasConstant/1e3), exp(-8.14));
+  feasst::MC mc(&space, &pair, &criteria);
+  mc.nMolSeek(216);
+  feasst::transformTrial(&mc, "translate", 0.5);
+  feasst::transformTrial(&mc, "rotate", 0.5);
+  mc.weight = 0.25;
+  feasst::deleteTrial(&mc);
+  feasst::addTrial(&mc, space.addMolListType(0).c_str());
+  *nspp = nsPerPair(&pair, rCut);
+  if (nSystems == 1) {
+    *tps = trialsPerSecond(&mc, scale*2e4);
+    return;
+  }
+  feasst::MCBatch batch;
+  batch.addClones(mc, nSystems);
+  for (int i = 0; i < nSystems; ++i) {
+    batch.mc(i)->criteria()->betaset(
+      1./((temp + 10*i)*feasst::idealGasConstant/1e3));
+  }
+  const long long nTrials = scale*5e3;
+  const double begin = wallTime();
+  batch.runNumTrials(nTrials);
+  *tps = static_cast<double>(nSystems*nTrials)/(wallTime() - begin);
+}
+
+// hard spheres at constant pressure, without a cell list for volume trials
+void hardSphereNPT(const double scale, double* tps, double* nspp) {
+  feasst::Space space(3);
+  space.initBoxLength(pow(500/0.5, 1./3.));
+  feasst::PairHardSphere pair(&space);
+  stringstream molType;
+  molType << space.install_dir() << "/forcefield/data.atom";
+  pair.initData(molType.str().c_str());
+  lattice(&pair, 500, molType.str().c_str());
+  pair.initEnergy();
+  feasst::CriteriaMetropolis criteria(1., 1.);
+  criteria.pressureset(2.);
+  feasst::MC mc(&space, &pair, &criteria);
+  feasst::transformTrial(&mc, "translate", 0.1);
+  mc.weight = 0.002;
+  feasst::transformTrial(&mc, "vol", 0.001);
+  *nspp = nsPerPair(&pair, 1.);
+  *tps = trialsPerSecond(&mc, scale*1e5);
+}
+
+// Kern-Frenkel patchy particles with a cell list
+void patchKF(const double scale, double* tps, double* nspp) {
+  const double rCut = 1.5;
+  feasst::Space space(3);
+  space.initBoxLength(pow(1000/0.3, 1./3.));
+  feasst::PairPatchKF pair(&space, {{"rCut", feasst::str(rCut)},
+    {"patchAngle", "90"}});
+  stringstream molType;
+  molType << space.install_dir() << "/forcefield/data.onePatch";
+  pair.initData(molType.str().c_str());
+  lattice(&pair, 1000, molType.str().c_str());
+  space.updateCells(rCut);
+  pair.initEnergy();
+  feasst::CriteriaMetropolis criteria(1./0.5, 1.);
+  feasst::MC mc(&space, &pair, &criteria);
+  feasst::transformTrial(&mc, "translate", 0.3);
+  feasst::transformTrial(&mc, "rotate", 0.3);
+  *nspp = nsPerPair(&pair, rCut);
+  *tps = trialsPerSecond(&mc, scale*1e5);
+}
+
+// Lennard-Jones transition-matrix grand canonical, in windows if there is
+// more than one OpenMP thread
+void ljTMMC(const double scale, double* tps, double* nspp) {
+  const double rCut = 3.;
+  feasst::Space space(3);
+  space.initBoxLength(8.);
+  feasst::PairLJ pair(&space, {{"rCut", feasst::str(rCut)},
+    {"cutType", "lrc"}, {"molTypeInForcefield", "data.lj"}});
+  pair.initEnergy();
+  auto criteria = feasst::makeCriteriaWLTMMC({{"beta", feasst::str(1./1.5)},
+    {"activ", feasst::str(exp(-1.568214))}, {"mType", "nmol"},
+    {"nMin", "0"}, {"nMax", "100"}});
+  criteria->collectInit();
+  criteria->tmmcInit();
+  feasst::WLTMMC mc(&space, &pair, criteria.get());
+  mc.weight = 3./4.;
+  feasst::transformTrial(&mc, "translate", 0.3);
+  mc.weight = 1./8.;
+  feasst::deleteTrial(&mc);
+  mc.weight = 1./8.;
+  feasst::addTrial(&mc, space.addMolListType(0).c_str());
+  mc.initLog("tmp/benchtmmc", 1e8);
+  mc.initColMat("tmp/benchtmmccolMat", 1e8);
+  mc.initRestart("tmp/benchtmmcrst", 1e8);
+  const long long nTrials = scale*1e5;
+  const double begin = wallTime();
+  #ifdef _OPENMP
+    if (omp_get_max_threads() > 1) {
+      mc.initWindows(2., 0);
+      mc.runNumSweeps(1000000, nTrials);
+    } else {
+      mc.runNumTrials(nTrials);
+    }
+  #else  // _OPENMP
+    mc.runNumTrials(nTrials);
+  #endif  // _OPENMP
+  *tps = static_cast<double>(nTrials)/(wallTime() - begin);
+  *nspp = nsPerPair(&pair, rCut);
+}
+
+// structure factor and radial distribution function of Lennard-Jones
+void scatter(const double scale, double* tps, double* nspp) {
+  const int nMol = 10000;
+  const double rMax = 6.;
+  feasst::Space space(3);
+  space.initBoxLength(pow(nMol/0.5, 1./3.));
+  feasst::PairLJ pair(&space, {{"rCut", "3"},
+    {"molTypeInForcefield", "data.lj"}});
+  lattice(&pair, nMol, space.addMolListType(0).c_str());
+  feasst::AnalyzeScatter scat(&pair);
+  scat.initSANS(0.1, 1, rMax);
+  const int nUpdates = std::max(1, static_cast<int>(scale*10));
+
+  // ns per pair of g(r) alone
+  double begin = wallTime();
+  for (int i = 0; i < nUpdates; ++i) scat.update();
+  const double elapsed = (wallTime() - begin)/nUpdates;
+  const double nPair = 0.5*nMol*(nMol - 1)*4./3.*feasst::PI*pow(rMax, 3)
+                       /space.volume();
+  *nspp = 1e9*elapsed/nPair;
+
+  // updates per second of g(r) and S(q)
+  scat.initStructureFactor(8);
+  begin = wallTime();
+  for (int i = 0; i < nUpdates; ++i) scat.update();
+  *tps = nUpdates/(wallTime() - begin);
+}
+
+// Lennard-Jones aggregation from a dispersed lattice at low temperature and
+// density, with single molecule moves and either rigid cluster moves
+// ("cluster"), the geometric cluster algorithm ("gca") or neither ("single").
+// Relaxation is the growth of the mean cluster size per second.
+void ljAggregate(const char* moves, const double scale, double* tps,
+                 double* nspp, double* relax) {
+  const int nMol = 500;
+  const double rCut = 3., rCutCluster = 1.5;
+  feasst::Space space(3);
+  space.initBoxLength(pow(nMol/0.05, 1./3.));
+  feasst::PairLJ pair(&space, {{"rCut", feasst::str(rCut)},
+    {"cutType", "lrc"}, {"molTypeInForcefield", "data.lj"}});
+  lattice(&pair, nMol, space.addMolListType(0).c_str());
+  space.updateCells(rCut);
+  space.addTypeForCluster(0);
+  pair.initEnergy();
+  feasst::CriteriaMetropolis criteria(1./0.7, 1.);
+  feasst::MC mc(&space, &pair, &criteria);
+  const string type(moves);
+  if (type == "single") {
+    feasst::transformTrial(&mc, "translate", 0.5);
+  } else if (type == "cluster") {
+    mc.weight = 0.8;
+    feasst::transformTrial(&mc, "translate", 0.5);
+    mc.weight = 0.1;
+    feasst::clusterTrial(&mc, "translate", rCutCluster, 0.5);
+    feasst::clusterTrial(&mc, "rotate", rCutCluster, 0.5);
+  } else if (type == "gca") {
+    mc.weight = 0.9;
+    feasst::transformTrial(&mc, "translate", 0.5);
+    mc.weight = 0.1;
+    feasst::gcaTrial(&mc);
+  }
+  space.updateClusters(rCutCluster);
+  const double sizeBegin = static_cast<double>(nMol)/space.nClusters();
+  const long long nTrials = scale*2e5;
+  const double begin = wallTime();
+  mc.runNumTrials(nTrials);
+  const double elapsed = wallTime() - begin;
+  space.updateClusters(rCutCluster);
+  const double sizeEnd = static_cast<double>(nMol)/space.nClusters();
+  *tps = static_cast<double>(nTrials)/elapsed;
+  *relax = (sizeEnd - sizeBegin)/elapsed;
+  *nspp = nsPerPair(&pair, rCut);
+}
+
+int main(int argc, char** argv) {
+  string workload, output;
+  double scale = 1.;
+
+  // parse command-line arguments using getopt
+  { int c; opterr = 0;
+    while ((c = getopt(argc, argv, "w:o:s:")) != -1) {
+      switch (c) {
+        case 'w': workload = optarg; break;
+        case 'o': output = optarg; break;
+        case 's': scale = atof(optarg); break;
+        case '?':
+          fprintf(stderr, "Unknown option `-%c'.\n", optopt);
+          return 1;
+        default: abort();
+      }
+    }
+  }  // GETOPT
+
+  feasst::ranInitForRepro();
+  double tps = 0., nspp = 0., relax = 0.;
+  if (workload == "lj1k") {
+    ljNVT(1000, scale, &tps, &nspp);
+  } else if (workload == "lj10k") {
+    ljNVT(10000, scale, &tps, &nspp);
+  } else if (workload == "lj100k") {
+    ljNVT(100000, scale, &tps, &nspp);
+  } else if (workload == "spce_gcmc") {
+    spceGCMC(1, scale, &tps, &nspp);
+  } else if (workload == "spce_batch") {
+    spceGCMC(8, scale, &tps, &nspp);
+  } else if (workload == "hs_npt") {
+    hardSphereNPT(scale, &tps, &nspp);
+  } else if (workload == "patchkf") {
+    patchKF(scale, &tps, &nspp);
+  } else if (workload == "lj_tmmc") {
+    ljTMMC(scale, &tps, &nspp);
+  } else if (workload == "scatter") {
+    scatter(scale, &tps, &nspp);
+  } else if (workload == "agg_single") {
+    ljAggregate("single", scale, &tps, &nspp, &relax);
+  } else if (workload == "agg_cluster") {
+    ljAggregate("cluster", scale, &tps, &nspp, &relax);
+  } else if (workload == "agg_gca") {
+    ljAggregate("gca", scale, &tps, &nspp, &relax);
+  } else {
+    fprintf(stderr, "Unknown workload `%s'.\n", workload.c_str());
+    return 1;
+  }
+
+  // append results
+  stringstream ss;
+  ss << workload << " " << tps << " " << nspp << " " << peakRSS() << " "
+     << relax << endl;
+  const char* header =
+    "#workload trialsPerSecond nsPerPair peakRSSkB relaxPerSecond";
+  if (output.empty()) {
+    cout << header << endl
+         << ss.str();
+  } else {
+    const bool newFile = !feasst::fileExists(output.c_str());
+    std::ofstream file(output.c_str(), std::ios_base::app);
+    if (newFile) file << header << endl;
+    file << ss.str();
+  }
+  return 0;
+}
@@ -0,0 +1,62 @@
+"""
+Compare two benchmark result files from "make bench" and flag regressions.
+
+Usage: python compare.py reference.txt new.txt [--tolerance 0.1]
+
+A workload regresses if its trials per second or relaxation per second
+decrease, or its nanoseconds per pair interaction or peak resident set size
+increase, by more than the relative tolerance. Metrics missing from older
+result files are skipped. The exit status is the number of regressions.
+"""
+
+import argparse
+import sys
+
+# column, and whether larger values are better
+METRICS = [("trialsPerSecond", True),
+           ("nsPerPair", False),
+           ("peakRSSkB", False),
+           ("relaxPerSecond", True)]
+
+def read_results(file_name):
+  """Return a dictionary of metrics for each workload."""
+  results = dict()
+  with open(file_name) as results_file:
+    for line in results_file:
+      if line.startswith("#") or not line.strip():
+        continue
+      columns = line.split()
+      results[columns[0]] = [float(value) for value in columns[1:]]
+  return results
+
+def compare(reference, new, tolerance):
+  """Print the relative change of each metric, and return the regressions."""
+  regressions = 0
+  print("#workload metric reference new change")
+  for workload in sorted(reference):
+    if workload not in new:
+      print(workload, "missing")
+      continue
+    for index, (metric, larger_is_better) in enumerate(METRICS):
+      if index >= min(len(reference[workload]), len(new[workload])):
+        continue
+      ref, val = reference[workload][index], new[workload][index]
+      change = (val - ref)/ref if ref != 0 else 0.
+      flag = ""
+      if (larger_is_better and change < -tolerance) or \
+         (not larger_is_better and change > tolerance):
+        flag = "REGRESSION"
+        regressions += 1
+      print(workload, metric, ref, val, "{:+.1%}".format(change), flag)
+  return regressions
+
+if __name__ == "__main__":
+  PARSER = argparse.ArgumentParser()
+  PARSER.add_argument("reference", help="reference results file")
+  PARSER.add_argument("new", help="new results file")
+  PARSER.add_argument("--tolerance", type=float, default=0.1,
+                      help="relative change allowed before a regression")
+  ARGS = PARSER.parse_args()
+  # exit status is modulo 256, so saturate the number of regressions
+  sys.exit(min(compare(read_results(ARGS.reference), read_results(ARGS.new),
+                       ARGS.tolerance), 255))
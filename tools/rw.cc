@@ -1,26 +1,33 @@
 /**
  * Reweight a collection matrix file to a given lnz, if given.
- * If a lnz is not given, then attempt to find saturation.
- *   For saturation, if a volume is not given, attempt to find the volume from a
- *   restart file in order to compute the density and pressure at saturation.
+ * If a range of lnz is given, or multiple beta, reweight in batch to each
+ *   state and write one row per state to the output file.
+ * If neither is given, then find saturation for each beta.
+ *   For batch and saturation, if a volume is not given, attempt to find the
+ *   volume from a restart file in order to compute the pressure.
+ * Additional collection matrix files may follow the options, in which case
+ *   the batch or saturation rows of each file are written to the same output,
+ *   with the index of the file in the first column.
  */
 
 #include "functions.h"
-#include "pair_ideal.h"
-#include "mc_wltmmc.h"
+#include "criteria_wltmmc.h"
 
 int main(int argc, char** argv) {
 
   // set input variables
   double volume = -1;
   const double LNZDEFAULT = 11234533;
-  double lnz = LNZDEFAULT;
+  double lnz = LNZDEFAULT, lnzMin = LNZDEFAULT, lnzMax = LNZDEFAULT;
+  int nLnz = 1;
+  vector<double> betas;
   int phaseBoundary = -1;
   std::ostringstream rstFile("tmp/rstspace"), ssFileIn("colMat.txt"), ssFileOut("colMatrw.txt");
 
   // parse command-line arguments using getopt
+  vector<string> fileIns;
   { int index, c; opterr = 0;
-    while ((c = getopt(argc, argv, "v:z:p:r:i:o:s:")) != -1) {
+    while ((c = getopt(argc, argv, "v:z:p:r:i:o:s:l:u:n:b:")) != -1) {
       switch (c) {
         case 'v': volume = atof(optarg); break;
         case 'z': lnz = atof(optarg); break;
@@ -28,6 +35,10 @@ int main(int argc, char** argv) {
         case 'r': rstFile.str(""); rstFile << optarg; break;
         case 'i': ssFileIn.str(""); ssFileIn << optarg; break;
         case 'o': ssFileOut.str(""); ssFileOut << optarg; break;
+        case 'l': lnzMin = atof(optarg); break;
+        case 'u': lnzMax = atof(optarg); break;
+        case 'n': nLnz = atoi(optarg); break;
+        case 'b': betas.push_back(atof(optarg)); break;
         case '?':
           if (isprint(optopt))
             fprintf(stderr, "Unknown option `-%c'.\n", optopt);
@@ -41,56 +52,67 @@ int main(int argc, char** argv) {
       << " -i " << ssFileIn.str()
       << " -o " << ssFileOut.str()
       << " -z " << lnz
+      << " -l " << lnzMin
+      << " -u " << lnzMax
+      << " -n " << nLnz
       << " -p " << phaseBoundary
       << " -v " << volume
       << " -r " << rstFile.str()
       << endl;
-    for (index = optind; index < argc; index++) printf("Non-option argument %s\n", argv[index]);
+    fileIns.push_back(ssFileIn.str());
+    for (index = optind; index < argc; index++) fileIns.push_back(argv[index]);
   }
 
   // If the lnz was set to some value, reweight to the given lnz.
   if (lnz != LNZDEFAULT) {
     feasst::CriteriaWLTMMC criteria(ssFileIn.str().c_str());
-    criteria.readCollectMat(ssFileIn.str().c_str());
     criteria.lnPIrw(exp(lnz));
     criteria.printRWinit();
     criteria.printCollectMat(ssFileOut.str().c_str());
 
-  // Otherwise, attempt to find saturation and reweight the lnzsat.
+  // Otherwise, reweight in batch, or find saturation, for each file.
   } else {
     // if volume is not given or unphysical, attempt to find volume from restart
-    shared_ptr<feasst::Space> space;
     if (volume < 0) {
       ASSERT(feasst::fileExists(rstFile.str().c_str()), "if volume is not "
         << "specified, then a restart file must be provided");
-      space = make_shared<feasst::Space>(rstFile.str().c_str());
-    } else {
-      space = make_shared<feasst::Space>();
-      space->initBoxLength(1);
-      space->scaleDomain(volume);
+      feasst::Space space(rstFile.str().c_str());
+      volume = space.volume();
     }
 
-    feasst::PairIdeal pair(space.get());
-    feasst::CriteriaWLTMMC criteria(ssFileIn.str().c_str());
-    feasst::WLTMMC wltmmc(space.get(), &pair, &criteria);
-    criteria.readCollectMat(ssFileIn.str().c_str());
-    if (phaseBoundary != -1) {
-      criteria.setPhaseBoundary(phaseBoundary);
+    // batch states of lnz
+    vector<double> lnzs;
+    if (lnzMin != LNZDEFAULT) {
+      if (lnzMax == LNZDEFAULT) lnzMax = lnzMin;
+      for (int i = 0; i < nLnz; ++i) {
+        lnzs.push_back(lnzMin + (lnzMax - lnzMin)*i/std::max(1, nLnz - 1));
+      }
     }
-    wltmmc.printSat();
-  }
-
-
-
-
 
-
-//  feasst::WLTMMC mc("tmp/rst");
-//  mc.c()->readCollectMat(ssFileIn.str().c_str());
-//  mc.initLog("logtest", 0);
-//  mc.c()->lnPIrw(exp(lnz));
-//  mc.c()->printRWinit();
-//  mc.c()->printCollectMat(ssFileOut.str().c_str());
-
-//  mc.printSat();
+    std::ofstream file(ssFileOut.str().c_str());
+    file << "# file " << feasst::CriteriaWLTMMC::rwBatchHeader() << endl;
+    const int nCols = feasst::CriteriaWLTMMC::nRWBatchCols();
+    for (int iFile = 0; iFile < static_cast<int>(fileIns.size()); ++iFile) {
+      feasst::CriteriaWLTMMC criteria(fileIns[iFile].c_str());
+      if (phaseBoundary != -1) {
+        criteria.setPhaseBoundary(phaseBoundary);
+      }
+      vector<double> betaFile = betas;
+      if (betaFile.size() == 0) betaFile.push_back(criteria.beta());
+      vector<double> data;
+      if (lnzs.size() > 0) {
+        criteria.rwBatch(lnzs, betaFile, volume, &data);
+      } else {
+        criteria.satBatch(betaFile, volume, &data);
+      }
+      file << std::setprecision(std::numeric_limits<double>::digits10+2);
+      for (int row = 0; row < static_cast<int>(data.size())/nCols; ++row) {
+        file << iFile;
+        for (int col = 0; col < nCols; ++col) {
+          file << " " << data[row*nCols + col];
+        }
+        file << endl;
+      }
+    }
+  }
 }